@@ -56,6 +56,9 @@
 #include <Arduino.h>
 
 #include "input.h"
+#include "sid_sched.h"
+#include "sid_prof.h"
+#include "sid_mem.h"
 
 /*
  * IRRemote class
@@ -82,6 +85,8 @@ static volatile IRState  _irstate = IRSTATE_IDLE;
 static volatile uint32_t _irlen = 0;
 static volatile uint32_t _irbuf[IRBUFSIZE];
 
+static volatile bool     _edgeSeen = false;
+
 // ISR 
 // Record duration of marks/spaces through a simple state machine
 static void IRAM_ATTR IRTimer_ISR()
@@ -111,7 +116,10 @@ static void IRAM_ATTR IRTimer_ISR()
             _irstate = IRSTATE_DARK;
             _irbuf[_irlen++] = _cnt;
             _cnt = 0;
-            if(_irlen >= IRBUFSIZE) _irstate = IRSTATE_STOP;
+            if(_irlen >= IRBUFSIZE) {
+                _irstate = IRSTATE_STOP;
+                sched_wakeFromISR();
+            }
         }
         break;
     case IRSTATE_DARK:
@@ -119,10 +127,15 @@ static void IRAM_ATTR IRTimer_ISR()
             _irstate = IRSTATE_LIGHT;
             _irbuf[_irlen++] = _cnt;
             _cnt = 0;
-            if(_irlen >= IRBUFSIZE) _irstate = IRSTATE_STOP;
+            if(_irlen >= IRBUFSIZE) {
+                _irstate = IRSTATE_STOP;
+                sched_wakeFromISR();
+            }
         } else if(_cnt > GAP_TICKS) {
             // Gap longer than usual space, transmission finished.
             _irstate = IRSTATE_STOP;
+            // Wake up main loop to decode
+            sched_wakeFromISR();
         }
         break;
     case IRSTATE_STOP:
@@ -158,6 +171,8 @@ bool IRRemote::loop()
     if(_irstate != IRSTATE_STOP)
         return false;
 
+    PROF_SCOPE(PROF_IR);
+
     // Copy result to backup buffer
     _buflen = _irlen;
     for(int i = 0; i < _buflen; i++) {
@@ -190,6 +205,41 @@ void IRRemote::resume()
     _irstate = IRSTATE_IDLE;
 }
 
+// IR receiver sees light while asleep
+static void IRAM_ATTR IREdge_ISR()
+{
+    _edgeSeen = true;
+    sched_wakeFromISR();
+}
+
+// Stop sampling (power save). If edgeWake is set, the first 
+// IR light is reported through edgeSeen(); the transmission
+// itself is lost.
+void IRRemote::sleep(bool edgeWake)
+{
+    timerAlarmDisable(_IRTimer);
+    _edgeSeen = false;
+    if(edgeWake) {
+        attachInterrupt(_ir_pin, IREdge_ISR, FALLING);
+    }
+}
+
+void IRRemote::wake()
+{
+    detachInterrupt(_ir_pin);
+    _irstate = IRSTATE_IDLE;
+    _irlen = 0;
+    _cnt = 0;
+    timerAlarmEnable(_IRTimer);
+}
+
+bool IRRemote::edgeSeen()
+{
+    bool ret = _edgeSeen;
+    _edgeSeen = false;
+    return ret;
+}
+
 uint32_t IRRemote::readHash()
 {
     return _hvalue;
@@ -370,3 +420,9 @@ void SIDButton::transitionTo(ButtonState nextState)
     _state = nextState;
 }
  
+
+// ISR sample buffer and IR receiver object
+void ir_getMemUse(memUse *m)
+{
+    m->staticBytes = sizeof(_irbuf) + sizeof(IRRemote);
+}
@@ -77,6 +77,10 @@ class IRRemote {
         bool loop();
         uint32_t readHash();
         void resume();
+
+        void sleep(bool edgeWake);
+        void wake();
+        bool edgeSeen();
         
     private:
         uint32_t compare(unsigned int oldval, unsigned int newval);
@@ -546,28 +546,55 @@
 #include "sid_settings.h"
 #include "sid_wifi.h"
 #include "sid_main.h"
+#include "sid_sched.h"
+#include "sid_task.h"
+#include "sid_time.h"
+#include "sid_stall.h"
+#include "sid_prof.h"
 
 void setup()
 {
-    powerupMillis = millis();
+    powerupMillis = sidMillis();
     
     Serial.begin(115200);
     Serial.println();
 
+    PROF_BOOT(BOOT_SETUP);
+
     Wire.begin(-1, -1, 400000);
 
+    task_init();
+    #ifdef SID_HAVESTATS
+    stall_setup();
+    #endif
+
     main_boot();
+    PROF_BOOT(BOOT_DISPLAY);
     settings_setup();
+    PROF_BOOT(BOOT_SETTINGS);
     wifi_setup();
+    PROF_BOOT(BOOT_WIFICFG);
+
+    // WiFi, CP, MQTT from now on run on core 0; WiFi 
+    // connects in the background while we boot
+    wifi_startTask();
+    
     main_setup();
-    bttfn_loop();
+    PROF_BOOT(BOOT_MAIN);
+
+    // Network task may now use file systems and start CP
+    task_setupDone();
 }
 
 void loop()
-{    
+{
+    #ifdef SID_HAVESTATS
+    stall_beat(TASK_LOOP);
+    #endif
+    task_parkPoint();
     main_loop();
-    wifi_loop();
     bttfn_loop();
+    sched_idle();
 }
 
 #if defined(SID_DBG) || defined(SID_DBG_NET)
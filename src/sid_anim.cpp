@@ -0,0 +1,244 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Animation engine
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#include "sid_anim.h"
+#include "sid_main.h"
+#include "sid_time.h"
+
+/*
+ * Animation engine
+ *
+ * Sequences (word sequences, fades, startup) are queued as
+ * keyframes and played back from main_loop() instead of
+ * blocking in a delay loop. Each keyframe is shown (its start
+ * action executed) and then held for "dur" ms; fades interpolate
+ * the brightness over that time.
+ */
+
+#define ANIM_QUEUE_SIZE 64
+
+static animKey animQueue[ANIM_QUEUE_SIZE];
+static int     animIn = 0, animOut = 0, animCnt = 0;
+
+static bool          animStarted = false;
+static bool          animRebase = true;
+static unsigned long animStartNow = 0;
+static uint8_t       animFadeFrom = 0;
+static uint8_t       animFadeCur = 0;
+
+static void (*animDoneFn)() = NULL;
+
+void anim_init(animKey *key, uint8_t type, uint16_t dur, uint8_t bri)
+{
+    memset((void *)key, 0, sizeof(*key));
+    key->type = type;
+    key->dur = dur;
+    key->bri = bri;
+}
+
+bool anim_add(const animKey *key)
+{
+    if(animCnt >= ANIM_QUEUE_SIZE) {
+        #ifdef SID_DBG
+        Serial.println("anim_add: Queue full");
+        #endif
+        return false;
+    }
+
+    // Queue starts from empty: New time base
+    if(!animCnt) animRebase = true;
+
+    animQueue[animIn] = *key;
+    animIn = (animIn + 1) % ANIM_QUEUE_SIZE;
+    animCnt++;
+
+    return true;
+}
+
+bool anim_addCmd(uint8_t type, uint16_t dur, uint8_t bri)
+{
+    animKey key;
+
+    anim_init(&key, type, dur, bri);
+    return anim_add(&key);
+}
+
+bool anim_addLetter(char alpha, int x, int y, uint16_t dur, uint8_t bri)
+{
+    animKey key;
+
+    anim_init(&key, ANIM_LETTER, dur, bri);
+    key.alpha = alpha;
+    key.x = x;
+    key.y = y;
+    return anim_add(&key);
+}
+
+int anim_space()
+{
+    return ANIM_QUEUE_SIZE - animCnt;
+}
+
+// Set function to call when the queue has run empty
+void anim_onDone(void (*fn)())
+{
+    animDoneFn = fn;
+}
+
+bool anim_running()
+{
+    return (animCnt > 0);
+}
+
+// Abort current animation. Does not call the
+// "done" function; caller needs to clean up.
+void anim_stop()
+{
+    if(!animCnt)
+        return;
+
+    animIn = animOut = animCnt = 0;
+    animStarted = false;
+
+    sid.clearBuf();
+    sid.clearDisplayDirect();
+    sid.setBrightness(255);
+}
+
+static void anim_startKey(animKey *key)
+{
+    if(key->type != ANIM_FADE) {
+        if(key->bri == ANIM_BRI_RESTORE) {
+            sid.setBrightness(255);
+        } else if(key->bri != ANIM_BRI_KEEP) {
+            sid.setBrightnessDirect(key->bri);
+        }
+    }
+
+    switch(key->type) {
+    case ANIM_LETTER:
+        sid.clearDisplayDirect();
+        sid.drawLetterAndShow(key->alpha, key->x, key->y);
+        break;
+    case ANIM_BARS:
+        for(int i = 0; i < 10; i++) {
+            sid.clearBar(i);
+            if(key->bars[i][0] != ANIM_NOBAR) {
+                sid.drawBar(i, key->bars[i][0], key->bars[i][1]);
+            }
+        }
+        sid.show();
+        break;
+    case ANIM_FADE:
+        animFadeFrom = animFadeCur = sid.getBrightness();
+        break;
+    case ANIM_CLEAR:
+        sid.clearBuf();
+        sid.clearDisplayDirect();
+        break;
+    case ANIM_ON:
+        sid.on();
+        break;
+    case ANIM_OFF:
+        sid.off();
+        break;
+    }
+}
+
+void anim_loop()
+{
+    while(animCnt) {
+
+        animKey *key = &animQueue[animOut];
+        unsigned long now = sidMillis();
+
+        // Keys start at previous start + dur, not when we get
+        // to them, so lateness does not add up over a sequence
+        if(!animStarted) {
+            animStarted = true;
+            if(animRebase) {
+                animStartNow = now;
+                animRebase = false;
+            }
+            anim_startKey(key);
+        }
+
+        unsigned long el = now - animStartNow;
+
+        if(key->type == ANIM_FADE) {
+            uint8_t level = key->bri;
+            if(el < key->dur) {
+                level = animFadeFrom + (((int)key->bri - (int)animFadeFrom) * (int)el) / (int)key->dur;
+            }
+            if(level != animFadeCur) {
+                sid.setBrightnessDirect(level);
+                animFadeCur = level;
+            }
+        }
+
+        if(el < key->dur)
+            return;
+
+        animOut = (animOut + 1) % ANIM_QUEUE_SIZE;
+        animStarted = false;
+        animStartNow += key->dur;
+        if(!--animCnt && animDoneFn) {
+            animDoneFn();
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Animation engine
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+#ifndef _SID_ANIM_H
+#define _SID_ANIM_H
+
+// Keyframe types
+#define ANIM_WAIT     0   // Do nothing, just wait
+#define ANIM_LETTER   1   // Draw letter and show
+#define ANIM_BARS     2   // Draw bars and show
+#define ANIM_FADE     3   // Ramp brightness to given level during dur
+#define ANIM_CLEAR    4   // Clear display
+#define ANIM_ON       5   // Switch display on
+#define ANIM_OFF      6   // Switch display off
+
+// Brightness on keyframe start
+#define ANIM_BRI_KEEP    0xfe   // Leave as is
+#define ANIM_BRI_RESTORE 0xff   // Restore to current user brightness
+
+#define ANIM_NOBAR    0xff      // bars[][]: Bar empty
+
+typedef struct {
+    uint8_t  type;
+    uint8_t  bri;         // brightness to set on start (direct), or ANIM_BRI_xxx; FADE: target
+    char     alpha;       // LETTER: character
+    int8_t   x, y;        // LETTER: position
+    uint16_t dur;         // ms until next keyframe
+    uint8_t  bars[10][2]; // BARS: { bottom, top } per bar (0=bottom)
+} animKey;
+
+void anim_init(animKey *key, uint8_t type, uint16_t dur = 0, uint8_t bri = ANIM_BRI_KEEP);
+bool anim_add(const animKey *key);
+bool anim_addCmd(uint8_t type, uint16_t dur = 0, uint8_t bri = ANIM_BRI_KEEP);
+bool anim_addLetter(char alpha, int x, int y, uint16_t dur, uint8_t bri = ANIM_BRI_RESTORE);
+int  anim_space();
+void anim_onDone(void (*fn)());
+
+void anim_stop();
+void anim_loop();
+
+bool anim_running();
+
+#endif
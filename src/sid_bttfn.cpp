@@ -0,0 +1,533 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * BTTFN receive state
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#include "sid_bttfn.h"
+
+/*
+ * Post notifications that only trigger something as events.
+ * Returns true if notification was passed on as event.
+ */
+static bool bttfn_rxPost(const BttfnPacket& pkt)
+{
+    if(pkt.isDataNot())
+        return false;
+        
+    switch(pkt.notId()) {
+    case BTTFN_NOT_PREPARE:
+        // Prepare for TT. Comes at some undefined point,
+        // an undefined time before the actual tt, and
+        // may not come at all.
+        // We don't ignore this if TCD is connected by wire,
+        // because this signal does not come via wire.
+        evt_post(EVQ_BTTFN, EVT_PREPARE);
+        break;
+    case BTTFN_NOT_TT:
+        // Trigger Time Travel (if not running already)
+        // Ignored if TCD is connected by wire
+        evt_postTT(EVQ_BTTFN, pkt.ttP0(), pkt.ttP1());
+        break;
+    case BTTFN_NOT_REENTRY:
+        // Start re-entry (if TT currently running)
+        evt_post(EVQ_BTTFN, EVT_REENTRY);
+        break;
+    case BTTFN_NOT_ABORT_TT:
+        // Abort TT (if TT currently running)
+        evt_post(EVQ_BTTFN, EVT_ABORT);
+        break;
+    case BTTFN_NOT_ALARM:
+        evt_post(EVQ_BTTFN, EVT_ALARM);
+        break;
+    case BTTFN_NOT_SID_CMD:
+        evt_postCmd(EVQ_BTTFN, pkt.command());
+        break;
+    case BTTFN_NOT_WAKEUP:
+        evt_post(EVQ_BTTFN, EVT_WAKEUP);
+        break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Sort a valid packet, received through the unicast or (mc = true)
+ * the multicast socket, from addr. tcdAddr is the address of our
+ * TCD (0 = unknown); mirFollow is true if we follow a mirroring 
+ * leader. Called from the receiver.
+ */
+int bttfn_rxSort(const BttfnPacket& pkt, bool mc, uint32_t addr, uint32_t tcdAddr, bool mirFollow)
+{
+    if(mc) {
+        // Do not use tcdHostNameHash; let DISCOVER do its work
+        // and wait for a result. Only notifications from
+        // our TCD are of interest.
+        // Mirroring followers also take pattern state from
+        // any SID; bttfn_mirReceive() picks one.
+        if(!pkt.isNotification())
+            return BTTFN_RX_DROP;
+        if(pkt.notId() == BTTFN_NOT_SID_MIRROR) {
+            if(!mirFollow)
+                return BTTFN_RX_DROP;
+        } else if(!tcdAddr || addr != tcdAddr) {
+            return BTTFN_RX_DROP;
+        }
+    }
+
+    if(pkt.isNotification() && bttfn_rxPost(pkt))
+        return BTTFN_RX_EVENT;
+
+    return BTTFN_RX_MAIN;
+}
+
+/*
+ * Sequence check for NOT_SPD and NOT_DATA
+ *
+ * Packets older than the last accepted one are rejected; #1 is 
+ * always accepted, as the sender starts over with it. If that 
+ * one was lost, we resync after BTTFN_SEQ_RESYNC rejects in a row.
+ */
+void bttfn_seqReset(bttfnSeq *sq)
+{
+    sq->last = 0;
+    sq->outOfSeq = 0;
+}
+
+bool bttfn_seqCheck(bttfnSeq *sq, uint32_t seqCnt, bttfnRxStats *st)
+{
+    if(!sq->last || seqCnt > sq->last || seqCnt == 1) {
+        if(sq->last && seqCnt > sq->last + 1) {
+            st->seqGaps += seqCnt - sq->last - 1;
+        }
+        sq->last = seqCnt;
+        sq->outOfSeq = 0;
+        return true;
+    }
+
+    st->seqRejected++;
+
+    if(++sq->outOfSeq >= BTTFN_SEQ_RESYNC) {
+        sq->last = seqCnt;
+        sq->outOfSeq = 0;
+    }
+    
+    return false;
+}
+
+/*
+ * Build SA band data packet (NOT_SID_SA) from bar heights (0..
+ * barHeight) and peaks (0..barHeight-1). The range is the bar 
+ * height; bars taller than 5 bits allow are scaled to 0..31.
+ * Called for every SA frame, so no allocation; the header is 
+ * only rewritten if the number of bands or the range changed.
+ */
+void bttfn_saBuild(bttfnBuf *buf, uint32_t seq, const int *heights, const uint8_t *peaks, int numBands, int barHeight)
+{
+    BttfnPacket pkt(buf);
+    uint8_t vals[BTTFN_SA_MAXVALS];
+    int range, h, p;
+
+    if(numBands > BTTFN_SA_MAXVALS / 2) numBands = BTTFN_SA_MAXVALS / 2;
+    if(barHeight < 1) barHeight = 1;
+    range = (barHeight > BTTFN_SA_MAXVAL) ? BTTFN_SA_MAXVAL : barHeight;
+
+    if(pkt.saNumBands() != numBands || pkt.saRange() != range) {
+        pkt.init();
+        pkt.setVersion(BTTFN_VERSION | 0x40);
+        pkt.setFlags(BTTFN_NOT_SID_SA);
+        pkt.setSAHeader(numBands, range);
+    }
+
+    for(int i = 0; i < numBands; i++) {
+        h = heights[i];
+        p = peaks[i];
+        if(barHeight > BTTFN_SA_MAXVAL) {
+            h = h * BTTFN_SA_MAXVAL / barHeight;
+            p = p * BTTFN_SA_MAXVAL / barHeight;
+        }
+        vals[i] = (h > range) ? range : ((h < 0) ? 0 : h);
+        vals[numBands + i] = (p > range) ? range : p;
+    }
+
+    pkt.setSeq(seq);
+    pkt.setSAValues(vals, numBands * 2);
+}
+
+/*
+ * Idle mirroring, follower
+ *
+ * Mirror frames are taken from one leader as long as it sends, 
+ * in order; a frame that is not newer than the last one is 
+ * rejected. now must not be 0. Returns true if the frame is to
+ * be shown.
+ */
+bool bttfn_mirAccept(bttfnMirRx *m, const BttfnPacket& pkt, uint32_t addr, unsigned long now, bttfnRxStats *st)
+{
+    int32_t d;
+
+    if(pkt.mirNumBars() != BTTFN_MIR_BARS)
+        return false;
+
+    if(m->now && (now - m->now < BTTFN_MIR_TIMEOUT)) {
+        // Stick with one leader as long as it sends
+        if(addr != m->leader)
+            return false;
+        d = (int32_t)(pkt.mirFrame() - m->frame);
+        if(d <= 0) {
+            st->seqRejected++;
+            return false;
+        }
+        st->mirGaps += d - 1;
+    }
+
+    m->leader = addr;
+    m->frame = pkt.mirFrame();
+    m->now = now;
+    st->mirFrames++;
+
+    return true;
+}
+
+// Following a leader? False once it has been quiet for BTTFN_MIR_TIMEOUT
+bool bttfn_mirActive(bttfnMirRx *m, unsigned long now)
+{
+    if(!m->now)
+        return false;
+
+    if(now - m->now >= BTTFN_MIR_TIMEOUT) {
+        m->now = 0;
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Client state
+ *
+ * tcdAddr is the TCD's address, from the settings, the cache or 
+ * a DISCOVER; if unknown (0), requests are sent as DISCOVER by
+ * multicast. A cached address is tried right away; once it 
+ * answered, the next request is a DISCOVER to validate it (the
+ * TCD answers this with data, too). If it does not answer 
+ * BTTFN_CACHE_TRIES times, it is dropped.
+ */
+void bttfn_cliInit(bttfnClient *c, uint32_t tcdAddr, uint32_t hostHash)
+{
+    memset(c, 0, sizeof(*c));
+    c->tcdAddr = tcdAddr;
+    c->hostHash = hostHash;
+    c->pollInt = BTTFN_POLL_INT;
+}
+
+// Try cached TCD; false if entry is not usable
+bool bttfn_cliUseCache(bttfnClient *c, const bttfnCacheEntry *e)
+{
+    if(!c->hostHash || e->hostHash != c->hostHash || !e->ip)
+        return false;
+
+    c->tcdAddr = e->ip;
+    c->cacheState = BTTFN_CACHE_TRY;
+
+    return true;
+}
+
+// Entry to be saved (without session and caps); false if none
+bool bttfn_cliCacheGet(bttfnClient *c, bttfnCacheEntry *e)
+{
+    // Only what we know to be right
+    if(c->cacheState != BTTFN_CACHE_NONE)
+        return false;
+
+    c->cacheDirty = false;
+
+    if(!c->hostHash || !c->tcdAddr)
+        return false;
+
+    memset(e, 0, sizeof(*e));
+    e->hostHash = c->hostHash;
+    e->ip = c->tcdAddr;
+
+    return true;
+}
+
+// Send next request as DISCOVER by multicast?
+bool bttfn_cliDiscover(const bttfnClient *c)
+{
+    return !c->tcdAddr || (c->cacheState == BTTFN_CACHE_VALIDATE);
+}
+
+// Request queued; returns its ID. reqStamp is to be set when sent.
+uint32_t bttfn_cliRequest(bttfnClient *c, unsigned long now)
+{
+    c->reqId = (uint32_t)now;
+    c->reqAge = now;
+    c->packetDue = true;
+
+    return c->reqId;
+}
+
+bool bttfn_cliPollDue(const bttfnClient *c, unsigned long now)
+{
+    if(c->notData || c->packetDue)
+        return false;
+
+    return (!c->updateNow || (now - c->updateNow > bttfn_cliPollInt(c)));
+}
+
+/*
+ * Adaptive polling
+ *
+ * While the TCD's data (speed, status) is unchanged, the poll
+ * interval is doubled with each response, up to 8 times; any
+ * change snaps it back. If the TCD supports NOT_DATA, it will
+ * push changes once it has registered us, so the interval is
+ * stretched right away. Date/time is not considered; it changes
+ * every minute and is only used for the clock.
+ */
+static void bttfn_cliPollBackoff(bttfnClient *c, const BttfnPacket& pkt)
+{
+    uint8_t flags = pkt.flags();
+    uint32_t sig = 0;
+
+    if(flags & BTTFN_RSP_SPEED)  sig |= (uint16_t)pkt.speed();
+    if(flags & BTTFN_RSP_STATUS) sig |= (uint32_t)pkt.status() << 16;
+    if(flags & BTTFN_RSP_CAPS)   sig |= (uint32_t)pkt.caps() << 24;
+
+    if(sig != c->pollSig) {
+        c->pollSig = sig;
+        c->pollShift = c->supportsNOTData ? BTTFN_POLL_SHIFT_MAX : 0;
+    } else if(c->supportsNOTData) {
+        c->pollShift = BTTFN_POLL_SHIFT_MAX;
+    } else if(c->pollShift < BTTFN_POLL_SHIFT_MAX) {
+        c->pollShift++;
+    }
+}
+
+unsigned long bttfn_cliPollInt(const bttfnClient *c)
+{
+    // No stretching when polling fast for speed
+    if(c->pollInt < BTTFN_POLL_INT)
+        return c->pollInt;
+
+    return c->pollInt << c->pollShift;
+}
+
+/*
+ * Response to a request, from addr, arrived at stamp (micros()).
+ * The caller evaluates the data unless BTTFN_CLI_IGNORED is
+ * returned; on BTTFN_CLI_NEWTCD, it tells the receiver.
+ */
+int bttfn_cliResponse(bttfnClient *c, const BttfnPacket& pkt, uint32_t addr, uint32_t stamp)
+{
+    int ret = BTTFN_CLI_OK;
+
+    if(pkt.reqId() != c->reqId)
+        return BTTFN_CLI_IGNORED;
+
+    // Response marker missing or wrong version, bail
+    if(!pkt.isResponse())
+        return BTTFN_CLI_IGNORED;
+
+    bttfn_cliRttSample(c, stamp - c->reqStamp);
+
+    c->failCount = 0;
+
+    // If it's our expected packet, no other is due for now
+    c->packetDue = false;
+
+    if(pkt.flags() & BTTFN_RSP_DISCOVER) {
+        if(!c->tcdAddr || (c->cacheState == BTTFN_CACHE_VALIDATE && addr != c->tcdAddr)) {
+            c->tcdAddr = addr;
+            bttfn_cliRttReset(c);
+            c->cacheDirty = true;
+            ret = BTTFN_CLI_NEWTCD;
+        } else if(c->cacheState != BTTFN_CACHE_VALIDATE) {
+            #ifdef SID_DBG_NET
+            Serial.println("Internal error - received unexpected DISCOVER response");
+            #endif
+        }
+        c->cacheState = BTTFN_CACHE_NONE;
+    } else if(c->cacheState == BTTFN_CACHE_TRY) {
+        // Cached IP answered; validate it by a DISCOVER
+        // with the next request
+        c->cacheState = BTTFN_CACHE_VALIDATE;
+    }
+
+    bttfn_cliPollBackoff(c, pkt);
+
+    return ret;
+}
+
+// Returns true if the TCD address was dropped
+bool bttfn_cliTimeout(bttfnClient *c, unsigned long now)
+{
+    if(c->notData || !c->packetDue)
+        return false;
+
+    if(now - c->reqAge <= BTTFN_RESPONSE_TO)
+        return false;
+
+    // Packet timed out
+    c->packetDue = false;
+    // Immediately trigger new request for
+    // the first 10 timeouts, after that
+    // the new request is only triggered
+    // in greater intervals via bttfn_loop().
+    if(c->tcdAddr && c->failCount < 10) {
+        c->failCount++;
+        c->updateNow = 0;
+    }
+    c->pollShift = 0;
+    // Cached IP does not answer: Forget it, DISCOVER
+    if(c->cacheState == BTTFN_CACHE_TRY && c->failCount >= BTTFN_CACHE_TRIES) {
+        #ifdef SID_DBG_NET
+        Serial.println("BTTFN: Cached TCD IP does not answer");
+        #endif
+        c->cacheState = BTTFN_CACHE_NONE;
+        c->tcdAddr = 0;
+        c->failCount = 0;
+        return true;
+    }
+
+    return false;
+}
+
+// NOT_DATA arrived; returns false if the TCD is not known to support it
+bool bttfn_cliNotData(bttfnClient *c, unsigned long now)
+{
+    if(!c->supportsNOTData)
+        return false;
+
+    c->notData = true;
+    c->lastNotData = now;
+
+    return true;
+}
+
+// Returns true if NOT_DATA timed out and polling resumes
+bool bttfn_cliDataTimeout(bttfnClient *c, unsigned long now)
+{
+    if(!c->notData || (now - c->lastNotData <= BTTFN_DATA_TO))
+        return false;
+
+    c->notData = false;
+    c->pollShift = 0;
+
+    // TCD might have got new IP address: Keep trying
+    // the current one, but re-do DISCOVER in the
+    // background (or right away if it does not answer)
+    if(c->hostHash && c->tcdAddr) {
+        c->cacheState = BTTFN_CACHE_TRY;
+        c->failCount = 0;
+    }
+
+    return true;
+}
+
+/*
+ * Round trip / transit delay estimation
+ *
+ * Each response echoes the ID of our request, so its round trip
+ * time is known exactly. BTTFN packets carry no time stamps of
+ * the TCD's clock, so, as in NTP, the path is assumed to be
+ * symmetric: A notification was sent half a round trip before
+ * it arrived. Like NTP's clock filter, we use the lowest of the
+ * last BTTFN_RTT_SAMPLES round trips, as that one suffered least
+ * from queuing and retransmissions.
+ */
+void bttfn_cliRttSample(bttfnClient *c, uint32_t rtt)
+{
+    bttfnClockStats *clk = &c->clk;
+    uint32_t rttMin = rtt;
+    int32_t  err;
+    int      n;
+
+    c->rttSamp[c->rttIdx] = rtt;
+    c->rttIdx = (c->rttIdx + 1) % BTTFN_RTT_SAMPLES;
+    clk->samples++;
+
+    n = (clk->samples < BTTFN_RTT_SAMPLES) ? clk->samples : BTTFN_RTT_SAMPLES;
+    for(int i = 0; i < n; i++) {
+        if(c->rttSamp[i] < rttMin) rttMin = c->rttSamp[i];
+    }
+
+    // Smoothed RTT and deviation as in RFC 6298
+    if(clk->samples == 1) {
+        clk->srtt = rtt;
+        clk->rttVar = rtt / 2;
+    } else {
+        err = (int32_t)rtt - (int32_t)clk->srtt;
+        clk->rttVar += ((int32_t)abs(err) - (int32_t)clk->rttVar) / 4;
+        clk->srtt += err / 8;
+    }
+    
+    clk->rtt = rtt;
+    clk->rttMin = rttMin;
+    clk->delay = rttMin / 2;
+
+    #ifdef SID_DBG_NET
+    Serial.printf("BTTFN: RTT %dus, min %dus, srtt %dus\n", rtt, rttMin, clk->srtt);
+    #endif
+}
+
+void bttfn_cliRttReset(bttfnClient *c)
+{
+    c->rttIdx = 0;
+    memset(&c->clk, 0, sizeof(c->clk));
+}
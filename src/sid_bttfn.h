@@ -0,0 +1,553 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * BTTFN packet format
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+#ifndef _SID_BTTFN_H
+#define _SID_BTTFN_H
+
+#include <string.h>
+
+#include "sid_event.h"
+
+/*
+ * Basic Telematics Transmission Framework (BTTFN): Packet format
+ *
+ * All packets are BTTF_PACKET_SIZE bytes:
+ *  0-3   "BTTF"
+ *  4     Version; 0x40 notification, 0x80 response (from TCD),
+ *        0x80/0x40 supports MC/ND (in requests)
+ *  5     Request/response flags, or notification ID
+ *  6-46  Payload, depends on packet type (see accessors)
+ *  47    Checksum: Sum of (byte ^ 0x55) over bytes 4-46
+ *
+ * Multi-byte values are little-endian.
+ *
+ * SA band data (NOT_SID_SA): Sent by the SID to the notification
+ * multicast group (port BTTF_DEFAULT_LOCAL_PORT + 2) once per SA 
+ * frame, if enabled. Receivers must filter notifications by 
+ * source anyway, so this does not disturb existing devices.
+ *  6-9   Sequence number
+ *  10    Device type (BTTFN_TYPE_SID)
+ *  11    Number of bands (n)
+ *  12    Bar height range (values are 0..range); the SID's bar 
+ *        height, at most 31 (taller bars are scaled down)
+ *  13-   n bar heights, then n peaks, 5 bits each, LSB first
+ *
+ * Pattern state (NOT_SID_MIRROR): Sent by a SID configured as
+ * mirroring leader to the notification multicast group for every 
+ * idle pattern frame. Followers render the very same frame from it.
+ *  6-9   Frame number
+ *  10    Device type (BTTFN_TYPE_SID)
+ *  11    Number of bars
+ *  12    Baseline
+ *  13    Strict baseline (index into TT sequence)
+ *  14    Variation
+ *  15-16 showBaseLine() flags
+ *  17-20 RNG state before frame
+ *  21-24 Time into backlot sequence (ms)
+ *  25    Bit 0: strict baseline going up
+ *  26-32 Previous bar heights, 5 bits each, LSB first
+ */
+
+#define BTTF_PACKET_SIZE        48
+
+#define BTTFN_VERSION            1
+#define BTTFN_SUP_MC          0x80
+#define BTTFN_SUP_ND          0x40
+
+#define BTTFN_TYPE_ANY     0    // Any, unknown or no device
+#define BTTFN_TYPE_FLUX    1    // Flux Capacitor
+#define BTTFN_TYPE_SID     2    // SID
+#define BTTFN_TYPE_PCG     3    // Dash Gauges
+#define BTTFN_TYPE_VSR     4    // VSR
+#define BTTFN_TYPE_AUX     5    // Aux (user custom device)
+#define BTTFN_TYPE_REMOTE  6    // Futaba remote control
+
+#define BTTFN_NOT_PREPARE  1
+#define BTTFN_NOT_TT       2
+#define BTTFN_NOT_REENTRY  3
+#define BTTFN_NOT_ABORT_TT 4
+#define BTTFN_NOT_ALARM    5
+#define BTTFN_NOT_REFILL   6
+#define BTTFN_NOT_FLUX_CMD 7
+#define BTTFN_NOT_SID_CMD  8
+#define BTTFN_NOT_PCG_CMD  9
+#define BTTFN_NOT_WAKEUP   10
+#define BTTFN_NOT_AUX_CMD  11
+#define BTTFN_NOT_VSR_CMD  12
+#define BTTFN_NOT_SPD      15
+#define BTTFN_NOT_INFO     16
+#define BTTFN_NOT_SID_SA   64   // SA band data, sent by SID
+#define BTTFN_NOT_SID_MIRROR 65 // Idle pattern state, sent by leading SID
+#define BTTFN_NOT_DATA     128  // bit only, not value
+
+#define BTTFN_REMCMD_KP_PING    4
+#define BTTFN_REMCMD_KP_KEY     5
+#define BTTFN_REMCMD_KP_BYE     6
+#define BTTFN_REM_MAX_COMMAND   BTTFN_REMCMD_KP_BYE
+#define BTTFN_REMCMD_KEEPALIVE 101
+
+#define BTTFN_SSRC_NONE         0
+#define BTTFN_SSRC_GPS          1
+#define BTTFN_SSRC_ROTENC       2
+#define BTTFN_SSRC_REM          3
+#define BTTFN_SSRC_P0           4
+#define BTTFN_SSRC_P1           5
+#define BTTFN_SSRC_P2           6
+
+#define BTTFN_TCDI1_NOREM     0x0001
+#define BTTFN_TCDI1_NOREMKP   0x0002
+#define BTTFN_TCDI1_EXT       0x0004
+#define BTTFN_TCDI1_OFF       0x0008
+#define BTTFN_TCDI1_NM        0x0010
+#define BTTFN_TCDI2_BUSY      0x0001
+#define BTTFN_TCDI2_TIMEINFO  0x8000
+
+// Response flags (byte 5)
+#define BTTFN_RSP_DATETIME    0x01
+#define BTTFN_RSP_SPEED       0x02
+#define BTTFN_RSP_STATUS      0x10
+#define BTTFN_RSP_CAPS        0x40
+#define BTTFN_RSP_DISCOVER    0x80
+
+// Capabilities (response, byte 31)
+#define BTTFN_CAP_MCSPD       0x01
+#define BTTFN_CAP_REMKP       0x08
+#define BTTFN_CAP_NOTDATA     0x10
+#define BTTFN_CAP_SSID        0x40
+
+// Status (response, byte 26)
+#define BTTFN_STAT_NM         0x01
+#define BTTFN_STAT_FPO        0x02
+#define BTTFN_STAT_REMOTE     0x08
+#define BTTFN_STAT_BUSY       0x10
+#define BTTFN_STAT_SPDREM     0x20
+#define BTTFN_STAT_SPDRE      0x80
+
+// SA band data
+#define BTTFN_SA_BITS         5
+#define BTTFN_SA_MAXVALS      ((BTTF_PACKET_SIZE - 1 - 13) * 8 / BTTFN_SA_BITS)
+#define BTTFN_SA_MAXVAL       ((1 << BTTFN_SA_BITS) - 1)
+
+// Pattern mirroring
+#define BTTFN_MIR_BARS        10
+
+// Buffer for a packet; word-aligned for the checksum
+typedef union {
+    uint8_t  b[BTTF_PACKET_SIZE];
+    uint32_t w[BTTF_PACKET_SIZE / 4];
+} bttfnBuf;
+
+/*
+ * View on a packet in a bttfnBuf; does not copy.
+ */
+class BttfnPacket {
+
+    public:
+        BttfnPacket(bttfnBuf *buf) : _b(buf->b), _w(buf->w) {}
+
+        // Header and checksum ok
+        bool valid() const
+        {
+            return (_w[0] == hdrWord()) && (_b[BTTF_PACKET_SIZE - 1] == checksum());
+        }
+
+        // Recompute checksum. Not needed for packets built by
+        // init() and the setters below, which keep it valid by
+        // updating it for every byte they change.
+        void seal()
+        {
+            _b[BTTF_PACKET_SIZE - 1] = checksum();
+        }
+
+        // Packet type
+        bool isNotification() const { return (_b[4] & 0x4f) == (BTTFN_VERSION | 0x40); }
+        bool isResponse() const     { return (_b[4] & 0x8f) == (BTTFN_VERSION | 0x80); }
+        uint8_t flags() const       { return _b[5]; }         // request/response flags
+        uint8_t notId() const       { return _b[5]; }         // notification id
+        bool isDataNot() const      { return !!(_b[5] & BTTFN_NOT_DATA); }
+
+        // Response (and NOT_DATA notification)
+        uint32_t reqId() const      { return get32(6); }
+        const uint8_t *dateTime() const { return &_b[10]; }   // 8 bytes
+        int16_t  speed() const      { return (int16_t)get16(18); }
+        uint8_t  status() const     { return _b[26]; }
+        uint8_t  caps() const       { return _b[31]; }
+        const uint8_t *ssid() const { return &_b[41]; }       // 6 bytes...
+        uint8_t  ssid7() const      { return _b[18]; }        // ...plus 7th
+        bool     pwMarker() const   { return !!(_b[19] & 0x01); }
+        uint32_t dataSeq() const    { return get32(6); }
+        uint32_t dataSession() const { return get32(27); }
+
+        // NOT_SPD
+        int16_t  spdSpeed() const   { return (int16_t)get16(6); }
+        uint16_t spdSource() const  { return get16(8); }
+        uint32_t spdSeq() const     { return get32(12); }
+
+        // NOT_TT
+        uint16_t ttP0() const       { return get16(6); }
+        uint16_t ttP1() const       { return get16(8); }
+
+        // NOT_SID_CMD
+        uint32_t command() const    { return get32(6); }
+
+        // NOT_INFO
+        uint16_t info1() const      { return get16(6); }
+        uint16_t info2() const      { return get16(8); }
+        const uint8_t *infoDateTime() const { return &_b[16]; }   // 8 bytes
+
+        // NOT_SID_SA
+        uint8_t  saNumBands() const { return _b[11]; }
+        uint8_t  saRange() const    { return _b[12]; }
+        uint8_t  saValue(int i) const { return get5(13, i); }   // 0..n-1 heights, n..2n-1 peaks
+        void setSAHeader(uint8_t numBands, uint8_t range)
+        {
+            put8(10, BTTFN_TYPE_SID); put8(11, numBands); put8(12, range);
+        }
+        void setSAValues(const uint8_t *vals, int cnt)     // cnt <= BTTFN_SA_MAXVALS
+        {
+            set5(13, vals, cnt);
+        }
+
+        // NOT_SID_MIRROR
+        uint32_t mirFrame() const   { return get32(6); }
+        uint8_t  mirNumBars() const { return _b[11]; }
+        uint8_t  mirBaseLine() const { return _b[12]; }
+        uint8_t  mirStrictBL() const { return _b[13]; }
+        uint8_t  mirVariation() const { return _b[14]; }
+        uint16_t mirFlags() const   { return get16(15); }
+        uint32_t mirSeed() const    { return get32(17); }
+        uint32_t mirSeqTime() const { return get32(21); }
+        bool     mirWayUp() const   { return !!(_b[25] & 0x01); }
+        uint8_t  mirHeight(int i) const { return get5(26, i); }
+        void setMirState(uint8_t bl, uint8_t sbl, uint8_t var, uint16_t flags, bool wayUp)
+        {
+            put8(10, BTTFN_TYPE_SID); put8(11, BTTFN_MIR_BARS);
+            put8(12, bl); put8(13, sbl); put8(14, var);
+            put8(15, flags); put8(16, flags >> 8);
+            put8(25, wayUp ? 0x01 : 0);
+        }
+        void setMirSeed(uint32_t seed)  { set32(17, seed); }
+        void setMirSeqTime(uint32_t t)  { set32(21, t); }
+        void setMirHeights(const uint8_t *h, int cnt)      // cnt <= BTTFN_MIR_BARS
+        {
+            set5(26, h, cnt);
+        }
+
+        // Requests/commands
+        void init()                 { memset(_b, 0, BTTF_PACKET_SIZE); _w[0] = hdrWord(); seal(); }
+        void setVersion(uint8_t v)  { put8(4, v); }
+        void setFlags(uint8_t f)    { put8(5, f); }
+        void setReqId(uint32_t id)  { set32(6, id); }
+        void setSeq(uint32_t s)     { set32(6, s); }
+        void setHostname(const char *hn)
+        {
+            // 13 bytes. If hostname is longer, last in buf is '.'
+            for(int i = 0; i < 13; i++) {
+                put8(10 + i, *hn);
+                if(*hn) hn++;
+            }
+            if(*hn) put8(10+12, '.');
+        }
+        void setDevType(uint8_t t)  { put8(10+13, t); }
+        void setCommand(uint8_t cmd, uint8_t p1, uint8_t p2)
+        {
+            put8(25, cmd); put8(26, p1); put8(27, p2);
+        }
+        void setHostHash(uint32_t h) { set32(31, h); }
+        void setRemID(uint32_t id)  { set32(35, id); }
+
+    private:
+        static uint32_t hdrWord()
+        {
+            const uint8_t h[4] = { 'B', 'T', 'T', 'F' };
+            uint32_t w;
+            memcpy(&w, h, 4);
+            return w;
+        }
+
+        // Byte sum of bytes 4-46, each xor 0x55; summed in
+        // 16-bit lanes (43 * 255 fits)
+        uint8_t checksum() const
+        {
+            uint32_t acc = 0, w;
+            for(int i = 1; i < (BTTF_PACKET_SIZE / 4) - 1; i++) {
+                w = _w[i] ^ 0x55555555;
+                acc += (w & 0x00ff00ff) + ((w >> 8) & 0x00ff00ff);
+            }
+            // Last word: bytes 44-46, without checksum byte
+            for(int i = BTTF_PACKET_SIZE - 4; i < BTTF_PACKET_SIZE - 1; i++) {
+                acc += _b[i] ^ 0x55;
+            }
+            return (uint8_t)((acc & 0xffff) + (acc >> 16));
+        }
+        
+        // Packed 5-bit values, LSB first
+        uint8_t get5(int o, int i) const
+        {
+            int bit = i * BTTFN_SA_BITS;
+            uint16_t v = _b[o + (bit >> 3)] | (_b[o + (bit >> 3) + 1] << 8);
+            return (v >> (bit & 7)) & ((1 << BTTFN_SA_BITS) - 1);
+        }
+        void set5(int o, const uint8_t *vals, int cnt)
+        {
+            uint32_t acc = 0;
+            int bits = 0;
+            for(int i = 0; i < cnt; i++) {
+                acc |= (uint32_t)vals[i] << bits;
+                bits += BTTFN_SA_BITS;
+                while(bits >= 8) {
+                    put8(o++, acc); acc >>= 8; bits -= 8;
+                }
+            }
+            if(bits) put8(o, acc);
+        }
+
+        uint16_t get16(int o) const { return _b[o] | (_b[o+1] << 8); }
+        uint32_t get32(int o) const 
+        {
+            return _b[o] | (_b[o+1] << 8) | (_b[o+2] << 16) | ((uint32_t)_b[o+3] << 24);
+        }
+        void set32(int o, uint32_t v)
+        {
+            put8(o, v); put8(o+1, v >> 8); put8(o+2, v >> 16); put8(o+3, v >> 24);
+        }
+
+        // Set byte (4-46) and update checksum (sum of byte ^ 0x55)
+        void put8(int o, uint8_t v)
+        {
+            _b[BTTF_PACKET_SIZE - 1] += (uint8_t)(v ^ 0x55) - (uint8_t)(_b[o] ^ 0x55);
+            _b[o] = v;
+        }
+
+        uint8_t  *_b;
+        uint32_t *_w;
+};
+
+/*
+ * Receiver
+ *
+ * Packets are received in their own task, time-stamped on arrival
+ * and passed to main_loop() through a ring. Notifications that
+ * only trigger something (TT, re-entry, commands, etc) are posted 
+ * to the BTTFN event queue directly.
+ */
+
+#define BTTFN_RX_RING     16      // packets; must be power of 2
+#define BTTFN_RX_WAIT     1000    // ms; max time receiver blocks
+
+// Latency: Time between arrival and handling in main_loop(),
+// in us; same buckets as event queues (evtLatLimits)
+typedef struct {
+    uint32_t received;
+    uint32_t invalid;             // wrong size, header or checksum
+    uint32_t dropped;             // ring full
+    uint32_t posted;              // passed on as events
+    uint32_t handled;
+    uint32_t latMax;
+    uint64_t latTotal;
+    uint32_t hist[EVT_LAT_BUCKETS];
+    uint32_t seqRejected;         // NOT_SPD/NOT_DATA out of sequence
+    uint32_t seqGaps;             // NOT_SPD/NOT_DATA missing (lost or late)
+    uint32_t procMax;             // us spent handling a packet
+    uint64_t procTotal;
+    uint32_t ttCount;             // TT notification to start of sequence
+    uint32_t ttLatLast;
+    uint32_t ttLatMax;
+    uint32_t sent;
+    uint32_t txErrors;            // sendto() failed
+    uint32_t txDropped;           // transmit queue full
+    uint32_t txQueueMax;          // max packets queued at once
+    uint32_t saSent;              // SA band data frames
+    uint32_t saErrors;            // SA frames not sent (send failed)
+    uint32_t mirFrames;           // Mirroring: frames sent (leader) or received (follower)
+    uint32_t mirGaps;             // Mirroring: frames missed (follower)
+    uint16_t rxPerMin;            // packets during last full minute
+    uint16_t txPerMin;
+    uint16_t pollInt;             // ms; current poll interval, 0 if on NOT_DATA
+} bttfnRxStats;
+
+void bttfn_getRxStats(bttfnRxStats *st);
+
+/*
+ * Receive state (sid_bttfn.cpp)
+ *
+ * Sorting of incoming packets and the sequence checks for the 
+ * NOT_SPD and NOT_DATA streams, and building of SA band data. 
+ * Platform-independent, so that it can be built, tested and 
+ * benchmarked on a host (see tools/host).
+ */
+
+// bttfn_rxSort() results
+#define BTTFN_RX_DROP     0       // not for us
+#define BTTFN_RX_EVENT    1       // posted to EVQ_BTTFN
+#define BTTFN_RX_MAIN     2       // to be handled by main_loop()
+
+// After this many consecutive out-of-sequence packets, assume 
+// the sender restarted and we missed its packet #1
+#define BTTFN_SEQ_RESYNC  3
+
+typedef struct {
+    uint32_t last;                // last accepted; 0 = none yet
+    uint8_t  outOfSeq;            // consecutive rejects
+} bttfnSeq;
+
+int  bttfn_rxSort(const BttfnPacket& pkt, bool mc, uint32_t addr, uint32_t tcdAddr, bool mirFollow);
+void bttfn_seqReset(bttfnSeq *sq);
+bool bttfn_seqCheck(bttfnSeq *sq, uint32_t seqCnt, bttfnRxStats *st);
+
+// SA band data packet; buf keeps its header between frames
+void bttfn_saBuild(bttfnBuf *buf, uint32_t seq, const int *heights, const uint8_t *peaks, int numBands, int barHeight);
+
+// Idle mirroring, follower: Leader followed
+#define BTTFN_MIR_TIMEOUT 3000    // ms; follower falls back to own pattern
+
+typedef struct {
+    uint32_t      leader;         // address of leader
+    uint32_t      frame;          // last frame number received
+    unsigned long now;            // when last frame was received; 0 = not following
+} bttfnMirRx;
+
+bool bttfn_mirAccept(bttfnMirRx *m, const BttfnPacket& pkt, uint32_t addr, unsigned long now, bttfnRxStats *st);
+bool bttfn_mirActive(bttfnMirRx *m, unsigned long now);
+
+/*
+ * Round trip / transit delay estimate
+ */
+
+#define BTTFN_RTT_SAMPLES     8       // clock filter size
+#define BTTFN_RTT_PROBE_INT   30000   // ms; probe interval while on NOT_DATA
+
+// Times in us
+typedef struct {
+    uint32_t samples;
+    uint32_t rtt;                 // last sample
+    uint32_t rttMin;              // minimum of last BTTFN_RTT_SAMPLES
+    uint32_t srtt;                // smoothed
+    uint32_t rttVar;              // smoothed deviation (jitter)
+    uint32_t delay;               // transit delay deducted from TT lead
+} bttfnClockStats;
+
+void bttfn_getClockStats(bttfnClockStats *st);
+
+/*
+ * Client state (sid_bttfn.cpp)
+ *
+ * Finding the TCD (address from settings, from the cache or by
+ * DISCOVER), matching responses to requests, response timeouts,
+ * adaptive polling and the round trip estimate. The caller sends 
+ * the requests and evaluates the data; see bttfn_loop().
+ */
+
+#define BTTFN_POLL_INT          1000
+#define BTTFN_POLL_SHIFT_MAX       3    // Poll interval stretched up to 8 times while data unchanged
+#define BTTFN_RESPONSE_TO        700
+#define BTTFN_DATA_TO          16200    // NOT_DATA missing for this long: back to polling
+#define BTTFN_CACHE_TRIES          3    // Unanswered requests until cache is dropped
+
+// TCD cache: Last discovered TCD; tried right away at boot,
+// validated by a DISCOVER in the background.
+enum {
+    BTTFN_CACHE_NONE = 0,         // TCD IP from settings or DISCOVER
+    BTTFN_CACHE_TRY,              // Trying cached IP
+    BTTFN_CACHE_VALIDATE,         // Cached IP answered, DISCOVER pending
+};
+
+typedef struct [[gnu::packed]] {
+    uint32_t hostHash;            // hostHash of entry
+    uint32_t ip;
+    uint32_t sessionID;
+    uint8_t  caps;
+} bttfnCacheEntry;
+
+// bttfn_cliResponse() results
+#define BTTFN_CLI_IGNORED     0   // not the response we wait for
+#define BTTFN_CLI_OK          1
+#define BTTFN_CLI_NEWTCD      2   // TCD address learned or changed
+
+typedef struct {
+    uint32_t      tcdAddr;        // 0 = unknown
+    uint32_t      hostHash;       // TCD given by hostname; 0 = by IP
+    uint8_t       cacheState;
+    bool          cacheDirty;     // cache entry outdated
+    bool          supportsNOTData;
+    bool          notData;        // TCD sends NOT_DATA; no polling
+    bool          packetDue;      // response to reqId outstanding
+    uint8_t       failCount;      // unanswered requests in a row
+    uint32_t      reqId;
+    uint32_t      reqStamp;       // micros() when request was sent
+    unsigned long reqAge;         // ms when request was queued
+    unsigned long updateNow;      // ms of last request; 0 = request now
+    unsigned long lastNotData;
+    unsigned long pollInt;        // base poll interval
+    uint8_t       pollShift;
+    uint32_t      pollSig;
+    uint32_t      rttSamp[BTTFN_RTT_SAMPLES];
+    uint8_t       rttIdx;
+    bttfnClockStats clk;
+} bttfnClient;
+
+void          bttfn_cliInit(bttfnClient *c, uint32_t tcdAddr, uint32_t hostHash);
+bool          bttfn_cliUseCache(bttfnClient *c, const bttfnCacheEntry *e);
+bool          bttfn_cliCacheGet(bttfnClient *c, bttfnCacheEntry *e);
+bool          bttfn_cliDiscover(const bttfnClient *c);
+uint32_t      bttfn_cliRequest(bttfnClient *c, unsigned long now);
+bool          bttfn_cliPollDue(const bttfnClient *c, unsigned long now);
+unsigned long bttfn_cliPollInt(const bttfnClient *c);
+int           bttfn_cliResponse(bttfnClient *c, const BttfnPacket& pkt, uint32_t addr, uint32_t stamp);
+bool          bttfn_cliTimeout(bttfnClient *c, unsigned long now);
+bool          bttfn_cliNotData(bttfnClient *c, unsigned long now);
+bool          bttfn_cliDataTimeout(bttfnClient *c, unsigned long now);
+void          bttfn_cliRttSample(bttfnClient *c, uint32_t rtt);
+void          bttfn_cliRttReset(bttfnClient *c);
+
+#endif
@@ -0,0 +1,256 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Event queue
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#include "sid_event.h"
+#include "sid_sched.h"
+#include "sid_mem.h"
+
+/*
+ * Event queues
+ *
+ * Network callbacks post typed, time-stamped events here instead
+ * of setting global flags; main_loop() retrieves them in order of
+ * posting. Each queue has exactly one producer and one consumer,
+ * so no locks are needed: The producer only writes "head", the 
+ * consumer only writes "tail"; both are free-running counters. 
+ * The slot is written before head is published (release), and 
+ * read after head was observed (acquire), which also holds if 
+ * producer and consumer run on different cores.
+ */
+
+#define EVT_MASK (EVT_QUEUE_SIZE - 1)
+
+typedef struct {
+    sidEvent ring[EVT_QUEUE_SIZE];
+    uint32_t head;              // written by producer
+    uint32_t tail;              // written by consumer
+    evtStats st;
+} evtQueue;
+
+static evtQueue queues[EVQ_NUM];
+
+const char *evtQueueNames[EVQ_NUM] = {
+    "BTTFN", "MQTT", "Network", "Held"
+};
+
+const uint32_t evtLatLimits[EVT_LAT_BUCKETS - 1] = {
+    100, 500, 1000, 5000, 10000, 50000, 100000
+};
+
+static bool evt_push(int q, const sidEvent *ev)
+{
+    evtQueue *eq = &queues[q];
+    uint32_t head = eq->head;
+    
+    if(head - __atomic_load_n(&eq->tail, __ATOMIC_ACQUIRE) >= EVT_QUEUE_SIZE) {
+        eq->st.dropped++;
+        #ifdef SID_DBG
+        Serial.printf("evt_push: Queue %s full, event %d dropped\n", evtQueueNames[q], ev->type);
+        #endif
+        return false;
+    }
+
+    eq->ring[head & EVT_MASK] = *ev;
+    __atomic_store_n(&eq->head, head + 1, __ATOMIC_RELEASE);
+    eq->st.posted++;
+
+    // Cut short main loop's sleep
+    sched_wake();
+
+    return true;
+}
+
+static bool evt_postEvent(int q, sidEvent *ev)
+{
+    if(q < 0 || q >= EVQ_NUM)
+        return false;
+    
+    ev->src = q;
+    ev->stamp = micros();
+    
+    return evt_push(q, ev);
+}
+
+bool evt_post(int q, uint8_t type)
+{
+    sidEvent ev;
+
+    ev.type = type;
+    ev.u.cmd = 0;
+
+    return evt_postEvent(q, &ev);
+}
+
+bool evt_postTT(int q, uint16_t lead, uint16_t p1)
+{
+    sidEvent ev;
+
+    ev.type = EVT_TT;
+    ev.u.tt.lead = lead;
+    ev.u.tt.p1 = p1;
+
+    return evt_postEvent(q, &ev);
+}
+
+bool evt_postCmd(int q, uint32_t cmd)
+{
+    sidEvent ev;
+
+    if(!cmd) return false;
+
+    ev.type = EVT_CMD;
+    ev.u.cmd = cmd;
+
+    return evt_postEvent(q, &ev);
+}
+
+bool evt_postMsg(int q, const char *msg)
+{
+    sidEvent ev;
+
+    ev.type = EVT_MSG;
+    strncpy(ev.u.msg, msg, EVT_MSG_LEN - 1);
+    ev.u.msg[EVT_MSG_LEN - 1] = 0;
+
+    return evt_postEvent(q, &ev);
+}
+
+bool evt_postUpdVers(int q, int v, int r)
+{
+    sidEvent ev;
+
+    ev.type = EVT_UPDVERS;
+    ev.u.vers.v = v;
+    ev.u.vers.r = r;
+
+    return evt_postEvent(q, &ev);
+}
+
+// Re-post an event, keeping its original source and time stamp
+bool evt_requeue(int q, const sidEvent *ev)
+{
+    if(q < 0 || q >= EVQ_NUM)
+        return false;
+    
+    return evt_push(q, ev);
+}
+
+bool evt_pending(int q)
+{
+    evtQueue *eq = &queues[q];
+    
+    return (__atomic_load_n(&eq->head, __ATOMIC_ACQUIRE) != eq->tail);
+}
+
+bool evt_get(int q, sidEvent *ev)
+{
+    evtQueue *eq = &queues[q];
+    uint32_t tail = eq->tail;
+    uint32_t lat;
+    int b;
+
+    if(__atomic_load_n(&eq->head, __ATOMIC_ACQUIRE) == tail)
+        return false;
+
+    *ev = eq->ring[tail & EVT_MASK];
+    __atomic_store_n(&eq->tail, tail + 1, __ATOMIC_RELEASE);
+
+    lat = micros() - ev->stamp;
+    for(b = 0; b < EVT_LAT_BUCKETS - 1; b++) {
+        if(lat < evtLatLimits[b]) break;
+    }
+    eq->st.hist[b]++;
+    eq->st.handled++;
+    eq->st.latTotal += lat;
+    if(lat > eq->st.latMax) eq->st.latMax = lat;
+
+    return true;
+}
+
+// Get oldest event from all producer queues (ie not EVQ_HELD)
+bool evt_getNext(sidEvent *ev)
+{
+    int q = -1;
+    uint32_t now = micros(), age = 0;
+
+    for(int i = 0; i < EVQ_HELD; i++) {
+        evtQueue *eq = &queues[i];
+        uint32_t tail = eq->tail;
+        if(__atomic_load_n(&eq->head, __ATOMIC_ACQUIRE) != tail) {
+            uint32_t a = now - eq->ring[tail & EVT_MASK].stamp;
+            if(q < 0 || a > age) {
+                q = i;
+                age = a;
+            }
+        }
+    }
+
+    return (q >= 0) ? evt_get(q, ev) : false;
+}
+
+// Counters are updated without locking; a snapshot may be
+// slightly inconsistent, which is fine for statistics.
+void evt_getStats(int q, evtStats *st)
+{
+    *st = queues[q].st;
+}
+
+void evt_getMemUse(memUse *m)
+{
+    m->staticBytes = sizeof(queues);
+}
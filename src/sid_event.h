@@ -0,0 +1,139 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Event queue
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef _SID_EVENT_H
+#define _SID_EVENT_H
+
+/*
+ * Event queues: One single-producer/single-consumer ring per 
+ * producer; main_loop() is the only consumer.
+ */
+
+// Queues (= producers)
+enum {
+    EVQ_BTTFN = 0,    // BTTFN receiver: bttfn_rxPost()
+    EVQ_MQTT,         // mqttCallback()
+    EVQ_NET,          // Network task: checkForUpdate()
+    EVQ_HELD,         // main_loop() itself: Held-back remote commands
+    EVQ_NUM
+};
+
+// Event types
+enum {
+    EVT_NONE = 0,
+    EVT_PREPARE,      // Prepare for TT
+    EVT_TT,           // Time travel; payload: tt
+    EVT_REENTRY,      // Re-entry
+    EVT_ABORT,        // Abort TT
+    EVT_ALARM,        // Alarm
+    EVT_WAKEUP,       // Wakeup
+    EVT_CMD,          // Remote command; payload: cmd
+    EVT_MSG,          // MQTT message to display; payload: msg
+    EVT_UPDVERS       // Latest version to save; payload: vers
+};
+
+#define EVT_QUEUE_SIZE  16    // per queue; must be power of 2
+#define EVT_MSG_LEN     10
+
+// Latency histogram: Time between post and retrieval in us;
+// bucket n counts events retrieved after less than 
+// evtLatLimits[n] us, the last one everything beyond.
+#define EVT_LAT_BUCKETS 8
+
+typedef struct {
+    uint8_t  type;
+    uint8_t  src;               // queue posted to (EVQ_xxx)
+    uint32_t stamp;             // micros() at post
+    union {
+        struct {
+            uint16_t lead;      // ms until P1 (TT start)
+            uint16_t p1;        // P1 duration in ms
+        } tt;
+        uint32_t cmd;
+        char     msg[EVT_MSG_LEN];
+        struct {
+            uint16_t v;
+            uint16_t r;
+        } vers;
+    } u;
+} sidEvent;
+
+typedef struct {
+    uint32_t posted;
+    uint32_t dropped;           // queue full
+    uint32_t handled;
+    uint32_t latMax;
+    uint64_t latTotal;
+    uint32_t hist[EVT_LAT_BUCKETS];
+} evtStats;
+
+// Producer side; each queue must be fed by one task only
+bool evt_post(int q, uint8_t type);
+bool evt_postTT(int q, uint16_t lead, uint16_t p1);
+bool evt_postCmd(int q, uint32_t cmd);
+bool evt_postMsg(int q, const char *msg);
+bool evt_postUpdVers(int q, int v, int r);
+bool evt_requeue(int q, const sidEvent *ev);
+
+// Consumer side
+bool evt_get(int q, sidEvent *ev);
+bool evt_getNext(sidEvent *ev);
+bool evt_pending(int q);
+
+void evt_getStats(int q, evtStats *st);
+
+extern const char     *evtQueueNames[EVQ_NUM];
+extern const uint32_t evtLatLimits[EVT_LAT_BUCKETS - 1];
+
+#endif
@@ -25,6 +25,27 @@
 // Uncomment for HomeAssistant MQTT protocol support
 #define SID_HAVEMQTT
 
+// Uncomment for status page in the Config Portal ("/prof") with event 
+// queue, BTTFN, task, power save and memory statistics; includes the 
+// loop stall detector (MQTT: "bttf/sid/stall") and boot time stamps 
+// (MQTT: "bttf/sid/boot")
+#define SID_HAVESTATS
+
+// Uncomment for loop profiler: Per-subsystem timing histograms, published
+// through MQTT ("bttf/sid/prof/...") and shown on the status page; costs
+// time in every profiled section. Stall records name the profiled region
+// only if this is enabled.
+//#define SID_HAVEPROF
+
+// Uncomment to run sequences, games, SA and display on a simulated clock
+// that only advances when the loop would otherwise sleep (see sid_time.h);
+// used by the host harness (tools/host/simloop)
+//#define SID_SIMCLOCK
+
+// Uncomment for a fixed seed for the animation PRNG (reproducible idle
+// and TT animations); otherwise it is seeded from the hardware RNG
+//#define SID_RNG_SEED 0x5eed1985
+
 // External time travel lead time, as defined by TCD firmware
 // If SID is connected to TCD by wire, and the option "Signal Time Travel
 // without 5s lead" is set on the TCD, the SID option "TCD signals without
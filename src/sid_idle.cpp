@@ -0,0 +1,219 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Idle pattern
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#include "sid_idle.h"
+#include "sid_time.h"
+
+static const uint8_t mods[21][IDLE_BARS] = {
+    { 130, 90, 10,  80,  10, 110, 100,  15, 120,  90 }, // g 0
+    { 130, 90, 10,  80,  10, 110, 100,  15, 100,  90 }, // g 1
+    { 130, 90, 20,  80,  15, 110, 100,  15, 120, 100 }, // g 2
+    { 110,100, 70,  80,  30,  50, 100,  15, 100, 110 }, // g 3
+    { 110,110, 40,  90,  30,  50, 100,  15,  80, 100 }, // g 4
+    { 110,110, 30, 120,  30,  50, 110,  15,  50, 100 }, // g 5
+    { 100,100, 20, 120,  10,  50, 110,  20,  40, 110 }, // g 6
+    { 110,120, 15, 110,  20,  40, 110,  18,  40, 100 }, // g 7
+    { 100,100, 15, 110,  20,  50, 100,  15,  50,  90 }, // g 8
+    {  90,110,  0, 100,  20,  50, 100,  15,  60, 100 }, // g 9
+    {  90,100, 10, 100,  10,  60,  90,  15,  40, 100 }, // g 10
+    {  90,100, 10, 100,  10,  90,  90,  15, 110, 100 }, // g 11
+    {  90, 90, 20,  90,  15, 100, 100,  50, 100,  90 }, // g 12
+    {  90, 90, 20,  90,  15, 100, 100,  50, 100,  90 }, // y 13
+    {  90, 80, 10,  80,  15,  90,  80,  50, 100,  80 }, // y 14
+    {  90, 80, 10,  80,  15,  90,  80,  50, 100,  80 }, // y 15
+    {  90, 80, 10,  80,  15,  90,  80,  50, 100,  80 }, // y 16
+    {  90, 70, 20,  70,  15,  70,  70,  40, 100,  70 }, // y 17
+    {  90, 70, 20,  70,  15,  70,  70,  40,  90,  70 }, // y 18
+    {  90, 60, 25,  60,  15,  80,  60,  40,  90,  60 }, // r 19
+    {  90, 90, 70, 100,  90, 110,  90,  60,  95,  80 }  // extra for TT
+};
+
+const uint8_t idleMaxTTHeight[IDLE_BARS] = {
+    19, 19, 12, 19, 19, 18, 19,  9, 19, 16
+};
+
+/*
+ * Bar heights of a non-strict idle (or TT) frame
+ *
+ * heights[] holds the previous frame's heights on entry, the new
+ * ones on return. All randomness comes from sidRandom(), so the
+ * result depends only on the arguments and the PRNG state; this
+ * is what idle mirroring relies on.
+ */
+void idle_calcBars(int baseLine, int variation, uint16_t flags, uint8_t *heights)
+{
+    int bh, a = baseLine, b;
+    int vc = (flags & SBLF_ISTT) ? 0 : variation / 2;
+
+    if(a < 0) a = 0;
+    if(a > 19) a = 19;
+
+    b = (flags & SBLF_ISTT) ? 20 : a;
+
+    for(int i = 0; i < IDLE_BARS; i++) {
+        bh = a * (mods[b][i] + ((int)(sidRandom() % variation)-vc)) / 100;
+        if(bh < 0) bh = 0;
+        if(bh > 19) bh = 19;
+        if((flags & SBLF_LM) && bh < 9) {
+            bh = 9 + (int)(sidRandom() % 4);
+        }
+        if(!(flags & SBLF_ISTT) && abs(bh - heights[i]) > 5) {
+            bh = (heights[i] + bh) / 2;
+        }
+        if(flags & SBLF_ISTT) {
+            if(bh > idleMaxTTHeight[i] || (!(flags & SBLF_ANIM))) bh = idleMaxTTHeight[i];
+        }
+        heights[i] = bh;
+    }
+}
+
+/*
+ * Bars (LEDs lit, 0-20) of an idle (or TT) frame
+ *
+ * Non-strict frames come from idle_calcBars(), strict frames 
+ * (SBLF_STRICT) from strictSeq at strictBaseLine, backlot frames
+ * (SBLF_NOBL) from blSeq at seqTime; SBLF_REPEAT repeats the last
+ * frame. If fr->seed is set, the frame is rendered from that PRNG
+ * state, and ours is left untouched. Letter mask and TT effects
+ * are the caller's. For backlot frames, returns ms until the bars 
+ * change next, otherwise 0.
+ */
+uint16_t idle_bars(idleState *st, const idleFrame *fr, uint8_t *bars)
+{
+    uint32_t ownRndState = sidRndState;
+    uint16_t flags = fr->flags;
+    uint16_t next = 0;
+    int bh;
+
+    if(fr->seed) sidRndState = fr->seed;
+
+    if(flags & SBLF_NOBL) {
+        next = seq_sample(st->blSeq, fr->seqTime, bars);
+    } else if(flags & SBLF_REPEAT) {
+        // (Never set in strict mode)
+        for(int i = 0; i < IDLE_BARS; i++) {
+            bars[i] = st->heights[i] + 1;
+        }
+    } else if(!(flags & SBLF_STRICT)) {
+        idle_calcBars(st->baseLine, fr->variation, flags, st->heights);
+        for(int i = 0; i < IDLE_BARS; i++) {
+            bars[i] = st->heights[i] + 1;
+        }
+    } else {
+        if(!seq_frame(st->strictSeq, st->strictBaseLine, bars)) {
+            memset(bars, 0, IDLE_BARS);
+        }
+        for(int i = 0; i < IDLE_BARS; i++) {
+            bh = bars[i];
+            if(flags & SBLF_ISTT) {
+                if(bh > idleMaxTTHeight[i] + 1 || (!(flags & SBLF_ANIM))) bh = idleMaxTTHeight[i] + 1;
+            }
+            bars[i] = bh;
+            if(bh > 0) bh--;
+            st->heights[i] = bh;
+        }
+    }
+
+    if(fr->seed) sidRndState = ownRndState;
+
+    return next;
+}
+
+/*
+ * Idle mirroring: Mirror frame (BTTFN_NOT_SID_MIRROR) with the 
+ * idle state and the frame's parameters; seed is the PRNG state
+ * the leader renders the frame from. buf keeps its header between
+ * frames.
+ */
+void idle_mirBuild(bttfnBuf *buf, uint32_t frame, const idleState *st, const idleFrame *fr, uint32_t seed)
+{
+    BttfnPacket pkt(buf);
+
+    if(!pkt.valid() || pkt.notId() != BTTFN_NOT_SID_MIRROR) {
+        pkt.init();
+        pkt.setVersion(BTTFN_VERSION | 0x40);
+        pkt.setFlags(BTTFN_NOT_SID_MIRROR);
+    }
+
+    pkt.setSeq(frame);
+    pkt.setMirState(st->baseLine, st->strictBaseLine, fr->variation, fr->flags, st->wayUp);
+    pkt.setMirSeed(seed);
+    pkt.setMirSeqTime(fr->seqTime);
+    pkt.setMirHeights(st->heights, BTTFN_MIR_BARS);
+}
+
+// Follower: Take over the leader's state from a mirror frame, 
+// clamped to what we can render
+void idle_mirApply(idleState *st, const BttfnPacket& pkt, idleFrame *fr)
+{
+    int maxStrict = seq_numFrames(st->strictSeq) - 1;
+
+    st->baseLine = min(19, (int)pkt.mirBaseLine());
+    st->strictBaseLine = min(maxStrict, (int)pkt.mirStrictBL());
+    if(st->strictBaseLine < 0) st->strictBaseLine = 0;
+    st->wayUp = pkt.mirWayUp();
+    for(int i = 0; i < IDLE_BARS; i++) {
+        st->heights[i] = min(19, (int)pkt.mirHeight(i));
+    }
+
+    fr->variation = pkt.mirVariation();
+    if(fr->variation < 1) fr->variation = 1;
+    fr->flags = pkt.mirFlags();
+    fr->seed = pkt.mirSeed();
+    fr->seqTime = pkt.mirSeqTime();
+}
@@ -0,0 +1,105 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Idle pattern
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+#ifndef _SID_IDLE_H
+#define _SID_IDLE_H
+
+#include "sid_seq.h"
+#include "sid_bttfn.h"
+
+// showBaseLine() flags
+#define SBLF_REPEAT   1
+#define SBLF_ISTT     2
+#define SBLF_LM       4
+#define SBLF_SKIPSHOW 8
+#define SBLF_LMTT     16
+#define SBLF_NOBL     32
+#define SBLF_ANIM     64
+#define SBLF_STRICT   128
+
+#define IDLE_BARS     10
+
+extern const uint8_t idleMaxTTHeight[IDLE_BARS];
+
+void idle_calcBars(int baseLine, int variation, uint16_t flags, uint8_t *heights);
+
+/*
+ * Idle frame rendering
+ *
+ * An idle frame is rendered from the idle state and the frame's
+ * parameters, with the PRNG. Idle mirroring sends both, and the
+ * PRNG state, to followers.
+ */
+
+typedef struct {
+    int      baseLine;              // 0-19
+    int      strictBaseLine;        // frame of strictSeq
+    bool     wayUp;                 // strict baseline going up
+    uint8_t  heights[IDLE_BARS];    // bar tops (0-19) of last frame
+    sidSeq   *strictSeq;            // strict frames (TT sequence)
+    sidSeq   *blSeq;                // backlot sequence
+} idleState;
+
+typedef struct {
+    int      variation;
+    uint16_t flags;                 // SBLF_xxx
+    uint32_t seed;                  // PRNG state to render with; 0 = own
+    uint32_t seqTime;               // ms into backlot sequence
+} idleFrame;
+
+uint16_t idle_bars(idleState *st, const idleFrame *fr, uint8_t *bars);
+
+void idle_mirBuild(bttfnBuf *buf, uint32_t frame, const idleState *st, const idleFrame *fr, uint32_t seed);
+void idle_mirApply(idleState *st, const BttfnPacket& pkt, idleFrame *fr);
+
+#endif
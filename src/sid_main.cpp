@@ -56,6 +56,7 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
+#include <lwip/sockets.h>
 #include "input.h"
 
 #include "sid_main.h"
@@ -64,6 +65,18 @@
 #include "sid_sa.h"
 #include "sid_siddly.h"
 #include "sid_snake.h"
+#include "sid_anim.h"
+#include "sid_seq.h"
+#include "sid_sched.h"
+#include "sid_prof.h"
+#include "sid_bttfn.h"
+#include "sid_mem.h"
+#include "sid_event.h"
+#include "sid_task.h"
+#include "sid_power.h"
+#include "sid_time.h"
+#include "sid_speed.h"
+#include "sid_idle.h"
 
 unsigned long powerupMillis = 0;
 
@@ -90,13 +103,18 @@ static SIDButton TTKey = SIDButton(TT_IN_PIN,
 static bool isTTKeyPressed = false;
 static bool isTTKeyHeld = false;
 
-bool networkTimeTravel = false;
-bool networkTCDTT      = false;
-bool networkReentry    = false;
-bool networkAbort      = false;
-bool networkAlarm      = false;
-uint16_t networkLead   = ETTO_LEAD;
-uint16_t networkP1     = 6600;
+// Set from events in handleEvents()
+static bool networkTimeTravel = false;
+static bool networkTCDTT      = false;
+static bool networkReentry    = false;
+static bool networkAbort      = false;
+static uint32_t networkTTStamp = 0;     // micros() at arrival of BTTFN TT
+bool        networkAlarm      = false;
+static uint16_t networkLead   = ETTO_LEAD;
+static uint16_t networkP1     = 6600;
+
+static bool mqttDisp = false;
+static char mqttDispMsg[EVT_MSG_LEN] = { 0 };
 
 static bool tcdIsBusy  = false;
 bool        sidBusy    = false;
@@ -108,24 +126,18 @@ bool        sidBusy    = false;
 #define SID_IDLE_BL   4   // "backlot mode"
 #define SID_IDLE_IDC  5   // text / "identity crisis"
 
-#define SBLF_REPEAT   1
-#define SBLF_ISTT     2
-#define SBLF_LM       4
-#define SBLF_SKIPSHOW 8
-#define SBLF_LMTT     16
-#define SBLF_NOBL     32
-#define SBLF_ANIM     64
-#define SBLF_STRICT   128
+#define SID_MIRROR_OFF    0
+#define SID_MIRROR_LEAD   1   // send idle pattern state
+#define SID_MIRROR_FOLLOW 2   // render idle pattern from leader's state
 uint16_t              idleMode = 0;
 bool                  strictMode = true;
-static int            sidBaseLine = 0;
-static int            strictBaseLine = 0;
-static bool           blWayup = true;
+static idleState      idleSt = {
+    0, 0, true, 
+    { 19, 19, 19, 19, 19, 19, 19, 19, 19, 19 },
+    NULL, NULL
+};
 static unsigned long  lastChange = 0;
 static unsigned long  idleDelay = 800;
-static uint8_t        oldIdleHeight[10] = { 
-    19, 19, 19, 19, 19, 19, 19, 19, 19, 19
-};
 
 static int            LMIdx, LMY, LMState;
 static unsigned long  LMAdvNow, LMDelay;
@@ -134,23 +146,31 @@ static unsigned long  idleDelay2 = 800;
 static char           LM[] = { 0xa8,0xa8,0xca,0xc9,0xcb,0xc3,0xa8,0xdc,0xc7,0xa8,0xdc,0xc0,0xcd,0xa8,0xce,0xdd,0xdc,0xdd,0xda,0xcd,0xa8,0 }; // Space at beginning for letting pattern grow first
 static const char     LMTT[] = { 36, 37, 38, 39, 0 };
 
+// Built-in sequences (see sid_seq.h for format)
+static sidSeq idleSeq, ttSeqFull, ttSeq;
+
+// Backlot idle pattern; can be replaced by custom
+// sequence on SD (SEQ_IDLE_FN)
+#define SEQ_IDLE_FN "/sid-idle.seq"
 #define ID5_STEPS 14
-static int id5idx = 0;
-static const uint8_t idle5[ID5_STEPS][10] = {
-    {  6,  8,  6,  5,  8, 11, 11, 11, 12, 12 }, // 1
-    { 10, 10, 10, 11, 11, 11, 11, 11, 12, 12 }, // 2
-    { 14, 14, 15, 13, 13, 11, 11, 11, 12, 12 }, // 3
-    { 14, 14, 15, 13, 13, 13, 13, 15, 14, 14 }, // 4
-    { 14, 14, 15, 13, 13, 15, 16, 19, 16, 17 }, // 5
-    { 16, 18, 17, 15, 17, 15, 16, 19, 16, 17 }, // 6
-    { 16, 18, 17, 15, 17, 20, 18, 20, 20, 20 }, // 7
-    { 19, 20, 20, 17, 19, 20, 18, 20, 20, 20 }, // 8
-    { 16, 18, 17, 15, 17, 20, 18, 20, 20, 20 }, // 9
-    { 16, 18, 17, 15, 17, 15, 16, 19, 16, 17 }, // 10
-    { 14, 14, 15, 13, 13, 15, 16, 19, 16, 17 }, // 11
-    { 14, 14, 15, 13, 13, 13, 13, 15, 14, 14 }, // 12
-    { 14, 14, 15, 13, 13, 11, 11, 11, 12, 12 }, // 13
-    { 10, 10, 10, 11, 11, 11, 11, 11, 12, 12 }  // 14
+static int id5idx = 0;                  // 0 = (re)start sequence
+static unsigned long id5Start = 0;
+static const uint8_t idle5[] = {
+    SEQ_HDR(ID5_STEPS, 90),
+    SEQ_FRM(0, 0,  6,  8,  6,  5,  8, 11, 11, 11, 12, 12), // 1
+    SEQ_FRM(0, 0, 10, 10, 10, 11, 11, 11, 11, 11, 12, 12), // 2
+    SEQ_FRM(0, 0, 14, 14, 15, 13, 13, 11, 11, 11, 12, 12), // 3
+    SEQ_FRM(0, 0, 14, 14, 15, 13, 13, 13, 13, 15, 14, 14), // 4
+    SEQ_FRM(0, 0, 14, 14, 15, 13, 13, 15, 16, 19, 16, 17), // 5
+    SEQ_FRM(0, 0, 16, 18, 17, 15, 17, 15, 16, 19, 16, 17), // 6
+    SEQ_FRM(0, 0, 16, 18, 17, 15, 17, 20, 18, 20, 20, 20), // 7
+    SEQ_FRM(0, 0, 19, 20, 20, 17, 19, 20, 18, 20, 20, 20), // 8
+    SEQ_FRM(0, 0, 16, 18, 17, 15, 17, 20, 18, 20, 20, 20), // 9
+    SEQ_FRM(0, 0, 16, 18, 17, 15, 17, 15, 16, 19, 16, 17), // 10
+    SEQ_FRM(0, 0, 14, 14, 15, 13, 13, 15, 16, 19, 16, 17), // 11
+    SEQ_FRM(0, 0, 14, 14, 15, 13, 13, 13, 13, 15, 14, 14), // 12
+    SEQ_FRM(0, 0, 14, 14, 15, 13, 13, 11, 11, 11, 12, 12), // 13
+    SEQ_FRM(0, 0, 10, 10, 10, 11, 11, 11, 11, 11, 12, 12)  // 14
 };
 
 static bool useGPSS     = false;
@@ -158,6 +178,8 @@ static bool usingGPSS   = false;
 static int16_t gpsSpeed = -1;
 static int16_t prevGPSSpeed = -2;
 static int16_t oldGpsSpeed = -2;
+static sidSpdEst gpsSpdEst;             // gpsSpeed, extrapolated between packets
+#define GPSS_FRAME_INT 100              // ms; frame interval while estimate changes
 static bool spdIsRotEnc = false;
 
 static bool useNM = false;
@@ -167,11 +189,10 @@ static bool useFPO = false;
 static bool tcdFPO = false;
 static int  FPOSAMode = -1;
 static bool bttfnTT = true;
+static bool saBcast = false;
+static int  sidMirror = 0;
 static bool oldSidNM = false;
 
-bool doPrepareTT = false;
-bool doWakeup = false;
-
 static bool skipTTAnim = false;
 
 // Time travel status flags etc.
@@ -198,92 +219,94 @@ static bool          TTLMTrigger = false;
 static int           TTsidBaseLineIdx = 0;
 
 #define TT_SQF_LN 51
-static const uint8_t ttledseqfull[TT_SQF_LN][10] = {
-    {  1,  0,  0,  4,  0,  0,  0,  0,  0,  0 },
-    {  2,  1,  0,  4,  0,  0,  0,  0,  0,  0 },
-    {  3,  2,  0,  5,  0,  0,  0,  0,  0,  0 },
-    {  4,  2,  0,  6,  0,  0,  0,  0,  0,  0 },
-    {  4,  3,  0,  6,  0,  0,  0,  0,  0,  0 },
-    {  4,  3,  0,  7,  0,  0,  0,  0,  0,  0 },
-    {  4,  4,  0,  7,  0,  0,  0,  0,  0,  0 },
-    {  4,  4,  0,  8,  0,  0,  0,  0,  0,  0 },
-    {  4,  5,  0,  9,  0,  0,  0,  0,  0,  0 },
-    {  4,  5,  0,  9,  0,  1,  0,  0,  0,  0 }, // 10
-    {  5,  5,  0,  9,  0,  1,  0,  0,  0,  0 },
-    {  5,  6,  0, 10,  0,  1,  0,  0,  0,  0 },
-    {  5,  7,  0, 10,  0,  1,  0,  0,  0,  1 },
-    {  5,  8,  0, 10,  0,  1,  0,  0,  0,  2 },
-    {  6,  9,  0, 10,  0,  2,  0,  0,  0,  3 },
-    {  6,  9,  0, 10,  0,  2,  1,  0,  0,  4 },
-    {  6,  9,  0, 10,  0,  3,  1,  0,  0,  5 },
-    {  6,  9,  0, 10,  0,  3,  2,  0,  0,  6 },
-    {  6,  9,  0, 10,  0,  3,  3,  0,  0,  7 },
-    {  6,  9,  0, 10,  0,  3,  4,  0,  0,  8 }, // 20
-    {  6,  9,  0, 10,  0,  3,  4,  0,  0,  9 },
-    {  7, 10,  0, 10,  0,  3,  4,  0,  0,  9 },
-    {  7, 10,  0, 10,  0,  4,  5,  0,  1,  9 },
-    {  8, 10,  0, 10,  0,  4,  6,  0,  1,  9 },
-    {  8, 10,  0, 10,  0,  4,  7,  0,  2,  9 },
-    {  8, 10,  0, 10,  0,  4,  8,  0,  2, 10 },
-    {  8, 10,  0, 10,  0,  4,  8,  0,  3, 10 },
-    {  8, 10,  0, 10,  0,  4,  9,  0,  3, 10 },
-    {  8, 10,  0, 10,  0,  4, 10,  0,  3, 10 },
-    {  9, 10,  0, 10,  0,  4, 10,  0,  4, 10 }, // 30
-    {  9, 10,  0, 10,  0,  5, 10,  0,  5, 10 },
-    {  9, 10,  0, 10,  0,  6, 10,  0,  6, 10 },
-    {  9, 10,  0, 10,  0,  7, 10,  0,  7, 10 },
-    { 10, 10,  0, 10,  0,  8, 10,  0,  8, 10 },
-    { 10, 10,  0, 10,  0,  9, 10,  0,  9, 10 },
-    { 10, 10,  1, 10,  0, 10, 10,  0, 10, 10 },
-    { 10, 10,  1, 10,  0, 11, 10,  0, 11, 10 },
-    { 10, 10,  2, 10,  0, 12, 10,  0, 12, 10 },
-    { 11, 10,  2, 10,  0, 12, 10,  0, 13, 10 },
-    { 12, 10,  3, 10,  0, 12, 10,  0, 14, 10 }, // 40
-    { 13, 10,  3, 10,  0, 12, 10,  0, 15, 10 },
-    { 14, 10,  3, 10,  0, 12, 10,  0, 16, 10 },
-    { 15, 10,  4, 10,  0, 12, 10,  0, 17, 10 },
-    { 16, 10,  4, 10,  0, 12, 10,  0, 18, 10 },
-    { 17, 10,  4, 10,  0, 12, 10,  0, 19, 10 },
-    { 18, 10,  6, 10,  0, 12, 10,  0, 20, 10 },
-    { 19, 10,  6, 10,  0, 12, 10,  0, 20, 10 },
-    { 19, 11,  6, 10,  0, 12, 11,  0, 20, 10 },   // 48
-    { 20, 15,  7, 10,  0, 12, 15,  0, 20, 10 },   // 51
-    { 20, 20, 10, 10,  5, 12, 20,  6, 20, 10 },   // 55-ish
-    { 20, 20, 13, 20, 20, 19, 20, 10, 20, 17 }    // 60 - tt
+static const uint8_t ttledseqfull[] = {
+    SEQ_HDR(TT_SQF_LN, 0),
+    SEQ_FRM(0, 0,  1,  0,  0,  4,  0,  0,  0,  0,  0,  0),
+    SEQ_FRM(0, 0,  2,  1,  0,  4,  0,  0,  0,  0,  0,  0),
+    SEQ_FRM(0, 0,  3,  2,  0,  5,  0,  0,  0,  0,  0,  0),
+    SEQ_FRM(0, 0,  4,  2,  0,  6,  0,  0,  0,  0,  0,  0),
+    SEQ_FRM(0, 0,  4,  3,  0,  6,  0,  0,  0,  0,  0,  0),
+    SEQ_FRM(0, 0,  4,  3,  0,  7,  0,  0,  0,  0,  0,  0),
+    SEQ_FRM(0, 0,  4,  4,  0,  7,  0,  0,  0,  0,  0,  0),
+    SEQ_FRM(0, 0,  4,  4,  0,  8,  0,  0,  0,  0,  0,  0),
+    SEQ_FRM(0, 0,  4,  5,  0,  9,  0,  0,  0,  0,  0,  0),
+    SEQ_FRM(0, 0,  4,  5,  0,  9,  0,  1,  0,  0,  0,  0), // 10
+    SEQ_FRM(0, 0,  5,  5,  0,  9,  0,  1,  0,  0,  0,  0),
+    SEQ_FRM(0, 0,  5,  6,  0, 10,  0,  1,  0,  0,  0,  0),
+    SEQ_FRM(0, 0,  5,  7,  0, 10,  0,  1,  0,  0,  0,  1),
+    SEQ_FRM(0, 0,  5,  8,  0, 10,  0,  1,  0,  0,  0,  2),
+    SEQ_FRM(0, 0,  6,  9,  0, 10,  0,  2,  0,  0,  0,  3),
+    SEQ_FRM(0, 0,  6,  9,  0, 10,  0,  2,  1,  0,  0,  4),
+    SEQ_FRM(0, 0,  6,  9,  0, 10,  0,  3,  1,  0,  0,  5),
+    SEQ_FRM(0, 0,  6,  9,  0, 10,  0,  3,  2,  0,  0,  6),
+    SEQ_FRM(0, 0,  6,  9,  0, 10,  0,  3,  3,  0,  0,  7),
+    SEQ_FRM(0, 0,  6,  9,  0, 10,  0,  3,  4,  0,  0,  8), // 20
+    SEQ_FRM(0, 0,  6,  9,  0, 10,  0,  3,  4,  0,  0,  9),
+    SEQ_FRM(0, 0,  7, 10,  0, 10,  0,  3,  4,  0,  0,  9),
+    SEQ_FRM(0, 0,  7, 10,  0, 10,  0,  4,  5,  0,  1,  9),
+    SEQ_FRM(0, 0,  8, 10,  0, 10,  0,  4,  6,  0,  1,  9),
+    SEQ_FRM(0, 0,  8, 10,  0, 10,  0,  4,  7,  0,  2,  9),
+    SEQ_FRM(0, 0,  8, 10,  0, 10,  0,  4,  8,  0,  2, 10),
+    SEQ_FRM(0, 0,  8, 10,  0, 10,  0,  4,  8,  0,  3, 10),
+    SEQ_FRM(0, 0,  8, 10,  0, 10,  0,  4,  9,  0,  3, 10),
+    SEQ_FRM(0, 0,  8, 10,  0, 10,  0,  4, 10,  0,  3, 10),
+    SEQ_FRM(0, 0,  9, 10,  0, 10,  0,  4, 10,  0,  4, 10), // 30
+    SEQ_FRM(0, 0,  9, 10,  0, 10,  0,  5, 10,  0,  5, 10),
+    SEQ_FRM(0, 0,  9, 10,  0, 10,  0,  6, 10,  0,  6, 10),
+    SEQ_FRM(0, 0,  9, 10,  0, 10,  0,  7, 10,  0,  7, 10),
+    SEQ_FRM(0, 0, 10, 10,  0, 10,  0,  8, 10,  0,  8, 10),
+    SEQ_FRM(0, 0, 10, 10,  0, 10,  0,  9, 10,  0,  9, 10),
+    SEQ_FRM(0, 0, 10, 10,  1, 10,  0, 10, 10,  0, 10, 10),
+    SEQ_FRM(0, 0, 10, 10,  1, 10,  0, 11, 10,  0, 11, 10),
+    SEQ_FRM(0, 0, 10, 10,  2, 10,  0, 12, 10,  0, 12, 10),
+    SEQ_FRM(0, 0, 11, 10,  2, 10,  0, 12, 10,  0, 13, 10),
+    SEQ_FRM(0, 0, 12, 10,  3, 10,  0, 12, 10,  0, 14, 10), // 40
+    SEQ_FRM(0, 0, 13, 10,  3, 10,  0, 12, 10,  0, 15, 10),
+    SEQ_FRM(0, 0, 14, 10,  3, 10,  0, 12, 10,  0, 16, 10),
+    SEQ_FRM(0, 0, 15, 10,  4, 10,  0, 12, 10,  0, 17, 10),
+    SEQ_FRM(0, 0, 16, 10,  4, 10,  0, 12, 10,  0, 18, 10),
+    SEQ_FRM(0, 0, 17, 10,  4, 10,  0, 12, 10,  0, 19, 10),
+    SEQ_FRM(0, 0, 18, 10,  6, 10,  0, 12, 10,  0, 20, 10),
+    SEQ_FRM(0, 0, 19, 10,  6, 10,  0, 12, 10,  0, 20, 10),
+    SEQ_FRM(0, 0, 19, 11,  6, 10,  0, 12, 11,  0, 20, 10),   // 48
+    SEQ_FRM(0, 0, 20, 15,  7, 10,  0, 12, 15,  0, 20, 10),   // 51
+    SEQ_FRM(0, 0, 20, 20, 10, 10,  5, 12, 20,  6, 20, 10),   // 55-ish
+    SEQ_FRM(0, 0, 20, 20, 13, 20, 20, 19, 20, 10, 20, 17)    // 60 - tt
 };
 
 #define TT_SQ_LN 29
-static const uint8_t ttledseq[TT_SQ_LN][10] = {
-//     1   2   3   4   5   6   7   8   9  10
-    {  0,  1,  0,  0,  0,  0,  0,  0,  0,  0 },   // 0
-    {  1,  2,  0,  2,  0,  0,  1,  0,  1,  1 },   // 1
-    {  2,  3,  0,  2,  0,  1,  2,  0,  1,  2 },   // 2
-    {  3,  4,  0,  3,  0,  1,  3,  0,  2,  3 },   // 3
-    {  4,  5,  0,  3,  0,  1,  4,  0,  2,  4 },   // 4
-    {  5,  6,  0,  5,  0,  2,  6,  0,  2,  5 },   // 5
-    {  6,  7,  0,  7,  0,  2,  7,  0,  2,  7 },   // 6    bl 6
-    {  7,  9,  0,  9,  0,  3,  8,  0,  3,  9 },   // 7    bl 8
-    {  8, 10,  0, 10,  0,  4,  9,  0,  3, 10 },   // 8  m bl 10 (26)
-    {  8, 10,  0, 10,  0,  5,  9,  0,  4, 10 },   // 9
-    {  8, 10,  0, 10,  0,  5,  9,  0,  5, 10 },   // 10
-    {  8, 10,  0, 10,  0,  6,  9,  0,  6, 10 },   // 11
-    {  8, 10,  0, 10,  0,  8,  9,  0,  7, 10 },   // 12
-    {  8, 10,  0, 10,  0, 10,  9,  0,  8, 10 },   // 13
-    {  8, 10,  0, 10,  0, 10,  9,  0,  9, 10 },   // 14
-    { 10, 10,  1, 10,  0, 10, 10,  0, 10, 10 },   // 15 m bl 10 (36)
-    { 10, 10,  1, 10,  0, 10, 10,  0, 10, 10 },   // 16 m bl 10
-    { 10, 10,  1, 10,  0, 11, 10,  0, 11, 10 },   // 17 m       (37)
-    { 10, 10,  2, 10,  0, 11, 10,  0, 12, 10 },   // 18 
-    { 11, 10,  3, 10,  0, 11, 10,  0, 13, 10 },   // 19 
-    { 12, 10,  3, 10,  0, 12, 10,  0, 14, 10 },   // 20 
-    { 13, 10,  3, 10,  0, 12, 10,  0, 15, 10 },   // 21 m       (41)
-    { 14, 10,  4, 10,  0, 12, 10,  0, 16, 10 },   // 22 
-    { 15, 10,  4, 10,  0, 12, 10,  0, 17, 10 },   // 23 
-    { 16, 10,  4, 10,  0, 12, 10,  0, 18, 10 },   // 24 m       (44)
-    { 19, 10,  6, 10,  0, 12, 10,  0, 20, 10 },   // 25 m       (47)
-    { 20, 15,  7, 10,  0, 12, 15,  7, 20, 10 },   // 26 m       (n/a)
-    { 20, 20, 10, 10,  5, 12, 20, 10, 20, 10 },   // 27 m       (n/a)
-    { 20, 20, 13, 20, 20, 19, 20, 10, 20, 17 },   // 28 m       (60)
+static const uint8_t ttledseq[] = {
+    SEQ_HDR(TT_SQ_LN, 0),
+//                1   2   3   4   5   6   7   8   9  10
+    SEQ_FRM(0, 0,  0,  1,  0,  0,  0,  0,  0,  0,  0,  0),   // 0
+    SEQ_FRM(0, 0,  1,  2,  0,  2,  0,  0,  1,  0,  1,  1),   // 1
+    SEQ_FRM(0, 0,  2,  3,  0,  2,  0,  1,  2,  0,  1,  2),   // 2
+    SEQ_FRM(0, 0,  3,  4,  0,  3,  0,  1,  3,  0,  2,  3),   // 3
+    SEQ_FRM(0, 0,  4,  5,  0,  3,  0,  1,  4,  0,  2,  4),   // 4
+    SEQ_FRM(0, 0,  5,  6,  0,  5,  0,  2,  6,  0,  2,  5),   // 5
+    SEQ_FRM(0, 0,  6,  7,  0,  7,  0,  2,  7,  0,  2,  7),   // 6    bl 6
+    SEQ_FRM(0, 0,  7,  9,  0,  9,  0,  3,  8,  0,  3,  9),   // 7    bl 8
+    SEQ_FRM(0, 0,  8, 10,  0, 10,  0,  4,  9,  0,  3, 10),   // 8  m bl 10 (26)
+    SEQ_FRM(0, 0,  8, 10,  0, 10,  0,  5,  9,  0,  4, 10),   // 9
+    SEQ_FRM(0, 0,  8, 10,  0, 10,  0,  5,  9,  0,  5, 10),   // 10
+    SEQ_FRM(0, 0,  8, 10,  0, 10,  0,  6,  9,  0,  6, 10),   // 11
+    SEQ_FRM(0, 0,  8, 10,  0, 10,  0,  8,  9,  0,  7, 10),   // 12
+    SEQ_FRM(0, 0,  8, 10,  0, 10,  0, 10,  9,  0,  8, 10),   // 13
+    SEQ_FRM(0, 0,  8, 10,  0, 10,  0, 10,  9,  0,  9, 10),   // 14
+    SEQ_FRM(0, 0, 10, 10,  1, 10,  0, 10, 10,  0, 10, 10),   // 15 m bl 10 (36)
+    SEQ_FRM(0, 0, 10, 10,  1, 10,  0, 10, 10,  0, 10, 10),   // 16 m bl 10
+    SEQ_FRM(0, 0, 10, 10,  1, 10,  0, 11, 10,  0, 11, 10),   // 17 m       (37)
+    SEQ_FRM(0, 0, 10, 10,  2, 10,  0, 11, 10,  0, 12, 10),   // 18
+    SEQ_FRM(0, 0, 11, 10,  3, 10,  0, 11, 10,  0, 13, 10),   // 19
+    SEQ_FRM(0, 0, 12, 10,  3, 10,  0, 12, 10,  0, 14, 10),   // 20
+    SEQ_FRM(0, 0, 13, 10,  3, 10,  0, 12, 10,  0, 15, 10),   // 21 m       (41)
+    SEQ_FRM(0, 0, 14, 10,  4, 10,  0, 12, 10,  0, 16, 10),   // 22
+    SEQ_FRM(0, 0, 15, 10,  4, 10,  0, 12, 10,  0, 17, 10),   // 23
+    SEQ_FRM(0, 0, 16, 10,  4, 10,  0, 12, 10,  0, 18, 10),   // 24 m       (44)
+    SEQ_FRM(0, 0, 19, 10,  6, 10,  0, 12, 10,  0, 20, 10),   // 25 m       (47)
+    SEQ_FRM(0, 0, 20, 15,  7, 10,  0, 12, 15,  7, 20, 10),   // 26 m       (n/a)
+    SEQ_FRM(0, 0, 20, 20, 10, 10,  5, 12, 20, 10, 20, 10),   // 27 m       (n/a)
+    SEQ_FRM(0, 0, 20, 20, 13, 20, 20, 19, 20, 10, 20, 17)    // 28 m       (60)
 };
 static const uint8_t seqEntry[21] = {
   //  0  1  2  3  4  5  6  7  8  9 10  11  12  13  14  15  16  17  18  19  20      baseline
@@ -310,6 +333,7 @@ static unsigned long brichgnow = 0;
 static unsigned long ipachgnow = 0;
 static unsigned long irlchgnow = 0;
 static unsigned long bmdchgnow = 0;
+static int           saveTask = -1;
 
 static unsigned long ssLastActivity = 0;
 static unsigned long ssDelay = 0;
@@ -358,15 +382,15 @@ static char          inputBuffer[INPUTLEN_MAX + 2];
 static char          inputBackup[INPUTLEN_MAX + 2];
 static int           inputIndex = 0;
 static bool          inputRecord = false;
-static unsigned long lastKeyPressed = 0;
+static int           inpClrTask = -1;
 static int           maxIRctrls = NUM_REM_TYPES;
 
 #define IR_FEEDBACK_DUR 300
 static bool          irFeedBack = false;
-static unsigned long irFeedBackNow = 0;
 static unsigned long irFeedBackDur = IR_FEEDBACK_DUR;
+static int           irFBTask = -1;
 static bool          irErrFeedBack = false;
-static unsigned long irErrFeedBackNow = 0;
+static int           irErrFBTask = -1;
 static int           irErrFBState = 0;
 bool                 irShowPosFBDisplay = true;
 bool                 irShowCmdFBDisplay = true;
@@ -376,164 +400,134 @@ bool                 irLocked = false;
 bool                 IRLearning = false;
 static uint32_t      backupIRcodes[NUM_IR_KEYS];
 static int           IRLearnIndex = 0;
-static unsigned long IRLearnNow;
-static unsigned long IRFBLearnNow;
+static int           irLearnTOTask = -1;
+static int           irLearnFBTask = -1;
 static bool          IRLearnBlink = false;
 static const char    IRLearnKeys[] = "0123456789*#^$<>~";
-static bool          triggerIRLN = false;
-static unsigned long triggerIRLNNow;
+static int           irLNTask = -1;
 
 uint32_t             myRemID = 0x56781234;
 static bool          remoteAllowed = false;
 static bool          remMode = false;
 static bool          remHoldKey = false;
 
-#define BTTFN_VERSION              1
-#define BTTFN_SUP_MC            0x80
-#define BTTFN_SUP_ND            0x40
-#define BTTF_PACKET_SIZE          48
 #define BTTF_DEFAULT_LOCAL_PORT 1338    // 1339, 1340 for multicast
-#define BTTFN_POLL_INT          1000
 #define BTTFN_POLL_INT_FAST      800
-#define BTTFN_RESPONSE_TO        700
 #define BTTFN_KA_OFFSET            3
 #define BTTFN_KA_INTERVAL  ((60+BTTFN_KA_OFFSET)*1000)
-#define BTTFN_DATA_TO          16200
-#define BTTFN_TYPE_ANY     0    // Any, unknown or no device
-#define BTTFN_TYPE_FLUX    1    // Flux Capacitor
-#define BTTFN_TYPE_SID     2    // SID
-#define BTTFN_TYPE_PCG     3    // Dash Gauges
-#define BTTFN_TYPE_VSR     4    // VSR
-#define BTTFN_TYPE_AUX     5    // Aux (user custom device)
-#define BTTFN_TYPE_REMOTE  6    // Futaba remote control
-#define BTTFN_NOT_PREPARE  1
-#define BTTFN_NOT_TT       2
-#define BTTFN_NOT_REENTRY  3
-#define BTTFN_NOT_ABORT_TT 4
-#define BTTFN_NOT_ALARM    5
-#define BTTFN_NOT_REFILL   6
-#define BTTFN_NOT_FLUX_CMD 7
-#define BTTFN_NOT_SID_CMD  8
-#define BTTFN_NOT_PCG_CMD  9
-#define BTTFN_NOT_WAKEUP   10
-#define BTTFN_NOT_AUX_CMD  11
-#define BTTFN_NOT_VSR_CMD  12
-#define BTTFN_NOT_SPD      15
-#define BTTFN_NOT_INFO     16
-#define BTTFN_NOT_DATA     128  // bit only, not value
-#define BTTFN_REMCMD_KP_PING    4
-#define BTTFN_REMCMD_KP_KEY     5
-#define BTTFN_REMCMD_KP_BYE     6
-#define BTTFN_REM_MAX_COMMAND   BTTFN_REMCMD_KP_BYE
-#define BTTFN_REMCMD_KEEPALIVE 101
-#define BTTFN_SSRC_NONE         0
-#define BTTFN_SSRC_GPS          1
-#define BTTFN_SSRC_ROTENC       2
-#define BTTFN_SSRC_REM          3
-#define BTTFN_SSRC_P0           4
-#define BTTFN_SSRC_P1           5
-#define BTTFN_SSRC_P2           6
-#define BTTFN_TCDI1_NOREM     0x0001
-#define BTTFN_TCDI1_NOREMKP   0x0002
-#define BTTFN_TCDI1_EXT       0x0004
-#define BTTFN_TCDI1_OFF       0x0008
-#define BTTFN_TCDI1_NM        0x0010
-#define BTTFN_TCDI2_BUSY      0x0001
-#define BTTFN_TCDI2_TIMEINFO  0x8000
-static const uint8_t BTTFUDPHD[4] = { 'B', 'T', 'T', 'F' };
 static bool          useBTTFN = false;
-static WiFiUDP       bttfUDP;
-static UDP*          sidUDP;
-static WiFiUDP       bttfMcUDP;
-static UDP*          sidMcUDP;
-static byte          BTTFUDPBuf[BTTF_PACKET_SIZE];
-static byte          BTTFUDPTBuf[BTTF_PACKET_SIZE];
-static unsigned long BTTFNUpdateNow = 0;
-static unsigned long bttfnSIDPollInt = BTTFN_POLL_INT;
-static unsigned long BTTFNTSRQAge = 0;
+static bool          bttfnSetupDone = false;
+static int           bttfnSock = -1;
+static int           bttfnMcSock = -1;
+
+// Transmit: Packets are built from prebuilt templates (checksum
+// kept valid while patching), queued, and sent in one go at the
+// end of bttfn_loop(_quick)().
+#define BTTFN_TXT_REQ          0      // data request
+#define BTTFN_TXT_TT           1      // trigger BTTFN-wide TT
+#define BTTFN_TXT_CMD          2      // command to TCD
+#define BTTFN_TXT_NUM          3
+#define BTTFN_TX_QUEUE         4
+typedef struct {
+    bttfnBuf buf;
+    bool     discover;                // multicast DISCOVER request
+    bool     isReq;                   // stamp for round trip
+} bttfnTxSlot;
+static bttfnBuf      bttfnTxTpl[BTTFN_TXT_NUM];
+static bttfnTxSlot   bttfnTxQ[BTTFN_TX_QUEUE];
+static int           bttfnTxQLen = 0;
+static bttfnClient   bttfnCl;
+static unsigned long bttfnRateNow = 0;
+static uint32_t      bttfnRateRx = 0;
+static uint32_t      bttfnRateTx = 0;
 static unsigned long BTTFNLastCmdSent = 0;
-static bool          BTTFNPacketDue = false;
 static bool          BTTFNWiFiUp = false;
-static uint8_t       BTTFNfailCount = 0;
-static uint32_t      BTTFUDPID    = 0;
 static unsigned long lastBTTFNpacket = 0;
 static unsigned long lastBTTFNKA = 0;
-static unsigned long bttfnLastNotData = 0;
 static bool          BTTFNBootTO = false;
-static bool          haveTCDIP = false;
-static IPAddress     bttfnTcdIP;
-static uint32_t      bttfnTCDSeqCnt = 0;
-static uint32_t      bttfnTCDDataSeqCnt = 0;
+static bttfnSeq      bttfnTCDSpdSeq;
+static bttfnSeq      bttfnTCDDataSeq;
 static uint32_t      bttfnSessionID = 0;
 int                  bttfnHaveTCDSSID = 0;
 char                 TCDSSID[8] = { 0 };
 uint8_t              TCDpwMarker = 0;
 static uint8_t       bttfnReqStatus = 0x53; // Request capabilities, status, speed, date/time
 static bool          TCDSupportsRemKP = false;
-static bool          TCDSupportsNOTData = false;
 static bool          TCDSupportsSSID = false;
-static bool          bttfnDataNotEnabled = false;
-static uint32_t      tcdHostNameHash = 0;
-static byte          BTTFMCBuf[BTTF_PACKET_SIZE];
 static IPAddress     bttfnMcIP(224, 0, 0, 224);
 static uint32_t      bttfnSeqCnt[BTTFN_REM_MAX_COMMAND+1] = { 1 };
 
+typedef struct {
+    bttfnBuf buf;
+    uint32_t stamp;             // micros() at arrival
+    uint32_t addr;              // sender
+} bttfnRxSlot;
+
+static bttfnRxSlot   bttfnRxRing[BTTFN_RX_RING];
+static uint32_t      bttfnRxHead = 0;     // written by receiver
+static uint32_t      bttfnRxTail = 0;     // written by main_loop()
+static uint32_t      bttfnRxTcdAddr = 0;  // written by main_loop(); 0 = unknown
+static bttfnRxStats  bttfnRxSt;
+static TaskHandle_t  bttfnRxTaskHandle = NULL;
+
+static bttfnBuf      bttfnSABuf;          // SA band data; header prepared once
+static uint32_t      bttfnSASeq = 0;
+
+// Pattern mirroring
+static bttfnBuf      bttfnMirBuf;           // leader: outgoing; follower: last received
+static uint32_t      bttfnMirFrame = 0;     // leader: last sent frame number
+static bttfnMirRx    bttfnMirIn;            // follower
+static bool          bttfnMirPending = false;
+
+static uint32_t      bttfnRxCurStamp = 0; // micros() at arrival of packet being handled
+static unsigned long bttfnRttProbeNow = 0;
+
+static bttfnCacheEntry bttfnCache;        // as last saved
+static uint8_t       bttfnTCDCaps = 0;
+
 enum {
     BTTFN_KP_KS_PRESSED,
     BTTFN_KP_KS_HOLD,
 };
 
-static int      iCmdIdx = 0;
-static int      oCmdIdx = 0;
-static uint32_t commandQueue[16] = { 0 };
-
 static uint8_t  bttfnDateBuf[8] = { 0xff };
 static unsigned long bttfnDateNow = 0;
 
-#ifdef ESP32
-/*  "warning: taking address of packed member of 'struct <anonymous>' may 
- *  result in an unaligned pointer value"
- *  "GCC will issue this warning when accessing an unaligned member of 
- *  a packed struct due to the incurred penalty of unaligned memory 
- *  access. However, all ESP chips (on both Xtensa and RISC-V 
- *  architectures) allow for unaligned memory access and incur no extra 
- *  penalty."
- *  https://docs.espressif.com/projects/esp-idf/en/v5.1/esp32s3/migration-guides/release-5.x/5.0/gcc.html
- */
-#define GET32(a,b)    *((uint32_t *)((a) + (b)))
-#define SET32(a,b,c)  *((uint32_t *)((a) + (b))) = c
-#else
-#define GET32(a,b)          \
-    (((a)[b])            |  \
-    (((a)[(b)+1]) << 8)  |  \
-    (((a)[(b)+2]) << 16) |  \
-    (((a)[(b)+3]) << 24))   
-#define SET32(a,b,c)                        \
-    (a)[b]       = ((uint32_t)(c)) & 0xff;  \
-    ((a)[(b)+1]) = ((uint32_t)(c)) >> 8;    \
-    ((a)[(b)+2]) = ((uint32_t)(c)) >> 16;   \
-    ((a)[(b)+3]) = ((uint32_t)(c)) >> 24; 
-#endif 
-
 // Forward declarations ------
 
 static void startIRLearn();
 static void endIRLearn(bool restore);
 static void handleIRinput();
 static void handleIRKey(int command);
-static void handleRemoteCommand();
+static void handleEvents();
+static void handleRemoteCommand(uint32_t command);
 static void clearInpBuf();
 static int  execute(bool isIR, bool injected);
 static void startIRfeedback();
 static void endIRfeedback();
+static void armIRfeedback();
+static void startDelayedSave();
+
+static void irFBDone();
+static void irErrFBTick();
+static void irLearnFBTick();
+static void irLearnTimeout();
+static void irLNTrigger();
+static void delayedSave();
 
 static void showBaseLine(int variation = 20, uint16_t flags = 0);
+static uint16_t showBaseLine(const idleFrame *fr);
 static bool showIdle(bool freezeBaseLine = false);
+static uint16_t showIdleFrame(const idleFrame *fr);
 static void play_startup();
 static void timeTravel(bool TCDtriggered, uint16_t P0Dur, uint16_t P1Dur = 0);
 
+static void drawSeqFrame(sidSeq *sq, int idx);
+
 static void showChar(const char text);
 static void fadeOutChar();
+static void animDone();
+static void abortAnim();
 
 static void span_start();
 static void span_stop(bool skipClearDisplay = false);
@@ -561,6 +555,12 @@ static bool bttfn_trigger_tt();
 static bool bttfn_send_command(uint8_t cmd, uint8_t p1, uint8_t p2);
 static void bttfn_setup();
 static void bttfn_loop_quick();
+static uint32_t bttfn_transitDelay();
+static void bttfn_noteTTStart(uint32_t stamp);
+static bool bttfn_mirFollowing();
+static bool bttfn_mirShow();
+static void bttfn_mirReceive(bttfnBuf *buf, uint32_t addr);
+static void bttfn_mirSend(const idleFrame *fr);
 
 void main_boot()
 {
@@ -572,12 +572,22 @@ void main_boot()
     digitalWrite(TT_OUT_PIN, LOW);
 }
 
+static void IRAM_ATTR TTInISR()
+{
+    sched_wakeFromISR();
+}
+
 void main_setup()
 {
     char *s = LM;
     
     Serial.println("Status Indicator Display version " SID_VERSION " " SID_VERSION_EXTRA);
 
+    // Seed PRNG for animations
+    sid_seedRandom();
+
+    mem_setup();
+
     // Load settings
     loadBrightness();
     loadIdlePat();                    // load idle pattern
@@ -597,6 +607,9 @@ void main_setup()
     useNM = evalBool(settings.useNM);
     useFPO = evalBool(settings.useFPO);
     bttfnTT = evalBool(settings.bttfnTT);
+    saBcast = evalBool(settings.saBcast);
+    sidMirror = atoi(settings.sidMirror);
+    if(sidMirror < SID_MIRROR_OFF || sidMirror > SID_MIRROR_FOLLOW) sidMirror = SID_MIRROR_OFF;
     ssClock = evalBool(settings.ssClock);
     ssClockOffinNM = evalBool(settings.ssClockOffNM);
 
@@ -650,22 +663,49 @@ void main_setup()
     Serial.println("Booting IR Receiver");
     #endif
     ir_remote.begin();
+    power_setup(&ir_remote);
 
     memset(bttfnDateBuf, 0xff, sizeof(bttfnDateBuf));
 
-    // Initialize BTTF network
-    bttfn_setup();
-    bttfn_loop();
+    // BTTF network is initialized in main_loop() once
+    // the network task has connected
 
     // Other inits
-    idleDelay2 = 800 + ((int)(esp_random() % 200) - 100);
+    anim_onDone(animDone);
+
+    // Timers
+    sched_init();
+    inpClrTask = sched_create(clearInpBuf);
+    irFBTask = sched_create(irFBDone);
+    irErrFBTask = sched_create(irErrFBTick);
+    irLearnFBTask = sched_create(irLearnFBTick);
+    irLearnTOTask = sched_create(irLearnTimeout);
+    irLNTask = sched_create(irLNTrigger);
+    saveTask = sched_create(delayedSave);
+
+    // Wake up main loop on TT input
+    attachInterrupt(TT_IN_PIN, TTInISR, CHANGE);
+
+    // Sequences
+    seq_openMem(&ttSeqFull, ttledseqfull, sizeof(ttledseqfull));
+    seq_openMem(&ttSeq, ttledseq, sizeof(ttledseq));
+    if(seq_openSD(&idleSeq, SEQ_IDLE_FN)) {
+        Serial.printf("Using custom idle sequence (%d frames)\n", seq_numFrames(&idleSeq));
+    } else {
+        seq_openMem(&idleSeq, idle5, sizeof(idle5));
+    }
+    idleSt.strictSeq = &ttSeqFull;
+    idleSt.blSeq = &idleSeq;
+    
+    idleDelay2 = 800 + ((int)(sidRandom() % 200) - 100);
 
     for( ; *s; ++s) *s ^= (SBLF_SKIPSHOW + SBLF_STRICT);
 
     // If "Follow TCD fake power" is set,
-    // stay silent and dark
+    // stay silent and dark. WiFi connects in the
+    // background; if it fails, we boot in main_loop().
 
-    if(useBTTFN && useFPO && (WiFi.status() == WL_CONNECTED)) {
+    if(settings.tcdIP[0] && useFPO && wifi_staConfigured()) {
       
         FPBUnitIsOn = false;
         tcdFPO = fpoOld = true;
@@ -708,16 +748,30 @@ void main_setup()
 
 void main_loop()
 {
-    unsigned long now = millis();
+    unsigned long now = sidMillis();
 
     // Reset polling interval; will be overruled in showIdle if applicable
-    bttfnSIDPollInt = BTTFN_POLL_INT;
+    bttfnCl.pollInt = BTTFN_POLL_INT;
+
+    // Network setup finished in background
+    if(!bttfnSetupDone && wifi_isSetupDone()) {
+        bttfnSetupDone = true;
+        bttfn_setup();
+        // Radio is on now; mix RF noise into PRNG
+        sid_reseedRandom();
+        // No network: Don't wait for TCD fake power on
+        if(useFPO && tcdFPO && (WiFi.status() != WL_CONNECTED)) {
+            tcdFPO = false;
+        }
+    }
 
     // Follow TCD fake power
     if(useFPO && (tcdFPO != fpoOld)) {
         if((fpoOld = tcdFPO)) {
             // Power off:
             FPBUnitIsOn = false;
+
+            abortAnim();
             
             if(TTrunning) {
                 TTrunning = false;
@@ -731,12 +785,14 @@ void main_loop()
             if(irFeedBack || irErrFeedBack) {
                 endIRfeedback();
                 irFeedBack = irErrFeedBack = false;
+                sched_stop(irFBTask);
+                sched_stop(irErrFBTask);
             }
             
             if(IRLearning) {
                 endIRLearn(true); // Turns LEDs on
             }
-            triggerIRLN = false;
+            sched_stop(irLNTask);
             
             // Display OFF
             sid.off();
@@ -750,15 +806,14 @@ void main_loop()
             snake_stop();
 
             flushDelayedSave();
-
-            doPrepareTT = false;
-            doWakeup = false;
             
             // anything else?
             
         } else {
             // Power on: 
             FPBUnitIsOn = true;
+
+            abortAnim();
             
             // Display ON, idle
             sid.clearDisplayDirect();
@@ -776,7 +831,7 @@ void main_loop()
             ssRestartTimer();
             ssActive = ssIsClock = false;
 
-            sidBaseLine = strictBaseLine = 0;
+            idleSt.baseLine = idleSt.strictBaseLine = 0;
             LMState = LMIdx = id5idx = 0;
 
             ir_remote.loop();
@@ -792,55 +847,20 @@ void main_loop()
         }
     }
 
-    // Discard (incomplete) input from IR after 30 seconds of inactivity
-    if(now - lastKeyPressed >= 30*1000) {
-        clearInpBuf();
+    // Advance running animation (word sequences, startup, etc)
+    anim_loop();
+    if(FPBUnitIsOn) {
+        PROF_BOOT(BOOT_FRAME);
     }
 
-    // Eval flags set in handle_tcd_notification
-    if(doPrepareTT) {
-        if(FPBUnitIsOn && !IRLearning && !TTrunning) {
-            prepareTT();
-        }
-        doPrepareTT = false;
-    }
-    if(doWakeup) {
-        if(FPBUnitIsOn && !IRLearning && !TTrunning) {
-            wakeup();
-        }
-        doWakeup = false;
-    }
+    // Display sub-frames (dither mode)
+    sid.ditherLoop();
 
-    // IR feedback
-    if(irErrFeedBack && (now - irErrFeedBackNow > 250)) {
-        irErrFeedBackNow = now;
-        irErrFBState++;
-        if(irErrFBState > 3) {
-            irErrFeedBack = false;
-            endIRfeedback();
-        } else {
-            (irErrFBState & 0x01) ? endIRfeedback() : startIRfeedback();
-            irErrFeedBack = true;  // startIR clears it, so set it again
-        }
-    }
-    if(irFeedBack && (now - irFeedBackNow > irFeedBackDur)) {
-        endIRfeedback();
-        irFeedBack = false;
-    }
+    // IR feedback, IR learning blink/timeout, delayed saves, etc
+    sched_run();
 
     if(IRLearning) {
         ssRestartTimer();
-        if(now - IRFBLearnNow > 200) {
-            IRLearnBlink = !IRLearnBlink;
-            IRLearnBlink ? endIRfeedback() : startIRfeedback();
-            IRFBLearnNow = now;
-        }
-        if(now - IRLearnNow > 20000) {
-            endIRLearn(true);
-            #ifdef SID_DBG
-            Serial.println("main_loop: IR learning timed out");
-            #endif
-        }
     }
 
     // IR Remote loop
@@ -848,29 +868,18 @@ void main_loop()
         if(ir_remote.loop()) {
             handleIRinput();
         }
-        if(!IRLearning) {
-            handleRemoteCommand();
-        }
     }
 
+    // Eval events posted by BTTFN and MQTT
+    handleEvents();
+
     // Spectrum analyzer / Siddly / Snake loops
-    if(FPBUnitIsOn && !TTrunning) {
-        //unsigned long now2 = millis();
+    if(FPBUnitIsOn && !TTrunning && !anim_running()) {
         sa_loop();
-        //now2 = millis() - now2;
-        //if(now2 > 0) Serial.printf("%d\n", now2);
         si_loop();
         sn_loop();
     }
     
-    // IR learning triggered by IR?
-    if(triggerIRLN && (now - triggerIRLNNow > 1000)) {
-        triggerIRLN = false;
-        if(!TTrunning) {
-            isTTKeyHeld = true;
-        }
-    }
-
     // TT button evaluation
     if(FPBUnitIsOn && !TTrunning) {
         ttkeyScan();
@@ -912,14 +921,18 @@ void main_loop()
             if(!networkAbort) {
                 ssEnd();
                 timeTravel(networkTCDTT, networkLead, networkP1);
+                if(networkTTStamp) {
+                    bttfn_noteTTStart(networkTTStamp);
+                }
             }
+            networkTTStamp = 0;
         }
     } else {
         isTTKeyHeld = isTTKeyPressed = false;
         TTKey.reset();
     }
 
-    now = millis();
+    now = sidMillis();
     
     if(TTrunning) {
 
@@ -949,14 +962,10 @@ void main_loop()
                                     TTcnt--;
                                     if(TTsbFlags & SBLF_STRICT) {
                                         TTsidBaseLineIdx = TT_SQF_LN - 1 - TTcnt;
-                                        for(int i = 0; i < 10; i++) {
-                                            sid.drawBarWithHeight(i, ttledseqfull[TT_SQF_LN - 1 - TTcnt][i]);
-                                        }
+                                        drawSeqFrame(&ttSeqFull, TT_SQF_LN - 1 - TTcnt);
                                     } else {
                                         TTsidBaseLineIdx = TT_SQ_LN - 1 - TTcnt;
-                                        for(int i = 0; i < 10; i++) {
-                                            sid.drawBarWithHeight(i, ttledseq[TT_SQ_LN - 1 - TTcnt][i]);
-                                        }
+                                        drawSeqFrame(&ttSeq, TT_SQ_LN - 1 - TTcnt);
                                     }
                                     sid.show();
                                 }
@@ -987,9 +996,7 @@ void main_loop()
                         if(TTstart == TTfUpdNow) {
                             // If we have missed P0, set last step of sequence at least
                             // Do this also in sa mode and if strict (pattern is same)
-                            for(int i = 0; i < 10; i++) {
-                                sid.drawBarWithHeight(i, ttledseq[TT_SQ_LN - 1][i]);
-                            }
+                            drawSeqFrame(&ttSeq, TT_SQ_LN - 1);
                             sid.show();
                         }
     
@@ -999,16 +1006,16 @@ void main_loop()
                             TTSAStopped = true;
                         }
 
-                        strictBaseLine = TT_SQF_LN - 1;
-                        sidBaseLine = 19;
+                        idleSt.strictBaseLine = TT_SQF_LN - 1;
+                        idleSt.baseLine = 19;
 
                     } else {
 
                         // determine baseline at time of abort
                         if(TTsbFlags & SBLF_STRICT) {
-                            strictBaseLine = TTsidBaseLineIdx;
+                            idleSt.strictBaseLine = TTsidBaseLineIdx;
                         } else {
-                            sidBaseLine = TTsidBaseLineIdx;
+                            idleSt.baseLine = TTsidBaseLineIdx;
                         }
 
                     }
@@ -1017,7 +1024,7 @@ void main_loop()
                     TTP1 = true;
                     
                     TTstart = TTfUpdNow = now;
-                    TTFInt = 1000 + ((int)(esp_random() % 200) - 100);
+                    TTFInt = 1000 + ((int)(sidRandom() % 200) - 100);
 
                     TTClrBar = TTBarCnt = 0;
                     TTClrBarInc = 1;
@@ -1032,7 +1039,7 @@ void main_loop()
 
                 if(((networkTCDTT && (!networkReentry && !networkAbort)) || 
                   (!networkTCDTT && digitalRead(TT_IN_PIN)))               &&
-                  (millis() - TTstart <  P1_maxtimeout) ) {
+                  (sidMillis() - TTstart <  P1_maxtimeout) ) {
 
                     if(TTFInt && (now - TTfUpdNow >= TTFInt)) {
                         if(TTLMTrigger) {
@@ -1045,7 +1052,7 @@ void main_loop()
                             TTLMTrigger = true;
                             TTFInt = 130;
                         } else {
-                            TTFInt = 100 + ((int)(esp_random() % 100) - 50);
+                            TTFInt = 100 + ((int)(sidRandom() % 100) - 50);
                         }
                     }
                     
@@ -1079,7 +1086,7 @@ void main_loop()
                             sa_setAmpFact(TTampFacts[TT_AMP_STEPS - 1 - TTcnt]);
                         }
                         TTfUpdNow = now;
-                        TTFInt = 400 + ((int)(esp_random() % 100) - 50);
+                        TTFInt = 400 + ((int)(sidRandom() % 100) - 50);
                     }
                     sa_loop();
                 } else {
@@ -1116,13 +1123,9 @@ void main_loop()
                                 if(TTcnt > 0) {
                                     TTcnt--;
                                     if(TTsbFlags & SBLF_STRICT) {
-                                        for(int i = 0; i < 10; i++) {
-                                            sid.drawBarWithHeight(i, ttledseqfull[TT_SQF_LN - 1 - TTcnt][i]);
-                                        }
+                                        drawSeqFrame(&ttSeqFull, TT_SQF_LN - 1 - TTcnt);
                                     } else {
-                                        for(int i = 0; i < 10; i++) {
-                                            sid.drawBarWithHeight(i, ttledseq[TT_SQ_LN - 1 - TTcnt][i]);
-                                        }
+                                        drawSeqFrame(&ttSeq, TT_SQ_LN - 1 - TTcnt);
                                     }
                                     sid.show();
                                 }
@@ -1155,10 +1158,10 @@ void main_loop()
 
                     TTP0 = false;
                     TTP1 = true;
-                    sidBaseLine = 19;
-                    strictBaseLine = TT_SQF_LN - 1;
+                    idleSt.baseLine = 19;
+                    idleSt.strictBaseLine = TT_SQF_LN - 1;
                     TTstart = TTfUpdNow = now;
-                    TTFInt = 1000 + ((int)(esp_random() % 200) - 100);
+                    TTFInt = 1000 + ((int)(sidRandom() % 200) - 100);
 
                     TTClrBar = TTBarCnt = 0;
                     TTClrBarInc = 1;
@@ -1185,7 +1188,7 @@ void main_loop()
                             TTLMTrigger = true;
                             TTFInt = 130;
                         } else {
-                            TTFInt = 100 + ((int)(esp_random() % 100) - 50);
+                            TTFInt = 100 + ((int)(sidRandom() % 100) - 50);
                         }
                     }
                     
@@ -1220,7 +1223,7 @@ void main_loop()
                             sa_setAmpFact(TTampFacts[TT_AMP_STEPS - 1 - TTcnt]);
                         }
                         TTfUpdNow = now;
-                        TTFInt = 400 + ((int)(esp_random() % 100) - 50);
+                        TTFInt = 400 + ((int)(sidRandom() % 100) - 50);
                     }
                     sa_loop();
                 } else {
@@ -1238,14 +1241,14 @@ void main_loop()
 
     } else if(!siActive && !snActive && !saActive) {    // No TT currently
 
-        if(!IRLearning) {
+        if(!IRLearning && !anim_running()) {
 
             if(networkAlarm || mqttDisp) {
             
                 ssEnd();
                 
                 if(!FPBUnitIsOn) {
-                    sid.on();
+                    anim_addCmd(ANIM_ON);
                 }
 
                 if(networkAlarm) {
@@ -1253,12 +1256,12 @@ void main_loop()
                     showWordSequence("ALARM", 4);
                     networkAlarm = false;
                 } else {
-                    showWordSequence(mqttMsg, 4);
-                    mqttDisp = 0;
+                    showWordSequence(mqttDispMsg, 4);
+                    mqttDisp = false;
                 }
                 
                 if(!FPBUnitIsOn) {
-                    sid.off();
+                    anim_addCmd(ANIM_OFF);
                 }
               
             } else {
@@ -1271,7 +1274,7 @@ void main_loop()
                     oldGpsSpeed = gpsSpeed;
                 }
     
-                now = millis();
+                now = sidMillis();
     
                 // "Screen saver"
                 if(FPBUnitIsOn) {
@@ -1292,6 +1295,12 @@ void main_loop()
                                 sid.show();
                             }
                         }
+                        // Wake up in time for next step of idle pattern
+                        if(useGPSS && gpsSpeed >= 0) {
+                            sched_wakeAt(lastChange + (spd_moving(&gpsSpdEst, now) ? GPSS_FRAME_INT : 500));
+                        } else {
+                            sched_wakeAt(lastChange + idleDelay);
+                        }
                     }
                 }
             }
@@ -1322,41 +1331,56 @@ void main_loop()
         nmOld = tcdNM;
     }
 
-    now = millis();
+    now = sidMillis();
 
     // If network is interrupted, return to stand-alone
     if(useBTTFN) {
-        if( !bttfnDataNotEnabled &&
+        if( !bttfnCl.notData &&
             ((lastBTTFNpacket && (now - lastBTTFNpacket > 30*1000)) ||
              (!BTTFNBootTO && !lastBTTFNpacket && (now - powerupMillis > 60*1000))) ) {
             tcdNM = false;
             tcdFPO = false;
             remoteAllowed = remMode = remHoldKey = false;
             gpsSpeed = -1;
+            spd_reset(&gpsSpdEst);
             lastBTTFNpacket = 0;
             BTTFNBootTO = true;
         }
     }
 
-    if(!TTrunning) {
-        if(brichgnow && (now - brichgnow > 10000)) {
-            // Save brightness 10 seconds after last change
-            brichgnow = 0;
-            saveBrightness();
-        } else if(ipachgnow && (now - ipachgnow > 10000)) {
-            // Save idle pattern 10 seconds after last change
-            ipachgnow = 0;
-            saveIdlePat();
-        } else if(irlchgnow && (now - irlchgnow > 10000)) {
-            // Save irlock 10 seconds after last change
-            irlchgnow = 0;
-            saveIRLock();
-        } else if(bmdchgnow && (now - bmdchgnow > 10000)) {
-            // Save boot mode 10 seconds after last change
-            bmdchgnow = 0;
-            saveBootMode();
-        }
+    // Heap telemetry, pressure hooks
+    mem_loop();
+
+    // Power save while display is dark
+    if(power_loop((!FPBUnitIsOn || (ssActive && !ssIsClock)) && 
+                  !TTrunning && !IRLearning && !anim_running() && 
+                  !saActive && !siActive && !snActive,
+                  !FPBUnitIsOn ? PWR_IR_OFF : (irLocked ? PWR_IR_KEEP : PWR_IR_WAKE))) {
+        // IR light ends screen saver
+        ssEnd();
     }
+
+    // Keep looping at full speed while something animates
+    if(TTrunning || saActive || siActive || snActive || anim_running() || sid.isDithering()) {
+        sched_busy();
+    }
+}
+
+// Save settings 10 seconds after last change; not
+// during time travel, retry a second later then.
+static void startDelayedSave()
+{
+    sched_once(saveTask, 10000);
+}
+
+static void delayedSave()
+{
+    if(TTrunning) {
+        sched_once(saveTask, 1000);
+        return;
+    }
+    
+    flushDelayedSave();
 }
 
 void flushDelayedSave()
@@ -1382,80 +1406,37 @@ void flushDelayedSave()
     }
 }
 
+static void drawSeqFrame(sidSeq *sq, int idx)
+{
+    uint8_t h[SEQ_MAX_BARS];
+
+    if(seq_frame(sq, idx, h)) {
+        for(int i = 0; i < 10; i++) {
+            sid.drawBarWithHeight(i, h[i]);
+        }
+    }
+}
+
 static void showBaseLine(int variation, uint16_t flags)
 {
-    const int mods[21][10] = {
-        { 130, 90, 10,  80,  10, 110, 100,  15, 120,  90 }, // g 0
-        { 130, 90, 10,  80,  10, 110, 100,  15, 100,  90 }, // g 1
-        { 130, 90, 20,  80,  15, 110, 100,  15, 120, 100 }, // g 2
-        { 110,100, 70,  80,  30,  50, 100,  15, 100, 110 }, // g 3
-        { 110,110, 40,  90,  30,  50, 100,  15,  80, 100 }, // g 4
-        { 110,110, 30, 120,  30,  50, 110,  15,  50, 100 }, // g 5
-        { 100,100, 20, 120,  10,  50, 110,  20,  40, 110 }, // g 6
-        { 110,120, 15, 110,  20,  40, 110,  18,  40, 100 }, // g 7
-        { 100,100, 15, 110,  20,  50, 100,  15,  50,  90 }, // g 8
-        {  90,110,  0, 100,  20,  50, 100,  15,  60, 100 }, // g 9
-        {  90,100, 10, 100,  10,  60,  90,  15,  40, 100 }, // g 10
-        {  90,100, 10, 100,  10,  90,  90,  15, 110, 100 }, // g 11
-        {  90, 90, 20,  90,  15, 100, 100,  50, 100,  90 }, // g 12
-        {  90, 90, 20,  90,  15, 100, 100,  50, 100,  90 }, // y 13
-        {  90, 80, 10,  80,  15,  90,  80,  50, 100,  80 }, // y 14
-        {  90, 80, 10,  80,  15,  90,  80,  50, 100,  80 }, // y 15
-        {  90, 80, 10,  80,  15,  90,  80,  50, 100,  80 }, // y 16
-        {  90, 70, 20,  70,  15,  70,  70,  40, 100,  70 }, // y 17
-        {  90, 70, 20,  70,  15,  70,  70,  40,  90,  70 }, // y 18
-        {  90, 60, 25,  60,  15,  80,  60,  40,  90,  60 }, // r 19
-        {  90, 90, 70, 100,  90, 110,  90,  60,  95,  80 }  // extra for TT
-    };
-    const uint8_t maxTTHeight[10] = {
-        19, 19, 12, 19, 19, 18, 19,  9, 19, 16
-    };
+    idleFrame fr = { variation, flags, 0, 0 };
 
-    int bh, a = sidBaseLine, b;
-    int vc = (flags & SBLF_ISTT) ? 0 : variation / 2;
+    showBaseLine(&fr);
+}
 
-    if(!(flags & SBLF_NOBL)) {
-          
-        if(a < 0) a = 0;
-        if(a > 19) a = 19;
+// Returns ms until a backlot frame changes next
+static uint16_t showBaseLine(const idleFrame *fr)
+{
+    uint16_t flags = fr->flags;
+    uint8_t bars[IDLE_BARS];
+    uint16_t next;
 
-        b = (flags & SBLF_ISTT) ? 20 : a;
-    
-        if(flags & SBLF_REPEAT) {
-            // (Never set in strict mode)
-            for(int i = 0; i < 10; i++) {
-                sid.drawBar(i, 0, oldIdleHeight[i]);
-            }
-        } else {
-            if(!(flags & SBLF_STRICT)) {
-                for(int i = 0; i < 10; i++) {
-                    bh = a * (mods[b][i] + ((int)(esp_random() % variation)-vc)) / 100;
-                    if(bh < 0) bh = 0;
-                    if(bh > 19) bh = 19;
-                    if((flags & SBLF_LM) && bh < 9) {
-                        bh = 9 + (int)(esp_random() % 4);
-                    }
-                    if(!(flags & SBLF_ISTT) && abs(bh - oldIdleHeight[i]) > 5) {
-                        bh = (oldIdleHeight[i] + bh) / 2;
-                    }
-                    if(flags & SBLF_ISTT) {
-                        if(bh > maxTTHeight[i] || (!(flags & SBLF_ANIM))) bh = maxTTHeight[i];
-                    }
-                    sid.drawBar(i, 0, bh);
-                    oldIdleHeight[i] = bh;
-                }
-            } else {
-                for(int i = 0; i < 10; i++) {
-                    bh = ttledseqfull[strictBaseLine][i];
-                    if(flags & SBLF_ISTT) {
-                        if(bh > maxTTHeight[i] + 1 || (!(flags & SBLF_ANIM))) bh = maxTTHeight[i] + 1;
-                    }
-                    sid.drawBarWithHeight(i, bh);
-                    if(bh > 0) bh--;
-                    oldIdleHeight[i] = bh;
-                }
-            }
-        }
+    next = idle_bars(&idleSt, fr, bars);
+    for(int i = 0; i < 10; i++) {
+        sid.drawBarWithHeight(i, bars[i]);
+    }
+
+    if(!(flags & SBLF_NOBL)) {
     
         if(flags & SBLF_ISTT) {
             if(flags & SBLF_ANIM) {
@@ -1478,7 +1459,7 @@ static void showBaseLine(int variation, uint16_t flags)
                 int temp1 = sid.getBrightness(), temp2 = 3;
                 if(temp1 >= 4) temp1 -= 2;
                 else { temp1 = 2; temp2 = 0; }
-                sid.setBrightnessDirect((esp_random() % temp1) + temp2); //       13) + 3);
+                sid.setBrightnessDirect((sidRandom() % temp1) + temp2); //       13) + 3);
             }
             if(flags & SBLF_LMTT) {
                 if(LMTT[TTLMIdx]) {
@@ -1494,61 +1475,74 @@ static void showBaseLine(int variation, uint16_t flags)
     }
 
     #ifdef SID_DBG
-    //Serial.printf("baseline %d, strict %d\n", sidBaseLine, strictBaseLine);
+    //Serial.printf("baseline %d, strict %d\n", idleSt.baseLine, idleSt.strictBaseLine);
     #endif
+
+    return next;
 }
 
 static bool showIdle(bool freezeBaseLine)
 {
-    unsigned long now = millis();
-    int oldBaseLine = sidBaseLine;
-    int oldSBaseLine = strictBaseLine;
+    unsigned long now = sidMillis();
+    int oldBaseLine = idleSt.baseLine;
+    int oldSBaseLine = idleSt.strictBaseLine;
     int variation = 20;
     uint16_t sblFlags = 0;
 
-    idleDelay2 = 800 + ((int)(esp_random() % 200) - 100);
+    // Follower: Frames come from leader; not during TT, where
+    // we are called for our own pattern
+    if(!TTrunning && bttfn_mirFollowing()) {
+        return bttfn_mirShow();
+    }
+
+    idleDelay2 = 800 + ((int)(sidRandom() % 200) - 100);
 
     if(useGPSS && gpsSpeed >= 0) {
 
-        if(!bttfnTCDSeqCnt) {
-            bttfnSIDPollInt = BTTFN_POLL_INT_FAST;
+        int spd = spd_estimate(&gpsSpdEst, now);
+        unsigned long frameInt = spd_moving(&gpsSpdEst, now) ? GPSS_FRAME_INT : 500;
+
+        if(spd < 0) spd = gpsSpeed;
+
+        if(!bttfnTCDSpdSeq.last) {
+            bttfnCl.pollInt = BTTFN_POLL_INT_FAST;
         }
 
         usingGPSS = true;
        
         if(!strictMode) {
-            if(now - lastChange < 500)
+            if(now - lastChange < frameInt)
                 return false;
 
             if(!freezeBaseLine) {
-                sidBaseLine = (max(10, (int)gpsSpeed) * 20 / 88) - 1;
-                if(sidBaseLine > 19) sidBaseLine = 19;
-                if(abs(oldBaseLine - sidBaseLine) > 3) {
-                    sidBaseLine = (sidBaseLine + oldBaseLine) / 2;
+                idleSt.baseLine = (max(10, spd) * 20 / 88) - 1;
+                if(idleSt.baseLine > 19) idleSt.baseLine = 19;
+                if(abs(oldBaseLine - idleSt.baseLine) > 3) {
+                    idleSt.baseLine = (idleSt.baseLine + oldBaseLine) / 2;
                 }
             }
             
         } else {
           
-            if((gpsSpeed == prevGPSSpeed) && (now - lastChange < 500))
+            if(now - lastChange < ((spd == prevGPSSpeed) ? 500 : GPSS_FRAME_INT))
                 return false;
             
             if(!freezeBaseLine) {
-                strictBaseLine = gpsSpeed * 100 / (88 * 100 / (TT_SQF_LN - 1));
-                if(gpsSpeed == prevGPSSpeed) {
-                    if(strictBaseLine < 5) {
-                        strictBaseLine += (esp_random() % 5);
-                    } else if(strictBaseLine > TT_SQF_LN - 4) {
+                idleSt.strictBaseLine = spd * 100 / (88 * 100 / (TT_SQF_LN - 1));
+                if(spd == prevGPSSpeed) {
+                    if(idleSt.strictBaseLine < 5) {
+                        idleSt.strictBaseLine += (sidRandom() % 5);
+                    } else if(idleSt.strictBaseLine > TT_SQF_LN - 4) {
                         // no modify
                     } else {
-                        strictBaseLine += (((esp_random() % 5)) - 2);
+                        idleSt.strictBaseLine += (((sidRandom() % 5)) - 2);
                     }
-                    if(strictBaseLine < 0) strictBaseLine = 0;
-                    if(strictBaseLine > TT_SQF_LN-2) strictBaseLine = TT_SQF_LN-2;
+                    if(idleSt.strictBaseLine < 0) idleSt.strictBaseLine = 0;
+                    if(idleSt.strictBaseLine > TT_SQF_LN-2) idleSt.strictBaseLine = TT_SQF_LN-2;
                 }
-                if(strictBaseLine > TT_SQF_LN-1) strictBaseLine = TT_SQF_LN-1;
-                if(abs(oldSBaseLine - strictBaseLine) > 3) {
-                    strictBaseLine = (strictBaseLine + oldSBaseLine) / 2;
+                if(idleSt.strictBaseLine > TT_SQF_LN-1) idleSt.strictBaseLine = TT_SQF_LN-1;
+                if(abs(oldSBaseLine - idleSt.strictBaseLine) > 3) {
+                    idleSt.strictBaseLine = (idleSt.strictBaseLine + oldSBaseLine) / 2;
                 }
             }
             sblFlags |= SBLF_STRICT;
@@ -1556,24 +1550,22 @@ static bool showIdle(bool freezeBaseLine)
         }
         
         lastChange = now;
-        prevGPSSpeed = gpsSpeed;
+        prevGPSSpeed = spd;
 
     } else if(idleMode == SID_IDLE_BL) {     // "backlot mode"
-
-        if(now - lastChange < idleDelay)
+        
+        if(id5idx && (now - lastChange < idleDelay))
             return false;
           
         lastChange = now;
 
-        idleDelay = 90;
-
-        for(int i = 0; i < 10; i++) {
-            sid.drawBarWithHeight(i, idle5[id5idx][i]);
+        if(!id5idx) {
+            id5Start = now;
+            id5idx = 1;
         }
-        id5idx++;
-        if(id5idx >= ID5_STEPS) id5idx = 0;
-        
-        sidBaseLine = strictBaseLine = 0;
+
+        // Bars drawn and idleDelay set by showIdleFrame()
+        idleSt.baseLine = idleSt.strictBaseLine = 0;
         sblFlags |= SBLF_NOBL;
 
     } else {
@@ -1591,99 +1583,99 @@ static bool showIdle(bool freezeBaseLine)
 
         switch(idleMode) {
         case SID_IDLE_1:     // higher peaks, tempo as 0
-            idleDelay = 800 + ((int)(esp_random() % 200) - 100);
+            idleDelay = 800 + ((int)(sidRandom() % 200) - 100);
             if(!strictMode) {
                 if(!freezeBaseLine) {
-                    if(sidBaseLine > 16) {
-                        sidBaseLine -= (((esp_random() % 3)) + 1);
-                    } else if(sidBaseLine > 12) {
-                        sidBaseLine -= (((esp_random() % 3)) + 1);
-                    } else if(sidBaseLine < 3) {
-                        sidBaseLine += (((esp_random() % 3)) + 2);
+                    if(idleSt.baseLine > 16) {
+                        idleSt.baseLine -= (((sidRandom() % 3)) + 1);
+                    } else if(idleSt.baseLine > 12) {
+                        idleSt.baseLine -= (((sidRandom() % 3)) + 1);
+                    } else if(idleSt.baseLine < 3) {
+                        idleSt.baseLine += (((sidRandom() % 3)) + 2);
                     } else {
-                        sidBaseLine += (((esp_random() % 5)) - 1);
+                        idleSt.baseLine += (((sidRandom() % 5)) - 1);
                     }
                     variation = 40;
                 }
             } else {
                 if(!freezeBaseLine) {
-                    if(strictBaseLine > 40) {
-                        strictBaseLine -= (((esp_random() % 5)) + 1);
-                        blWayup = false;
-                    } else if(strictBaseLine < 10) {
-                        strictBaseLine += (((esp_random() % 5)) + 2);
-                        blWayup = true;
+                    if(idleSt.strictBaseLine > 40) {
+                        idleSt.strictBaseLine -= (((sidRandom() % 5)) + 1);
+                        idleSt.wayUp = false;
+                    } else if(idleSt.strictBaseLine < 10) {
+                        idleSt.strictBaseLine += (((sidRandom() % 5)) + 2);
+                        idleSt.wayUp = true;
                     } else {
-                        strictBaseLine += (((esp_random() % 7)) - (blWayup ? 2 : 4));
+                        idleSt.strictBaseLine += (((sidRandom() % 7)) - (idleSt.wayUp ? 2 : 4));
                     }
                 } else {
-                    if((esp_random() % 5) >= 2) {
-                        strictBaseLine ^= 0x01;   // toggle bit 0, nothing more
+                    if((sidRandom() % 5) >= 2) {
+                        idleSt.strictBaseLine ^= 0x01;   // toggle bit 0, nothing more
                     }
                 }
             }
             break;
         case SID_IDLE_2:       // Same as 0, but faster
-            idleDelay = 300 + ((int)(esp_random() % 200) - 100);
+            idleDelay = 300 + ((int)(sidRandom() % 200) - 100);
             if(!strictMode) {
                 if(!freezeBaseLine) {
-                    if(sidBaseLine > 14) {
-                        sidBaseLine -= (((esp_random() % 3)) + 1);
-                    } else if(sidBaseLine > 8) {
-                        sidBaseLine -= (((esp_random() % 5)) + 1);
-                    } else if(sidBaseLine < 3) {
-                        sidBaseLine += (((esp_random() % 3)) + 2);
+                    if(idleSt.baseLine > 14) {
+                        idleSt.baseLine -= (((sidRandom() % 3)) + 1);
+                    } else if(idleSt.baseLine > 8) {
+                        idleSt.baseLine -= (((sidRandom() % 5)) + 1);
+                    } else if(idleSt.baseLine < 3) {
+                        idleSt.baseLine += (((sidRandom() % 3)) + 2);
                     } else {
-                        sidBaseLine += (((esp_random() % 4)) - 1);
+                        idleSt.baseLine += (((sidRandom() % 4)) - 1);
                     }
                 }
             } else {
                 if(!freezeBaseLine) {
-                    if(strictBaseLine > 30) {
-                        strictBaseLine -= (((esp_random() % 3)) + 1);
-                        blWayup = false;
-                    } else if(strictBaseLine < 10) {
-                        strictBaseLine += (((esp_random() % 3)) + 2);
-                        blWayup = true;
+                    if(idleSt.strictBaseLine > 30) {
+                        idleSt.strictBaseLine -= (((sidRandom() % 3)) + 1);
+                        idleSt.wayUp = false;
+                    } else if(idleSt.strictBaseLine < 10) {
+                        idleSt.strictBaseLine += (((sidRandom() % 3)) + 2);
+                        idleSt.wayUp = true;
                     } else {
-                        strictBaseLine += (((esp_random() % 7)) - (blWayup ? 2 : 4));
+                        idleSt.strictBaseLine += (((sidRandom() % 7)) - (idleSt.wayUp ? 2 : 4));
                     }
                 } else {
-                    if((esp_random() % 5) >= 2) {
-                        strictBaseLine ^= 0x01;   // toggle bit 0, nothing more
+                    if((sidRandom() % 5) >= 2) {
+                        idleSt.strictBaseLine ^= 0x01;   // toggle bit 0, nothing more
                     }
                 }
             }
             break;
         case SID_IDLE_3:     // higher peaks, faster
-            idleDelay = 300 + ((int)(esp_random() % 200) - 100);
+            idleDelay = 300 + ((int)(sidRandom() % 200) - 100);
             if(!strictMode) {
                 if(!freezeBaseLine) {
-                    if(sidBaseLine > 16) {
-                        sidBaseLine -= (((esp_random() % 3)) + 1);
-                    } else if(sidBaseLine > 12) {
-                        sidBaseLine -= (((esp_random() % 3)) + 1);
-                    } else if(sidBaseLine < 3) {
-                        sidBaseLine += (((esp_random() % 3)) + 2);
+                    if(idleSt.baseLine > 16) {
+                        idleSt.baseLine -= (((sidRandom() % 3)) + 1);
+                    } else if(idleSt.baseLine > 12) {
+                        idleSt.baseLine -= (((sidRandom() % 3)) + 1);
+                    } else if(idleSt.baseLine < 3) {
+                        idleSt.baseLine += (((sidRandom() % 3)) + 2);
                     } else {
-                        sidBaseLine += (((esp_random() % 5)) - 1);
+                        idleSt.baseLine += (((sidRandom() % 5)) - 1);
                     }
                     variation = 40;
                 }
             } else {
                 if(!freezeBaseLine) {
-                    if(strictBaseLine > 40) {
-                        strictBaseLine -= (((esp_random() % 5)) + 1);
-                        blWayup = false;
-                    } else if(strictBaseLine < 10) {
-                        strictBaseLine += (((esp_random() % 5)) + 2);
-                        blWayup = true;
+                    if(idleSt.strictBaseLine > 40) {
+                        idleSt.strictBaseLine -= (((sidRandom() % 5)) + 1);
+                        idleSt.wayUp = false;
+                    } else if(idleSt.strictBaseLine < 10) {
+                        idleSt.strictBaseLine += (((sidRandom() % 5)) + 2);
+                        idleSt.wayUp = true;
                     } else {
-                        strictBaseLine += (((esp_random() % 7)) - (blWayup ? 2 : 4));
+                        idleSt.strictBaseLine += (((sidRandom() % 7)) - (idleSt.wayUp ? 2 : 4));
                     }
                 } else {
-                    if((esp_random() % 5) >= 2) {
-                        strictBaseLine ^= 0x01;   // toggle bit 0, nothing more
+                    if((sidRandom() % 5) >= 2) {
+                        idleSt.strictBaseLine ^= 0x01;   // toggle bit 0, nothing more
                     }
                 }
             }
@@ -1695,47 +1687,47 @@ static bool showIdle(bool freezeBaseLine)
                 sblFlags |= SBLF_REPEAT;
             } else {
                 if(!freezeBaseLine) {
-                    if(sidBaseLine > 18) {
-                        sidBaseLine -= (((esp_random() % 3)) + 1);
-                    } else if(sidBaseLine < 3) {
-                        sidBaseLine += (((esp_random() % 3)) + 2);
+                    if(idleSt.baseLine > 18) {
+                        idleSt.baseLine -= (((sidRandom() % 3)) + 1);
+                    } else if(idleSt.baseLine < 3) {
+                        idleSt.baseLine += (((sidRandom() % 3)) + 2);
                     } else {
-                        sidBaseLine += (((esp_random() % 5)) - 1);
+                        idleSt.baseLine += (((sidRandom() % 5)) - 1);
                     }
                     variation = 40;
                 }
                 lastChange2 = now;
-                idleDelay2 = 800 + ((int)(esp_random() % 200) - 100);
+                idleDelay2 = 800 + ((int)(sidRandom() % 200) - 100);
             }
             break;
         default:
-            idleDelay = 800 + ((int)(esp_random() % 200) - 100);
+            idleDelay = 800 + ((int)(sidRandom() % 200) - 100);
             if(!strictMode) {
                 if(!freezeBaseLine) {
-                    if(sidBaseLine > 14) {
-                        sidBaseLine -= (((esp_random() % 3)) + 1);
-                    } else if(sidBaseLine > 8) {
-                        sidBaseLine -= (((esp_random() % 5)) + 1);
-                    } else if(sidBaseLine < 3) {
-                        sidBaseLine += (((esp_random() % 3)) + 2);
+                    if(idleSt.baseLine > 14) {
+                        idleSt.baseLine -= (((sidRandom() % 3)) + 1);
+                    } else if(idleSt.baseLine > 8) {
+                        idleSt.baseLine -= (((sidRandom() % 5)) + 1);
+                    } else if(idleSt.baseLine < 3) {
+                        idleSt.baseLine += (((sidRandom() % 3)) + 2);
                     } else {
-                        sidBaseLine += (((esp_random() % 4)) - 1);
+                        idleSt.baseLine += (((sidRandom() % 4)) - 1);
                     }
                 }
             } else {
                 if(!freezeBaseLine) {
-                    if(strictBaseLine > 30) {
-                        strictBaseLine -= (((esp_random() % 3)) + 1);
-                        blWayup = false;
-                    } else if(strictBaseLine < 10) {
-                        strictBaseLine += (((esp_random() % 3)) + 2);
-                        blWayup = true;
+                    if(idleSt.strictBaseLine > 30) {
+                        idleSt.strictBaseLine -= (((sidRandom() % 3)) + 1);
+                        idleSt.wayUp = false;
+                    } else if(idleSt.strictBaseLine < 10) {
+                        idleSt.strictBaseLine += (((sidRandom() % 3)) + 2);
+                        idleSt.wayUp = true;
                     } else {
-                        strictBaseLine += (((esp_random() % 7)) - (blWayup ? 2 : 4));
+                        idleSt.strictBaseLine += (((sidRandom() % 7)) - (idleSt.wayUp ? 2 : 4));
                     }
                 } else {
-                    if((esp_random() % 5) >= 2) {
-                        strictBaseLine ^= 0x01;   // toggle bit 0, nothing more
+                    if((sidRandom() % 5) >= 2) {
+                        idleSt.strictBaseLine ^= 0x01;   // toggle bit 0, nothing more
                     }
                 }
             }
@@ -1746,12 +1738,12 @@ static bool showIdle(bool freezeBaseLine)
             if(usingGPSS) {
                 // Smoothen
                 if(!(sblFlags & SBLF_STRICT)) {
-                    if(abs(oldBaseLine - sidBaseLine) > 3) {
-                        sidBaseLine = (sidBaseLine + oldBaseLine) / 2;
+                    if(abs(oldBaseLine - idleSt.baseLine) > 3) {
+                        idleSt.baseLine = (idleSt.baseLine + oldBaseLine) / 2;
                     }
                 } else {
-                    if(abs(oldSBaseLine - strictBaseLine) > 7) {
-                        strictBaseLine = (strictBaseLine + oldSBaseLine) / 2;
+                    if(abs(oldSBaseLine - idleSt.strictBaseLine) > 7) {
+                        idleSt.strictBaseLine = (idleSt.strictBaseLine + oldSBaseLine) / 2;
                     }
                 }
                 usingGPSS = false;
@@ -1759,18 +1751,36 @@ static bool showIdle(bool freezeBaseLine)
         }
     }
 
-    if(sidBaseLine < 0) sidBaseLine = 0;
-    else if(sidBaseLine > 19) sidBaseLine = 19;
-    if(strictBaseLine < 0) strictBaseLine = 0;
-    else if(strictBaseLine > TT_SQF_LN-1) strictBaseLine = TT_SQF_LN-1;
+    if(idleSt.baseLine < 0) idleSt.baseLine = 0;
+    else if(idleSt.baseLine > 19) idleSt.baseLine = 19;
+    if(idleSt.strictBaseLine < 0) idleSt.strictBaseLine = 0;
+    else if(idleSt.strictBaseLine > TT_SQF_LN-1) idleSt.strictBaseLine = TT_SQF_LN-1;
+
+    idleFrame fr = { variation, sblFlags, 0, (uint32_t)(now - id5Start) };
+
+    // Leader: Pass state on before showBaseLine() consumes randomness
+    bttfn_mirSend(&fr);
     
-    showBaseLine(variation, sblFlags);
+    if(sblFlags & SBLF_NOBL) {
+        idleDelay = showIdleFrame(&fr);
+    } else {
+        showIdleFrame(&fr);
+    }
+
+    return true;
+}
+
+// Returns ms until a backlot frame changes next
+static uint16_t showIdleFrame(const idleFrame *fr)
+{
+    uint16_t sblFlags = fr->flags;
+    uint16_t next = showBaseLine(fr);
 
     if(sblFlags & SBLF_LM) {
         switch(LMState) {
         case 0:
             if(!LM[LMIdx]) LMIdx = 0;
-            LMAdvNow = millis();
+            LMAdvNow = sidMillis();
             LMDelay = (LM[LMIdx] == '.') ? 400 : 1000;
             LMState++;
             LMY = 11;
@@ -1778,8 +1788,8 @@ static bool showIdle(bool freezeBaseLine)
         case 1:
         case 2:
             sid.drawLetterMask(LM[LMIdx], 1, LMY);
-            if(millis() - LMAdvNow > LMDelay) {
-                LMAdvNow = millis();
+            if(sidMillis() - LMAdvNow > LMDelay) {
+                LMAdvNow = sidMillis();
                 if(LMState == 1) {
                     LMState++;
                     LMDelay = 50;
@@ -1799,7 +1809,7 @@ static bool showIdle(bool freezeBaseLine)
         sid.show();
     }
 
-    return true;
+    return next;
 }
 
 /*
@@ -1812,6 +1822,9 @@ static void timeTravel(bool TCDtriggered, uint16_t P0Dur, uint16_t P1Dur)
     if(TTrunning || IRLearning)
         return;
 
+    // TT pre-empts word sequences
+    abortAnim();
+
     bool initScreen = siActive || snActive;
 
     siddly_stop();
@@ -1827,7 +1840,7 @@ static void timeTravel(bool TCDtriggered, uint16_t P0Dur, uint16_t P1Dur)
     }
         
     TTrunning = true;
-    TTstart = TTfUpdNow = millis();
+    TTstart = TTfUpdNow = sidMillis();
     TTP0 = true;   // phase 0
     TTP1 = TTP2 = false;
     TTSAStopped = false;
@@ -1842,7 +1855,7 @@ static void timeTravel(bool TCDtriggered, uint16_t P0Dur, uint16_t P1Dur)
     P1_maxtimeout = P1Dur + 3000;
     
     #ifdef SID_DBG
-    Serial.printf("TT: baseLine %d, entry %d\n", sidBaseLine, seqEntry[sidBaseLine]);
+    Serial.printf("TT: baseLine %d, entry %d\n", idleSt.baseLine, seqEntry[idleSt.baseLine]);
     #endif
 
     if(saActive) {
@@ -1850,9 +1863,9 @@ static void timeTravel(bool TCDtriggered, uint16_t P0Dur, uint16_t P1Dur)
     } else if(usingGPSS) {
         if(strictMode) TTsbFlags |= SBLF_STRICT;
         if(TTsbFlags & SBLF_STRICT) {
-            TTcnt = TT_SQF_LN - strictBaseLine;
+            TTcnt = TT_SQF_LN - idleSt.strictBaseLine;
         } else {
-            TTcnt = TT_SQ_LN - seqEntry[sidBaseLine];
+            TTcnt = TT_SQ_LN - seqEntry[idleSt.baseLine];
         }
     } else {
         if(idleMode == SID_IDLE_IDC) {
@@ -1861,12 +1874,12 @@ static void timeTravel(bool TCDtriggered, uint16_t P0Dur, uint16_t P1Dur)
             TTsbFlags |= SBLF_STRICT;   // yes, even when idleMode == SID_IDLE_BL
         }
         if(TTsbFlags & SBLF_STRICT) {
-            TTcnt = TT_SQF_LN - strictBaseLine;
+            TTcnt = TT_SQF_LN - idleSt.strictBaseLine;
         } else {
-            TTcnt = TT_SQ_LN - seqEntry[sidBaseLine];
+            TTcnt = TT_SQ_LN - seqEntry[idleSt.baseLine];
         }
     }
-    TTsidBaseLineIdx = sidBaseLine;
+    TTsidBaseLineIdx = idleSt.baseLine;
     
     if(TCDtriggered) {    // TCD-triggered TT (GPIO, BTTFN or MQTT) (synced with TCD)
         extTT = true;
@@ -1925,41 +1938,42 @@ static void play_startup()
     };
     uint8_t w[10];
     uint8_t oldBri = sid.getBrightness();
+    animKey key;
+
+    abortAnim();
 
     blockScan = true;
     // Not long enough to justify sidBusy
 
-    sid.clearBuf();
-    sid.clearDisplayDirect();
-
-    sid.setBrightnessDirect(0);
+    anim_addCmd(ANIM_CLEAR, 0, 0);
 
     // Growing line
+    anim_init(&key, ANIM_BARS);
+    memset(key.bars, ANIM_NOBAR, sizeof(key.bars));
     for(int i = 0; i < 5; i++) {
-        sid.drawDot(4 - i, 10);
-        sid.drawDot(5 + i, 10);
-        sid.show();
-        if(oldBri >= (i + 1) * 2) sid.setBrightnessDirect((i + 1) * 2);
-        mydelay(20 - (i*2), false);
+        key.bars[4 - i][0] = key.bars[4 - i][1] = 10;
+        key.bars[5 + i][0] = key.bars[5 + i][1] = 10;
+        key.bri = (oldBri >= (i + 1) * 2) ? (i + 1) * 2 : ANIM_BRI_KEEP;
+        key.dur = 20 - (i*2);
+        anim_add(&key);
     }
 
-    if(oldBri >= 12) sid.setBrightnessDirect(12);
-    
-    mydelay(50, false);
-    
-    sid.setBrightness(255);
+    anim_addCmd(ANIM_WAIT, 50, (oldBri >= 12) ? 12 : ANIM_BRI_KEEP);
 
     // Fill from center
+    key.bri = ANIM_BRI_RESTORE;
     for(int i = 0; i < 10; i++) {
         for(int j = 0; j < 10; j++) {
-            sid.drawBar(j, 10 - i, 10 + i);
+            key.bars[j][0] = 10 - i;
+            key.bars[j][1] = 10 + i;
         }
-        sid.show();
-        mydelay(30 - (i*2), false);
+        key.dur = 30 - (i*2);
+        anim_add(&key);
+        key.bri = ANIM_BRI_KEEP;
     }
     
     for(int i = 0; i < 10; i++) {
-        oldIdleHeight[i] = 0;
+        idleSt.heights[i] = 0;
     }
     
     // Shrink like idle pattern
@@ -1972,14 +1986,17 @@ static void play_startup()
     }
     for(int i = 0; i < 28/2; i++) {
         for(int j = 0; j < 10; j++) {
-            sid.drawBarWithHeight(j, w[j]);
+            if(w[j]) {
+                key.bars[j][0] = 0;
+                key.bars[j][1] = ((w[j] > 20) ? 20 : w[j]) - 1;
+            } else {
+                key.bars[j][0] = ANIM_NOBAR;
+            }
             if(w[j] >= 2) w[j] -= 2;
         }
-        sid.show();
-        mydelay(30 + (i*5), false);
+        key.dur = 30 + (i*5);
+        anim_add(&key);
     }
-
-    blockScan = false;
 }
 
 void setIdleMode(int idleNo)
@@ -1994,7 +2011,8 @@ void setIdleMode(int idleNo)
             id5idx = 0;
         }
     }
-    ipachgnow = millisNonZero();
+    ipachgnow = sidMillisNonZero();
+    startDelayedSave();
     storeIdlePat();
 }
 
@@ -2008,7 +2026,8 @@ static void toggleStrictMode()
 static void changeBootMode(uint8_t bM)
 {
     storeBootMode(bM);
-    bmdchgnow = millisNonZero();
+    bmdchgnow = sidMillisNonZero();
+    startDelayedSave();
 }
 
 /*
@@ -2027,13 +2046,47 @@ static void endIRfeedback()
     digitalWrite(IRFeedBackPin, LOW);
 }
 
+// Arm timer to end IR feedback (again, if duration changed)
+static void armIRfeedback()
+{
+    if(irFeedBack) {
+        sched_once(irFBTask, irFeedBackDur);
+    }
+}
+
+static void irFBDone()
+{
+    endIRfeedback();
+    irFeedBack = false;
+}
+
 static void startIRErrFeedback()
 {
     startIRfeedback();
     irErrFeedBack = true;
-    irErrFeedBackNow = millis();
+    sched_every(irErrFBTask, 250);
     irErrFBState = 0;
     irFeedBack = false;
+    sched_stop(irFBTask);
+}
+
+static void irErrFBTick()
+{
+    // Cancelled by startIRfeedback()?
+    if(!irErrFeedBack) {
+        sched_stop(irErrFBTask);
+        return;
+    }
+    
+    irErrFBState++;
+    if(irErrFBState > 3) {
+        irErrFeedBack = false;
+        sched_stop(irErrFBTask);
+        endIRfeedback();
+    } else {
+        (irErrFBState & 0x01) ? endIRfeedback() : startIRfeedback();
+        irErrFeedBack = true;  // startIR clears it, so set it again
+    }
 }
 
 static void backupIR()
@@ -2056,7 +2109,8 @@ static void startIRLearn()
     showWordSequence("GO", 4);
     IRLearning = true;
     IRLearnIndex = 0;
-    IRLearnNow = IRFBLearnNow = millis();
+    sched_every(irLearnFBTask, 200);
+    sched_once(irLearnTOTask, 20000);
     IRLearnBlink = false;
     backupIR();
     showChar(IRLearnKeys[IRLearnIndex]);
@@ -2067,6 +2121,8 @@ static void endIRLearn(bool restore)
 {
     // TODO Restore display
     IRLearning = false;
+    sched_stop(irLearnFBTask);
+    sched_stop(irLearnTOTask);
     endIRfeedback();
     if(restore) {
         restoreIRbackup();
@@ -2074,6 +2130,28 @@ static void endIRLearn(bool restore)
     ir_remote.loop();     // Ignore IR received in the meantime
 }
 
+static void irLearnFBTick()
+{
+    IRLearnBlink = !IRLearnBlink;
+    IRLearnBlink ? endIRfeedback() : startIRfeedback();
+}
+
+static void irLearnTimeout()
+{
+    endIRLearn(true);
+    #ifdef SID_DBG
+    Serial.println("main_loop: IR learning timed out");
+    #endif
+}
+
+// IR learning triggered by IR
+static void irLNTrigger()
+{
+    if(!TTrunning) {
+        isTTKeyHeld = true;
+    }
+}
+
 static void handleIRinput()
 {
     uint32_t myHash = ir_remote.readHash();
@@ -2103,7 +2181,7 @@ static void handleIRinput()
             #endif
         }
         if(IRLearning) {
-            IRLearnNow = millis();
+            sched_once(irLearnTOTask, 20000);
         } else {
             endIRLearn(false);
         }
@@ -2116,6 +2194,8 @@ static void handleIRinput()
                 #ifdef SID_DBG
                 Serial.printf("handleIRinput: key %d\n", i);
                 #endif
+                // Valid key pre-empts word sequences
+                abortAnim();
                 handleIRKey(i);
                 done = true;
                 break;
@@ -2175,7 +2255,7 @@ static void handleIRKey(int key)
     int doInpReaction = 0;
     bool tempIRShowPosFBDisplay = irShowPosFBDisplay;
     bool tempIRShowCmdFBDisplay = irShowCmdFBDisplay;
-    unsigned long now = millisNonZero();
+    unsigned long now = sidMillisNonZero();
 
     if(ssActive) {
         if(!irLocked || key == 11) {
@@ -2189,9 +2269,11 @@ static void handleIRKey(int key)
 
         startIRfeedback();
         irFeedBack = true;
-        irFeedBackNow = now;
+        armIRfeedback();
     }
-    lastKeyPressed = now;
+
+    // Discard (incomplete) input after 30 seconds of inactivity
+    sched_once(inpClrTask, 30*1000);
     
     // If we are in "recording" mode, just record and bail
     if(inputRecord && key >= 0 && key <= 9) {
@@ -2212,6 +2294,7 @@ static void handleIRKey(int key)
             bttfn_send_command(BTTFN_REMCMD_KP_BYE, 0, 0);
             sid.specialSig(SID_SS_REMEND);
             irFeedBackDur = 1000;
+            armIRfeedback();
         } else if(key == 10) {   // * means the following key is "held" on TCD keypad
             remHoldKey = true;
         } else {
@@ -2305,6 +2388,7 @@ static void handleIRKey(int key)
         } else {
             inc_bri();
             brichgnow = now;
+            startDelayedSave();
             storeBrightness();
         }
         break;
@@ -2319,6 +2403,7 @@ static void handleIRKey(int key)
         } else {
             dec_bri();
             brichgnow = now;
+            startDelayedSave();
             storeBrightness();
         }
         break;
@@ -2365,6 +2450,7 @@ static void handleIRKey(int key)
         }
     } else if(doInpReaction) {
         irFeedBackDur = 1000;
+        armIRfeedback();
         if(!TTrunning && !siActive && !snActive) {
             switch(doInpReaction) {
             case 2:
@@ -2382,18 +2468,97 @@ static void handleIRKey(int key)
     }
 }
 
-static void handleRemoteCommand()
+/*
+ * Handle events posted by the BTTFN receiver (bttfn_rxPost()) 
+ * and mqttCallback()
+ */
+static void handleEvents()
+{
+    sidEvent ev;
+    // Remote commands are held back while an animation is running
+    bool holdCmds = !FPBUnitIsOn || IRLearning || anim_running();
+    bool cmdDone = false;
+
+    // Held-back commands first, one per pass
+    if(!holdCmds && evt_get(EVQ_HELD, &ev)) {
+        handleRemoteCommand(ev.u.cmd);
+        cmdDone = true;
+    }
+
+    while(evt_getNext(&ev)) {
+        switch(ev.type) {
+        case EVT_PREPARE:
+            if(FPBUnitIsOn && !IRLearning && !TTrunning) {
+                prepareTT();
+            }
+            break;
+        case EVT_WAKEUP:
+            if(FPBUnitIsOn && !IRLearning && !TTrunning) {
+                wakeup();
+            }
+            break;
+        case EVT_TT:
+            // Ignore if TCD is connected by wire
+            if(!TCDconnected && !TTrunning && !IRLearning) {
+                // Lead counts from when the notification was sent, so
+                // deduct the time spent in queue, and for BTTFN also the
+                // estimated transit time
+                uint32_t age = micros() - ev.stamp;
+                if(ev.src == EVQ_BTTFN) {
+                    age += bttfn_transitDelay();
+                }
+                age /= 1000;
+                networkTimeTravel = true;
+                networkTCDTT = true;
+                networkReentry = false;
+                networkAbort = false;
+                networkLead = (ev.u.tt.lead > age) ? ev.u.tt.lead - age : 0;
+                networkP1 = ev.u.tt.p1;
+                // TT latency statistics are for BTTFN only
+                networkTTStamp = (ev.src == EVQ_BTTFN) ? ev.stamp : 0;
+            }
+            break;
+        case EVT_REENTRY:
+            if(!TCDconnected && (TTrunning || networkTimeTravel) && networkTCDTT) {
+                networkReentry = true;
+            }
+            break;
+        case EVT_ABORT:
+            if(!TCDconnected && (TTrunning || networkTimeTravel) && networkTCDTT) {
+                networkAbort = true;
+            }
+            break;
+        case EVT_ALARM:
+            // Eval this at our convenience
+            networkAlarm = true;
+            break;
+        case EVT_MSG:
+            memcpy(mqttDispMsg, ev.u.msg, EVT_MSG_LEN);
+            mqttDisp = true;
+            break;
+        case EVT_UPDVERS:
+            // Settings are only written by the loop task
+            saveUpdVers(ev.u.vers.v, ev.u.vers.r);
+            break;
+        case EVT_CMD:
+            // Keep order: Hold back if others are already waiting
+            if(holdCmds || cmdDone || evt_pending(EVQ_HELD)) {
+                evt_requeue(EVQ_HELD, &ev);
+            } else {
+                handleRemoteCommand(ev.u.cmd);
+                cmdDone = true;
+            }
+            break;
+        }
+    }
+}
+
+static void handleRemoteCommand(uint32_t command)
 {
-    uint32_t command = commandQueue[oCmdIdx];
     int      doInpReaction = 0;
     bool     injected = false;
 
-    if(!command)
-        return;
-
-    commandQueue[oCmdIdx] = 0;
-    oCmdIdx++;
-    oCmdIdx &= 0x0f;
+    PROF_SCOPE(PROF_REMCMD);
 
     if(command & 0x80000000) {
         injected = true;
@@ -2505,7 +2670,7 @@ static int execute(bool isIR, bool injected)
     int  inputReaction = 0;
     bool isIRLocked = (isIR && !injected) ? irLocked : false;
     uint16_t temp;
-    unsigned long now = millisNonZero();
+    unsigned long now = sidMillisNonZero();
 
     switch(strlen(inputBuffer)) {
 
@@ -2620,6 +2785,16 @@ static int execute(bool isIR, bool injected)
                     } else inputReaction = -1;
                 }
                 break;
+            case 65:                              // *65  enable/disable "soft bar tops" in Spectrum Analyzer
+                if(!isIRLocked) {
+                    if(!TTrunning) {
+                        doSoft = !doSoft;
+                        saveSASettings();
+                        updateConfigPortalSAValues();
+                        inputReaction = 1;
+                    } else inputReaction = -1;
+                }
+                break;
             case 70:                              // *70 taken by FC IR lock sequence
               // Stay silent
               break;
@@ -2632,26 +2807,22 @@ static int execute(bool isIR, bool injected)
                 }
                 irLocked = !irLocked;
                 irlchgnow = now;
+                startDelayedSave();
                 storeIRLock();
                 if(!irLocked && isIR) {
                     // Start IR feedback here, since wasn't done above
                     startIRfeedback();
                     irFeedBack = true;
-                    irFeedBackNow = now;
+                    armIRfeedback();
                 }
                 inputReaction = 1;
                 break;
             case 77:                              // *77 Restart WiFi after entering Power Save
                 if(isIR && !isIRLocked && !TTrunning && !injected) {
-                    bool blocked = false;
-                    if(wifiOnWillBlock()) {
-                        flushDelayedSave();
-                        blocked = true;
-                    }
-                    // Enable WiFi / even if in AP mode / with CP
-                    wifiOn(0, true, false);
-                    if(!blocked) inputReaction = 1;
-                    else ir_remote.loop(); // Flush IR afterwards
+                    // Enable WiFi / even if in AP mode / with CP;
+                    // a re-connect blocks the network task only
+                    wifi_request(NETREQ_WIFION);
+                    inputReaction = 1;
                 } else {
                     inputReaction = -1;
                 }
@@ -2668,7 +2839,6 @@ static int execute(bool isIR, bool injected)
                         snake_stop();
                         flushDelayedSave();
                         showWordSequence(ipbuf, 5);
-                        ir_remote.loop(); // Flush IR afterwards
                     } else inputReaction = -1;
                 }
                 break;
@@ -2711,6 +2881,7 @@ static int execute(bool isIR, bool injected)
                 if(!TTrunning) {
                     sid.setBrightness(temp - 400);
                     brichgnow = now;
+                    startDelayedSave();
                     storeBrightness();
                     inputReaction = 1;
                 } else inputReaction = -1;
@@ -2802,8 +2973,7 @@ static int execute(bool isIR, bool injected)
                     }
                     inputReaction = 1;
                 } else if(!strcmp(inputBuffer, "987654") && !injected) {
-                    triggerIRLN = true;               // *987654OK initates IR learning
-                    triggerIRLNNow = millis();
+                    sched_once(irLNTask, 1000);       // *987654OK initates IR learning
                     inputReaction = 1;
                 } else {
                     inputReaction = -1;
@@ -2827,7 +2997,11 @@ static int execute(bool isIR, bool injected)
 static void span_start()
 {
     sid.clearDisplayDirect();
-    sa_activate();
+    if(!sa_activate()) {
+        // Likely no memory for the i2s driver
+        Serial.println("SA: Failed to start");
+        showWordSequence("SA ERROR", 2);
+    }
 }
 
 static void span_stop(bool skipClearDisplay)
@@ -2913,56 +3087,74 @@ void allOff()
 
 static void fadeOut()
 {
-    // blockscan already set by caller
-    int a = sid.getBrightness();
-    while(a >= 0) {
-        sid.setBrightnessDirect(a);
-        a--;
-        mydelay(10, false);
-    }
+    uint8_t a = sid.getBrightness();
+    
+    anim_addCmd(ANIM_FADE, (a + 1) * 10, 0);
 }
 
-void showWordSequence(const char *text, int speed)
+// Queue word sequence; it is played back by main_loop().
+// Remote commands are held back until it is finished,
+// IR input and TT pre-empt it.
+// Each letter takes 3 queue entries, plus 3 in total; with an
+// empty queue, this allows for 20 letters. Text beyond what
+// fits is not shown, and false is returned.
+bool showWordSequence(const char *text, int speed)
 {
     const int speedDelay[6] = { 100, 200, 300, 400, 500, 1000 };
+    int len = strlen(text);
+    bool ret = true;
 
     if(speed < 0) speed = 0;
     else if(speed > 5) speed = 5;
 
+    // Truncate if queue space is insufficient
+    if(len > (anim_space() - 3) / 3) {
+        len = (anim_space() - 3) / 3;
+        ret = false;
+        if(len <= 0) return false;
+    }
+
     blockScan = sidBusy = true;
     
-    sid.clearDisplayDirect();
-    for(int i = 0; i < strlen(text); i++) {
-        sid.drawLetterAndShow(text[i], 0, 8);
-        sid.setBrightness(255);
-        mydelay(speedDelay[speed], false);
+    anim_addCmd(ANIM_CLEAR);
+    for(int i = 0; i < len; i++) {
+        anim_addLetter(text[i], 0, 8, speedDelay[speed]);
         fadeOut();
-        mydelay(50, false);
+        anim_addCmd(ANIM_WAIT, 50);
     }
-    sid.clearDisplayDirect();
-    sid.setBrightness(255);
-    LMState = LMIdx = id5idx = 0;
-    
-    blockScan = sidBusy = false;
-    
-    ir_remote.loop();     // Ignore IR received in the meantime
+    anim_addCmd(ANIM_CLEAR, 0, ANIM_BRI_RESTORE);
+
+    return ret;
 }
 
 static void showChar(const char text)
 {
-    sid.clearDisplayDirect();
-    sid.drawLetterAndShow(text, 0, 8);
+    anim_addLetter(text, 0, 8, 0, ANIM_BRI_KEEP);
 }
 
 static void fadeOutChar()
 {
     // Only used while IRlearning, so wifi scan is already blocked
     fadeOut();
-    mydelay(50, false);
-    sid.clearDisplayDirect();
-    sid.setBrightness(255);
+    anim_addCmd(ANIM_WAIT, 50);
+    anim_addCmd(ANIM_CLEAR, 0, ANIM_BRI_RESTORE);
+}
+
+// Called when animation queue has run empty
+static void animDone()
+{
+    blockScan = sidBusy = false;
     LMState = LMIdx = id5idx = 0;
-    ir_remote.loop();     // Ignore IR received in the meantime
+}
+
+// Abort running animation (pre-emption)
+static void abortAnim()
+{
+    if(anim_running()) {
+        anim_stop();
+        blockScan = sidBusy = false;
+        LMState = LMIdx = id5idx = 0;
+    }
 }
 
 void populateIRarray(uint32_t *irkeys, int index)
@@ -3048,7 +3240,7 @@ static void ssStart()
 
 static void ssRestartTimer()
 {
-    ssLastActivity = millis();
+    ssLastActivity = sidMillis();
 }
 
 static void ssEnd()
@@ -3073,7 +3265,7 @@ static void ssEnd()
 
 static void ssUpdateClock()
 {
-    unsigned long now = millis();
+    unsigned long now = sidMillis();
     
     if(ssIsClock) {
         if(now - bttfnDateNow > 5000) {
@@ -3100,8 +3292,6 @@ void prepareTT()
     ssEnd();
     siddly_stop();
     snake_stop();
-
-    doPrepareTT = false;
 }
 
 // Wakeup: Sent by TCD upon entering dest date,
@@ -3111,8 +3301,6 @@ void wakeup()
 {
     // End screen saver
     ssEnd();
-
-    doWakeup = false;
 }
 
 static void setTTOUT(uint8_t stat)
@@ -3132,7 +3320,8 @@ static void setTTOUT(uint8_t stat)
  */
 static void myloop(bool withIR)
 {
-    wifi_loop();
+    task_parkPoint();
+    wifi_loop();       // no-op once network task runs
     bttfn_loop_quick();
     if(withIR) ir_remote.loop();
 }
@@ -3143,10 +3332,11 @@ static void myloop(bool withIR)
  */
 void mydelay(unsigned long mydel, bool withIR)
 {
-    unsigned long startNow = millis();
+    unsigned long startNow = sidMillis();
+    PROF_SCOPE(PROF_DELAY);
     myloop(withIR);
-    while(millis() - startNow < mydel) {
-        delay(10);
+    while(sidMillis() - startNow < mydel) {
+        sidDelay(10);
         myloop(withIR);
     }
 }
@@ -3162,59 +3352,55 @@ unsigned long millisNonZero()
  * Basic Telematics Transmission Framework (BTTFN)
  */
 
-static bool check_packet(uint8_t *buf)
+static void bttfn_applyCaps(uint8_t caps)
 {
-    // Basic validity check
-    if(memcmp(buf, BTTFUDPHD, 4))
-        return false;
-
-    uint8_t a = 0;
-    for(int i = 4; i < BTTF_PACKET_SIZE - 1; i++) {
-        a += buf[i] ^ 0x55;
+    // Cached caps might be outdated, so set all
+    TCDSupportsRemKP = !!(caps & BTTFN_CAP_REMKP);
+    bttfnCl.supportsNOTData = !!(caps & BTTFN_CAP_NOTDATA);
+    TCDSupportsSSID = bttfnCl.supportsNOTData && (caps & BTTFN_CAP_SSID);
+    if(caps != bttfnTCDCaps) {
+        bttfnTCDCaps = caps;
+        bttfnCl.cacheDirty = true;
     }
-
-    return (buf[BTTF_PACKET_SIZE - 1] == a);
 }
 
-void addCmdQueue(uint32_t command)
-{    
-    if(!command) return;
-
-    commandQueue[iCmdIdx] = command;
-    iCmdIdx++;
-    iCmdIdx &= 0x0f;
+// Arrival time of packet being handled, in sidMillis()
+static unsigned long bttfn_rxTime()
+{
+    return sidMillis() - (micros() - bttfnRxCurStamp) / 1000;
 }
 
-static void bttfn_eval_response(uint8_t *buf, bool checkCaps)
+static void bttfn_eval_response(const BttfnPacket& pkt, bool checkCaps)
 {
-    if(checkCaps && (buf[5] & 0x40)) {
-        bttfnReqStatus &= ~0x40;     // Do no longer poll capabilities
-        if(buf[31] & 0x01) {
-            bttfnReqStatus &= ~0x02; // Do no longer poll speed, comes over multicast
-        }
-        TCDSupportsRemKP = !!(buf[31] & 0x08);
-        if(buf[31] & 0x10) {
-            TCDSupportsNOTData = true;
-            TCDSupportsSSID = !!(buf[31] & 0x40);
+    uint8_t flags = pkt.flags();
+    
+    if(checkCaps && (flags & BTTFN_RSP_CAPS)) {
+        uint8_t caps = pkt.caps();
+        bttfnReqStatus &= ~BTTFN_RSP_CAPS;      // Do no longer poll capabilities
+        if(caps & BTTFN_CAP_MCSPD) {
+            bttfnReqStatus &= ~BTTFN_RSP_SPEED; // Do no longer poll speed, comes over multicast
         }
+        bttfn_applyCaps(caps);
     }
 
-    if(buf[5] & 0x01) {
-        memcpy(bttfnDateBuf, &buf[10], sizeof(bttfnDateBuf));
-        bttfnDateNow = millis();
+    if(flags & BTTFN_RSP_DATETIME) {
+        memcpy(bttfnDateBuf, pkt.dateTime(), sizeof(bttfnDateBuf));
+        bttfnDateNow = sidMillis();
     }
 
-    if(buf[5] & 0x02) {
-        gpsSpeed = (int16_t)(buf[18] | (buf[19] << 8));
+    if(flags & BTTFN_RSP_SPEED) {
+        gpsSpeed = pkt.speed();
         if(gpsSpeed > 88) gpsSpeed = 88;
-        spdIsRotEnc = !!(buf[26] & (0x80|0x20));    // Speed is from RotEnc or Remote
+        spd_sample(&gpsSpdEst, bttfn_rxTime(), gpsSpeed);
+        spdIsRotEnc = !!(pkt.status() & (BTTFN_STAT_SPDRE|BTTFN_STAT_SPDREM));    // Speed is from RotEnc or Remote
     }
 
-    if(buf[5] & 0x10) {
-        tcdNM  = !!(buf[26] & 0x01);
-        tcdFPO = !!(buf[26] & 0x02);   // 1 means fake power off
-        remoteAllowed = (buf[26] & 0x08) ? TCDSupportsRemKP : false;
-        tcdIsBusy = !!(buf[26] & 0x10);
+    if(flags & BTTFN_RSP_STATUS) {
+        uint8_t st = pkt.status();
+        tcdNM  = !!(st & BTTFN_STAT_NM);
+        tcdFPO = !!(st & BTTFN_STAT_FPO);   // 1 means fake power off
+        remoteAllowed = (st & BTTFN_STAT_REMOTE) ? TCDSupportsRemKP : false;
+        tcdIsBusy = !!(st & BTTFN_STAT_BUSY);
         if(!remoteAllowed || tcdIsBusy) remMode = remHoldKey = false;
     } else {
         tcdNM = false;
@@ -3224,13 +3410,13 @@ static void bttfn_eval_response(uint8_t *buf, bool checkCaps)
 
     if(!bttfnHaveTCDSSID && !checkCaps && TCDSupportsSSID) {
         bttfnHaveTCDSSID = 1;
-        memcpy((void *)TCDSSID, (void *)&buf[41], 6);
-        TCDSSID[6] = buf[18];
-        TCDpwMarker = buf[19] & 0x01;
+        memcpy((void *)TCDSSID, (void *)pkt.ssid(), 6);
+        TCDSSID[6] = pkt.ssid7();
+        TCDpwMarker = pkt.pwMarker() ? 1 : 0;
     }
 }
 
-static void handle_tcd_notification(uint8_t *buf)
+static void handle_tcd_notification(const BttfnPacket& pkt)
 {
     uint32_t seqCnt;
 
@@ -3239,39 +3425,40 @@ static void handle_tcd_notification(uint8_t *buf)
     // that are evaluated synchronously (=later).
     // Do not stuff that messes with display, input,
     // etc.
+    // Notifications that trigger something do not
+    // come here; they are posted as events by the
+    // receiver (bttfn_rxPost()).
 
-    if(buf[5] & BTTFN_NOT_DATA) {
-        if(TCDSupportsNOTData) {
-            bttfnDataNotEnabled = true;
-            bttfnLastNotData = millis();
-            seqCnt = GET32(buf, 27);
+    if(pkt.isDataNot()) {
+        if(bttfn_cliNotData(&bttfnCl, sidMillis())) {
+            seqCnt = pkt.dataSession();
             if(bttfnSessionID && (bttfnSessionID != seqCnt)) {
-                lastBTTFNKA = bttfnLastNotData - BTTFN_KA_INTERVAL + (BTTFN_KA_OFFSET*1000);
-                bttfnTCDDataSeqCnt = 1;
+                lastBTTFNKA = bttfnCl.lastNotData - BTTFN_KA_INTERVAL + (BTTFN_KA_OFFSET*1000);
+                bttfn_seqReset(&bttfnTCDDataSeq);
                 bttfnHaveTCDSSID = 0;
             }
+            if(bttfnSessionID != seqCnt) bttfnCl.cacheDirty = true;
             bttfnSessionID = seqCnt;
-            seqCnt = GET32(buf, 6);
-            if(seqCnt > bttfnTCDDataSeqCnt || seqCnt == 1) {
+            seqCnt = pkt.dataSeq();
+            if(bttfn_seqCheck(&bttfnTCDDataSeq, seqCnt, &bttfnRxSt)) {
                 #ifdef SID_DBG_NET
                 Serial.println("Valid NOT_DATA packet received");
                 #endif
-                bttfn_eval_response(buf, false);
+                bttfn_eval_response(pkt, false);
             } else {
                 #ifdef SID_DBG_NET
-                Serial.printf("Out-of-sequence NOT_DATA packet received %d %d\n", seqCnt, bttfnTCDDataSeqCnt);
+                Serial.printf("Out-of-sequence NOT_DATA packet received %d %d\n", seqCnt, bttfnTCDDataSeq.last);
                 #endif
             }
-            bttfnTCDDataSeqCnt = seqCnt;
         }
         return;
     }
     
-    switch(buf[5]) {
+    switch(pkt.notId()) {
     case BTTFN_NOT_SPD:
-        seqCnt = GET32(buf, 12);
-        if(seqCnt > bttfnTCDSeqCnt || seqCnt == 1 ) {
-            switch(buf[8] | (buf[9] << 8)) {
+        seqCnt = pkt.spdSeq();
+        if(bttfn_seqCheck(&bttfnTCDSpdSeq, seqCnt, &bttfnRxSt)) {
+            switch(pkt.spdSource()) {
             case BTTFN_SSRC_GPS:
                 spdIsRotEnc = false;
                 break;
@@ -3285,60 +3472,15 @@ static void handle_tcd_notification(uint8_t *buf)
             default:
                 spdIsRotEnc = true;
             }
-            gpsSpeed = (int16_t)(buf[6] | (buf[7] << 8));
+            gpsSpeed = pkt.spdSpeed();
             if(gpsSpeed > 88) gpsSpeed = 88;
+            spd_sample(&gpsSpdEst, bttfn_rxTime(), gpsSpeed);
         } 
-        bttfnTCDSeqCnt = seqCnt;
-        break;
-    case BTTFN_NOT_PREPARE:
-        // Prepare for TT. Comes at some undefined point,
-        // an undefined time before the actual tt, and
-        // may not come at all.
-        // We don't ignore this if TCD is connected by wire,
-        // because this signal does not come via wire.
-        doPrepareTT = true;
-        break;
-    case BTTFN_NOT_TT:
-        // Trigger Time Travel (if not running already)
-        // Ignore command if TCD is connected by wire
-        if(!TCDconnected && !TTrunning && !IRLearning && !sidBusy) {
-            networkTimeTravel = true;
-            networkTCDTT = true;
-            networkReentry = false;
-            networkAbort = false;
-            networkLead = buf[6] | (buf[7] << 8);
-            networkP1 = buf[8] | (buf[9] << 8);
-        }
-        break;
-    case BTTFN_NOT_REENTRY:
-        // Start re-entry (if TT currently running)
-        // Ignore command if TCD is connected by wire
-        if(!TCDconnected && (TTrunning || networkTimeTravel) && networkTCDTT) {
-            networkReentry = true;
-        }
-        break;
-    case BTTFN_NOT_ABORT_TT:
-        // Abort TT (if TT currently running)
-        // Ignore command if TCD is connected by wire
-        if(!TCDconnected && (TTrunning || networkTimeTravel) && networkTCDTT) {
-            networkAbort = true;
-        }
-        break;
-    case BTTFN_NOT_ALARM:
-        networkAlarm = true;
-        break;
-    case BTTFN_NOT_SID_CMD:
-        if(!sidBusy) {
-            addCmdQueue(GET32(buf, 6));
-        }
-        break;
-    case BTTFN_NOT_WAKEUP:
-        doWakeup = true;
         break;
     case BTTFN_NOT_INFO:
         {
-            uint16_t tcdi1 = buf[6] | (buf[7] << 8);
-            uint16_t tcdi2 = buf[8] | (buf[9] << 8);
+            uint16_t tcdi1 = pkt.info1();
+            uint16_t tcdi2 = pkt.info2();
             if(tcdi1 & BTTFN_TCDI1_EXT) {
                 tcdNM  = !!(tcdi1 & BTTFN_TCDI1_NM);
                 tcdFPO = !!(tcdi1 & BTTFN_TCDI1_OFF);
@@ -3348,179 +3490,484 @@ static void handle_tcd_notification(uint8_t *buf)
             if(!remoteAllowed || tcdIsBusy) remMode = remHoldKey = false;
 
             if(tcdi2 & BTTFN_TCDI2_TIMEINFO) {
-                memcpy(bttfnDateBuf, &buf[16], sizeof(bttfnDateBuf));
-                bttfnDateNow = millis();
+                memcpy(bttfnDateBuf, pkt.infoDateTime(), sizeof(bttfnDateBuf));
+                bttfnDateNow = sidMillis();
             }
         }
         break;
     }
 }
 
-// Check for pending MC packet and parse it
-static bool bttfn_checkmc()
-{
-    int psize = sidMcUDP->parsePacket();
+/*
+ * Receiver
+ *
+ * Runs in its own task (if that could not be created: polled from 
+ * the loop task), and blocks on both sockets. Packets are time-
+ * stamped on arrival and validated; notifications that merely
+ * trigger something are posted to the BTTFN event queue right 
+ * away; anything that updates main's state is put into a ring 
+ * for main_loop() and parsed in place there.
+ * The ring has one producer and one consumer, see sid_event.cpp.
+ */
 
-    if(!psize) {
-        return false;
+// Read one packet from socket; returns false if there was none
+static bool bttfn_rxRead(int sock, bool mc)
+{
+    struct sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    uint32_t head = bttfnRxHead;
+    bttfnRxSlot *slot;
+    int len;
+
+    if(head - __atomic_load_n(&bttfnRxTail, __ATOMIC_ACQUIRE) >= BTTFN_RX_RING) {
+        // Ring full; clear socket buffer anyway
+        bttfnBuf dummy;
+        if(recv(sock, dummy.b, BTTF_PACKET_SIZE, MSG_DONTWAIT) < 0)
+            return false;
+        bttfnRxSt.received++;
+        bttfnRxSt.dropped++;
+        #ifdef SID_DBG_NET
+        Serial.println("BTTFN: Receive ring full, packet dropped");
+        #endif
+        return true;
     }
 
-    // This returns true as long as a packet was received
-    // regardless whether it was for us or not. Point is
-    // to clear the receive buffer.
+    slot = &bttfnRxRing[head & (BTTFN_RX_RING - 1)];
     
-    sidMcUDP->read(BTTFMCBuf, BTTF_PACKET_SIZE);
+    len = recvfrom(sock, slot->buf.b, BTTF_PACKET_SIZE, MSG_DONTWAIT, 
+                   (struct sockaddr *)&from, &fromLen);
+    if(len < 0)
+        return false;
 
-    #ifdef SID_DBG_NET
-    Serial.printf("Received multicast packet from %s\n", sidMcUDP->remoteIP().toString());
-    #endif
+    slot->stamp = micros();
+    bttfnRxSt.received++;
 
-    if(haveTCDIP) {
-        if(bttfnTcdIP != sidMcUDP->remoteIP())
-            return true;
-    } else {
-        // Do not use tcdHostNameHash; let DISCOVER do its work
-        // and wait for a result.
+    BttfnPacket pkt(&slot->buf);
+
+    if(len != BTTF_PACKET_SIZE || !pkt.valid()) {
+        bttfnRxSt.invalid++;
         return true;
     }
 
-    if(!check_packet(BTTFMCBuf))
+    slot->addr = from.sin_addr.s_addr;
+
+    switch(bttfn_rxSort(pkt, mc, slot->addr, 
+                        __atomic_load_n(&bttfnRxTcdAddr, __ATOMIC_ACQUIRE),
+                        sidMirror == SID_MIRROR_FOLLOW)) {
+    case BTTFN_RX_DROP:
+        return true;
+    case BTTFN_RX_EVENT:
+        bttfnRxSt.posted++;
         return true;
+    }
 
-    if((BTTFMCBuf[4] & 0x4f) == (BTTFN_VERSION | 0x40)) {
+    __atomic_store_n(&bttfnRxHead, head + 1, __ATOMIC_RELEASE);
 
-        // A notification from the TCD
-        handle_tcd_notification(BTTFMCBuf);
-    
-    }
+    // Cut short main loop's sleep
+    sched_wake();
 
     return true;
 }
 
-// Check for pending packet and parse it
-static void BTTFNCheckPacket()
+// Wait up to "timeout" ms for packets, and read them
+static void bttfn_rxWait(uint32_t timeout)
 {
-    unsigned long mymillis = millisNonZero();
+    fd_set rfds;
+    struct timeval tv;
+    unsigned long waitNow = micros();
+    int n, t;
+
+    FD_ZERO(&rfds);
+    FD_SET(bttfnSock, &rfds);
+    FD_SET(bttfnMcSock, &rfds);
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
     
-    int psize = sidUDP->parsePacket();
-    if(!psize) {
-        if(!bttfnDataNotEnabled && BTTFNPacketDue) {
-            if((mymillis - BTTFNTSRQAge) > BTTFN_RESPONSE_TO) {
-                // Packet timed out
-                BTTFNPacketDue = false;
-                // Immediately trigger new request for
-                // the first 10 timeouts, after that
-                // the new request is only triggered
-                // in greater intervals via bttfn_loop().
-                if(haveTCDIP && BTTFNfailCount < 10) {
-                    BTTFNfailCount++;
-                    BTTFNUpdateNow = 0;
-                }
-            }
+    n = select(max(bttfnSock, bttfnMcSock) + 1, &rfds, NULL, NULL, &tv);
+
+    if(timeout) {
+        task_idle(TASK_BTTFN, micros() - waitNow);
+        if(n < 0) {
+            // Don't spin on errors
+            vTaskDelay(pdMS_TO_TICKS(100));
         }
-        return;
     }
     
-    sidUDP->read(BTTFUDPBuf, BTTF_PACKET_SIZE);
-
-    if(!check_packet(BTTFUDPBuf))
+    if(n <= 0)
         return;
 
-    if((BTTFUDPBuf[4] & 0x4f) == (BTTFN_VERSION | 0x40)) {
+    // Drain socket buffers, but do not starve the other one
+    if(FD_ISSET(bttfnMcSock, &rfds)) {
+        t = 100;
+        while(bttfn_rxRead(bttfnMcSock, true) && t--) {}
+    }
+    if(FD_ISSET(bttfnSock, &rfds)) {
+        t = 100;
+        while(bttfn_rxRead(bttfnSock, false) && t--) {}
+    }
+}
 
-        // A notification from the TCD
-        handle_tcd_notification(BTTFUDPBuf);
-      
-    } else {
+static void bttfnRxTask(void *parm)
+{
+    task_register(TASK_BTTFN, xTaskGetCurrentTaskHandle(), xPortGetCoreID());
 
-        // (Possibly) a response packet
+    for(;;) {
+        #ifdef SID_HAVESTATS
+        stall_beat(TASK_BTTFN);
+        #endif
+        
+        bttfn_rxWait(BTTFN_RX_WAIT);
+    }
+}
 
-        if(GET32(BTTFUDPBuf, 6) != BTTFUDPID)
-                return;
+// Tell receiver which address multicast must come from
+static void bttfn_rxSetTCD()
+{
+    __atomic_store_n(&bttfnRxTcdAddr, bttfnCl.tcdAddr, __ATOMIC_RELEASE);
+}
 
-        // Response marker missing or wrong version, bail
-        if((BTTFUDPBuf[4] & 0x8f) != (BTTFN_VERSION | 0x80))
-            return;
+// Estimated time between TCD sending and us receiving a packet, in us
+static uint32_t bttfn_transitDelay()
+{
+    return bttfnCl.clk.delay;
+}
 
-        BTTFNfailCount = 0;
-    
-        // If it's our expected packet, no other is due for now
-        BTTFNPacketDue = false;
+// Counters are updated without locking, see evt_getStats()
+void bttfn_getClockStats(bttfnClockStats *st)
+{
+    *st = bttfnCl.clk;
+}
 
-        if(BTTFUDPBuf[5] & 0x80) {
-            if(!haveTCDIP) {
-                bttfnTcdIP = sidUDP->remoteIP();
-                haveTCDIP = true;
-                #ifdef SID_DBG_NET
-                Serial.printf("Discovered TCD IP %d.%d.%d.%d\n", bttfnTcdIP[0], bttfnTcdIP[1], bttfnTcdIP[2], bttfnTcdIP[3]);
-                #endif
+static void bttfn_handleResponse(const BttfnPacket& pkt, uint32_t addr, uint32_t stamp)
+{
+    switch(bttfn_cliResponse(&bttfnCl, pkt, addr, stamp)) {
+    case BTTFN_CLI_IGNORED:
+        return;
+    case BTTFN_CLI_NEWTCD:
+        bttfn_rxSetTCD();
+        #ifdef SID_DBG_NET
+        {
+            IPAddress ip(bttfnCl.tcdAddr);
+            Serial.printf("Discovered TCD IP %d.%d.%d.%d\n", ip[0], ip[1], ip[2], ip[3]);
+        }
+        #endif
+        break;
+    }
+
+    // TCD did register us, so use current millis as
+    // baseline for KEEP_ALIVE (lastBTTFNKA)
+    lastBTTFNpacket = lastBTTFNKA = sidMillisNonZero();
+
+    bttfn_eval_response(pkt, true);
+}
+
+// Handle packets the receiver has queued
+static void bttfn_rxHandle()
+{
+    uint32_t tail = bttfnRxTail;
+    uint32_t lat, procNow;
+    int b;
+
+    if(!bttfnRxTaskHandle) {
+        bttfn_rxWait(0);
+    }
+
+    while(__atomic_load_n(&bttfnRxHead, __ATOMIC_ACQUIRE) != tail) {
+        bttfnRxSlot *slot = &bttfnRxRing[tail & (BTTFN_RX_RING - 1)];
+        BttfnPacket pkt(&slot->buf);
+
+        procNow = micros();
+        bttfnRxCurStamp = slot->stamp;
+        
+        if(pkt.isNotification()) {
+            if(pkt.notId() == BTTFN_NOT_SID_MIRROR) {
+                bttfn_mirReceive(&slot->buf, slot->addr);
             } else {
-                #ifdef SID_DBG_NET
-                Serial.println("Internal error - received unexpected DISCOVER response");
-                #endif
+                handle_tcd_notification(pkt);
             }
+        } else {
+            bttfn_handleResponse(pkt, slot->addr, slot->stamp);
         }
 
-        // TCD did register us, so use current millis as
-        // baseline for KEEP_ALIVE (lastBTTFNKA)
-        lastBTTFNpacket = lastBTTFNKA = mymillis;
+        lat = micros();
+        procNow = lat - procNow;
+        bttfnRxSt.procTotal += procNow;
+        if(procNow > bttfnRxSt.procMax) bttfnRxSt.procMax = procNow;
+        
+        lat -= slot->stamp;
+        __atomic_store_n(&bttfnRxTail, ++tail, __ATOMIC_RELEASE);
+
+        for(b = 0; b < EVT_LAT_BUCKETS - 1; b++) {
+            if(lat < evtLatLimits[b]) break;
+        }
+        bttfnRxSt.hist[b]++;
+        bttfnRxSt.handled++;
+        bttfnRxSt.latTotal += lat;
+        if(lat > bttfnRxSt.latMax) bttfnRxSt.latMax = lat;
+    }
+}
+
+// Called when a network-triggered TT sequence starts;
+// stamp is the notification's arrival time
+static void bttfn_noteTTStart(uint32_t stamp)
+{
+    uint32_t lat = micros() - stamp;
+
+    bttfnRxSt.ttCount++;
+    bttfnRxSt.ttLatLast = lat;
+    if(lat > bttfnRxSt.ttLatMax) bttfnRxSt.ttLatMax = lat;
+}
+
+// Counters are updated without locking, see evt_getStats()
+void bttfn_getRxStats(bttfnRxStats *st)
+{
+    *st = bttfnRxSt;
+}
 
-        bttfn_eval_response(BTTFUDPBuf, true);
+static void BTTFNCheckTimeout()
+{
+    if(bttfn_cliTimeout(&bttfnCl, sidMillis())) {
+        // Cached IP did not answer
+        bttfn_rxSetTCD();
     }
 }
 
+static void bttfn_loadCache()
+{
+    if(!loadTCDCache((uint8_t *)&bttfnCache, sizeof(bttfnCache)) ||
+       !bttfn_cliUseCache(&bttfnCl, &bttfnCache)) {
+        memset(&bttfnCache, 0, sizeof(bttfnCache));
+        return;
+    }
+
+    bttfnSessionID = bttfnCache.sessionID;
+    bttfn_applyCaps(bttfnCache.caps);
+    bttfnCl.cacheDirty = false;
+
+    #ifdef SID_DBG_NET
+    IPAddress ip(bttfnCl.tcdAddr);
+    Serial.printf("BTTFN: Trying cached TCD IP %d.%d.%d.%d\n", ip[0], ip[1], ip[2], ip[3]);
+    #endif
+}
+
+// Called from bttfn_loop() only, not from delay loops
+static void bttfn_saveCache()
+{
+    bttfnCacheEntry c;
+
+    if(!bttfn_cliCacheGet(&bttfnCl, &c))
+        return;
+
+    c.sessionID = bttfnSessionID;
+    c.caps = bttfnTCDCaps;
+
+    if(!memcmp(&c, &bttfnCache, sizeof(c)))
+        return;
+
+    bttfnCache = c;
+    saveTCDCache((uint8_t *)&bttfnCache, sizeof(bttfnCache));
+}
+
 static void BTTFNPreparePacketTemplate()
 {
-    memset(BTTFUDPTBuf, 0, BTTF_PACKET_SIZE);
+    BttfnPacket pkt(&bttfnTxTpl[BTTFN_TXT_REQ]);
 
-    // ID
-    memcpy(BTTFUDPTBuf, BTTFUDPHD, 4);
+    pkt.init();
 
     // Tell the TCD about our hostname
-    // 13 bytes total. If hostname is longer, last in buf is '.'
-    memcpy(BTTFUDPTBuf + 10, settings.hostName, 13);
-    if(strlen(settings.hostName) > 13) BTTFUDPTBuf[10+12] = '.';
-
-    BTTFUDPTBuf[10+13] = BTTFN_TYPE_SID;
+    pkt.setHostname(settings.hostName);
+    pkt.setDevType(BTTFN_TYPE_SID);
 
     // Version, MC-marker, ND-marker
-    BTTFUDPTBuf[4] = BTTFN_VERSION | BTTFN_SUP_MC | BTTFN_SUP_ND;
+    pkt.setVersion(BTTFN_VERSION | BTTFN_SUP_MC | BTTFN_SUP_ND);
 
     // Remote-ID
-    SET32(BTTFUDPTBuf, 35, myRemID);
+    pkt.setRemID(myRemID);
+
+    // TT trigger and commands are requests with
+    // different flags and the command bytes set
+    bttfnTxTpl[BTTFN_TXT_TT] = bttfnTxTpl[BTTFN_TXT_REQ];
+    BttfnPacket(&bttfnTxTpl[BTTFN_TXT_TT]).setFlags(0x80);
+    bttfnTxTpl[BTTFN_TXT_CMD] = bttfnTxTpl[BTTFN_TXT_REQ];
 }
 
-static void BTTFNPreparePacket()
+// Queue a copy of a template; returns NULL if queue is full
+static bttfnBuf *bttfn_txQueue(int tpl, bool discover = false, bool isReq = false)
 {
-    memcpy(BTTFUDPBuf, BTTFUDPTBuf, BTTF_PACKET_SIZE);               
+    bttfnTxSlot *slot;
+
+    if(bttfnTxQLen >= BTTFN_TX_QUEUE) {
+        bttfnRxSt.txDropped++;
+        return NULL;
+    }
+
+    slot = &bttfnTxQ[bttfnTxQLen++];
+    if(bttfnTxQLen > bttfnRxSt.txQueueMax) bttfnRxSt.txQueueMax = bttfnTxQLen;
+
+    slot->buf = bttfnTxTpl[tpl];
+    slot->discover = discover;
+    slot->isReq = isReq;
+
+    return &slot->buf;
 }
 
-static void BTTFNDispatch()
+// Send all queued packets
+static void bttfn_txFlush()
 {
-    uint8_t a = 0;
-    for(int i = 4; i < BTTF_PACKET_SIZE - 1; i++) {
-        a += BTTFUDPBuf[i] ^ 0x55;
+    struct sockaddr_in to;
+
+    if(!bttfnTxQLen)
+        return;
+
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+
+    for(int i = 0; i < bttfnTxQLen; i++) {
+        bttfnTxSlot *slot = &bttfnTxQ[i];
+        if(bttfnCl.tcdAddr && !slot->discover) {
+            to.sin_addr.s_addr = bttfnCl.tcdAddr;
+            to.sin_port = htons(BTTF_DEFAULT_LOCAL_PORT);
+        } else {
+            #ifdef SID_DBG_NET
+            Serial.printf("Sending multicast (hostname hash %x)\n", bttfnCl.hostHash);
+            #endif
+            to.sin_addr.s_addr = (uint32_t)bttfnMcIP;
+            to.sin_port = htons(BTTF_DEFAULT_LOCAL_PORT + 1);
+        }
+        // Stamp before sending; the response might be 
+        // handled before sendto() returns
+        if(slot->isReq) {
+            bttfnCl.reqStamp = micros();
+        }
+        if(sendto(bttfnSock, slot->buf.b, BTTF_PACKET_SIZE, 0, (struct sockaddr *)&to, sizeof(to)) < 0) {
+            bttfnRxSt.txErrors++;
+        } else {
+            bttfnRxSt.sent++;
+        }
     }
-    BTTFUDPBuf[BTTF_PACKET_SIZE - 1] = a;
 
-    if(haveTCDIP) {
-        sidUDP->beginPacket(bttfnTcdIP, BTTF_DEFAULT_LOCAL_PORT);
+    bttfnTxQLen = 0;
+}
+
+// Send a packet to the notification multicast group; never blocks
+static int bttfn_sendMc(bttfnBuf *buf)
+{
+    struct sockaddr_in to;
+
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = (uint32_t)bttfnMcIP;
+    to.sin_port = htons(BTTF_DEFAULT_LOCAL_PORT + 2);
+
+    return sendto(bttfnSock, buf->b, BTTF_PACKET_SIZE, MSG_DONTWAIT, (struct sockaddr *)&to, sizeof(to));
+}
+
+/*
+ * Send SA band data (one frame) to the notification multicast
+ * group. Called from sa_loop() for every frame drawn, so this 
+ * must not block: No allocation, no DNS, MSG_DONTWAIT. If the
+ * stack can't take the packet, the frame is dropped; the next
+ * one follows 32ms later anyway.
+ */
+void bttfn_saFrame(const int *heights, const uint8_t *peaks, int numBands, int barHeight)
+{
+    if(!saBcast || !useBTTFN || !BTTFNWiFiUp || numBands <= 0)
+        return;
+
+    bttfn_saBuild(&bttfnSABuf, ++bttfnSASeq, heights, peaks, numBands, barHeight);
+
+    if(bttfn_sendMc(&bttfnSABuf) < 0) {
+        bttfnRxSt.saErrors++;
     } else {
-        #ifdef SID_DBG_NET
-        Serial.printf("Sending multicast (hostname hash %x)\n", tcdHostNameHash);
-        #endif
-        sidUDP->beginPacket(bttfnMcIP, BTTF_DEFAULT_LOCAL_PORT + 1);
+        bttfnRxSt.saSent++;
+    }
+}
+
+/*
+ * Idle pattern mirroring
+ *
+ * The leader sends the state that showIdleFrame() renders from 
+ * (baselines, RNG state, previous bar heights, time into backlot 
+ * sequence) with every idle frame. Followers render each frame 
+ * as it arrives, from that state instead of their own, so they 
+ * show the very same bars at the leader's pace. Since every 
+ * packet carries the complete state, a lost packet only skips 
+ * a frame; nothing accumulates. If the leader goes quiet (not 
+ * idle, off, gone), followers return to their own pattern.
+ * The letter mask of the "identity crisis" mode is not mirrored.
+ * Packing and applying the state is in sid_idle.cpp, the follower's
+ * checks in sid_bttfn.cpp.
+ */
+static void bttfn_mirSend(const idleFrame *fr)
+{
+    if(sidMirror != SID_MIRROR_LEAD || !useBTTFN || !BTTFNWiFiUp)
+        return;
+
+    idle_mirBuild(&bttfnMirBuf, ++bttfnMirFrame, &idleSt, fr, sidRndState);
+
+    if(bttfn_sendMc(&bttfnMirBuf) < 0) {
+        bttfnRxSt.txErrors++;
+    } else {
+        bttfnRxSt.mirFrames++;
+    }
+}
+
+// Store frame from leader; rendered by showIdle()
+static void bttfn_mirReceive(bttfnBuf *buf, uint32_t addr)
+{
+    unsigned long now = sidMillisNonZero();
+
+    if(!bttfn_mirAccept(&bttfnMirIn, BttfnPacket(buf), addr, now, &bttfnRxSt))
+        return;
+
+    bttfnMirBuf = *buf;
+    bttfnMirPending = true;
+
+    // Don't sleep before showing it
+    sched_wakeAt(now);
+}
+
+static bool bttfn_mirFollowing()
+{
+    if(sidMirror != SID_MIRROR_FOLLOW)
+        return false;
+
+    if(!bttfn_mirActive(&bttfnMirIn, sidMillis())) {
+        bttfnMirPending = false;
+        return false;
     }
-    sidUDP->write(BTTFUDPBuf, BTTF_PACKET_SIZE);
-    sidUDP->endPacket();
+
+    return true;
+}
+
+static bool bttfn_mirShow()
+{
+    idleFrame fr;
+
+    if(!bttfnMirPending)
+        return false;
+
+    bttfnMirPending = false;
+    lastChange = sidMillis();
+
+    // Render from leader's state and PRNG state, leaving
+    // our own PRNG state untouched
+    idle_mirApply(&idleSt, BttfnPacket(&bttfnMirBuf), &fr);
+
+    showIdleFrame(&fr);
+
+    return true;
 }
 
 // Send a new data request
 static bool BTTFNSendRequest()
 {
-    BTTFNPacketDue = false;
+    bttfnBuf *buf;
+    bool discover;
+    
+    bttfnCl.packetDue = false;
 
-    BTTFNUpdateNow = millisNonZero();
+    bttfnCl.updateNow = sidMillisNonZero();
 
     if(WiFi.status() != WL_CONNECTED) {
         BTTFNWiFiUp = false;
@@ -3529,26 +3976,25 @@ static bool BTTFNSendRequest()
 
     BTTFNWiFiUp = true;
 
-    // Send new packet
-    BTTFNPreparePacket();
-    
-    // Serial
-    BTTFUDPID = (uint32_t)millis();
-    SET32(BTTFUDPBuf, 6, BTTFUDPID);
-
     // Request flags
-    BTTFUDPBuf[5] = bttfnReqStatus;                
-
-    if(!haveTCDIP) {
-        BTTFUDPBuf[5] |= 0x80;
-        SET32(BTTFUDPBuf, 31, tcdHostNameHash);
-    }
+    // DISCOVER also while validating cached IP
+    discover = bttfn_cliDiscover(&bttfnCl);
 
-    BTTFNDispatch();
+    // Queue new packet; sent at end of bttfn_loop()
+    if(!(buf = bttfn_txQueue(BTTFN_TXT_REQ, discover, true)))
+        return false;
 
-    BTTFNTSRQAge = millis();
+    BttfnPacket pkt(buf);
     
-    BTTFNPacketDue = true;
+    // Serial
+    pkt.setReqId(bttfn_cliRequest(&bttfnCl, sidMillis()));
+
+    if(discover) {
+        pkt.setFlags(bttfnReqStatus | BTTFN_RSP_DISCOVER);
+        pkt.setHostHash(bttfnCl.hostHash);
+    } else {
+        pkt.setFlags(bttfnReqStatus);
+    }
     
     return true;
 }
@@ -3558,7 +4004,7 @@ static bool bttfn_connected()
     if(!useBTTFN)
         return false;
 
-    if(!haveTCDIP)
+    if(!bttfnCl.tcdAddr)
         return false;
     
     if(WiFi.status() != WL_CONNECTED)
@@ -3578,14 +4024,8 @@ static bool bttfn_trigger_tt()
     if(TTrunning || IRLearning || tcdIsBusy)
         return false;
 
-    BTTFNPreparePacket();
-
     // Trigger BTTFN-wide TT
-    BTTFUDPBuf[5] = 0x80;           
-
-    BTTFNDispatch();
-
-    return true;
+    return (bttfn_txQueue(BTTFN_TXT_TT) != NULL);
 }
 
 static bool bttfn_send_command(uint8_t cmd, uint8_t p1, uint8_t p2)
@@ -3596,31 +4036,69 @@ static bool bttfn_send_command(uint8_t cmd, uint8_t p1, uint8_t p2)
     if(!bttfn_connected())
         return false;
 
-    BTTFNPreparePacket();
+    bttfnBuf *buf = bttfn_txQueue(BTTFN_TXT_CMD);
+
+    if(!buf)
+        return false;
+
+    BttfnPacket pkt(buf);
     
-    //BTTFUDPBuf[5] = 0x00;   // 0 already
+    //pkt.setFlags(0);   // 0 already
 
     if(cmd <= BTTFN_REM_MAX_COMMAND) {
-        SET32(BTTFUDPBuf, 6, bttfnSeqCnt[cmd]);
+        pkt.setSeq(bttfnSeqCnt[cmd]);
         bttfnSeqCnt[cmd]++;
         if(!bttfnSeqCnt[cmd]) bttfnSeqCnt[cmd]++;
     }
 
-    BTTFUDPBuf[25] = cmd;
-    BTTFUDPBuf[26] = p1;
-    BTTFUDPBuf[27] = p2;
-
-    BTTFNDispatch();
+    pkt.setCommand(cmd, p1, p2);
 
     #ifdef SID_DBG_NET
     Serial.printf("Sent command %d\n", cmd);
     #endif
 
-    BTTFNLastCmdSent = millisNonZero();
+    BTTFNLastCmdSent = sidMillisNonZero();
 
     return true;
 }
 
+static int bttfn_openSocket(uint16_t port, bool mc)
+{
+    struct sockaddr_in addr;
+    int s, yes = 1;
+
+    if((s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0)
+        return -1;
+
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if(bind(s, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(s);
+        return -1;
+    }
+
+    if(mc) {
+        struct ip_mreq mreq;
+        mreq.imr_multiaddr.s_addr = (uint32_t)bttfnMcIP;
+        mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+        if(setsockopt(s, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+            #ifdef SID_DBG_NET
+            Serial.printf("BTTFN: Failed to join multicast group (%d)\n", errno);
+            #endif
+        }
+    } else {
+        // Don't receive our own multicast (SA band data)
+        uint8_t loop = 0;
+        setsockopt(s, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    }
+
+    return s;
+}
+
 static void bttfn_setup()
 {
     useBTTFN = false;
@@ -3629,26 +4107,47 @@ static void bttfn_setup()
     if(!settings.tcdIP[0])
         return;
 
-    haveTCDIP = isIp(settings.tcdIP);
-    
-    if(!haveTCDIP) {
-        tcdHostNameHash = 0;
+    if(!isIp(settings.tcdIP)) {
+        uint32_t hostHash = 0;
         unsigned char *s = (unsigned char *)settings.tcdIP;
-        for ( ; *s; ++s) tcdHostNameHash = 37 * tcdHostNameHash + tolower(*s);
+        for ( ; *s; ++s) hostHash = 37 * hostHash + tolower(*s);
+        bttfn_cliInit(&bttfnCl, 0, hostHash);
+        bttfn_loadCache();
     } else {
-        bttfnTcdIP.fromString(settings.tcdIP);
+        IPAddress ip;
+        ip.fromString(settings.tcdIP);
+        bttfn_cliInit(&bttfnCl, (uint32_t)ip, 0);
     }
     
-    sidUDP = &bttfUDP;
-    sidUDP->begin(BTTF_DEFAULT_LOCAL_PORT);
-
-    sidMcUDP = &bttfMcUDP;
-    sidMcUDP->beginMulticast(bttfnMcIP, BTTF_DEFAULT_LOCAL_PORT + 2);
+    bttfn_rxSetTCD();
+    
+    bttfnSock = bttfn_openSocket(BTTF_DEFAULT_LOCAL_PORT, false);
+    bttfnMcSock = bttfn_openSocket(BTTF_DEFAULT_LOCAL_PORT + 2, true);
+    if(bttfnSock < 0 || bttfnMcSock < 0) {
+        Serial.println("BTTFN: Failed to open sockets");
+        if(bttfnSock >= 0) close(bttfnSock);
+        if(bttfnMcSock >= 0) close(bttfnMcSock);
+        bttfnSock = bttfnMcSock = -1;
+        return;
+    }
 
     BTTFNPreparePacketTemplate();
     
-    BTTFNfailCount = 0;
     useBTTFN = true;
+
+    if(xTaskCreatePinnedToCore(bttfnRxTask, "BTTFN", TASK_BTTFN_STACK, NULL,
+                               TASK_BTTFN_PRIO, &bttfnRxTaskHandle, TASK_BTTFN_CORE) != pdPASS) {
+        // Poll from loop task
+        bttfnRxTaskHandle = NULL;
+        Serial.println("Failed to start BTTFN task");
+    }
+}
+
+void bttfn_getMemUse(memUse *m)
+{
+    m->staticBytes = sizeof(bttfnTxTpl) + sizeof(bttfnTxQ) + sizeof(bttfnRxRing) + 
+                     sizeof(bttfnRxSt) + sizeof(bttfnSeqCnt) + sizeof(bttfnCl);
+    if(bttfnRxTaskHandle) m->heapBytes += TASK_BTTFN_STACK;
 }
 
 void bttfn_loop()
@@ -3656,15 +4155,25 @@ void bttfn_loop()
     if(!useBTTFN)
         return;
 
-    int t = 100;
-    
-    while(bttfn_checkmc() && t--) {}
+    PROF_SCOPE(PROF_BTTFN);
+
+    bttfn_rxHandle();
+
+    if(bttfnCl.cacheDirty) {
+        bttfn_saveCache();
+    }
 
-    unsigned long now = millisNonZero();
+    unsigned long now = sidMillisNonZero();
             
-    BTTFNCheckPacket();
+    BTTFNCheckTimeout();
     
-    if(bttfnDataNotEnabled) {
+    if(bttfnCl.notData) {
+        // No polling, so probe now and then to keep the
+        // round trip estimate up to date
+        if(now - bttfnRttProbeNow > BTTFN_RTT_PROBE_INT) {
+            bttfnRttProbeNow = now;
+            BTTFNSendRequest();
+        }
         if(now - lastBTTFNKA > BTTFN_KA_INTERVAL) {
             if(!BTTFNLastCmdSent || (now - BTTFNLastCmdSent > (BTTFN_KA_INTERVAL/2))) {
                 bttfn_send_command(BTTFN_REMCMD_KEEPALIVE, 0, 0);
@@ -3674,12 +4183,9 @@ void bttfn_loop()
                 lastBTTFNKA += BTTFN_KA_INTERVAL;
             } while(now - lastBTTFNKA >= BTTFN_KA_INTERVAL);
         }
-        if(now - bttfnLastNotData > BTTFN_DATA_TO) {
-            // Return to polling if no NOT_DATA for too long
-            bttfnDataNotEnabled = false;
-            bttfnTCDDataSeqCnt = 1;
-            // Re-do DISCOVER, TCD might have got new IP address
-            if(tcdHostNameHash) haveTCDIP = false;
+        if(bttfn_cliDataTimeout(&bttfnCl, now)) {
+            // Returned to polling, no NOT_DATA for too long
+            bttfn_seqReset(&bttfnTCDDataSeq);
             // Don't assume TCD comes back with same SSID/pwMarker
             bttfnHaveTCDSSID = 0;
             // Avoid immediate return to stand-alone in main_loop()
@@ -3688,15 +4194,29 @@ void bttfn_loop()
             Serial.println("NOT_DATA timeout, returning to polling");
             #endif
         }
-    } else if(!BTTFNPacketDue) {
+    } else if(!bttfnCl.packetDue) {
         // If WiFi status changed, trigger immediately
         if(!BTTFNWiFiUp && (WiFi.status() == WL_CONNECTED)) {
-            BTTFNUpdateNow = 0;
+            bttfnCl.updateNow = 0;
         }
-        if((!BTTFNUpdateNow) || (now - BTTFNUpdateNow > bttfnSIDPollInt)) {
+        if(bttfn_cliPollDue(&bttfnCl, now)) {
             BTTFNSendRequest();
         }
     }
+
+    // Send request, keep-alive and commands queued since last time
+    bttfn_txFlush();
+
+    // Packet rates
+    if(now - bttfnRateNow >= 60*1000) {
+        uint32_t rx = bttfnRxSt.received, tx = bttfnRxSt.sent;
+        bttfnRxSt.rxPerMin = rx - bttfnRateRx;
+        bttfnRxSt.txPerMin = tx - bttfnRateTx;
+        bttfnRateRx = rx;
+        bttfnRateTx = tx;
+        bttfnRateNow = now;
+    }
+    bttfnRxSt.pollInt = bttfnCl.notData ? 0 : bttfn_cliPollInt(&bttfnCl);
 }
 
 static void bttfn_loop_quick()
@@ -3704,7 +4224,7 @@ static void bttfn_loop_quick()
     if(!useBTTFN)
         return;
     
-    int t = 100;
-    
-    while(bttfn_checkmc() && t--) {}
+    bttfn_rxHandle();
+
+    bttfn_txFlush();
 }
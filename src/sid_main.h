@@ -71,7 +71,7 @@ void prepareReboot();
 void populateIRarray(uint32_t *irkeys, int index);
 void copyIRarray(uint32_t *irkeys, int index);
 
-void showWordSequence(const char *text, int speed = 3);
+bool showWordSequence(const char *text, int speed = 3);
 
 void mydelay(unsigned long mydel, bool withIR);
 unsigned long millisNonZero();
@@ -81,8 +81,8 @@ void wakeup();
 
 void setIdleMode(int idleNo);
 
-void addCmdQueue(uint32_t command);
 void bttfn_loop();
+void bttfn_saFrame(const int *heights, const uint8_t *peaks, int numBands, int barHeight);
 
 extern unsigned long powerupMillis;
 
@@ -111,24 +111,10 @@ extern bool blockScan;
 extern bool TTrunning;
 extern bool IRLearning;
 
-extern bool networkTimeTravel;
-extern bool networkTCDTT;
-extern bool networkReentry;
-extern bool networkAbort;
 extern bool networkAlarm;
-extern uint16_t networkLead;
-extern uint16_t networkP1;
-
-extern uint32_t mqttDisp;
-#ifdef SID_HAVEMQTT
-extern char mqttMsg[];
-#endif
 
 extern uint32_t myRemID;
 
-extern bool doPrepareTT;
-extern bool doWakeup;
-
 extern bool sidBusy;
 
 extern bool showUpdAvail;
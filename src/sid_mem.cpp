@@ -0,0 +1,190 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Memory telemetry
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+#include "sid_global.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+#include "sid_mem.h"
+
+/*
+ * Memory telemetry
+ *
+ * Free heap, largest free block (as a measure of fragmentation),
+ * minimum free heap and failed allocations are monitored; each
+ * subsystem reports its static footprint and its current heap
+ * use through its xxx_getMemUse() provider.
+ *
+ * Heap pressure: If the largest free block falls below
+ * MEM_PRESSURE_BLOCK, the registered hooks are called (once per
+ * episode) in order to release buffers that can be re-allocated
+ * later (such as those of an inactive SA). The hooks are called
+ * from the loop task.
+ */
+
+const char *memNames[MEM_NUM] = {
+    "display", "sa", "ir", "siddly", "snake", "bttfn", "events", "net", "prof"
+};
+
+static void (* const memProviders[MEM_NUM])(memUse *m) = {
+    display_getMemUse, sa_getMemUse, ir_getMemUse, si_getMemUse,
+    sn_getMemUse, bttfn_getMemUse, evt_getMemUse, wifi_getMemUse,
+    prof_getMemUse
+};
+
+static memPressureHook hooks[MEM_MAX_HOOKS] = { NULL };
+static int             numHooks = 0;
+
+static memStat         memStats;
+static unsigned long   lastCheck = 0;
+
+static volatile uint32_t allocFails = 0;
+static volatile uint32_t lastFailSize = 0;
+
+// Called in context of failing malloc(); keep short
+static void allocFailed(size_t size, uint32_t caps, const char *func)
+{
+    allocFails++;
+    lastFailSize = size;
+}
+
+void mem_setup()
+{
+    heap_caps_register_failed_alloc_callback(allocFailed);
+    mem_loop();
+}
+
+// Called once per subsystem, from loop task
+void mem_addPressureHook(memPressureHook hook)
+{
+    for(int i = 0; i < numHooks; i++) {
+        if(hooks[i] == hook) return;
+    }
+
+    if(numHooks < MEM_MAX_HOOKS) {
+        hooks[numHooks++] = hook;
+    }
+}
+
+void mem_loop()
+{
+    unsigned long now = millis();
+
+    if(lastCheck && (now - lastCheck < MEM_CHECK_INT))
+        return;
+
+    lastCheck = now;
+
+    memStats.freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    memStats.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    memStats.minFreeHeap = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    memStats.allocFails = allocFails;
+    memStats.lastFailSize = lastFailSize;
+
+    if(!memStats.pressure) {
+        if(memStats.largestBlock < MEM_PRESSURE_BLOCK) {
+            memStats.pressure = true;
+            memStats.pressureCnt++;
+            #ifdef SID_DBG
+            Serial.printf("Heap pressure: free %d, largest block %d\n", 
+                  memStats.freeHeap, memStats.largestBlock);
+            #endif
+            for(int i = 0; i < numHooks; i++) {
+                hooks[i]();
+            }
+        }
+    } else if(memStats.largestBlock > MEM_RELAX_BLOCK) {
+        memStats.pressure = false;
+    }
+}
+
+// Snapshot of last check
+void mem_getStats(memStat *st)
+{
+    *st = memStats;
+}
+
+void mem_getUse(int sub, memUse *m)
+{
+    memset(m, 0, sizeof(*m));
+    memProviders[sub](m);
+}
+
+// Returns length, or 0 if buffer too small
+int mem_getJSON(char *buf, int bufSize)
+{
+    memStat st;
+    int len, r;
+
+    mem_getStats(&st);
+    
+    len = snprintf(buf, bufSize, "{\"free\":%u,\"largest\":%u,\"min\":%u,\"press\":%u,\"fails\":%u,\"use\":{",
+              (unsigned int)st.freeHeap, (unsigned int)st.largestBlock, (unsigned int)st.minFreeHeap,
+              (unsigned int)st.pressureCnt, (unsigned int)st.allocFails);
+    if(len < 0 || len >= bufSize) return 0;
+
+    for(int i = 0; i < MEM_NUM; i++) {
+        memUse m;
+        mem_getUse(i, &m);
+        r = snprintf(buf + len, bufSize - len, "%s\"%s\":[%u,%u]", i ? "," : "", memNames[i],
+                (unsigned int)m.staticBytes, (unsigned int)m.heapBytes);
+        if(r < 0 || r >= bufSize - len) return 0;
+        len += r;
+    }
+
+    r = snprintf(buf + len, bufSize - len, "}}");
+    if(r < 0 || r >= bufSize - len) return 0;
+
+    return len + r;
+}
@@ -0,0 +1,115 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Memory telemetry
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+#ifndef _SID_MEM_H
+#define _SID_MEM_H
+
+#define MEM_CHECK_INT       1000        // ms; heap check interval
+#define MEM_PRESSURE_BLOCK  (16*1024)   // Largest free block below this: pressure
+#define MEM_RELAX_BLOCK     (24*1024)   // ...above this: pressure over
+#define MEM_MAX_HOOKS       4
+
+// Subsystems
+enum {
+    MEM_DISPLAY = 0,
+    MEM_SA,
+    MEM_IR,
+    MEM_SIDDLY,
+    MEM_SNAKE,
+    MEM_BTTFN,
+    MEM_EVENTS,
+    MEM_NET,
+    MEM_PROF,
+    MEM_NUM
+};
+
+typedef struct {
+    uint32_t staticBytes;     // .bss/.data, fixed
+    uint32_t heapBytes;       // currently allocated by subsystem
+} memUse;
+
+typedef struct {
+    uint32_t freeHeap;
+    uint32_t largestBlock;
+    uint32_t minFreeHeap;     // minimum ever
+    uint32_t pressureCnt;     // times pressure hooks were called
+    uint32_t allocFails;      // failed malloc()s since boot
+    uint32_t lastFailSize;
+    bool     pressure;
+} memStat;
+
+typedef void (*memPressureHook)();
+
+void mem_addPressureHook(memPressureHook hook);
+
+void mem_setup();
+void mem_loop();
+
+void mem_getStats(memStat *st);
+void mem_getUse(int sub, memUse *m);
+int  mem_getJSON(char *buf, int bufSize);
+
+extern const char *memNames[MEM_NUM];
+
+// Subsystem providers
+void display_getMemUse(memUse *m);
+void sa_getMemUse(memUse *m);
+void ir_getMemUse(memUse *m);
+void si_getMemUse(memUse *m);
+void sn_getMemUse(memUse *m);
+void bttfn_getMemUse(memUse *m);
+void evt_getMemUse(memUse *m);
+void wifi_getMemUse(memUse *m);
+void prof_getMemUse(memUse *m);
+
+#endif
@@ -0,0 +1,260 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Power save
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#if defined(CONFIG_PM_ENABLE) && defined(CONFIG_FREERTOS_USE_TICKLESS_IDLE)
+#define PWR_LIGHTSLEEP
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#endif
+
+#include "sid_power.h"
+#include "input.h"
+#include "sid_sched.h"
+#include "sid_wifi.h"
+
+/*
+ * Power save
+ *
+ * Entered while the display is dark (screen saver without clock,
+ * fake power off):
+ * - CPU clock goes down to 80MHz; if the framework was built with
+ *   power management and tickless idle, automatic light sleep is
+ *   enabled instead, with wake-up through the IR and TT GPIOs.
+ * - WiFi goes into modem sleep; it stays associated, but incoming
+ *   packets may be delayed up to the AP's DTIM interval.
+ * - The loop task sleeps up to PWR_MAX_SLEEP ms. IR light, a TT 
+ *   button/TT-IN edge and events from the network task wake it
+ *   earlier.
+ * - IR sampling is stopped; the first IR light only wakes the SID,
+ *   the key itself is lost.
+ *
+ * The current estimate is based on typical ESP32 figures for the
+ * respective states, weighted with the time the loop task sleeps.
+ * It does not include the display.
+ */
+
+#define MA_FULL_AWAKE   115   // 240MHz, WiFi modem always on
+#define MA_FULL_IDLE    95
+#define MA_LOW_AWAKE    45    // 80MHz, WiFi modem sleep
+#ifdef PWR_LIGHTSLEEP
+#define MA_LOW_IDLE     5     // light sleep, WiFi associated (DTIM 1-3)
+#else
+#define MA_LOW_IDLE     25
+#endif
+
+static IRRemote      *irRem = NULL;
+
+static bool          pwrActive = false;
+static bool          pwrIRAsleep = false;
+static unsigned long darkNow = 0;
+static unsigned long pwrStartNow = 0;
+static uint32_t      pwrEnterCnt = 0;
+static uint32_t      pwrActiveSecs = 0;
+
+static unsigned long lastNow = 0;
+static uint64_t      lastSlept = 0;
+static unsigned long windowNow = 0;
+static uint64_t      windowCharge = 0;    // mA * ms
+static uint16_t      estCurrent = 0;
+
+static void setLightSleep(bool enable)
+{
+#ifdef PWR_LIGHTSLEEP
+    esp_pm_config_esp32_t cfg;
+    
+    cfg.max_freq_mhz = 240;
+    cfg.min_freq_mhz = enable ? 80 : 240;
+    cfg.light_sleep_enable = enable;
+    esp_pm_configure(&cfg);
+
+    if(enable) {
+        gpio_wakeup_enable((gpio_num_t)IRREMOTE_PIN, GPIO_INTR_LOW_LEVEL);
+        gpio_wakeup_enable((gpio_num_t)TT_IN_PIN, digitalRead(TT_IN_PIN) ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+        esp_sleep_enable_gpio_wakeup();
+    } else {
+        gpio_wakeup_disable((gpio_num_t)IRREMOTE_PIN);
+        gpio_wakeup_disable((gpio_num_t)TT_IN_PIN);
+    }
+#else
+    setCpuFrequencyMhz(enable ? 80 : 240);
+#endif
+}
+
+static void enterPowerSave(int irMode)
+{
+    pwrActive = true;
+    pwrStartNow = millis();
+    pwrEnterCnt++;
+    
+    sched_resetWakeLatency();
+    
+    if(irRem && irMode != PWR_IR_KEEP) {
+        irRem->sleep(irMode == PWR_IR_WAKE);
+        pwrIRAsleep = true;
+    }
+    
+    wifi_request(NETREQ_PS_ON);
+    setLightSleep(true);
+    sched_setMaxSleep(PWR_MAX_SLEEP);
+
+    #ifdef SID_DBG
+    Serial.println("Power save on");
+    #endif
+}
+
+static void exitPowerSave()
+{
+    sched_setMaxSleep(SCHED_MAX_SLEEP);
+    setLightSleep(false);
+    wifi_request(NETREQ_PS_OFF);
+    
+    if(pwrIRAsleep) {
+        irRem->wake();
+        pwrIRAsleep = false;
+    }
+
+    pwrActiveSecs += (millis() - pwrStartNow) / 1000;
+    pwrActive = false;
+
+    #ifdef SID_DBG
+    Serial.println("Power save off");
+    #endif
+}
+
+static void updateEstimate(unsigned long now)
+{
+    uint64_t slept = sched_getSlept();
+    uint32_t dt = now - lastNow;
+    uint32_t ds = (slept - lastSlept) / 1000;
+
+    if(ds > dt) ds = dt;
+    
+    if(pwrActive) {
+        windowCharge += (uint64_t)(dt - ds) * MA_LOW_AWAKE + (uint64_t)ds * MA_LOW_IDLE;
+    } else {
+        windowCharge += (uint64_t)(dt - ds) * MA_FULL_AWAKE + (uint64_t)ds * MA_FULL_IDLE;
+    }
+    lastNow = now;
+    lastSlept = slept;
+
+    if(now - windowNow >= PWR_WINDOW) {
+        estCurrent = windowCharge / (now - windowNow);
+        windowCharge = 0;
+        windowNow = now;
+    }
+}
+
+void power_setup(IRRemote *ir)
+{
+    irRem = ir;
+    lastNow = windowNow = millis();
+}
+
+/*
+ * Called by main_loop() on every pass
+ * dark:   Display is dark, nothing runs
+ * irMode: PWR_IR_xxx
+ * Returns true if power save was ended by IR light
+ */
+bool power_loop(bool dark, int irMode)
+{
+    unsigned long now = millis();
+    bool ret = false;
+
+    updateEstimate(now);
+
+    if(!dark) {
+        darkNow = 0;
+        if(pwrActive) {
+            exitPowerSave();
+        }
+        return false;
+    }
+
+    if(!pwrActive) {
+        if(!darkNow) {
+            darkNow = now;
+        } else if(now - darkNow >= PWR_ENTER_DELAY) {
+            enterPowerSave(irMode);
+        }
+        return false;
+    }
+
+    if(pwrIRAsleep && irRem->edgeSeen()) {
+        exitPowerSave();
+        darkNow = 0;
+        ret = true;
+    }
+
+    return ret;
+}
+
+void power_getStats(powerStat *st)
+{
+    st->active = pwrActive;
+    #ifdef PWR_LIGHTSLEEP
+    st->lightSleep = true;
+    #else
+    st->lightSleep = false;
+    #endif
+    st->enterCnt = pwrEnterCnt;
+    st->activeSecs = pwrActiveSecs + (pwrActive ? (millis() - pwrStartNow) / 1000 : 0);
+    st->estCurrent = estCurrent;
+    sched_getWakeLatency(&st->wakeCnt, &st->wakeLatAvg, &st->wakeLatMax);
+}
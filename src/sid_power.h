@@ -0,0 +1,85 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Power save
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef _SID_POWER_H
+#define _SID_POWER_H
+
+#define PWR_ENTER_DELAY   2000    // ms display must be dark before entering power save
+#define PWR_MAX_SLEEP     100     // ms; max loop sleep in power save
+#define PWR_WINDOW        10000   // ms; current estimate is averaged per window
+
+// IR handling in power save
+#define PWR_IR_KEEP   0   // Keep sampling
+#define PWR_IR_OFF    1   // Stop sampling
+#define PWR_IR_WAKE   2   // Stop sampling, IR light ends power save
+
+class IRRemote;
+
+typedef struct {
+    bool     active;
+    bool     lightSleep;          // automatic light sleep available
+    uint32_t enterCnt;
+    uint32_t activeSecs;          // total time in power save
+    uint16_t estCurrent;          // mA, last window; w/o display
+    uint32_t wakeCnt;             // ISR wake-ups (last power save period)
+    uint32_t wakeLatAvg;          // us
+    uint32_t wakeLatMax;          // us
+} powerStat;
+
+void power_setup(IRRemote *ir);
+bool power_loop(bool dark, int irMode);
+
+void power_getStats(powerStat *st);
+
+#endif
@@ -0,0 +1,216 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Loop profiler
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#include "sid_prof.h"
+#include "sid_mem.h"
+
+/*
+ * Loop profiler (SID_HAVEPROF)
+ *
+ * Sections of the main loop are timed through PROF_SCOPE() and
+ * collected into per-section duration histograms. Statistics are
+ * gathered over windows of PROF_WINDOW ms; the last complete
+ * window is what is reported (MQTT, Config Portal).
+ *
+ * Boot phases (SID_HAVESTATS) are time-stamped once through 
+ * prof_bootMark(), and reported through MQTT and the Config Portal.
+ */
+
+const char *profNames[PROF_NUM] = {
+    "sa", "si", "sn", "ir", "remcmd", "wifi", "bttfn", "mqtt", "show",
+    "delay", "updchk", "mqttcon", "fswrite"
+};
+
+const char *profBootNames[BOOT_NUM] = {
+    "setup", "display", "settings", "wificfg", "main", "frame", "net", "mqtt"
+};
+
+#ifdef SID_HAVEPROF
+
+const uint32_t profLimits[PROF_BUCKETS - 1] = {
+    100, 500, 1000, 2000, 5000, 10000, 50000
+};
+
+static profStat      profCur[PROF_NUM];
+static profStat      profLast[PROF_NUM];
+static unsigned long profWindowNow = 0;
+
+// Sections are recorded by loop and network task
+static portMUX_TYPE  profMux = portMUX_INITIALIZER_UNLOCKED;
+
+void prof_record(int sect, uint32_t us)
+{
+    profStat *p = &profCur[sect];
+    int b;
+
+    for(b = 0; b < PROF_BUCKETS - 1; b++) {
+        if(us < profLimits[b]) break;
+    }
+
+    portENTER_CRITICAL(&profMux);
+    p->calls++;
+    p->total += us;
+    if(us > p->max) p->max = us;
+    p->hist[b]++;
+    portEXIT_CRITICAL(&profMux);
+}
+
+// Returns true when a new window is complete
+bool prof_loop()
+{
+    unsigned long now = millis();
+    
+    if(now - profWindowNow < PROF_WINDOW)
+        return false;
+
+    portENTER_CRITICAL(&profMux);
+    memcpy(profLast, profCur, sizeof(profLast));
+    memset(profCur, 0, sizeof(profCur));
+    portEXIT_CRITICAL(&profMux);
+    profWindowNow = now;
+
+    return true;
+}
+
+const profStat *prof_getStats()
+{
+    return profLast;
+}
+
+// Section statistics of last window as JSON; returns
+// length, or 0 if buffer too small
+int prof_getJSON(int sect, char *buf, int bufSize)
+{
+    const profStat *p = &profLast[sect];
+    int len, r;
+
+    len = snprintf(buf, bufSize, "{\"win\":%d,\"n\":%u,\"avg\":%u,\"max\":%u,\"h\":[",
+              PROF_WINDOW / 1000, (unsigned int)p->calls, 
+              (unsigned int)(p->calls ? p->total / p->calls : 0), (unsigned int)p->max);
+    if(len < 0 || len >= bufSize) return 0;
+    
+    for(int j = 0; j < PROF_BUCKETS; j++) {
+        r = snprintf(buf + len, bufSize - len, j ? ",%u" : "%u", (unsigned int)p->hist[j]);
+        if(r < 0 || r >= bufSize - len) return 0;
+        len += r;
+    }
+    
+    r = snprintf(buf + len, bufSize - len, "]}");
+    if(r < 0 || r >= bufSize - len) return 0;
+
+    return len + r;
+}
+
+#endif  // SID_HAVEPROF
+
+#ifdef SID_HAVESTATS
+
+static uint32_t bootTimes[BOOT_NUM] = { 0 };
+
+// Called by loop and network task; each phase only by one
+void prof_bootMark(int phase)
+{
+    if(bootTimes[phase])
+        return;
+        
+    bootTimes[phase] = millis();
+    if(!bootTimes[phase]) bootTimes[phase]++;
+    
+    #ifdef SID_DBG
+    Serial.printf("Boot: %s at %dms\n", profBootNames[phase], bootTimes[phase]);
+    #endif
+}
+
+// Returns 0 if phase not (yet) reached
+uint32_t prof_bootTime(int phase)
+{
+    return bootTimes[phase];
+}
+
+// Boot phases as JSON; returns length, or 0 if buffer too small
+int prof_getBootJSON(char *buf, int bufSize)
+{
+    int len = 1, r;
+    
+    if(bufSize < 2) return 0;
+    buf[0] = '{';
+
+    for(int i = 0; i < BOOT_NUM; i++) {
+        r = snprintf(buf + len, bufSize - len, "%s\"%s\":%u", i ? "," : "", 
+                    profBootNames[i], (unsigned int)bootTimes[i]);
+        if(r < 0 || r >= bufSize - len) return 0;
+        len += r;
+    }
+    
+    r = snprintf(buf + len, bufSize - len, "}");
+    if(r < 0 || r >= bufSize - len) return 0;
+
+    return len + r;
+}
+
+#endif  // SID_HAVESTATS
+
+void prof_getMemUse(memUse *m)
+{
+    #ifdef SID_HAVEPROF
+    m->staticBytes += sizeof(profCur) + sizeof(profLast);
+    #endif
+    #ifdef SID_HAVESTATS
+    m->staticBytes += sizeof(bootTimes);
+    #endif
+}
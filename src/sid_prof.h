@@ -0,0 +1,162 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Loop profiler
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef _SID_PROF_H
+#define _SID_PROF_H
+
+#include "sid_stall.h"
+
+// Profiled sections; also stall detector regions
+#define PROF_SA       0   // sa_loop()
+#define PROF_SI       1   // si_loop()
+#define PROF_SN       2   // sn_loop()
+#define PROF_IR       3   // ir_remote.loop() (decoding)
+#define PROF_REMCMD   4   // handleRemoteCommand()
+#define PROF_WIFI     5   // wifi_loop()
+#define PROF_BTTFN    6   // bttfn_loop()
+#define PROF_MQTT     7   // mqttClient.loop()
+#define PROF_SHOW     8   // sid.show()
+#define PROF_DELAY    9   // mydelay()
+#define PROF_UPDCHK   10  // checkForUpdate()
+#define PROF_MQTTCON  11  // mqttClient.connect()
+#define PROF_FSWRITE  12  // Writes to SD/flash FS
+#define PROF_NUM      13
+
+// Boot phases; time stamps in ms since power-up
+#define BOOT_SETUP    0   // setup() entered
+#define BOOT_DISPLAY  1   // Display initialized (main_boot())
+#define BOOT_SETTINGS 2   // Settings loaded
+#define BOOT_WIFICFG  3   // WiFi/CP configured (not connected)
+#define BOOT_MAIN     4   // main_setup() done (IR, startup sequence queued)
+#define BOOT_FRAME    5   // First frame of startup sequence shown
+#define BOOT_NET      6   // WiFi connected (or AP up)
+#define BOOT_MQTT     7   // First MQTT connection
+#define BOOT_NUM      8
+
+extern const char *profNames[PROF_NUM];
+extern const char *profBootNames[BOOT_NUM];
+
+#ifdef SID_HAVEPROF
+
+#include <esp_timer.h>
+
+// Duration histogram: bucket n counts calls shorter than
+// profLimits[n] us, the last one everything beyond.
+#define PROF_BUCKETS  8
+
+#define PROF_WINDOW   60000   // ms; statistics are collected per window
+
+typedef struct {
+    uint32_t calls;
+    uint32_t total;     // us
+    uint32_t max;       // us
+    uint32_t hist[PROF_BUCKETS];
+} profStat;
+
+void prof_record(int sect, uint32_t us);
+bool prof_loop();
+const profStat *prof_getStats();
+int  prof_getJSON(int sect, char *buf, int bufSize);
+
+extern const uint32_t profLimits[PROF_BUCKETS - 1];
+
+// Times the rest of the enclosing block, and marks it as
+// current region for the stall detector
+class profScope {
+
+    public:
+        #ifdef SID_HAVESTATS
+        profScope(uint8_t sect) : _sect(sect), _prev(stall_enter(sect)), _start(esp_timer_get_time()) {}
+        #else
+        profScope(uint8_t sect) : _sect(sect), _start(esp_timer_get_time()) {}
+        #endif
+        ~profScope() 
+        { 
+            prof_record(_sect, (uint32_t)(esp_timer_get_time() - _start));
+            #ifdef SID_HAVESTATS
+            stall_leave(_prev);
+            #endif
+        }
+    
+    private:
+        uint8_t _sect;
+        #ifdef SID_HAVESTATS
+        int8_t  _prev;
+        #endif
+        int64_t _start;
+};
+
+#define PROF_SCOPE(s) profScope _profScope(s)
+
+#else
+
+#define PROF_SCOPE(s)
+
+#endif  // SID_HAVEPROF
+
+#ifdef SID_HAVESTATS
+
+void     prof_bootMark(int phase);
+uint32_t prof_bootTime(int phase);
+int      prof_getBootJSON(char *buf, int bufSize);
+
+#define PROF_BOOT(p)  prof_bootMark(p)
+
+#else
+
+#define PROF_BOOT(p)
+
+#endif  // SID_HAVESTATS
+
+#endif
@@ -59,10 +59,14 @@
 #include <driver/adc.h>
 #include <soc/i2s_reg.h>
 #include "sid_main.h"
+#include "sid_prof.h"
+#include "sid_time.h"
+#include "sid_mem.h"
 
-#define NUMBANDS      11    // Number of bands ("bins" in FFT-speak)
-#define DISPLAYBANDS  10    // Displayed number of bands
-#define LEDS_PER_BAR  20    // Height of bar
+#define NUMBANDS      11    // Default number of bands ("bins" in FFT-speak)
+#define DISPLAYBANDS  10    // Default displayed number of bands
+#define LEDS_PER_BAR  20    // Default height of bar
+#define MAXBANDS      (SD_MAX_WIDTH + 1)  // Max number of bands
 
 #define NUMSAMPLES  1024    // Size of sample block
 #define SAMPLERATE 32000    // Sampling frequency
@@ -74,28 +78,35 @@
 
 static const i2s_port_t I2S_PORT = I2S_NUM_0;
 
-static int32_t rawSamples[NUMSAMPLES];
-static FTYPE vReal[NUMSAMPLES];
-static FTYPE vImag[NUMSAMPLES];
+// Sample and FFT buffers; static, since a ~12K block might not
+// be available on a fragmented heap. Only the i2s driver (and its
+// DMA buffers) is installed upon first activation, and released 
+// under heap pressure while inactive.
+typedef struct {
+    int32_t rawSamples[NUMSAMPLES];
+    FTYPE   vReal[NUMSAMPLES];
+    FTYPE   vImag[NUMSAMPLES];
+} saBuffers;
+static saBuffers saBuf;
 
-static FTYPE freqBands[NUMBANDS] = { 0.0f };
+static FTYPE freqBands[MAXBANDS] = { 0.0f };
 
 // 32 = 32ms * 32 = 1 sec
 // 64 = 32ms * 64 = 2 secs
 // 128 = 32ms * 128 = 4 secs
 #define FQ_HIST 128
 static int histIdx = 0;
-static FTYPE freqBandsHistory[FQ_HIST][NUMBANDS] = { 0.0f };
+static FTYPE freqBandsHistory[FQ_HIST][MAXBANDS] = { 0.0f };
 
 // The frequency bands
 // First one is "garbage bin", not used for display
-static const int freqSteps[NUMBANDS] = {
+static const int defFreqSteps[NUMBANDS] = {
     80,  100,  150,  250,  430,  600, 1000, 2000, 4000, 6000, 8000
 //  80,  100,  150,  250,  430,  600, 1000, 2000, 4000, 7000, 10000
 };
 
 // Noise threshold per band. Lower bands have more noise.
-static const FTYPE minTreshold[NUMBANDS] = {
+static const FTYPE defMinTreshold[NUMBANDS] = {
     0.0f, 5000.0f, 5000.0f, 5000.0f, 3000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f, 1000.0f
 };
 
@@ -103,16 +114,24 @@ static const int maxTTHeight[10] = {
     20, 20, 13, 20, 20, 19, 20, 10, 20, 17
 };
 
-static int oldHeight[DISPLAYBANDS]  = { 0 };
+// Bands in use; depend on display width
+static int   numBands = NUMBANDS;
+static int   dispBands = DISPLAYBANDS;
+static int   ledsPerBar = LEDS_PER_BAR;
+static int   freqSteps[MAXBANDS];
+static FTYPE minTreshold[MAXBANDS];
 
-static uint8_t       peaks[DISPLAYBANDS]     = { 0 };
-static unsigned long newPeak[DISPLAYBANDS]   = { 0 };
-static unsigned long peakTimer[DISPLAYBANDS] = { 0 };
+static int oldHeight[MAXBANDS]  = { 0 };
+
+static uint8_t       peaks[MAXBANDS]     = { 0 };
+static unsigned long newPeak[MAXBANDS]   = { 0 };
+static unsigned long peakTimer[MAXBANDS] = { 0 };
 
 bool        saActive = false;
 static bool sa_avail = false;
 bool        doPeaks  = false;
 bool        doMirror = false;
+bool        doSoft   = false;
 static bool startFlag = false;
 static bool initFlag = false;
 static bool initDisplay = true;
@@ -151,6 +170,38 @@ static const i2s_config_t i2s_config = {
     .fixed_mclk           = 0
 };   
 
+// Set up bands for display width. For the original 10 bars, the
+// hand-tuned table is used; otherwise the same range is split into
+// log-spaced bands, at least one FFT bin wide.
+static void sa_setupBands()
+{
+    dispBands = min(sid.getWidth(), MAXBANDS - 1);
+    numBands = dispBands + 1;
+    ledsPerBar = sid.getHeight();
+
+    if(dispBands == DISPLAYBANDS) {
+        memcpy(freqSteps, defFreqSteps, sizeof(defFreqSteps));
+        memcpy(minTreshold, defMinTreshold, sizeof(defMinTreshold));
+        return;
+    }
+
+    FTYPE fact = powf((FTYPE)defFreqSteps[NUMBANDS-1] / (FTYPE)defFreqSteps[0], 1.0f / (FTYPE)dispBands);
+    FTYPE f = (FTYPE)defFreqSteps[0];
+    int minStep = (SAMPLERATE / NUMSAMPLES) + 1;
+    
+    freqSteps[0] = defFreqSteps[0];
+    minTreshold[0] = 0.0f;
+    for(int i = 1, k = 1; i < numBands; i++) {
+        f *= fact;
+        freqSteps[i] = max((int)f, freqSteps[i-1] + minStep);
+        // Use threshold of the default band this one ends in
+        while(k < NUMBANDS - 1 && defFreqSteps[k] < freqSteps[i]) k++;
+        minTreshold[i] = defMinTreshold[k];
+    }
+}
+
+static void sa_remove();
+
 static bool sa_setup()
 {
     esp_err_t err;
@@ -172,8 +223,12 @@ static bool sa_setup()
 
     i2s_set_pin(I2S_PORT, &i2sPins);
 
+    sa_setupBands();
+
     sa_avail = true;
 
+    mem_addPressureHook(sa_remove);
+
     #if defined(SID_DBG) && defined(SA_DBG_WRITEOUT)
     if(haveSD) {
         outFile = SD.open("/sidsa.pcm", FILE_WRITE);
@@ -184,31 +239,48 @@ static bool sa_setup()
     return true;
 }
 
-#if 0   // Unused
-void sa_remove()
+// Heap pressure hook: Release driver if inactive
+static void sa_remove()
 {
-    if(!sa_avail)
+    if(!sa_avail || saActive)
         return;
         
     i2s_driver_uninstall(I2S_PORT);
     sa_avail = false;
+
+    #ifdef SID_DBG
+    Serial.println("SA: Driver released");
+    #endif
+}
+
+void sa_getMemUse(memUse *m)
+{
+    m->staticBytes = sizeof(freqBands) + sizeof(freqBandsHistory) + sizeof(freqSteps) + 
+                     sizeof(minTreshold) + sizeof(oldHeight) + sizeof(peaks) + 
+                     sizeof(newPeak) + sizeof(peakTimer) + sizeof(saBuf);
+    if(sa_avail) {
+        m->heapBytes = (i2s_config.dma_buf_count * i2s_config.dma_buf_len * sizeof(int32_t));
+    }
 }
-#endif
 
 // internal resume/stop
 
-static void sa_resume(bool initDisp, unsigned long start_Delay)
+static bool sa_resume(bool initDisp, unsigned long start_Delay)
 {
-    if(!sa_avail)
-        sa_setup();
-    else 
+    if(!sa_avail) {
+        if(!sa_setup())
+            return false;
+    } else {
         i2s_start(I2S_PORT);
+    }
 
-    lastTime = lastStart = millis();
+    lastTime = lastStart = sidMillis();
     startFlag = true;
     startDelay = start_Delay;
     initFlag = false;
     initDisplay = initDisp;
+
+    return true;
 }
 
 static void sa_stop()
@@ -218,12 +290,15 @@ static void sa_stop()
 
 // Externally called activate/deactivate
 
-void sa_activate(bool init, unsigned long start_Delay)
+// Returns false if the i2s driver could not be installed
+bool sa_activate(bool init, unsigned long start_Delay)
 {
-    sa_resume(init, start_Delay);
+    if(!sa_resume(init, start_Delay))
+        return false;
 
-    if(sa_avail)
-        saActive = true;
+    saActive = true;
+
+    return true;
 }
 
 void sa_deactivate()
@@ -233,6 +308,8 @@ void sa_deactivate()
 
     saActive = false;
 
+    sid.setDither(false);
+
     #if defined(SID_DBG) && defined(SA_DBG_WRITEOUT)
     outFile.close();
     outFileOpen = false;
@@ -257,7 +334,7 @@ int sa_setAmpFact(int newAmpFact)
 void sa_loop()
 {
     size_t bytesRead = 0;
-    unsigned long now = millis();
+    unsigned long now = sidMillis();
     int band = 0;
     FTYPE mmax = 1.0f;
     
@@ -267,18 +344,24 @@ void sa_loop()
     if(lastTime && (now - lastTime < (NUMSAMPLES * 1000 / SAMPLERATE)))
         return;
 
-    //unsigned long dnow1 = millis();
+    PROF_SCOPE(PROF_SA);
+
+    int32_t *rawSamples = saBuf.rawSamples;
+    FTYPE   *vReal = saBuf.vReal;
+    FTYPE   *vImag = saBuf.vImag;
+
+    //unsigned long dnow1 = sidMillis();
 
     // Read. This waits until our requested data is fully available,...
-    i2s_read(I2S_PORT, (void *)rawSamples, sizeof(rawSamples), &bytesRead, portMAX_DELAY);
+    i2s_read(I2S_PORT, (void *)rawSamples, sizeof(saBuf.rawSamples), &bytesRead, portMAX_DELAY);
 
     // .. and therefore, to keep the pace, we update lastTime here, and not above.
     // (-X because ... this leads to us being called a bit earlier than necessary
     // but that's better than too late (if we return above a tad before the data 
     // is ready). Could as well be -5 or -10, but then we burn too much time here.)
-    lastTime = millis() - 2;
+    lastTime = sidMillis() - 2;
 
-    if(bytesRead != sizeof(rawSamples)) {
+    if(bytesRead != sizeof(saBuf.rawSamples)) {
         // what now?
         #ifdef SID_DBG
         Serial.println("bytesRead != sizeof(rawSamples)");
@@ -293,7 +376,7 @@ void sa_loop()
     
     #else
 
-    //unsigned long dnow2 = millis();
+    //unsigned long dnow2 = sidMillis();
 
     // Convert; clear vImag
     for(int i = 0; i < NUMSAMPLES; i++) {
@@ -325,7 +408,7 @@ void sa_loop()
         int freq = (i - 2) * (SAMPLERATE / 2) / (NUMSAMPLES / 2);
         if(freq >= freqSteps[band]) {
             band++;
-            if(band == NUMBANDS) break;
+            if(band == numBands) break;
             else freqBands[band] = 0.0f;
         }
         if(band && (vReal[i] > minTreshold[band])) {
@@ -334,14 +417,14 @@ void sa_loop()
     }
 
     // Store absolute band sums to our history table
-    for(int i = 1; i < NUMBANDS; i++) {
+    for(int i = 1; i < numBands; i++) {
         freqBandsHistory[histIdx][i] = freqBands[i];
     }
     histIdx++;
     histIdx &= (FQ_HIST-1);
 
     // Find maximum in history table for scaling each bar
-    for(int i = 1; i < NUMBANDS; i++) {
+    for(int i = 1; i < numBands; i++) {
         mmax = 1.0f;
         for(int j = 0; j < FQ_HIST; j++) {
             if(mmax < freqBandsHistory[j][i]) mmax = freqBandsHistory[j][i];
@@ -351,19 +434,19 @@ void sa_loop()
 
     //Serial.printf("   %d \n", dnow2-dnow1); 
 
-    now = millis();
+    now = sidMillis();
 
     if(startFlag) {
 
         if(now - lastStart < startDelay) {
             if(!initFlag) {
-                for(int i = 0; i < DISPLAYBANDS; i++) {
+                for(int i = 0; i < dispBands; i++) {
                     peaks[i] = 0;
                     newPeak[i] = now;
                     peakTimer[i] = PEAK_HOLD;
                     oldHeight[i] = 1;
                     if(initDisplay) {
-                        doMirror ? sid.drawMirrorBarWithHeight(i, 1, LEDS_PER_BAR) : sid.drawBarWithHeight(i, 1);
+                        doMirror ? sid.drawMirrorBarWithHeight(i, 1, ledsPerBar) : sid.drawBarWithHeight(i, 1);
                     }
                 }
                 if(initDisplay) {
@@ -375,7 +458,7 @@ void sa_loop()
             startFlag = false;
             histIdx = 0;
             for(int i = 0; i < FQ_HIST; i++) {
-                for(int j = 1; j < NUMBANDS; j++) {
+                for(int j = 1; j < numBands; j++) {
                     freqBandsHistory[i][j] = 0.0f;
                 }
             }
@@ -383,31 +466,38 @@ void sa_loop()
 
     } else {
 
+        // Soft bar tops: Switch display into dither mode
+        if(sid.getDither() != doSoft) {
+            sid.setDither(doSoft);
+        }
+        
         // Calculate bar heights
-        for(int i = 0; i < DISPLAYBANDS; i++) {
-            int height = (int)(freqBands[i+1] * (FTYPE)(LEDS_PER_BAR - 1));
+        for(int i = 0; i < dispBands; i++) {
+            FTYPE fheight = freqBands[i+1] * (FTYPE)(ledsPerBar - 1);
+            int height = (int)fheight;
+            int rawHeight = height;
             int maxHeight;
     
             if(ampFact != 100) {
                 if(!height) height = 1;
                 height = height * ampFact / 100;
-                maxHeight = maxTTHeight[i];
+                maxHeight = (dispBands == DISPLAYBANDS && ledsPerBar == LEDS_PER_BAR) ? maxTTHeight[i] : ledsPerBar;
                 if(!doMirror && (height > maxHeight)) height = maxHeight;
             } else {
-                maxHeight = LEDS_PER_BAR;
-                if(height > LEDS_PER_BAR) height = LEDS_PER_BAR;
+                maxHeight = ledsPerBar;
+                if(height > ledsPerBar) height = ledsPerBar;
                 if(!height) height = 1;
             }
       
             // Smoothen jumps in downward direction
             if(height < oldHeight[i]) {
-                if(oldHeight[i] - height > 10) height = (oldHeight[i] + height) / 2;
+                if(oldHeight[i] - height > ledsPerBar / 2) height = (oldHeight[i] + height) / 2;
                 else                           height = oldHeight[i] - 1;
             }
     
             // Now do peaks
             if(height - 1 > peaks[i]) {
-                peaks[i] = min(LEDS_PER_BAR - 1, height - 1);
+                peaks[i] = min(ledsPerBar - 1, height - 1);
                 newPeak[i] = now;
                 peakTimer[i] = PEAK_HOLD;
             }
@@ -424,18 +514,29 @@ void sa_loop()
                 sid.drawBarWithHeight(i, oldHeight[i]);
                 if(doPeaks && peaks[i] > oldHeight[i] - 1) {
                     sid.drawDot(i, peaks[i]);
+                    // Soft tail of falling peak
+                    if(peakTimer[i] == PEAK_FALL && peaks[i] < ledsPerBar - 1) {
+                        sid.drawPartialDot(i, peaks[i] + 1, 1);
+                    }
+                }
+                // Fractional part of bar height (dither mode only)
+                if(height == rawHeight && height < ledsPerBar) {
+                    sid.drawPartialDot(i, height, (int)((fheight - (FTYPE)rawHeight) * (FTYPE)SD_SUBFRAMES));
                 }
             }
         }
 
         // Put result on display
         sid.show();
+
+        // Pass on to other props, if enabled
+        bttfn_saFrame(oldHeight, peaks, dispBands, ledsPerBar);
     }
 
-    now = millis();
+    now = sidMillis();
 
     // Make peaks fall down
-    for(int i = 0; i < DISPLAYBANDS; i++) {
+    for(int i = 0; i < dispBands; i++) {
         if(newPeak[i] && now - newPeak[i] > peakTimer[i]) {
             if(peaks[i] > 0) {
                 peakTimer[i] = PEAK_FALL;
@@ -56,7 +56,7 @@
 
 #define SA_START_DELAY  1000   // Delay to skip the mic's startup noise
 
-void sa_activate(bool init = true, unsigned long start_Delay = SA_START_DELAY);
+bool sa_activate(bool init = true, unsigned long start_Delay = SA_START_DELAY);
 void sa_deactivate();
 
 int sa_setAmpFact(int newAmpFact);
@@ -66,5 +66,6 @@ void sa_loop();
 extern bool saActive;   // Read only!
 extern bool doPeaks;
 extern bool doMirror;
+extern bool doSoft;
 
 #endif
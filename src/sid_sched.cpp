@@ -0,0 +1,324 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Deadline scheduler
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#include "sid_sched.h"
+#include "sid_task.h"
+#include "sid_time.h"
+
+#include <esp_timer.h>
+
+/*
+ * Deadline scheduler
+ *
+ * Subsystems create tasks once and arm them as one-shot or
+ * periodic timers. sched_run() (called from loop()) dispatches
+ * all tasks whose deadline has passed; sched_idle() then puts
+ * the loop task to sleep until the next deadline, unless some
+ * subsystem declared itself busy for this pass (through
+ * sched_busy()). The sleep is capped at SCHED_MAX_SLEEP so that
+ * remaining polled code (network, buttons) keeps working, and
+ * can be cut short by sched_wake() and sched_wakeFromISR().
+ */
+
+typedef struct {
+    void          (*fn)();
+    unsigned long due;
+    unsigned long period;   // 0 = one-shot
+    bool          armed;
+} schedTask;
+
+static schedTask tasks[SCHED_MAX_TASKS];
+static int       numTasks = 0;
+
+static bool          isBusy = false;
+static bool          haveWakeAt = false;
+static unsigned long wakeAt = 0;
+
+static TaskHandle_t  loopTask = NULL;
+
+static unsigned long maxSleep = SCHED_MAX_SLEEP;
+static uint64_t      sleptUs = 0;
+
+// ISR-to-loop latency
+static volatile int64_t isrWakeStamp = 0;
+static uint32_t      wakeLatCnt = 0;
+static uint32_t      wakeLatMax = 0;
+static uint64_t      wakeLatTotal = 0;
+
+const uint16_t schedJitLimits[SCHED_JIT_BUCKETS - 1] = {
+    1, 2, 5, 10, 20, 50, 100
+};
+static uint32_t jitHist[SCHED_JIT_BUCKETS] = { 0 };
+
+// Must be called from the loop task
+void sched_init()
+{
+    loopTask = xTaskGetCurrentTaskHandle();
+}
+
+// Returns task id, or -1 if table is full
+int sched_create(void (*fn)())
+{
+    if(numTasks >= SCHED_MAX_TASKS) {
+        #ifdef SID_DBG
+        Serial.println("sched_create: Task table full");
+        #endif
+        return -1;
+    }
+
+    tasks[numTasks].fn = fn;
+    tasks[numTasks].armed = false;
+
+    return numTasks++;
+}
+
+// Run task once, ms from now; re-arms if already pending
+void sched_once(int id, unsigned long ms)
+{
+    if(id < 0) return;
+    
+    tasks[id].due = sidMillis() + ms;
+    tasks[id].period = 0;
+    tasks[id].armed = true;
+}
+
+// Run task every period ms, first time period ms from now
+void sched_every(int id, unsigned long period)
+{
+    if(id < 0 || !period) return;
+    
+    tasks[id].due = sidMillis() + period;
+    tasks[id].period = period;
+    tasks[id].armed = true;
+}
+
+void sched_stop(int id)
+{
+    if(id < 0) return;
+    
+    tasks[id].armed = false;
+}
+
+bool sched_pending(int id)
+{
+    return (id >= 0) && tasks[id].armed;
+}
+
+// Wake-up hint for code that still polls sidMillis(): Do not
+// sleep beyond "when" in this pass
+void sched_wakeAt(unsigned long when)
+{
+    if(!haveWakeAt || (long)(when - wakeAt) < 0) {
+        wakeAt = when;
+        haveWakeAt = true;
+    }
+}
+
+// Do not sleep after this pass
+void sched_busy()
+{
+    isBusy = true;
+}
+
+void sched_run()
+{
+    unsigned long now = sidMillis();
+    
+    for(int i = 0; i < numTasks; i++) {
+        schedTask *t = &tasks[i];
+        unsigned long late;
+        int b;
+        
+        if(!t->armed || (long)(now - t->due) < 0)
+            continue;
+
+        late = now - t->due;
+        for(b = 0; b < SCHED_JIT_BUCKETS - 1; b++) {
+            if(late < schedJitLimits[b]) break;
+        }
+        jitHist[b]++;
+        
+        if(t->period) {
+            // Keep the period without drift, unless we have
+            // fallen behind by more than a period
+            t->due += t->period;
+            if((long)(now - t->due) >= 0) {
+                t->due = now + t->period;
+            }
+        } else {
+            t->armed = false;
+        }
+
+        // Callback may re-arm or stop this and other tasks
+        t->fn();
+    }
+}
+
+// Sleep until next deadline, if nobody is busy
+void sched_idle()
+{
+    unsigned long now, wait = maxSleep;
+    uint32_t slept = 0;
+
+    if(isBusy || !loopTask) {
+        isBusy = haveWakeAt = false;
+        #ifdef SID_SIMCLOCK
+        // Busy loop passes take time, too
+        sidAdvance(1);
+        #endif
+        task_idle(TASK_LOOP, 0);
+        return;
+    }
+
+    now = sidMillis();
+
+    for(int i = 0; i < numTasks; i++) {
+        if(tasks[i].armed) {
+            long d = (long)(tasks[i].due - now);
+            if(d < (long)wait) wait = (d > 0) ? d : 0;
+        }
+    }
+    if(haveWakeAt) {
+        long d = (long)(wakeAt - now);
+        if(d < (long)wait) wait = (d > 0) ? d : 0;
+        haveWakeAt = false;
+    }
+
+    #ifdef SID_SIMCLOCK
+    // Simulated time: Skip ahead instead of sleeping
+    sidAdvance(wait);
+    wait = 0;
+    #endif
+
+    if(wait) {
+        uint32_t sleepNow = micros();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+        slept = micros() - sleepNow;
+        sleptUs += slept;
+    }
+
+    if(isrWakeStamp) {
+        uint32_t lat = (uint32_t)(esp_timer_get_time() - isrWakeStamp);
+        isrWakeStamp = 0;
+        wakeLatCnt++;
+        wakeLatTotal += lat;
+        if(lat > wakeLatMax) wakeLatMax = lat;
+    }
+
+    task_idle(TASK_LOOP, slept);
+}
+
+// Cut short current or next sleep
+void sched_wake()
+{
+    if(loopTask) {
+        xTaskNotifyGive(loopTask);
+    }
+}
+
+void IRAM_ATTR sched_wakeFromISR()
+{
+    BaseType_t woken = pdFALSE;
+
+    if(!isrWakeStamp) {
+        isrWakeStamp = esp_timer_get_time();
+    }
+    
+    if(loopTask) {
+        vTaskNotifyGiveFromISR(loopTask, &woken);
+        if(woken) {
+            portYIELD_FROM_ISR();
+        }
+    }
+}
+
+// Cap for sleep in sched_idle(); larger when in power save
+void sched_setMaxSleep(unsigned long ms)
+{
+    maxSleep = ms;
+}
+
+// Total time slept in sched_idle(), us
+uint64_t sched_getSlept()
+{
+    return sleptUs;
+}
+
+// Time from sched_wakeFromISR() until loop task runs again, us
+void sched_getWakeLatency(uint32_t *cnt, uint32_t *avg, uint32_t *max)
+{
+    *cnt = wakeLatCnt;
+    *avg = wakeLatCnt ? (uint32_t)(wakeLatTotal / wakeLatCnt) : 0;
+    *max = wakeLatMax;
+}
+
+void sched_resetWakeLatency()
+{
+    wakeLatCnt = wakeLatMax = 0;
+    wakeLatTotal = 0;
+}
+
+void sched_getJitter(uint32_t *hist)
+{
+    memcpy(hist, jitHist, sizeof(jitHist));
+}
+
+void sched_resetJitter()
+{
+    memset(jitHist, 0, sizeof(jitHist));
+}
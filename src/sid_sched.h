@@ -0,0 +1,94 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Deadline scheduler
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef _SID_SCHED_H
+#define _SID_SCHED_H
+
+#define SCHED_MAX_TASKS   16
+#define SCHED_MAX_SLEEP   10    // ms; max time loop() sleeps when idle (default)
+
+// Jitter histogram: Lateness of task dispatch in ms; bucket n
+// counts dispatches late by less than schedJitLimits[n] ms, the
+// last one everything beyond.
+#define SCHED_JIT_BUCKETS 8
+
+void sched_init();
+
+int  sched_create(void (*fn)());
+void sched_once(int id, unsigned long ms);
+void sched_every(int id, unsigned long period);
+void sched_stop(int id);
+bool sched_pending(int id);
+
+void sched_wakeAt(unsigned long when);
+void sched_busy();
+
+void sched_run();
+void sched_idle();
+
+void sched_wake();
+void sched_wakeFromISR();
+
+void sched_setMaxSleep(unsigned long ms);
+uint64_t sched_getSlept();
+
+void sched_getWakeLatency(uint32_t *cnt, uint32_t *avg, uint32_t *max);
+void sched_resetWakeLatency();
+
+void sched_getJitter(uint32_t *hist);
+void sched_resetJitter();
+
+extern const uint16_t schedJitLimits[SCHED_JIT_BUCKETS - 1];
+
+#endif
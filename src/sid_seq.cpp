@@ -0,0 +1,259 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Sequence player
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+#include "src/SD/SD.h"
+#include <FS.h>
+
+#include "sid_seq.h"
+#include "sid_settings.h"
+
+/*
+ * Sequence player
+ *
+ * Plays bar height sequences stored in flash (const arrays)
+ * or in files on the SD card. Frames are read on demand, only
+ * one frame is cached, so memory usage does not depend on
+ * sequence length.
+ */
+
+static bool seq_readHeader(sidSeq *sq, const uint8_t *hdr, size_t len)
+{
+    if(hdr[0] != 'S' || hdr[1] != 'Q' || hdr[2] != SEQ_VERSION)
+        return false;
+
+    sq->numBars = hdr[3];
+    sq->numFrames = hdr[4] | (hdr[5] << 8);
+    sq->defDur = hdr[6] | (hdr[7] << 8);
+
+    if(!sq->numBars || sq->numBars > SEQ_MAX_BARS || !sq->numFrames)
+        return false;
+
+    sq->frameSize = 3 + sq->numBars;
+
+    if(len < SEQ_HDR_SIZE + (size_t)sq->numFrames * sq->frameSize)
+        return false;
+
+    sq->curIdx = 0;
+    sq->curStart = 0;
+    sq->cacheIdx = -1;
+
+    return true;
+}
+
+static const uint8_t *seq_getFrame(sidSeq *sq, int idx)
+{
+    if(idx == sq->cacheIdx)
+        return sq->cache;
+
+    if(sq->data) {
+        return sq->data + SEQ_HDR_SIZE + idx * sq->frameSize;
+    }
+
+    if(!sq->file.seek(SEQ_HDR_SIZE + idx * sq->frameSize) ||
+       sq->file.read(sq->cache, sq->frameSize) != sq->frameSize) {
+        return NULL;
+    }
+    sq->cacheIdx = idx;
+
+    return sq->cache;
+}
+
+static uint16_t seq_frameDur(sidSeq *sq, const uint8_t *f)
+{
+    uint16_t dur = f[0] | (f[1] << 8);
+
+    return dur ? dur : (sq->defDur ? sq->defDur : 1);
+}
+
+static void seq_calcDuration(sidSeq *sq)
+{
+    sq->totalDur = 0;
+    for(int i = 0; i < sq->numFrames; i++) {
+        const uint8_t *f = seq_getFrame(sq, i);
+        if(!f) {
+            sq->numFrames = i;
+            break;
+        }
+        sq->totalDur += seq_frameDur(sq, f);
+    }
+}
+
+bool seq_openMem(sidSeq *sq, const uint8_t *data, size_t len)
+{
+    sq->data = data;
+
+    if(len < SEQ_HDR_SIZE || !seq_readHeader(sq, data, len)) {
+        sq->numFrames = 0;
+        return false;
+    }
+
+    seq_calcDuration(sq);
+
+    return true;
+}
+
+bool seq_openSD(sidSeq *sq, const char *fn)
+{
+    uint8_t hdr[SEQ_HDR_SIZE];
+
+    if(!haveSD || !SD.exists(fn))
+        return false;
+
+    if(!(sq->file = SD.open(fn, "r")))
+        return false;
+
+    sq->data = NULL;
+    
+    if(sq->file.read(hdr, SEQ_HDR_SIZE) != SEQ_HDR_SIZE ||
+       !seq_readHeader(sq, hdr, sq->file.size())) {
+        #ifdef SID_DBG
+        Serial.printf("seq_openSD: %s is invalid\n", fn);
+        #endif
+        sq->file.close();
+        sq->numFrames = 0;
+        return false;
+    }
+
+    seq_calcDuration(sq);
+
+    if(!sq->numFrames) {
+        sq->file.close();
+        return false;
+    }
+    
+    return true;
+}
+
+void seq_close(sidSeq *sq)
+{
+    if(!sq->data && sq->numFrames) {
+        sq->file.close();
+    }
+    sq->numFrames = 0;
+}
+
+int seq_numFrames(sidSeq *sq)
+{
+    return sq->numFrames;
+}
+
+// Get heights of frame idx; missing bars are set to 0
+bool seq_frame(sidSeq *sq, int idx, uint8_t *heights)
+{
+    const uint8_t *f;
+
+    if(idx < 0 || idx >= sq->numFrames || !(f = seq_getFrame(sq, idx))) {
+        return false;
+    }
+
+    memset(heights, 0, SEQ_MAX_BARS);
+    memcpy(heights, f + 3, sq->numBars);
+
+    return true;
+}
+
+// Get heights at time t (in ms, looped), interpolated if the frame
+// is flagged accordingly. Returns ms until the heights change next.
+uint16_t seq_sample(sidSeq *sq, uint32_t t, uint8_t *heights)
+{
+    const uint8_t *f;
+    uint16_t dur;
+    uint32_t el;
+    uint8_t flags;
+
+    if(!sq->numFrames || !sq->totalDur)
+        return 1000;
+
+    t %= sq->totalDur;
+
+    // Rewind if time went backwards
+    if(t < sq->curStart) {
+        sq->curIdx = 0;
+        sq->curStart = 0;
+    }
+
+    // Advance cursor to frame containing t
+    while(1) {
+        if(!(f = seq_getFrame(sq, sq->curIdx)))
+            return 1000;
+        dur = seq_frameDur(sq, f);
+        if(t - sq->curStart < dur || sq->curIdx >= sq->numFrames - 1)
+            break;
+        sq->curStart += dur;
+        sq->curIdx++;
+    }
+
+    el = t - sq->curStart;
+    flags = f[2];
+
+    memset(heights, 0, SEQ_MAX_BARS);
+    memcpy(heights, f + 3, sq->numBars);
+
+    if(!(flags & SEQF_INTERP)) {
+        return (el < dur) ? dur - el : 1;
+    }
+
+    // Interpolate towards next frame (wrap to first)
+    if((f = seq_getFrame(sq, (sq->curIdx + 1) % sq->numFrames))) {
+        for(int i = 0; i < sq->numBars; i++) {
+            int a = heights[i], b = f[3 + i];
+            heights[i] = a + ((b - a) * (int)el) / (int)dur;
+        }
+    }
+
+    return SEQ_INTERP_TICK;
+}
@@ -0,0 +1,115 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Sequence player
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+#ifndef _SID_SEQ_H
+#define _SID_SEQ_H
+
+#include <FS.h>
+
+/*
+ * Sequence format (all values little endian):
+ *
+ * Header (8 bytes):
+ *   'S', 'Q'       magic
+ *   version        SEQ_VERSION
+ *   numBars        number of heights per frame (1-10)
+ *   numFrames      uint16
+ *   defDur         uint16; frame duration in ms if frame's is 0
+ *
+ * Frame (3 + numBars bytes):
+ *   dur            uint16; duration in ms (0 = defDur)
+ *   flags          SEQF_xxx
+ *   heights        numBars bytes, 0-20
+ */
+
+#define SEQ_VERSION    1
+#define SEQ_HDR_SIZE   8
+#define SEQ_MAX_BARS   10
+
+// Frame flags
+#define SEQF_INTERP    0x01   // Interpolate towards next frame
+
+// Frame rate when interpolating
+#define SEQ_INTERP_TICK 30
+
+// Helpers for building sequences in flash
+#define SEQ_HDR(frames, dur) \
+    'S', 'Q', SEQ_VERSION, SEQ_MAX_BARS, (frames) & 0xff, (frames) >> 8, (dur) & 0xff, (dur) >> 8
+#define SEQ_FRM(dur, flags, b0, b1, b2, b3, b4, b5, b6, b7, b8, b9) \
+    (dur) & 0xff, (dur) >> 8, (flags), b0, b1, b2, b3, b4, b5, b6, b7, b8, b9
+
+typedef struct {
+    const uint8_t *data;      // Sequence in memory, or NULL if file
+    File          file;
+    uint8_t       numBars;
+    uint8_t       frameSize;
+    uint16_t      numFrames;
+    uint16_t      defDur;
+    uint32_t      totalDur;
+    // Playback cursor
+    int           curIdx;
+    uint32_t      curStart;
+    // Frame cache
+    int           cacheIdx;
+    uint8_t       cache[3 + SEQ_MAX_BARS];
+} sidSeq;
+
+bool     seq_openMem(sidSeq *sq, const uint8_t *data, size_t len);
+bool     seq_openSD(sidSeq *sq, const char *fn);
+void     seq_close(sidSeq *sq);
+
+int      seq_numFrames(sidSeq *sq);
+bool     seq_frame(sidSeq *sq, int idx, uint8_t *heights);
+uint16_t seq_sample(sidSeq *sq, uint32_t t, uint8_t *heights);
+
+#endif
@@ -72,6 +72,7 @@
 #include "sid_settings.h"
 #include "sid_main.h"
 #include "sid_wifi.h"
+#include "sid_prof.h"
 
 // Settings transition, stage 2: Assume new settings
 // are present, but still delete obsolete files.
@@ -103,6 +104,7 @@ static struct [[gnu::packed]] {
     uint8_t  updateR            = 0;
     uint8_t  SAmirror           = DEF_SA_MIRROR;
     uint8_t  carMode            = 0;
+    uint8_t  SAsoft             = DEF_SA_SOFT;
 } secSettings;
 
 // Tertiary settings (SD only)
@@ -126,6 +128,7 @@ static uint32_t ipHash = 0;
 static const char *cfgName    = "/sidconfig.json";  // Main config (flash)
 static const char *ipCfgName  = "/sidipcfg";        // IP config (flash)
 static const char *idName     = "/sidid";           // SID remote ID (flash)
+static const char *tcdCacheName = "/sidtcdc";       // BTTFN TCD cache (flash)
 static const char *irCfgName  = "/sidirkeys.json";  // IR keys (system-created) (flash/SD)
 static const char *secCfgName = "/sid2cfg";         // Secondary settings (flash/SD)
 static const char *terCfgName = "/sid3cfg";         // Tertiary settings (SD)
@@ -170,6 +173,7 @@ bool FlashROMode = false;
 
 extern bool doPeaks;
 extern bool doMirror;
+extern bool doSoft;
 
 static bool read_settings(File configFile, int cfgReadCount);
 
@@ -493,6 +497,8 @@ static bool read_settings(File configFile, int cfgReadCount)
         wd |= CopyCheckValidNumParm(json["bttfnTT"], settings.bttfnTT, sizeof(settings.bttfnTT), 0, 1, DEF_BTTFN_TT);
         wd |= CopyCheckValidNumParm(json["ssClock"], settings.ssClock, sizeof(settings.ssClock), 0, 1, DEF_SS_CLK);
         wd |= CopyCheckValidNumParm(json["ssClkOffNM"], settings.ssClockOffNM, sizeof(settings.ssClockOffNM), 0, 1, DEF_SS_CLK_NMOFF);
+        wd |= CopyCheckValidNumParm(json["saBcast"], settings.saBcast, sizeof(settings.saBcast), 0, 1, DEF_SA_BCAST);
+        wd |= CopyCheckValidNumParm(json["sidMir"], settings.sidMirror, sizeof(settings.sidMirror), 0, 2, DEF_SID_MIRROR);
 
         wd |= CopyCheckValidNumParm(json["TCDpresent"], settings.TCDpresent, sizeof(settings.TCDpresent), 0, 1, DEF_TCD_PRES);
         wd |= CopyCheckValidNumParm(json["noETTOLead"], settings.noETTOLead, sizeof(settings.noETTOLead), 0, 1, DEF_NO_ETTO_LEAD);
@@ -562,6 +568,8 @@ void write_settings()
     json["bttfnTT"] = (const char *)settings.bttfnTT;
     json["ssClock"] = (const char *)settings.ssClock;
     json["ssClkOffNM"] = (const char *)settings.ssClockOffNM;
+    json["saBcast"] = (const char *)settings.saBcast;
+    json["sidMir"] = (const char *)settings.sidMirror;
 
     json["TCDpresent"] = (const char *)settings.TCDpresent;
     json["noETTOLead"] = (const char *)settings.noETTOLead;
@@ -887,6 +895,7 @@ void loadSASettings()
         #endif
         doPeaks = !!secSettings.SApeaks;
         doMirror = !!secSettings.SAmirror;
+        doSoft = !!secSettings.SAsoft;
     }
 }
 
@@ -894,6 +903,7 @@ void saveSASettings()
 {
     secSettings.SApeaks = doPeaks ? 1 : 0;
     secSettings.SAmirror = doMirror ? 1 : 0;
+    secSettings.SAsoft = doSoft ? 1 : 0;
     saveSecSettings(true);
 }
 
@@ -983,6 +993,7 @@ void saveAllSecCP()
     secSettings.strictMode = strictMode ? 1 : 0;
     secSettings.SApeaks = doPeaks ? 1 : 0;
     secSettings.SAmirror = doMirror ? 1 : 0;
+    secSettings.SAsoft = doSoft ? 1 : 0;
     secSettings.irShowPosFBDisplay = irShowPosFBDisplay ? 1 : 0;
     secSettings.irShowCmdFBDisplay = irShowCmdFBDisplay ? 1 : 0;
     saveSecSettings(true);
@@ -1130,6 +1141,31 @@ void deleteIpSettings()
     }
 }
 
+/*
+ *  Load/save BTTFN TCD cache
+ */
+
+bool loadTCDCache(uint8_t *buf, int len)
+{
+    int vb = 0;
+    
+    if(!haveFS && !FlashROMode)
+        return false;
+
+    if(!loadConfigFile(tcdCacheName, buf, len, vb, -1))
+        return false;
+
+    return (vb == len);
+}
+
+void saveTCDCache(uint8_t *buf, int len)
+{
+    if(!haveFS && !FlashROMode)
+        return;
+
+    saveConfigFile(tcdCacheName, buf, len, -1);
+}
+
 /*
  *  Load/save/create remote ID
  */
@@ -1391,6 +1427,7 @@ static bool writeFileToSD(const char *fn, uint8_t *buf, int len)
     if(!haveSD)
         return false;
 
+    PROF_SCOPE(PROF_FSWRITE);
     File myFile = SD.open(fn, FILE_WRITE);
     return writeFile(myFile, buf, len);
 }
@@ -1401,6 +1438,7 @@ static bool writeFileToFS(const char *fn, uint8_t *buf, int len)
     if(!haveFS)
         return false;
 
+    PROF_SCOPE(PROF_FSWRITE);
     File myFile = MYNVS.open(fn, FILE_WRITE);
     return writeFile(myFile, buf, len);
 }
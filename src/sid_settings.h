@@ -114,6 +114,9 @@ bool loadIpSettings();
 void writeIpSettings();
 void deleteIpSettings();
 
+bool loadTCDCache(uint8_t *buf, int len);
+void saveTCDCache(uint8_t *buf, int len);
+
 void moveSettings();
 
 // Default settings
@@ -127,6 +130,7 @@ void moveSettings();
 #define DEF_SKIP_TTANIM     1     // 0: Don't skip tt anim; 1: do
 #define DEF_SA_PEAKS        0     // 1: Show peaks in SA, 0: don't
 #define DEF_SA_MIRROR       0     // 1: Show "mirrored" SA, 0: don't
+#define DEF_SA_SOFT         0     // 1: Soft bar tops in SA (dither mode), 0: don't
 #define DEF_IRFB            1     // 0: Don't show positive IR feedback on display; 1: do
 #define DEF_IRCFB           1     // 0: Don't show command entry feedback; 1: do
 #define DEF_SS_TIMER        0     // "Screen saver" timeout in minutes; 0 = ss off
@@ -138,6 +142,8 @@ void moveSettings();
 #define DEF_BTTFN_TT        1     // 0: '0' on IR remote and TT button trigger stand-alone TT; 1: They trigger BTTFN-wide TT
 #define DEF_SS_CLK          0     // "Screen saver" is clock (0=off, 1=on)
 #define DEF_SS_CLK_NMOFF    0     // 0: Clock dimmed in NM 1: Clock off in NM
+#define DEF_SA_BCAST        0     // 0: Don't send SA band data over BTTFN 1: Send
+#define DEF_SID_MIRROR      0     // 0: No idle pattern mirroring 1: Leader 2: Follower
 
 #define DEF_TCD_PRES        0     // 0: No TCD connected, 1: connected via GPIO
 #define DEF_NO_ETTO_LEAD    0     // Default: 0: TCD signals TT with ETTO_LEAD lead time; 1 without
@@ -173,6 +179,8 @@ struct Settings {
     char bttfnTT[2]         = MS(DEF_BTTFN_TT);
     char ssClock[2]         = MS(DEF_SS_CLK);
     char ssClockOffNM[2]    = MS(DEF_SS_CLK_NMOFF);    
+    char saBcast[2]         = MS(DEF_SA_BCAST);
+    char sidMirror[2]       = MS(DEF_SID_MIRROR);
 
     char TCDpresent[2]      = MS(DEF_TCD_PRES);
     char noETTOLead[2]      = MS(DEF_NO_ETTO_LEAD);
@@ -194,6 +202,7 @@ struct Settings {
     char strictMode[2]      = MS(DEF_STRICT);
     char SApeaks[2]         = MS(DEF_SA_PEAKS);
     char SAmirror[2]        = MS(DEF_SA_MIRROR);
+    char SAsoft[2]          = MS(DEF_SA_SOFT);
     char PIRFB[2]           = MS(DEF_IRFB);
     char PIRCFB[2]          = MS(DEF_IRCFB);
     char ecmKludge[2]       = "0";  // MUST BE 0
@@ -58,6 +58,10 @@
 
 #include "sid_siddly.h"
 #include "sid_main.h" 
+#include "sid_prof.h"
+#include "sid_time.h"
+#include "sid_anim.h"
+#include "sid_mem.h"
 
 #define WIDTH  10
 #define HEIGHT 19
@@ -97,6 +101,7 @@ static int     cpy = 0;                 // current y position
 static unsigned long cp_now = 0;
 
 static unsigned long  siStartup = 0;    // startup sequence running
+static bool           siTitle = false;    // title still playing
 static bool           havePiece = false;
 static bool           gameOver = false;
 static bool           gameOverShown = false;
@@ -279,7 +284,7 @@ static void moveRight()
 
 static bool newPiece()
 {
-    cp = esp_random() % NUM_PIECES;
+    cp = sidRandom() % NUM_PIECES;
     cps = ps[cp];
     cpx = (WIDTH - cps) / 2;
     cpy = 0;
@@ -292,7 +297,7 @@ static bool newPiece()
     }
     
     if(canPlace()) {
-        cp_now = millis();
+        cp_now = sidMillis();
         pcnt++;
         havePiece = true;
     } else {
@@ -308,6 +313,10 @@ static void updateDisplay()
 {
     uint8_t myField[WIDTH * (HEIGHT + 1)];
 
+    // Word sequence (level, game over) still playing
+    if(sidBusy)
+        return;
+
     memset((void *)myField, 0, WIDTH);
 
     for(int i = 0; i < min(10, ((PIECES_PER_LEVEL - pcnt) * 10 / PIECES_PER_LEVEL) + 1); i++) {
@@ -344,17 +353,21 @@ void si_init()          // start game
 
     showWordSequence("SIDDLY", 2);
 
-    siStartup = millis();
+    // 1s pause starts when title is done
+    siStartup = sidMillisNonZero();
+    siTitle = true;
     siActive = true;
 }
 
 void si_loop()
 {
-    unsigned long now = millis();
+    unsigned long now = sidMillis();
     
     if(!siActive)
         return;
 
+    PROF_SCOPE(PROF_SI);
+
     if(gameOver) {
         if(!gameOverShown) {
             showWordSequence("GAME OVER ", 1);
@@ -368,6 +381,13 @@ void si_loop()
     }
 
     if(siStartup) {
+        if(siTitle) {
+            if(anim_running())
+                return;
+            siTitle = false;
+            siStartup = sidMillisNonZero();
+            return;
+        }
         if(now - siStartup < 1000) {
             return;
         }
@@ -429,6 +449,12 @@ void si_loop()
     updateDisplay();
 }
   
+void si_getMemUse(memUse *m)
+{
+    m->staticBytes = sizeof(board) + sizeof(cpd) + sizeof(p1) + sizeof(p2) + sizeof(p3) + 
+                     sizeof(p4) + sizeof(p5) + sizeof(p6) + sizeof(p7);
+}
+
 void si_end()
 {
     if(!siActive)
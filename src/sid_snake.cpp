@@ -58,6 +58,10 @@
 
 #include "sid_snake.h"
 #include "sid_main.h" 
+#include "sid_prof.h"
+#include "sid_time.h"
+#include "sid_anim.h"
+#include "sid_mem.h"
 
 #define WIDTH  10
 #define HEIGHT 20
@@ -86,6 +90,7 @@ static const unsigned long ldelays[NUM_LEVELS] = {
 static unsigned long  cp_now = 0;
 
 static unsigned long  snStartup = 0;    // startup sequence running
+static bool           snTitle = false;    // title still playing
 static bool           gameOver = false;
 static bool           gameOverShown = false;
 static bool           pauseGame = false;
@@ -97,6 +102,10 @@ static void updateDisplay()
 {
     uint8_t myField[WIDTH * HEIGHT] = { 0 };
 
+    // Word sequence (level, game over) still playing
+    if(sidBusy)
+        return;
+
     // Snake
     for(int i = 0; i < scl - 1; i++) {
         myField[(snake[i][1] * WIDTH) + snake[i][0]] = 1;
@@ -157,19 +166,23 @@ void sn_init()
     
     showWordSequence("SNAKE", 2);
 
-    snStartup = millis();
+    // 1s pause starts when title is done
+    snStartup = sidMillisNonZero();
+    snTitle = true;
     snActive = true;
 }
 
 void sn_loop()
 {
-    unsigned long now = millis();
+    unsigned long now = sidMillis();
     bool skipCheck = false;
     bool newApple = false;
     
     if(!snActive)
         return;
 
+    PROF_SCOPE(PROF_SN);
+
     if(gameOver) {
         if(!gameOverShown) {
             showWordSequence("GAME OVER ", 1);
@@ -184,6 +197,13 @@ void sn_loop()
     }
 
     if(snStartup) {
+        if(snTitle) {
+            if(anim_running())
+                return;
+            snTitle = false;
+            snStartup = sidMillisNonZero();
+            return;
+        }
         if(now - snStartup < 1000) {
             return;
         }
@@ -243,8 +263,8 @@ void sn_loop()
     // Make new apply
     if(newApple) {
         do {
-          apx = esp_random() % WIDTH;
-          apy = esp_random() % HEIGHT;
+          apx = sidRandom() % WIDTH;
+          apy = sidRandom() % HEIGHT;
         } while(appleHitsSnake());
     }
 
@@ -264,6 +284,11 @@ void sn_loop()
     updateDisplay();
 }
 
+void sn_getMemUse(memUse *m)
+{
+    m->staticBytes = sizeof(snake);
+}
+
 void sn_end()
 {
     if(!snActive)
@@ -0,0 +1,173 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Speed estimator
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#include "sid_speed.h"
+
+static float spd_fit(sidSpdEst *se, unsigned long now)
+{
+    long dt = (long)(now - se->t0);
+
+    if(dt > SPD_HORIZON) dt = SPD_HORIZON;
+
+    return se->base + se->slope * (float)dt;
+}
+
+static float spd_eval(sidSpdEst *se, unsigned long now)
+{
+    float v = spd_fit(se, now);
+    unsigned long ct = now - se->corrT;
+
+    if(se->corr != 0.0f && ct < SPD_CORR_TIME) {
+        v += se->corr * (float)(SPD_CORR_TIME - ct) / (float)SPD_CORR_TIME;
+    }
+
+    return v;
+}
+
+void spd_reset(sidSpdEst *se)
+{
+    memset(se, 0, sizeof(*se));
+}
+
+/*
+ * Add a sample; t is the time of arrival (sidMillis()).
+ * A negative speed means "no speed", and resets the
+ * estimator.
+ */
+void spd_sample(sidSpdEst *se, unsigned long t, int speed)
+{
+    float old = 0.0f, mt = 0.0f, mv = 0.0f, sxy = 0.0f, sxx = 0.0f;
+    unsigned long newest;
+    int n = 0, i;
+
+    if(speed < 0) {
+        spd_reset(se);
+        return;
+    }
+
+    if(se->cnt) {
+        old = spd_eval(se, t);
+    }
+
+    se->t[se->idx] = newest = t;
+    se->v[se->idx] = speed;
+    se->idx = (se->idx + 1) % SPD_SAMPLES;
+    if(se->cnt < SPD_SAMPLES) se->cnt++;
+
+    // Least squares over samples in window, times
+    // relative to newest
+    for(i = 0; i < se->cnt; i++) {
+        if(newest - se->t[i] > SPD_WINDOW) continue;
+        mt -= (float)(newest - se->t[i]);
+        mv += (float)se->v[i];
+        n++;
+    }
+    mt /= (float)n;
+    mv /= (float)n;
+    for(i = 0; i < se->cnt; i++) {
+        if(newest - se->t[i] > SPD_WINDOW) continue;
+        float dt = -(float)(newest - se->t[i]) - mt;
+        sxy += dt * ((float)se->v[i] - mv);
+        sxx += dt * dt;
+    }
+
+    se->t0 = newest;
+    se->slope = (sxx > 0.0f) ? sxy / sxx : 0.0f;
+    se->base = mv - se->slope * mt;
+
+    // Don't overshoot when accelerating to, or stopping at, the limits
+    if((speed >= SPD_MAX && se->slope > 0.0f) || (speed <= 0 && se->slope < 0.0f)) {
+        se->slope = 0.0f;
+        se->base = speed;
+    }
+
+    // Fade out the step the new fit would cause
+    se->corr = 0.0f;
+    if(se->cnt > 1) {
+        se->corr = old - spd_fit(se, t);
+        se->corrT = t;
+    }
+}
+
+// Estimated speed at "now"; -1 if there are no samples
+int spd_estimate(sidSpdEst *se, unsigned long now)
+{
+    float v;
+
+    if(!se->cnt)
+        return -1;
+
+    v = spd_eval(se, now);
+
+    if(v < 0.0f) return 0;
+    if(v > (float)SPD_MAX) return SPD_MAX;
+
+    return (int)(v + 0.5f);
+}
+
+// True if the estimate still changes over time
+bool spd_moving(sidSpdEst *se, unsigned long now)
+{
+    if(!se->cnt)
+        return false;
+
+    if(se->corr != 0.0f && now - se->corrT < SPD_CORR_TIME)
+        return true;
+
+    return (se->slope != 0.0f) && ((long)(now - se->t0) < SPD_HORIZON);
+}
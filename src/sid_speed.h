@@ -0,0 +1,93 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Speed estimator
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+#ifndef _SID_SPEED_H
+#define _SID_SPEED_H
+
+/*
+ * Speed estimator
+ *
+ * Speed from the TCD comes in steps, whenever a packet arrives.
+ * The estimator fits a line through the most recent samples 
+ * (time-stamped on arrival) and extrapolates it to the time of
+ * the display frame, so the bars follow acceleration between
+ * packets. When a new sample moves the line, the difference 
+ * is faded out over SPD_CORR_TIME instead of causing a jump.
+ */
+
+#define SPD_SAMPLES     4       // samples used for fit
+#define SPD_WINDOW      2000    // ms; older samples are not used
+#define SPD_HORIZON     1000    // ms; max extrapolation beyond last sample
+#define SPD_CORR_TIME   300     // ms; correction fade time
+#define SPD_MAX         88
+
+typedef struct {
+    int           cnt;                  // valid samples
+    int           idx;                  // next to write
+    unsigned long t[SPD_SAMPLES];       // sidMillis() at arrival
+    int16_t       v[SPD_SAMPLES];
+    // Fit: v = base + slope * (t - t0)
+    unsigned long t0;
+    float         base;
+    float         slope;                // per ms
+    // Correction on new sample
+    unsigned long corrT;
+    float         corr;
+} sidSpdEst;
+
+void spd_reset(sidSpdEst *se);
+void spd_sample(sidSpdEst *se, unsigned long t, int speed);
+int  spd_estimate(sidSpdEst *se, unsigned long now);
+bool spd_moving(sidSpdEst *se, unsigned long now);
+
+#endif
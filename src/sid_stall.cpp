@@ -0,0 +1,317 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Loop stall detector
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+#include "sid_global.h"
+
+#ifdef SID_HAVESTATS
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <esp_attr.h>
+
+#include "sid_stall.h"
+#include "sid_prof.h"
+#include "sid_task.h"
+
+/*
+ * Loop stall detector
+ *
+ * Each task calls stall_beat() once per pass of its loop. A periodic
+ * esp_timer (which runs in the high-priority esp_timer task) checks
+ * the heartbeats; if a task misses its deadline, a stall record is
+ * created with the profiled region (PROF_SCOPE) the task is in at
+ * that moment (only known with SID_HAVEPROF). The duration is 
+ * updated by the timer while the stall lasts and finalized by the 
+ * next heartbeat.
+ *
+ * Records are kept in RTC memory which survives a software reset
+ * (including a watchdog reset), so a stall that ends in a reboot
+ * can be inspected afterwards. Such records are flagged STALL_RESET.
+ *
+ * While the loop task is parked by the network task, its heartbeat
+ * is not checked.
+ */
+
+#define STALL_MAGIC 0x5ad57a11
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint16_t boots;
+    uint8_t  head;
+    uint8_t  count;
+    stallRec rec[STALL_RECS];
+} stallMemory;
+
+typedef struct {
+    volatile uint32_t beat;
+    volatile bool     active;
+    volatile bool     suspended;
+    volatile int8_t   region;
+    volatile int8_t   rec;        // index of open record, or -1
+} stallTask;
+
+static RTC_NOINIT_ATTR stallMemory stallMem;
+
+static stallTask stallTasks[TASK_NUM];
+
+static const uint32_t stallLimits[TASK_NUM] = {
+    STALL_LIMIT_LOOP, STALL_LIMIT_NET, STALL_LIMIT_BTTFN
+};
+
+static uint32_t pubSeq = 0;
+
+static esp_timer_handle_t stallTimer = NULL;
+
+static portMUX_TYPE stallMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Called with stallMux held
+static int newRecord(int task, int8_t region, uint32_t start, uint32_t dur)
+{
+    int idx = stallMem.head;
+    stallRec *r = &stallMem.rec[idx];
+
+    r->seq = ++stallMem.seq;
+    r->start = start;
+    r->dur = dur;
+    r->boot = stallMem.boots;
+    r->task = task;
+    r->region = region;
+    r->flags = STALL_OPEN;
+
+    stallMem.head = (idx + 1) % STALL_RECS;
+    if(stallMem.count < STALL_RECS) stallMem.count++;
+
+    return idx;
+}
+
+static void stallCheck(void *arg)
+{
+    uint32_t now = millis();
+
+    portENTER_CRITICAL(&stallMux);
+    for(int i = 0; i < TASK_NUM; i++) {
+        stallTask *t = &stallTasks[i];
+        uint32_t age;
+        
+        if(!t->active || t->suspended)
+            continue;
+
+        age = now - t->beat;
+        if(age > stallLimits[i]) {
+            if(t->rec < 0) {
+                t->rec = newRecord(i, t->region, t->beat, age);
+            } else {
+                stallMem.rec[t->rec].dur = age;
+            }
+        }
+    }
+    portEXIT_CRITICAL(&stallMux);
+}
+
+void stall_setup()
+{
+    const esp_timer_create_args_t targs = {
+        .callback = &stallCheck,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "stall"
+    };
+    
+    if(stallMem.magic != STALL_MAGIC || stallMem.head >= STALL_RECS || stallMem.count > STALL_RECS) {
+        memset(&stallMem, 0, sizeof(stallMem));
+        stallMem.magic = STALL_MAGIC;
+    }
+    
+    stallMem.boots++;
+    pubSeq = stallMem.seq;
+
+    // Close records of previous boot that were still open, and
+    // have those published which belong to the previous boot
+    for(int i = 0; i < stallMem.count; i++) {
+        stallRec *r = &stallMem.rec[i];
+        if(r->flags & STALL_OPEN) {
+            r->flags = (r->flags & ~STALL_OPEN) | STALL_RESET;
+        }
+        if(r->boot == (uint16_t)(stallMem.boots - 1) && r->seq <= pubSeq) {
+            pubSeq = r->seq - 1;
+        }
+    }
+
+    #ifdef SID_DBG
+    Serial.printf("stall_setup: Boot %d, %d records\n", stallMem.boots, stallMem.count);
+    #endif
+
+    for(int i = 0; i < TASK_NUM; i++) {
+        stallTasks[i].rec = -1;
+        stallTasks[i].region = STALL_REGION_NONE;
+    }
+
+    if(esp_timer_create(&targs, &stallTimer) == ESP_OK) {
+        esp_timer_start_periodic(stallTimer, STALL_CHECK_INT * 1000);
+    } else {
+        Serial.println("Failed to create stall timer");
+    }
+}
+
+// Called by task itself; first call activates the check
+void stall_beat(int task)
+{
+    stallTask *t = &stallTasks[task];
+    uint32_t now = millis();
+
+    if(t->rec >= 0) {
+        portENTER_CRITICAL(&stallMux);
+        if(t->rec >= 0) {
+            stallRec *r = &stallMem.rec[t->rec];
+            r->dur = now - r->start;
+            r->flags &= ~STALL_OPEN;
+            t->rec = -1;
+        }
+        portEXIT_CRITICAL(&stallMux);
+        #ifdef SID_DBG
+        Serial.printf("Stall: %s blocked %dms in %s\n", taskNames[task], 
+                now - t->beat, stall_regionName(t->region));
+        #endif
+    }
+
+    t->beat = now;
+    t->active = true;
+}
+
+void stall_suspend(int task, bool suspend)
+{
+    stall_beat(task);
+    stallTasks[task].suspended = suspend;
+}
+
+// Called by profScope; returns previous region of calling task
+int8_t stall_enter(int8_t region)
+{
+    int task = task_current();
+    int8_t prev;
+    
+    if(task < 0)
+        return STALL_REGION_NONE;
+
+    prev = stallTasks[task].region;
+    stallTasks[task].region = region;
+    
+    return prev;
+}
+
+void stall_leave(int8_t prev)
+{
+    int task = task_current();
+    
+    if(task >= 0) {
+        stallTasks[task].region = prev;
+    }
+}
+
+// Copy records, newest first; returns number of records
+int stall_getRecords(stallRec *recs, uint16_t *boot)
+{
+    int cnt;
+    
+    portENTER_CRITICAL(&stallMux);
+    cnt = stallMem.count;
+    for(int i = 0; i < cnt; i++) {
+        recs[i] = stallMem.rec[(stallMem.head + STALL_RECS - 1 - i) % STALL_RECS];
+    }
+    *boot = stallMem.boots;
+    portEXIT_CRITICAL(&stallMux);
+
+    return cnt;
+}
+
+// Oldest completed record not yet published; single consumer
+bool stall_getUnpublished(stallRec *rec)
+{
+    stallRec *r = NULL;
+
+    portENTER_CRITICAL(&stallMux);
+    for(int i = 0; i < stallMem.count; i++) {
+        stallRec *t = &stallMem.rec[i];
+        if(t->seq > pubSeq && (!r || t->seq < r->seq)) {
+            r = t;
+        }
+    }
+    if(r && !(r->flags & STALL_OPEN)) {
+        *rec = *r;
+        pubSeq = r->seq;
+    } else {
+        r = NULL;
+    }
+    portEXIT_CRITICAL(&stallMux);
+    
+    return (r != NULL);
+}
+
+// Record as JSON; returns length, or 0 if buffer too small
+int stall_getJSON(const stallRec *r, char *buf, int bufSize)
+{
+    int len = snprintf(buf, bufSize, 
+                  "{\"seq\":%u,\"boot\":%u,\"task\":\"%s\",\"region\":\"%s\",\"start\":%u,\"dur\":%u,\"reset\":%d}",
+                  (unsigned int)r->seq, r->boot, taskNames[r->task], stall_regionName(r->region),
+                  (unsigned int)r->start, (unsigned int)r->dur, (r->flags & STALL_RESET) ? 1 : 0);
+
+    return (len < 0 || len >= bufSize) ? 0 : len;
+}
+
+const char *stall_regionName(int8_t region)
+{
+    return (region >= 0 && region < PROF_NUM) ? profNames[region] : "-";
+}
+
+#endif  // SID_HAVESTATS
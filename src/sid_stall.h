@@ -0,0 +1,97 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Loop stall detector
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+#ifndef _SID_STALL_H
+#define _SID_STALL_H
+
+#ifdef SID_HAVESTATS
+
+#define STALL_RECS        8       // Number of records kept (RTC memory)
+#define STALL_CHECK_INT   100     // ms; heartbeat check interval
+#define STALL_LIMIT_LOOP  500     // ms; loop task heartbeat deadline
+#define STALL_LIMIT_NET   2000    // ms; network task heartbeat deadline
+#define STALL_LIMIT_BTTFN 2000    // ms; BTTFN receiver heartbeat deadline
+
+#define STALL_REGION_NONE -1
+
+// Record flags
+#define STALL_OPEN        0x01    // Stall still ongoing
+#define STALL_RESET       0x02    // Stall ended by reboot
+
+typedef struct {
+    uint32_t seq;       // Running number, continued over reboots
+    uint32_t start;     // ms uptime at last heartbeat
+    uint32_t dur;       // ms
+    uint16_t boot;      // Boot number
+    uint8_t  task;
+    int8_t   region;    // PROF_xxx, or STALL_REGION_NONE
+    uint8_t  flags;
+} stallRec;
+
+void stall_setup();
+
+void stall_beat(int task);
+void stall_suspend(int task, bool suspend);
+
+int8_t stall_enter(int8_t region);
+void   stall_leave(int8_t prev);
+
+int  stall_getRecords(stallRec *recs, uint16_t *boot);
+bool stall_getUnpublished(stallRec *rec);
+int  stall_getJSON(const stallRec *r, char *buf, int bufSize);
+
+const char *stall_regionName(int8_t region);
+
+#endif  // SID_HAVESTATS
+
+#endif
@@ -0,0 +1,224 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Task management
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#include "sid_task.h"
+#include "sid_sched.h"
+#include "sid_stall.h"
+
+/*
+ * Task bookkeeping
+ *
+ * CPU load: Each task reports the time it spent waiting through
+ * task_idle(); the rest of the window counts as busy. Each task
+ * only updates its own record.
+ *
+ * Parking: Display, file systems and most of main's state belong
+ * to the loop task. If the network task needs them (save settings
+ * and reboot, OTA update), it parks the loop task at a safe point
+ * (task_parkPoint(), called in main_loop() and mydelay()) and thus
+ * has exclusive access until it unparks it.
+ *
+ * Startup: The network task is started before main_setup() and 
+ * connects in the background; anything touching the file systems
+ * or the Config Portal waits for task_setupDone().
+ */
+
+typedef struct {
+    TaskHandle_t  handle;
+    int8_t        core;
+    unsigned long windowNow;
+    uint32_t      idleUs;
+    uint8_t       load;
+} taskRec;
+
+static taskRec tasks[TASK_NUM];
+
+const char *taskNames[TASK_NUM] = {
+    "Loop", "Network", "BTTFN"
+};
+
+static bool              parkReq = false;
+static SemaphoreHandle_t parkedSem = NULL;
+static SemaphoreHandle_t unparkSem = NULL;
+static SemaphoreHandle_t setupSem = NULL;
+
+// Must be called from the loop task
+void task_init()
+{
+    parkedSem = xSemaphoreCreateBinary();
+    unparkSem = xSemaphoreCreateBinary();
+    setupSem = xSemaphoreCreateBinary();
+    
+    task_register(TASK_LOOP, xTaskGetCurrentTaskHandle(), xPortGetCoreID());
+}
+
+void task_register(int id, TaskHandle_t handle, int core)
+{
+    tasks[id].handle = handle;
+    tasks[id].core = core;
+    tasks[id].windowNow = millis();
+    tasks[id].idleUs = 0;
+}
+
+// Called from loop task at end of setup()
+void task_setupDone()
+{
+    xSemaphoreGive(setupSem);
+}
+
+// Called from network task, once
+void task_waitSetupDone()
+{
+    xSemaphoreTake(setupSem, portMAX_DELAY);
+}
+
+// Returns id of calling task, or -1 if not one of ours
+int task_current()
+{
+    TaskHandle_t h = xTaskGetCurrentTaskHandle();
+
+    for(int i = 0; i < TASK_NUM; i++) {
+        if(tasks[i].handle == h) return i;
+    }
+
+    return -1;
+}
+
+// Called by task "id" itself
+void task_idle(int id, uint32_t us)
+{
+    taskRec *t = &tasks[id];
+    unsigned long now = millis();
+    unsigned long win;
+
+    t->idleUs += us;
+
+    win = now - t->windowNow;
+    if(win >= TASK_LOAD_WINDOW) {
+        uint32_t idleMs = t->idleUs / 1000;
+        t->load = (idleMs < win) ? ((win - idleMs) * 100) / win : 0;
+        t->idleUs = 0;
+        t->windowNow = now;
+    }
+}
+
+void task_getStats(int id, taskStat *st)
+{
+    taskRec *t = &tasks[id];
+
+    if(!t->handle) {
+        memset(st, 0, sizeof(*st));
+        st->core = -1;
+        return;
+    }
+    
+    st->stackFree = uxTaskGetStackHighWaterMark(t->handle);
+    st->load = t->load;
+    st->core = t->core;
+}
+
+// Called from network task. Returns true if loop task is
+// parked, false on timeout.
+bool task_parkLoop(unsigned long timeout)
+{
+    if(!parkedSem) 
+        return false;
+
+    __atomic_store_n(&parkReq, true, __ATOMIC_RELEASE);
+    sched_wake();
+    
+    if(xSemaphoreTake(parkedSem, pdMS_TO_TICKS(timeout)) != pdTRUE) {
+        // Withdraw request; if the loop task has taken it
+        // in the meantime, it is about to park.
+        if(__atomic_exchange_n(&parkReq, false, __ATOMIC_ACQ_REL)) {
+            #ifdef SID_DBG
+            Serial.println("task_parkLoop: Time-out");
+            #endif
+            return false;
+        }
+        xSemaphoreTake(parkedSem, portMAX_DELAY);
+    }
+
+    return true;
+}
+
+void task_unparkLoop()
+{
+    xSemaphoreGive(unparkSem);
+}
+
+// Called from loop task at safe points
+void task_parkPoint()
+{
+    if(!__atomic_load_n(&parkReq, __ATOMIC_ACQUIRE))
+        return;
+
+    if(!__atomic_exchange_n(&parkReq, false, __ATOMIC_ACQ_REL))
+        return;
+    
+    #ifdef SID_HAVESTATS
+    stall_suspend(TASK_LOOP, true);
+    #endif
+    
+    xSemaphoreGive(parkedSem);
+    xSemaphoreTake(unparkSem, portMAX_DELAY);
+
+    #ifdef SID_HAVESTATS
+    stall_suspend(TASK_LOOP, false);
+    #endif
+}
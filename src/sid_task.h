@@ -0,0 +1,111 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Task management
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef _SID_TASK_H
+#define _SID_TASK_H
+
+/*
+ * Tasks:
+ * Loop:    Arduino loop() task (core 1): main_loop(), display,
+ *          SA, games, IR, BTTFN.
+ * Network: (core 0): WiFi, Config Portal, MQTT, update check.
+ * BTTFN:   (core 0): BTTFN packet reception.
+ *
+ * Network to loop: Event queues (sid_event.h)
+ * BTTFN to loop:   Event queue, packet ring (sid_bttfn.h)
+ * Loop to network: wifi_request() (sid_wifi.h)
+ */
+ 
+enum {
+    TASK_LOOP = 0,
+    TASK_NET,
+    TASK_BTTFN,
+    TASK_NUM
+};
+
+#define TASK_NET_CORE     0
+#define TASK_NET_STACK    8192
+#define TASK_NET_PRIO     1
+
+#define TASK_BTTFN_CORE   0
+#define TASK_BTTFN_STACK  3072
+#define TASK_BTTFN_PRIO   2
+
+#define TASK_LOAD_WINDOW  10000   // ms; CPU load is averaged per window
+
+typedef struct {
+    uint32_t stackFree;       // bytes; minimum ever
+    uint8_t  load;            // percent, last window
+    int8_t   core;
+} taskStat;
+
+void task_init();
+void task_register(int id, TaskHandle_t handle, int core);
+
+void task_setupDone();
+void task_waitSetupDone();
+
+int  task_current();
+
+void task_idle(int id, uint32_t us);
+
+void task_getStats(int id, taskStat *st);
+
+bool task_parkLoop(unsigned long timeout);
+void task_unparkLoop();
+void task_parkPoint();
+
+extern const char *taskNames[TASK_NUM];
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Time base and random numbers
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#ifndef _SID_TIME_H
+#define _SID_TIME_H
+
+/*
+ * All timing in main_loop(), sequences, games, SA, the scheduler
+ * and the display goes through sidMillis() and sidDelay(), all
+ * randomness through sidRandom().
+ *
+ * Normally, these are millis() and delay(). With 
+ * SID_SIMCLOCK, time is a counter which only advances through 
+ * sidDelay() and sidAdvance() (the scheduler advances it instead 
+ * of sleeping), so that sequences run as fast as the CPU allows.
+ * 
+ * Hardware-related timing (button debounce, IR, network, power
+ * save, statistics) still uses real time.
+ *
+ * sidRandom() is a xorshift32 PRNG, seeded at boot through 
+ * sid_seedRandom() and once more by sid_reseedRandom() when 
+ * WiFi is up. It is much cheaper than reading the hardware 
+ * RNG, and with a fixed seed (SID_RNG_SEED), animations are 
+ * reproducible. Loop task only; not thread-safe.
+ */
+
+#ifdef SID_SIMCLOCK
+
+extern unsigned long sidSimMillis;
+
+static inline unsigned long sidMillis()         { return sidSimMillis; }
+static inline void sidDelay(unsigned long ms)   { sidSimMillis += ms; }
+static inline void sidAdvance(unsigned long ms) { sidSimMillis += ms; }
+
+#else
+
+static inline unsigned long sidMillis()         { return millis(); }
+static inline void sidDelay(unsigned long ms)   { delay(ms); }
+
+#endif
+
+static inline unsigned long sidMillisNonZero()
+{
+    unsigned long now = sidMillis();
+    if(!now) now--;
+    return now;
+}
+
+extern uint32_t sidRndState;
+
+void sid_seedRandom();
+void sid_reseedRandom();
+
+static inline uint32_t sidRandom()
+{
+    uint32_t x = sidRndState;
+    
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    
+    return (sidRndState = x);
+}
+
+#endif
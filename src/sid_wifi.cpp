@@ -66,6 +66,14 @@
 #include "sid_settings.h"
 #include "sid_wifi.h"
 #include "sid_main.h"
+#include "sid_prof.h"
+#include "sid_stall.h"
+#include "sid_mem.h"
+#include "sid_sched.h"
+#include "sid_event.h"
+#include "sid_bttfn.h"
+#include "sid_task.h"
+#include "sid_power.h"
 #ifdef SID_HAVEMQTT
 #include "mqtt.h"
 #endif
@@ -89,6 +97,7 @@ static const char tcdList[] = "<datalist id='tcda'><option value='TCD-AP%s'></op
 static const char tcdSSIDp[] = "<div style='margin:0 0 10px 0;padding:0;font-size:80%%'>SSID of currently connected TCD is <b>TCD-AP%s</b> (%s password)</div>";
 static const char tcdAPPW1[] = "no";
 static const char tcdAPPW2[] = "with";
+static const char tcdRTTp[] = "<div style='margin:0 0 10px 0;padding:0;font-size:80%%'>Round trip to TCD %u.%ums (min %u.%ums, jitter %u.%ums); time travel lead corrected by %u.%ums</div>";
 
 static const char *apChannelCustHTMLSrc[14] = {
     "'>WiFi channel",
@@ -107,6 +116,14 @@ static const char *apChannelCustHTMLSrc[14] = {
     ">11%s"
 };
 
+static const char *mirrorCustHTMLSrc[5] = {
+    "'>Idle pattern mirroring",
+    "smir",
+    ">Off%s1'",
+    ">Leader%s2'",
+    ">Follower%s"
+};
+
 #ifdef SID_HAVEMQTT
 static const char *mqttpCustHTMLSrc[4] = {
     "'>Protocol version",
@@ -129,6 +146,8 @@ static const char mqttMsgGenError[] = "Error";
 
 static const char *wmBuildTCDAPList(const char *dest, int op);
 static const char *wmBuildTCDSSID(const char *dest, int op);
+static const char *wmBuildTCDRTT(const char *dest, int op);
+static const char *wmBuildMirror(const char *dest, int op);
 static const char *wmBuildApChnl(const char *dest, int op);
 static const char *wmBuildBestApChnl(const char *dest, int op);
 
@@ -203,11 +222,13 @@ WiFiManagerParameter custom_sStrict("sStrict", "Adhere strictly to movie pattern
 WiFiManagerParameter custom_sTTANI("sTTANI", "Skip time tunnel animation", settings.skipTTAnim, "title='Check to skip the time tunnel animation'", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
 WiFiManagerParameter custom_SApeaks("sap", "Show peaks in Spectrum Analyzer", settings.SApeaks, "", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
 WiFiManagerParameter custom_SAmirror("sam", "Mirrored Spectrum Analyzer", settings.SAmirror, "", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
+WiFiManagerParameter custom_SAsoft("sas", "Soft bar tops in Spectrum Analyzer<br><span>Fast display refresh; not supported by all displays</span>", settings.SAsoft, "", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
 WiFiManagerParameter custom_PIRFB("pir", "Show positive IR feedback on display", settings.PIRFB, "", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
 WiFiManagerParameter custom_PIRCFB("pirc", "Show IR command entry feedback on display", settings.PIRCFB, "class='mb10'", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
 WiFiManagerParameter custom_ssDelay("ssDel", "Screen Saver timer (1-999[minutes]; 0=off)", settings.ssTimer, 3, "type='number' min='0' max='999'");
 
 WiFiManagerParameter custom_sectstart_nw("Wireless communication (BTTF-Network)", WFM_SECTS|WFM_HL);
+WiFiManagerParameter custom_tcdrtt(wmBuildTCDRTT);
 WiFiManagerParameter custom_tcdIP("tcdIP", "Hostname or IP address of TCD", settings.tcdIP, 31, "pattern='(^((25[0-5]|(2[0-4]|1\\d|[1-9]|)\\d)\\.?\\b){4}$)|([A-Za-z0-9\\-]+)' placeholder='Example: timecircuits' list='tcdh'");
 WiFiManagerParameter custom_uGPS("uGPS", "Adapt pattern to TCD-provided speed<br><span>Speed from TCD (GPS, rotary encoder, remote control), if available, will overrule idle pattern</span>", settings.useGPSS, "class='mb0'", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
 WiFiManagerParameter custom_uNM("uNM", "Follow TCD night-mode<br><span>If checked, the Screen Saver will activate when TCD is in night-mode.</span>", settings.useNM, "class='mb0'", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
@@ -215,6 +236,8 @@ WiFiManagerParameter custom_uFPO("uFPO", "Follow TCD fake power", settings.useFP
 WiFiManagerParameter custom_bttfnTT("bttfnTT", "'0' and button trigger BTTFN-wide TT<br><span>If checked, pressing '0' on the IR remote or pressing the Time Travel button triggers a BTTFN-wide TT</span>", settings.bttfnTT, "class='mb0'", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
 WiFiManagerParameter custom_ssClock("ssClk", "Show clock when Screen Saver is active", settings.ssClock, "", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
 WiFiManagerParameter custom_ssClockO("ssClkO", "Clock off in Night Mode", settings.ssClockOffNM, "class='mb0 mt5 ml20'", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
+WiFiManagerParameter custom_mirror(wmBuildMirror);
+WiFiManagerParameter custom_saBcast("saBc", "Send Spectrum Analyzer data to other props<br><span>If checked, the bar heights are sent over BTTFN while the Spectrum Analyzer is active</span>", settings.saBcast, "class='mt5'", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
 
 WiFiManagerParameter custom_TCDpresent("TCDpres", "TCD connected by wire", settings.TCDpresent, "title='Check if you have a Time Circuits Display connected via wire' class='mt5'", WFM_LABEL_AFTER|WFM_IS_CHKBOX|WFM_SECTS);
 WiFiManagerParameter custom_noETTOL("uEtNL", "TCD signals Time Travel without 5s lead", settings.noETTOLead, "class='mt5 ml20'", WFM_LABEL_AFTER|WFM_IS_CHKBOX);
@@ -299,6 +322,7 @@ unsigned long origWiFiOffDelay = 0;
 #ifdef SID_HAVEMQTT
 #define       MQTT_SHORT_INT  (30*1000)
 #define       MQTT_LONG_INT   (5*60*1000)
+#define       MQTT_MEM_INT    (60*1000)     // memory telemetry interval
 static const char    emptyStr[1] = { 0 };
 static bool          useMQTT = false;
 static char          *mqttUser = (char *)emptyStr;
@@ -315,26 +339,46 @@ static bool          mqttPingDone = false;
 static unsigned long mqttPingNow = 0;
 static unsigned long mqttPingInt = MQTT_SHORT_INT;
 static uint16_t      mqttPingsExpired = 0;
-char                 mqttMsg[10] = { 0 };
+static unsigned long mqttMemNow = 0;
+#ifdef SID_HAVESTATS
+static bool          mqttBootPublished = false;
+#endif
 #endif
-uint32_t             mqttDisp = 0;
 
 static unsigned int wmLenBuf = 0;
 
+#define NET_MAX_SLEEP     10      // ms; max time network task sleeps
+#define NET_REQ_QUEUE_LEN 8
+#define NET_PARK_TIMEOUT  5000    // ms; max wait for loop task to park
+#define NET_PARK_RETRIES  3       // park attempts before OTA update
+static TaskHandle_t  netTaskHandle = NULL;
+static bool          otaLoopParked = false;
+static QueueHandle_t netReqQueue = NULL;
+
 extern bool doPeaks;
 extern bool doMirror;
+extern bool doSoft;
 
 static void wifiConnect(bool deferConfigPortal = false);
 static void wifiOff(bool force);
 
 static void checkForUpdate();
 
+static void netTask(void *parm);
+static void wifiConnectSetup();
+static void wifiFinishSetup();
+static void handleRequest(uint8_t req);
+
 static void saveParamsCallback(int);
 static void saveWiFiCallback(const char *ssid, const char *pass, const char *bssid);
 static void preUpdateCallback();
 static void postUpdateCallback(bool);
 static bool preWiFiScanCallback();
 static void setCMCallback(bool enable);
+#ifdef SID_HAVESTATS
+static void webServerCallback();
+static void handleProfPage();
+#endif
 
 static void updateConfigPortalValues();
 
@@ -348,6 +392,7 @@ static void mystrcpy(char *sv, WiFiManagerParameter *el);
 static void mystrcpyWiFiDelay(char *sv, WiFiManagerParameter *el);
 static void evalCB(char *sv, WiFiManagerParameter *el);
 static void setCBVal(WiFiManagerParameter *el, char *sv);
+static void setBoolAndUpdCB(bool myBool, char *sett, WiFiManagerParameter *wmParm);
 
 #ifdef SID_HAVEMQTT
 static void strcpyutf8(char *dst, const char *src, unsigned int len);
@@ -356,6 +401,14 @@ static bool mqttReconnect(bool force = false);
 static void mqttLooper();
 static void mqttCallback(char *topic, byte *payload, unsigned int length);
 static void mqttSubscribe();
+static void mqttPublishMem();
+#ifdef SID_HAVEPROF
+static void mqttPublishProf();
+#endif
+#ifdef SID_HAVESTATS
+static void mqttPublishStall();
+static void mqttPublishBoot();
+#endif
 #endif
 
 /*
@@ -402,18 +455,22 @@ void wifi_setup()
       &custom_sTTANI,
       &custom_SApeaks,
       &custom_SAmirror,
+      &custom_SAsoft,
       &custom_PIRFB,
       &custom_PIRCFB,
       &custom_ssDelay,
       
-      &custom_sectstart_nw,   // 8
+      &custom_sectstart_nw,   // 11
       &custom_tcdIP,
+      &custom_tcdrtt,
       &custom_uGPS,
       &custom_uNM,
       &custom_uFPO,
       &custom_bttfnTT,
       &custom_ssClock,
       &custom_ssClockO,
+      &custom_saBcast,
+      &custom_mirror,
   
       &custom_TCDpresent,     // 2
       &custom_noETTOL,
@@ -473,6 +530,10 @@ void wifi_setup()
     wm.setCCarMode(carMode);
     wm.setCCarModeCallback(setCMCallback);
 
+    #ifdef SID_HAVESTATS
+    wm.setWebServerCallback(webServerCallback);
+    #endif
+
     temp = atoi(settings.apChnl);
     if(temp < 0) temp = 0;
     else if(temp > 11) temp = 11;
@@ -529,9 +590,6 @@ void wifi_setup()
             if(wm.getConnectRetries() < 2) {
                 wm.setConnectRetries(2);
             }
-            // Delay to give the TCD some time
-            // (differs accross the props)
-            delay(1100);
             #ifdef SID_HAVEMQTT
             useMQTT = false;
             #endif
@@ -561,17 +619,34 @@ void wifi_setup()
         }
     }
 
+    // Uses stored version info until connected
+    checkForUpdate();
+}
+
+/*
+ * Second part of WiFi setup: Connect, start MQTT
+ * Runs in network task, in parallel to main_setup(). Must
+ * not touch the file systems.
+ */
+static void wifiConnectSetup()
+{
+    if(connectedToTCDAP) {
+        // Delay to give the TCD some time
+        // (differs accross the props)
+        delay(1100);
+    }
+    
     // Connect, but defer starting the CP
     wifiConnect(true);
 
+    PROF_BOOT(BOOT_NET);
+
     #ifdef SID_MDNS
     if(MDNS.begin(settings.hostName)) {
         MDNS.addService("http", "tcp", 80);
     }
     #endif
 
-    checkForUpdate();
-
 #ifdef SID_HAVEMQTT
     if((!settings.mqttServer[0]) || // No server -> no MQTT
        (wifiInAPMode))              // WiFi in AP mode -> no MQTT
@@ -660,13 +735,44 @@ void wifi_setup()
 
     }
 #endif
+}
 
-    // Start the Config Portal
+/*
+ * Third part of WiFi setup: Update check (writes settings),
+ * Config Portal. Runs after setup() finished.
+ */
+static void wifiFinishSetup()
+{
     if(WiFi.status() == WL_CONNECTED) {
+        checkForUpdate();
         wifiStartCP();
     }
 
-    wifiSetupDone = true;
+    __atomic_store_n(&wifiSetupDone, true, __ATOMIC_RELEASE);
+}
+
+// For loop task: Network setup (including BTTFN
+// prerequisites) complete
+bool wifi_isSetupDone()
+{
+    return __atomic_load_n(&wifiSetupDone, __ATOMIC_ACQUIRE);
+}
+
+// WiFi configured to connect to a network (might fail)
+bool wifi_staConfigured()
+{
+    return wifiHaveSTAConf;
+}
+
+// WiFiManager, MQTT client; network task stack
+void wifi_getMemUse(memUse *m)
+{
+    m->staticBytes = sizeof(wm);
+    #ifdef SID_HAVEMQTT
+    m->staticBytes += sizeof(mqttWClient) + sizeof(mqttClient);
+    if(useMQTT) m->heapBytes += MQTT_MAX_PACKET_SIZE;
+    #endif
+    if(netTaskHandle) m->heapBytes += TASK_NET_STACK;
 }
 
 /*
@@ -676,10 +782,17 @@ void wifi_setup()
 void wifi_loop()
 {
     char oldCfgOnSD = 0;
+    bool parked = false;
 
     if(!wifiSetupDone)
         return;
 
+    // Once the network task runs, it is the only caller
+    if(netTaskHandle && (xTaskGetCurrentTaskHandle() != netTaskHandle))
+        return;
+
+    PROF_SCOPE(PROF_WIFI);
+
 #ifdef SID_HAVEMQTT
     if(useMQTT) {
         if(mqttClient.state() != MQTT_CONNECTING) {
@@ -708,7 +821,36 @@ void wifi_loop()
                 mqttOldState = true;
             }
         }
-        mqttClient.loop();
+        {
+            PROF_SCOPE(PROF_MQTT);
+            mqttClient.loop();
+        }
+    }
+#endif
+
+#ifdef SID_HAVEPROF
+    if(prof_loop()) {
+        #ifdef SID_HAVEMQTT
+        mqttPublishProf();
+        #endif
+    }
+#endif
+
+#ifdef SID_HAVESTATS
+    #ifdef SID_HAVEMQTT
+    mqttPublishStall();
+    if(!mqttBootPublished && mqttState()) {
+        PROF_BOOT(BOOT_MQTT);
+        mqttPublishBoot();
+        mqttBootPublished = true;
+    }
+    #endif
+#endif
+
+#ifdef SID_HAVEMQTT
+    if(millis() - mqttMemNow >= MQTT_MEM_INT) {
+        mqttMemNow = millis();
+        mqttPublishMem();
     }
 #endif
 
@@ -718,7 +860,14 @@ void wifi_loop()
         }
     }
 
-    if(wifiLoopSaveAction & WLA_SET_CM) {
+    // Settings are written, and the ESP rebooted, with
+    // the loop task parked. If it fails to park in time,
+    // the action flags stay set and we retry next pass.
+    if(wifiLoopSaveAction & (WLA_SET_CM|WLA_SET)) {
+        parked = task_parkLoop(NET_PARK_TIMEOUT);
+    }
+
+    if(parked && (wifiLoopSaveAction & WLA_SET_CM)) {
         bool ocm = carMode;
         carMode = !!(wifiLoopSaveAction & WLA_SET_CM_ON);
         if(!*settings.cm_ssid) carMode = false;
@@ -733,7 +882,11 @@ void wifi_loop()
         wifiLoopSaveAction &= ~(WLA_SET_CM|WLA_SET_CM_ON);
     }
 
-    if(wifiLoopSaveAction & WLA_SET) {
+    if(parked && !(wifiLoopSaveAction & WLA_SET)) {
+        task_unparkLoop();
+    }
+
+    if(parked && (wifiLoopSaveAction & WLA_SET)) {
 
         int temp;
 
@@ -804,6 +957,8 @@ void wifi_loop()
             doPeaks = evalBool(settings.SApeaks);
             evalCB(settings.SAmirror, &custom_SAmirror);
             doMirror = evalBool(settings.SAmirror);
+            evalCB(settings.SAsoft, &custom_SAsoft);
+            doSoft = evalBool(settings.SAsoft);
             evalCB(settings.PIRFB, &custom_PIRFB);
             irShowPosFBDisplay = evalBool(settings.PIRFB);
             evalCB(settings.PIRCFB, &custom_PIRCFB);
@@ -824,6 +979,7 @@ void wifi_loop()
             evalCB(settings.bttfnTT, &custom_bttfnTT);
             evalCB(settings.ssClock, &custom_ssClock);
             evalCB(settings.ssClockOffNM, &custom_ssClockO);
+            evalCB(settings.saBcast, &custom_saBcast);
 
             evalCB(settings.TCDpresent, &custom_TCDpresent);
             evalCB(settings.noETTOLead, &custom_noETTOL);
@@ -909,6 +1065,108 @@ void wifi_loop()
 
 }
 
+/*
+ * Network task
+ *
+ * Runs wifi_loop() on core 0, so that a slow MQTT server, DNS
+ * lookups or Config Portal page building do not hold up the
+ * display. Requests from the loop task arrive through 
+ * wifi_request().
+ * The task is started before main_setup() and connects in
+ * the background, so the startup sequence is not delayed by
+ * WiFi association.
+ */
+void wifi_startTask()
+{
+    netReqQueue = xQueueCreate(NET_REQ_QUEUE_LEN, sizeof(uint8_t));
+    
+    if(!netReqQueue || 
+       xTaskCreatePinnedToCore(netTask, "Network", TASK_NET_STACK, NULL, 
+                               TASK_NET_PRIO, &netTaskHandle, TASK_NET_CORE) != pdPASS) {
+        // Keep running wifi_loop() from the loop task,
+        // connect in the foreground
+        netTaskHandle = NULL;
+        Serial.println("Failed to start network task");
+        wifiConnectSetup();
+        wifiFinishSetup();
+    }
+}
+
+static void netTask(void *parm)
+{
+    uint8_t req;
+    unsigned long waitNow;
+    
+    task_register(TASK_NET, xTaskGetCurrentTaskHandle(), xPortGetCoreID());
+
+    wifiConnectSetup();
+    task_waitSetupDone();
+    wifiFinishSetup();
+    
+    for(;;) {
+        #ifdef SID_HAVESTATS
+        stall_beat(TASK_NET);
+        #endif
+        
+        wifi_loop();
+        
+        waitNow = micros();
+        if(xQueueReceive(netReqQueue, &req, pdMS_TO_TICKS(NET_MAX_SLEEP)) == pdTRUE) {
+            task_idle(TASK_NET, micros() - waitNow);
+            do {
+                handleRequest(req);
+            } while(xQueueReceive(netReqQueue, &req, 0) == pdTRUE);
+        } else {
+            task_idle(TASK_NET, micros() - waitNow);
+        }
+    }
+}
+
+// Called from loop task; executed in network task
+void wifi_request(uint8_t req)
+{
+    if(!netTaskHandle) {
+        handleRequest(req);
+        return;
+    }
+
+    if(xQueueSend(netReqQueue, &req, 0) != pdTRUE) {
+        #ifdef SID_DBG
+        Serial.printf("wifi_request: Queue full, request %d dropped\n", req);
+        #endif
+    }
+}
+
+static void handleRequest(uint8_t req)
+{
+    switch(req) {
+    case NETREQ_WIFION:
+        // Enable WiFi / even if in AP mode / with CP
+        wifiOn(0, true, false);
+        break;
+    case NETREQ_CP_STRICT:
+        setBoolAndUpdCB(strictMode, settings.strictMode, &custom_sStrict);
+        break;
+    case NETREQ_CP_SA:
+        setBoolAndUpdCB(doPeaks, settings.SApeaks, &custom_SApeaks);
+        setBoolAndUpdCB(doMirror, settings.SAmirror, &custom_SAmirror);
+        setBoolAndUpdCB(doSoft, settings.SAsoft, &custom_SAsoft);
+        break;
+    case NETREQ_CP_IRFB:
+        setBoolAndUpdCB(irShowPosFBDisplay, settings.PIRFB, &custom_PIRFB);
+        setBoolAndUpdCB(irShowCmdFBDisplay, settings.PIRCFB, &custom_PIRCFB);
+        break;
+    case NETREQ_PS_ON:
+    case NETREQ_PS_OFF:
+        // Modem sleep; only relevant in STA mode. wifiConnect()
+        // disables it again upon re-connect.
+        if(!wifiInAPMode && !wifiIsOff) {
+            WiFi.setSleep(req == NETREQ_PS_ON);
+        }
+        break;
+    }
+}
+
 static void wifiConnect(bool deferConfigPortal)
 {
     char realAPName[16];
@@ -1143,24 +1401,6 @@ void wifiOn(unsigned long newDelay, bool alsoInAPMode, bool deferCP)
     }
 }
 
-// Check if a longer interruption due to a re-connect is to
-// be expected when calling wifiOn(true, xxx).
-bool wifiOnWillBlock()
-{
-    if(wifiInAPMode) {  // We are in AP mode
-        if(!wifiAPIsOff) {
-            if(!wifiHaveSTAConf) {
-                return false;
-            }
-        }
-    } else {            // We are in STA mode
-        if(!wifiIsOff && (WiFi.status() == WL_CONNECTED)) 
-            return false;
-    }
-
-    return true;
-}
-
 void wifiStartCP()
 {
     if(wifiInAPMode || wifiIsOff)
@@ -1174,6 +1414,8 @@ static void checkForUpdate()
     int cver = 0, crev = 0, uver = 0, urev = 0;
     bool haveCVer = false;
 
+    PROF_SCOPE(PROF_UPDCHK);
+
     *newversion = 0;
 
     lastUpdateCheck = millis();
@@ -1188,7 +1430,8 @@ static void checkForUpdate()
         if(WiFi.hostByName(WEBHOME "v.out-a-ti.me", remote_addr)) {
             if(remote_addr[0] + remote_addr[1] == remote_addr[3]) {
                 uver = remote_addr[0]; urev = remote_addr[1];
-                if(uver) saveUpdVers(uver, urev);
+                // Saved by the loop task, see handleEvents()
+                if(uver) evt_postUpdVers(EVQ_NET, uver, urev);
             }
         }
         lastUpdateLiveCheck = millisNonZero();
@@ -1322,6 +1565,7 @@ static void saveParamsCallback(int paramspage)
 
     switch(paramspage) {
     case 1:
+        getServerParam("smir", settings.sidMirror, 1, 0, 2, DEF_SID_MIRROR);
         break;
     case 2:
         #ifdef SID_HAVEMQTT
@@ -1331,12 +1575,27 @@ static void saveParamsCallback(int paramspage)
     }
 }
 
+// Park loop task for OTA update; it stays parked until reboot.
+static bool otaParkLoop()
+{
+    for(int i = 0; i < NET_PARK_RETRIES && !otaLoopParked; i++) {
+        otaLoopParked = task_parkLoop(NET_PARK_TIMEOUT);
+    }
+
+    return otaLoopParked;
+}
+
 // This is called before a firmware updated is initiated.
 static void preUpdateCallback()
 {
     wifiAPOffDelay = 0;
     origWiFiOffDelay = 0;
 
+    // The update only writes the OTA partition; files and
+    // display are left alone unless the loop task is parked.
+    if(!otaParkLoop())
+        return;
+
     flushDelayedSave();
 
     showWaitSequence(true);
@@ -1348,7 +1607,9 @@ static void preUpdateCallback()
 static void postUpdateCallback(bool res)
 {
     Serial.flush();
-    prepareReboot();
+    if(otaParkLoop()) {
+        prepareReboot();
+    }
 
     // WM does not reboot on OTA update errors.
     // However, don't bother for that really
@@ -1379,6 +1640,248 @@ static void setCMCallback(bool enable)
     else       wifiLoopSaveAction &= ~WLA_SET_CM_ON;
 }
 
+#ifdef SID_HAVESTATS
+static void webServerCallback()
+{
+    wm.server->on("/prof", HTTP_GET, handleProfPage);
+}
+
+// Page output: Collected in a small buffer on the stack and sent 
+// in chunks, so no large contiguous heap block is needed
+typedef struct {
+    char buf[512];
+    int  len;
+} pageBuf;
+
+static void pageFlush(pageBuf *pb)
+{
+    if(pb->len) {
+        wm.server->sendContent(pb->buf, pb->len);
+        pb->len = 0;
+    }
+}
+
+static void pageAdd(pageBuf *pb, const char *s)
+{
+    int l = strlen(s);
+
+    if(pb->len + l > (int)sizeof(pb->buf)) {
+        pageFlush(pb);
+        if(l > (int)sizeof(pb->buf)) {
+            wm.server->sendContent(s, l);
+            return;
+        }
+    }
+    memcpy(pb->buf + pb->len, s, l);
+    pb->len += l;
+}
+
+// Status page: Loop profiler statistics of last window (if 
+// enabled), scheduler jitter and event queue statistics since boot,
+// task stack and load, power save, stall records, boot phases,
+// memory
+static void handleProfPage()
+{
+    uint32_t jit[SCHED_JIT_BUCKETS];
+    char buf[128];
+    pageBuf pb;
+
+    pb.len = 0;
+
+    wm.server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+    wm.server->send(200, "text/html", "");
+
+    pageAdd(&pb, "<!DOCTYPE html><html><head><meta name='viewport' content='width=device-width,initial-scale=1'>"
+                 "<title>SID Status</title><style>body{font-family:sans-serif;font-size:0.9em}"
+                 "table{border-collapse:collapse}td,th{border:1px solid #aaa;padding:2px 5px;text-align:right}"
+                 "</style></head><body>");
+    
+    #ifdef SID_HAVEPROF
+    const profStat *st = prof_getStats();
+
+    snprintf(buf, sizeof(buf), "<h3>Loop profiler</h3><p>Last %d seconds; times in &micro;s</p><table><tr><th></th><th>calls</th><th>avg</th><th>max</th>", PROF_WINDOW / 1000);
+    pageAdd(&pb, buf);
+    for(int j = 0; j < PROF_BUCKETS; j++) {
+        if(j < PROF_BUCKETS - 1) snprintf(buf, sizeof(buf), "<th>&lt;%u</th>", (unsigned int)profLimits[j]);
+        else                     snprintf(buf, sizeof(buf), "<th>&ge;%u</th>", (unsigned int)profLimits[j-1]);
+        pageAdd(&pb, buf);
+    }
+    pageAdd(&pb, "</tr>");
+    
+    for(int i = 0; i < PROF_NUM; i++) {
+        const profStat *p = &st[i];
+        snprintf(buf, sizeof(buf), "<tr><td>%s</td><td>%u</td><td>%u</td><td>%u</td>", profNames[i],
+                (unsigned int)p->calls, (unsigned int)(p->calls ? p->total / p->calls : 0), (unsigned int)p->max);
+        pageAdd(&pb, buf);
+        for(int j = 0; j < PROF_BUCKETS; j++) {
+            snprintf(buf, sizeof(buf), "<td>%u</td>", (unsigned int)p->hist[j]);
+            pageAdd(&pb, buf);
+        }
+        pageAdd(&pb, "</tr>");
+    }
+    pageAdd(&pb, "</table>");
+    #endif
+    
+    pageAdd(&pb, "<h3>Scheduler jitter</h3><table><tr>");
+    sched_getJitter(jit);
+    for(int j = 0; j < SCHED_JIT_BUCKETS; j++) {
+        if(j < SCHED_JIT_BUCKETS - 1) snprintf(buf, sizeof(buf), "<th>&lt;%dms</th>", schedJitLimits[j]);
+        else                          snprintf(buf, sizeof(buf), "<th>&ge;%dms</th>", schedJitLimits[j-1]);
+        pageAdd(&pb, buf);
+    }
+    pageAdd(&pb, "</tr><tr>");
+    for(int j = 0; j < SCHED_JIT_BUCKETS; j++) {
+        snprintf(buf, sizeof(buf), "<td>%u</td>", (unsigned int)jit[j]);
+        pageAdd(&pb, buf);
+    }
+    pageAdd(&pb, "</tr></table><h3>Event queues</h3><p>Latency in &micro;s</p><table><tr><th></th><th>posted</th><th>dropped</th><th>handled</th><th>avg</th><th>max</th>");
+    for(int j = 0; j < EVT_LAT_BUCKETS; j++) {
+        if(j < EVT_LAT_BUCKETS - 1) snprintf(buf, sizeof(buf), "<th>&lt;%u</th>", (unsigned int)evtLatLimits[j]);
+        else                        snprintf(buf, sizeof(buf), "<th>&ge;%u</th>", (unsigned int)evtLatLimits[j-1]);
+        pageAdd(&pb, buf);
+    }
+    pageAdd(&pb, "</tr>");
+    for(int i = 0; i < EVQ_NUM; i++) {
+        evtStats es;
+        evt_getStats(i, &es);
+        snprintf(buf, sizeof(buf), "<tr><td>%s</td><td>%u</td><td>%u</td><td>%u</td><td>%u</td><td>%u</td>", evtQueueNames[i],
+                (unsigned int)es.posted, (unsigned int)es.dropped, (unsigned int)es.handled,
+                (unsigned int)(es.handled ? es.latTotal / es.handled : 0), (unsigned int)es.latMax);
+        pageAdd(&pb, buf);
+        for(int j = 0; j < EVT_LAT_BUCKETS; j++) {
+            snprintf(buf, sizeof(buf), "<td>%u</td>", (unsigned int)es.hist[j]);
+            pageAdd(&pb, buf);
+        }
+        pageAdd(&pb, "</tr>");
+    }
+    
+    {
+        bttfnRxStats rs;
+        bttfn_getRxStats(&rs);
+        pageAdd(&pb, "</table><h3>BTTFN receiver</h3><p>Arrival to handling in &micro;s; notifications passed on as events are listed under BTTFN above</p>"
+                     "<table><tr><th>received</th><th>invalid</th><th>dropped</th><th>events</th><th>handled</th><th>avg</th><th>max</th>");
+        for(int j = 0; j < EVT_LAT_BUCKETS; j++) {
+            if(j < EVT_LAT_BUCKETS - 1) snprintf(buf, sizeof(buf), "<th>&lt;%u</th>", (unsigned int)evtLatLimits[j]);
+            else                        snprintf(buf, sizeof(buf), "<th>&ge;%u</th>", (unsigned int)evtLatLimits[j-1]);
+            pageAdd(&pb, buf);
+        }
+        snprintf(buf, sizeof(buf), "</tr><tr><td>%u</td><td>%u</td><td>%u</td><td>%u</td>",
+                (unsigned int)rs.received, (unsigned int)rs.invalid, (unsigned int)rs.dropped, (unsigned int)rs.posted);
+        pageAdd(&pb, buf);
+        snprintf(buf, sizeof(buf), "<td>%u</td><td>%u</td><td>%u</td>", (unsigned int)rs.handled,
+                (unsigned int)(rs.handled ? rs.latTotal / rs.handled : 0), (unsigned int)rs.latMax);
+        pageAdd(&pb, buf);
+        for(int j = 0; j < EVT_LAT_BUCKETS; j++) {
+            snprintf(buf, sizeof(buf), "<td>%u</td>", (unsigned int)rs.hist[j]);
+            pageAdd(&pb, buf);
+        }
+        pageAdd(&pb, "</tr></table><p></p><table><tr><th>out of sequence</th><th>missing</th><th>handling avg/max</th><th>TT</th><th>TT start last/max</th></tr>");
+        snprintf(buf, sizeof(buf), "<tr><td>%u</td><td>%u</td><td>%u/%u</td>",
+                (unsigned int)rs.seqRejected, (unsigned int)rs.seqGaps,
+                (unsigned int)(rs.handled ? rs.procTotal / rs.handled : 0), (unsigned int)rs.procMax);
+        pageAdd(&pb, buf);
+        snprintf(buf, sizeof(buf), "<td>%u</td><td>%u/%u</td></tr>", (unsigned int)rs.ttCount,
+                (unsigned int)rs.ttLatLast, (unsigned int)rs.ttLatMax);
+        pageAdd(&pb, buf);
+        pageAdd(&pb, "</table><p></p><table><tr><th>sent</th><th>send errors</th><th>queue max/full</th><th>received/min</th><th>sent/min</th><th>poll interval (ms)</th><th>SA frames sent/failed</th><th>mirror frames/missed</th></tr>");
+        snprintf(buf, sizeof(buf), "<tr><td>%u</td><td>%u</td><td>%u/%u</td><td>%u</td><td>%u</td>",
+                (unsigned int)rs.sent, (unsigned int)rs.txErrors, (unsigned int)rs.txQueueMax,
+                (unsigned int)rs.txDropped, rs.rxPerMin, rs.txPerMin);
+        pageAdd(&pb, buf);
+        if(rs.pollInt) {
+            snprintf(buf, sizeof(buf), "<td>%u</td>", rs.pollInt);
+            pageAdd(&pb, buf);
+        } else {
+            pageAdd(&pb, "<td>push</td>");
+        }
+        snprintf(buf, sizeof(buf), "<td>%u/%u</td><td>%u/%u</td></tr>", (unsigned int)rs.saSent, (unsigned int)rs.saErrors,
+                (unsigned int)rs.mirFrames, (unsigned int)rs.mirGaps);
+        pageAdd(&pb, buf);
+    }
+    
+    pageAdd(&pb, "</table><h3>Tasks</h3><table><tr><th></th><th>core</th><th>stack free</th><th>load %</th></tr>");
+    for(int i = 0; i < TASK_NUM; i++) {
+        taskStat ts;
+        task_getStats(i, &ts);
+        snprintf(buf, sizeof(buf), "<tr><td>%s</td><td>%d</td><td>%u</td><td>%u</td></tr>", taskNames[i],
+                ts.core, (unsigned int)ts.stackFree, ts.load);
+        pageAdd(&pb, buf);
+    }
+
+    {
+        powerStat ps;
+        power_getStats(&ps);
+        snprintf(buf, sizeof(buf), "</table><h3>Power save</h3><table><tr><td>active</td><td>%s%s</td></tr>",
+                ps.active ? "yes" : "no", ps.lightSleep ? " (light sleep)" : "");
+        pageAdd(&pb, buf);
+        snprintf(buf, sizeof(buf), "<tr><td>entered</td><td>%u</td></tr><tr><td>total time (s)</td><td>%u</td></tr>",
+                (unsigned int)ps.enterCnt, (unsigned int)ps.activeSecs);
+        pageAdd(&pb, buf);
+        snprintf(buf, sizeof(buf), "<tr><td>est. current (mA, w/o display)</td><td>%u</td></tr>", ps.estCurrent);
+        pageAdd(&pb, buf);
+        snprintf(buf, sizeof(buf), "<tr><td>wake-ups</td><td>%u</td></tr><tr><td>wake-up latency avg/max (&micro;s)</td><td>%u/%u</td></tr>",
+                (unsigned int)ps.wakeCnt, (unsigned int)ps.wakeLatAvg, (unsigned int)ps.wakeLatMax);
+        pageAdd(&pb, buf);
+    }
+    {
+        stallRec recs[STALL_RECS];
+        uint16_t boot;
+        int cnt = stall_getRecords(recs, &boot);
+        snprintf(buf, sizeof(buf), "</table><h3>Stalls</h3><p>Boot %u; limits loop %dms, network %dms, BTTFN %dms</p>",
+                boot, STALL_LIMIT_LOOP, STALL_LIMIT_NET, STALL_LIMIT_BTTFN);
+        pageAdd(&pb, buf);
+        pageAdd(&pb, "<table><tr><th>#</th><th>boot</th><th>task</th><th>region</th><th>at (s)</th><th>ms</th><th></th></tr>");
+        for(int i = 0; i < cnt; i++) {
+            stallRec *r = &recs[i];
+            snprintf(buf, sizeof(buf), "<tr><td>%u</td><td>%u</td><td>%s</td><td>%s</td>",
+                    (unsigned int)r->seq, r->boot, taskNames[r->task], stall_regionName(r->region));
+            pageAdd(&pb, buf);
+            snprintf(buf, sizeof(buf), "<td>%u</td><td>%u</td><td>%s</td></tr>",
+                    (unsigned int)(r->start / 1000), (unsigned int)r->dur,
+                    (r->flags & STALL_OPEN) ? "ongoing" : ((r->flags & STALL_RESET) ? "reset" : ""));
+            pageAdd(&pb, buf);
+        }
+    }
+    pageAdd(&pb, "</table><h3>Boot</h3><p>ms since power-up</p><table><tr>");
+    for(int i = 0; i < BOOT_NUM; i++) {
+        snprintf(buf, sizeof(buf), "<th>%s</th>", profBootNames[i]);
+        pageAdd(&pb, buf);
+    }
+    pageAdd(&pb, "</tr><tr>");
+    for(int i = 0; i < BOOT_NUM; i++) {
+        uint32_t t = prof_bootTime(i);
+        if(t) snprintf(buf, sizeof(buf), "<td>%u</td>", (unsigned int)t);
+        else  snprintf(buf, sizeof(buf), "<td>-</td>");
+        pageAdd(&pb, buf);
+    }
+    {
+        memStat ms;
+        mem_getStats(&ms);
+        snprintf(buf, sizeof(buf), "</tr></table><h3>Memory</h3><table><tr><td>free heap</td><td>%u</td></tr>",
+                (unsigned int)ms.freeHeap);
+        pageAdd(&pb, buf);
+        snprintf(buf, sizeof(buf), "<tr><td>largest free block</td><td>%u</td></tr><tr><td>min. free heap</td><td>%u</td></tr>",
+                (unsigned int)ms.largestBlock, (unsigned int)ms.minFreeHeap);
+        pageAdd(&pb, buf);
+        snprintf(buf, sizeof(buf), "<tr><td>heap pressure</td><td>%u%s</td></tr><tr><td>failed allocs</td><td>%u</td></tr>",
+                (unsigned int)ms.pressureCnt, ms.pressure ? " (now)" : "", (unsigned int)ms.allocFails);
+        pageAdd(&pb, buf);
+        pageAdd(&pb, "</table><p>Footprint in bytes</p><table><tr><th></th><th>static</th><th>heap</th></tr>");
+        for(int i = 0; i < MEM_NUM; i++) {
+            memUse mu;
+            mem_getUse(i, &mu);
+            snprintf(buf, sizeof(buf), "<tr><td>%s</td><td>%u</td><td>%u</td></tr>", memNames[i],
+                    (unsigned int)mu.staticBytes, (unsigned int)mu.heapBytes);
+            pageAdd(&pb, buf);
+        }
+    }
+    pageAdd(&pb, "</table><p><a href='/'>Back</a></p></body></html>");
+
+    pageFlush(&pb);
+    wm.server->sendContent("");
+}
+#endif
+
 static void setBoolAndUpdCB(bool myBool, char *sett, WiFiManagerParameter *wmParm)
 {
     sett[0] = myBool ? '1' : '0';
@@ -1412,6 +1915,7 @@ static void updateConfigPortalValues()
     setCBVal(&custom_bttfnTT, settings.bttfnTT);
     setCBVal(&custom_ssClock, settings.ssClock);
     setCBVal(&custom_ssClockO, settings.ssClockOffNM);
+    setCBVal(&custom_saBcast, settings.saBcast);
 
     setCBVal(&custom_TCDpresent, settings.TCDpresent);
     setCBVal(&custom_noETTOL, settings.noETTOLead);
@@ -1429,21 +1933,20 @@ static void updateConfigPortalValues()
     #endif
 }
 
+// CP parameters belong to the network task
 void updateConfigPortalStrictValue()
 {
-    setBoolAndUpdCB(strictMode, settings.strictMode, &custom_sStrict);
+    wifi_request(NETREQ_CP_STRICT);
 }
 
 void updateConfigPortalSAValues()
 {
-    setBoolAndUpdCB(doPeaks, settings.SApeaks, &custom_SApeaks);
-    setBoolAndUpdCB(doMirror, settings.SAmirror, &custom_SAmirror);
+    wifi_request(NETREQ_CP_SA);
 }
 
 void updateConfigPortalIRFBValues()
 {
-    setBoolAndUpdCB(irShowPosFBDisplay, settings.PIRFB, &custom_PIRFB);
-    setBoolAndUpdCB(irShowCmdFBDisplay, settings.PIRCFB, &custom_PIRCFB);
+    wifi_request(NETREQ_CP_IRFB);
 }
 
 static const char *buildBanner(const char *msg, const char *col, int op) 
@@ -1570,6 +2073,38 @@ static const char *wmBuildTCDSSID(const char *dest, int op)
     return str;
 }
 
+static const char *wmBuildTCDRTT(const char *dest, int op)
+{
+    bttfnClockStats cs;
+    
+    if(op == WM_CP_DESTROY) {
+        if(dest) free((void *)dest);
+        return NULL;
+    }
+
+    bttfn_getClockStats(&cs);
+    
+    if(!cs.samples)
+        return NULL;
+
+    unsigned int l = STRLEN(tcdRTTp) + (4 * 12) + 4;
+
+    if(op == WM_CP_LEN) {
+        wmLenBuf = l;
+        return (const char *)&wmLenBuf;
+    }
+
+    char *str = (char *)malloc(l);
+
+    snprintf(str, l, tcdRTTp, 
+            (unsigned int)(cs.srtt / 1000), (unsigned int)((cs.srtt % 1000) / 100), 
+            (unsigned int)(cs.rttMin / 1000), (unsigned int)((cs.rttMin % 1000) / 100),
+            (unsigned int)(cs.rttVar / 1000), (unsigned int)((cs.rttVar % 1000) / 100), 
+            (unsigned int)(cs.delay / 1000), (unsigned int)((cs.delay % 1000) / 100));
+
+    return str;
+}
+
 static const char *wmBuildApChnl(const char *dest, int op)
 {
     return wmBuildSelect(dest, op, apChannelCustHTMLSrc, 14, settings.apChnl, false);
@@ -1612,6 +2147,11 @@ static const char *wmBuildHaveSD(const char *dest, int op)
     return buildBanner(haveNoSD, col_r, op);
 }
 
+static const char *wmBuildMirror(const char *dest, int op)
+{
+    return wmBuildSelect(dest, op, mirrorCustHTMLSrc, 5, settings.sidMirror, false);
+}
+
 #ifdef SID_HAVEMQTT
 static const char *wmBuildMQTTprot(const char *dest, int op)
 {
@@ -1971,7 +2511,7 @@ static void mqttCallback(char *topic, byte *payload, unsigned int length)
     static const char *cmdList[] = {
       "\x01" "TIMETRAVEL",       // 0
       "\x01" "IDLE_",            // 1
-      "\x41" "IDLE",             // 2
+      "\x01" "IDLE",             // 2
       "\x01" "SA",               // 3
       "\x01" "INJECT_",          // 4
       NULL
@@ -2023,45 +2563,30 @@ static void mqttCallback(char *topic, byte *payload, unsigned int length)
             // We disable our Screen Saver.
             // We don't ignore this if TCD is connected by wire,
             // because this signal does not come via wire.
-            doPrepareTT = true;
+            evt_post(EVQ_MQTT, EVT_PREPARE);
             break;
         case 1:
             // Trigger Time Travel (if not running already)
-            // Ignore command if TCD is connected by wire
-            if(!TCDconnected && !TTrunning && !IRLearning && !sidBusy) {
-                networkTimeTravel = true;
-                networkTCDTT = true;
-                networkReentry = false;
-                networkAbort = false;
-                if(strlen(tempBuf) == 20) {
-                    networkLead = a2i(&tempBuf[11]);
-                    networkP1 = a2i(&tempBuf[16]);
-                } else {
-                    networkLead = ETTO_LEAD;
-                    networkP1 = 6600;
-                }
+            // Ignored if TCD is connected by wire
+            if(strlen(tempBuf) == 20) {
+                evt_postTT(EVQ_MQTT, a2i(&tempBuf[11]), a2i(&tempBuf[16]));
+            } else {
+                evt_postTT(EVQ_MQTT, ETTO_LEAD, 6600);
             }
             break;
         case 2:   // Re-entry
             // Start re-entry (if TT currently running)
-            // Ignore command if TCD is connected by wire
-            if(!TCDconnected && TTrunning && networkTCDTT) {
-                networkReentry = true;
-            }
+            evt_post(EVQ_MQTT, EVT_REENTRY);
             break;
         case 3:   // Abort TT (TCD fake-powered down during TT)
-            // Ignore command if TCD is connected by wire
-            // (mainly because this is no network-triggered TT)
-            if(!TCDconnected && TTrunning && networkTCDTT) {
-                networkAbort = true;
-            }
+            evt_post(EVQ_MQTT, EVT_ABORT);
             break;
         case 4:
-            networkAlarm = true;
             // Eval this at our convenience
+            evt_post(EVQ_MQTT, EVT_ALARM);
             break;
         case 5:
-            doWakeup = true;
+            evt_post(EVQ_MQTT, EVT_WAKEUP);
             break;
         }
        
@@ -2090,9 +2615,6 @@ static void mqttCallback(char *topic, byte *payload, unsigned int length)
         if(!FPBUnitIsOn && (!(k & 0x80)))
             return;
 
-        if(sidBusy && (!(k & 0x40)))
-            return;
-
         // What needs to be handled here:
         // - complete command parsing
         // - stuff to execute when fake power is off
@@ -2103,28 +2625,30 @@ static void mqttCallback(char *topic, byte *payload, unsigned int length)
         switch(i) {
         case 1:
             if(tblen > j && tempBuf[j] >= '0' && tempBuf[j] <= '5') {
-                addCmdQueue(10 + (uint32_t)(tempBuf[j] - '0'));
+                evt_postCmd(EVQ_MQTT, 10 + (uint32_t)(tempBuf[j] - '0'));
             }
             break;
         case 2:
-            addCmdQueue(20);
+            evt_postCmd(EVQ_MQTT, 20);
             break;
         case 3:
-            addCmdQueue(21);
+            evt_postCmd(EVQ_MQTT, 21);
             break;
         case 4:
             if(tblen > j) {
-                addCmdQueue(atoi(tempBuf+j) | 0x80000000);
+                evt_postCmd(EVQ_MQTT, atoi(tempBuf+j) | 0x80000000);
             }
             break;
         default:
-            addCmdQueue(1000 + i);
+            evt_postCmd(EVQ_MQTT, 1000 + i);
         }
             
     } else if(*settings.mqttTopic && (!strcmp(topic, settings.mqttTopic))) {
 
+        char mqttMsg[EVT_MSG_LEN];
+        
         if(filterOutNonDisp(tempBuf, mqttMsg, 0, 8)) {
-            mqttDisp = 1;
+            evt_postMsg(EVQ_MQTT, mqttMsg);
             #ifdef SID_DBG
             Serial.printf("MQTT: Message about [%s]: %s\n", topic, mqttMsg);
             #endif
@@ -2192,10 +2716,13 @@ static bool mqttReconnect(bool force)
                 Serial.println("MQTT: Attempting to (re)connect");
                 #endif
     
-                if(strlen(mqttUser)) {
-                    success = mqttClient.connect(mqttUser, strlen(mqttPass) ? mqttPass : NULL);
-                } else {
-                    success = mqttClient.connect();
+                {
+                    PROF_SCOPE(PROF_MQTTCON);
+                    if(strlen(mqttUser)) {
+                        success = mqttClient.connect(mqttUser, strlen(mqttPass) ? mqttPass : NULL);
+                    } else {
+                        success = mqttClient.connect();
+                    }
                 }
     
                 mqttReconnectNow = millisNonZero();
@@ -2259,4 +2786,67 @@ void mqttPublish(const char *topic, const char *pl, unsigned int len)
     }
 }           
 
+// Publish heap statistics and footprint per subsystem
+static void mqttPublishMem()
+{
+    char pl[320];
+    int len;
+
+    if(!mqttState())
+        return;
+
+    if((len = mem_getJSON(pl, sizeof(pl)))) {
+        mqttPublish("bttf/sid/mem", pl, len);
+    }
+}
+
+#ifdef SID_HAVEPROF
+// Publish profiler statistics, one topic per section
+static void mqttPublishProf()
+{
+    char topic[32], pl[320];
+    int len;
+    
+    if(!mqttState())
+        return;
+
+    for(int i = 0; i < PROF_NUM; i++) {
+        if((len = prof_getJSON(i, pl, sizeof(pl)))) {
+            snprintf(topic, sizeof(topic), "bttf/sid/prof/%s", profNames[i]);
+            mqttPublish(topic, pl, len);
+        }
+    }
+}
+#endif
+
+#ifdef SID_HAVESTATS
+// Publish boot phase time stamps
+static void mqttPublishBoot()
+{
+    char pl[160];
+    int len;
+
+    if((len = prof_getBootJSON(pl, sizeof(pl)))) {
+        mqttPublish("bttf/sid/boot", pl, len);
+    }
+}
+
+// Publish new stall records, one message each
+static void mqttPublishStall()
+{
+    stallRec r;
+    char pl[160];
+    int len;
+
+    if(!mqttState())
+        return;
+
+    while(stall_getUnpublished(&r)) {
+        if((len = stall_getJSON(&r, pl, sizeof(pl)))) {
+            mqttPublish("bttf/sid/stall", pl, len);
+        }
+    }
+}
+#endif
+
 #endif
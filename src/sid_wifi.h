@@ -57,8 +57,22 @@
 
 void wifi_setup();
 void wifi_loop();
+void wifi_startTask();
+bool wifi_isSetupDone();
+bool wifi_staConfigured();
+
+// Requests from loop task to network task
+enum {
+    NETREQ_WIFION = 1,    // *77
+    NETREQ_CP_STRICT,     // Update CP parameters
+    NETREQ_CP_SA,
+    NETREQ_CP_IRFB,
+    NETREQ_PS_ON,         // WiFi modem sleep on/off
+    NETREQ_PS_OFF
+};
+void wifi_request(uint8_t req);
+
 void wifiOn(unsigned long newDelay = 0, bool alsoInAPMode = false, bool deferConfigPortal = false);
-bool wifiOnWillBlock();
 void wifiStartCP();
 bool updateAvailable();
 
@@ -60,231 +60,44 @@
 #include "siddisplay.h"
 
 #include "sid_font.h"
+#include "sid_prof.h"
+#include "sid_time.h"
+#include "sid_mem.h"
+
+// Original SID: Two controllers; each bar consists of a 4-LED segment
+// at the top (controller 2, rows 2-7, two bars per row) and a 16-LED
+// segment below (one row each).
+static const sdSegment defSegs[] = {
+    // bar, row, cnt, idx,  shift
+    { 0, 0,  4, 8+2, 0 }, { 0, 4, 16,   0, 0 },
+    { 1, 0,  4, 8+3, 0 }, { 1, 4, 16,   1, 0 },
+    { 2, 0,  4, 8+4, 0 }, { 2, 4, 16,   2, 0 },
+    { 3, 0,  4, 8+5, 0 }, { 3, 4, 16,   3, 0 },
+    { 4, 0,  4, 8+6, 0 }, { 4, 4, 16,   4, 0 },
+    { 5, 0,  4, 8+7, 0 }, { 5, 4, 16,   5, 0 },
+    { 6, 0,  4, 8+2, 4 }, { 6, 4, 16,   6, 0 },
+    { 7, 0,  4, 8+3, 4 }, { 7, 4, 16,   7, 0 },
+    { 8, 0,  4, 8+4, 4 }, { 8, 4, 16, 8+0, 0 },
+    { 9, 0,  4, 8+5, 4 }, { 9, 4, 16, 8+1, 0 }
+};
 
-static const uint16_t translator[10][20][2] =
-{ 
-    { 
-        { 8+2, 1<<3 },    // bar 0, top most LED   { index in buffer [0-7 chip1, 8-15 chip2], bitmask }
-        { 8+2, 1<<2 },
-        { 8+2, 1<<1 },
-        { 8+2, 1<<0 },
-        {   0, 1<<15 },
-        {   0, 1<<14 },
-        {   0, 1<<13 },
-        {   0, 1<<12 },
-        {   0, 1<<11 },
-        {   0, 1<<10 },
-        {   0, 1<<9 },
-        {   0, 1<<8 },
-        {   0, 1<<7 },
-        {   0, 1<<6 },
-        {   0, 1<<5 },
-        {   0, 1<<4 },
-        {   0, 1<<3 },
-        {   0, 1<<2 },
-        {   0, 1<<1 },
-        {   0, 1<<0 }     // bar 0, bottom LED
-    },
-    { 
-        { 8+3, 1<<3 },    // bar 1, top most LED
-        { 8+3, 1<<2 },
-        { 8+3, 1<<1 },
-        { 8+3, 1<<0 },
-        {   1, 1<<15 },
-        {   1, 1<<14 },
-        {   1, 1<<13 },
-        {   1, 1<<12 },
-        {   1, 1<<11 },
-        {   1, 1<<10 },
-        {   1, 1<<9 },
-        {   1, 1<<8 },
-        {   1, 1<<7 },
-        {   1, 1<<6 },
-        {   1, 1<<5 },
-        {   1, 1<<4 },
-        {   1, 1<<3 },
-        {   1, 1<<2 },
-        {   1, 1<<1 },
-        {   1, 1<<0 } 
-    },
-    { 
-        { 8+4, 1<<3 },    // bar 2, top most LED
-        { 8+4, 1<<2 },
-        { 8+4, 1<<1 },
-        { 8+4, 1<<0 },
-        {   2, 1<<15 },
-        {   2, 1<<14 },
-        {   2, 1<<13 },
-        {   2, 1<<12 },
-        {   2, 1<<11 },
-        {   2, 1<<10 },
-        {   2, 1<<9 },
-        {   2, 1<<8 },
-        {   2, 1<<7 },
-        {   2, 1<<6 },
-        {   2, 1<<5 },
-        {   2, 1<<4 },
-        {   2, 1<<3 },
-        {   2, 1<<2 },
-        {   2, 1<<1 },
-        {   2, 1<<0 } 
-    },
-    { 
-        { 8+5, 1<<3 },    // bar 3, top most LED
-        { 8+5, 1<<2 },
-        { 8+5, 1<<1 },
-        { 8+5, 1<<0 },
-        {   3, 1<<15 },
-        {   3, 1<<14 },
-        {   3, 1<<13 },
-        {   3, 1<<12 },
-        {   3, 1<<11 },
-        {   3, 1<<10 },
-        {   3, 1<<9 },
-        {   3, 1<<8 },
-        {   3, 1<<7 },
-        {   3, 1<<6 },
-        {   3, 1<<5 },
-        {   3, 1<<4 },
-        {   3, 1<<3 },
-        {   3, 1<<2 },
-        {   3, 1<<1 },
-        {   3, 1<<0 }
-    },
-    { 
-        { 8+6, 1<<3 },    // bar 4, top most LED
-        { 8+6, 1<<2 },
-        { 8+6, 1<<1 },
-        { 8+6, 1<<0 },
-        {   4, 1<<15 },
-        {   4, 1<<14 },
-        {   4, 1<<13 },
-        {   4, 1<<12 },
-        {   4, 1<<11 },
-        {   4, 1<<10 },
-        {   4, 1<<9 },
-        {   4, 1<<8 },
-        {   4, 1<<7 },
-        {   4, 1<<6 },
-        {   4, 1<<5 },
-        {   4, 1<<4 },
-        {   4, 1<<3 },
-        {   4, 1<<2 },
-        {   4, 1<<1 },
-        {   4, 1<<0 }
-    },
-    { 
-        { 8+7, 1<<3 },    // bar 5, top most LED
-        { 8+7, 1<<2 },
-        { 8+7, 1<<1 },
-        { 8+7, 1<<0 },
-        {   5, 1<<15 },
-        {   5, 1<<14 },
-        {   5, 1<<13 },
-        {   5, 1<<12 },
-        {   5, 1<<11 },
-        {   5, 1<<10 },
-        {   5, 1<<9 },
-        {   5, 1<<8 },
-        {   5, 1<<7 },
-        {   5, 1<<6 },
-        {   5, 1<<5 },
-        {   5, 1<<4 },
-        {   5, 1<<3 },
-        {   5, 1<<2 },
-        {   5, 1<<1 },
-        {   5, 1<<0 }
-    },
-    { 
-        { 8+2, 1<<7 },    // bar 6, top most LED
-        { 8+2, 1<<6 },
-        { 8+2, 1<<5 },
-        { 8+2, 1<<4 },
-        {   6, 1<<15 },
-        {   6, 1<<14 },
-        {   6, 1<<13 },
-        {   6, 1<<12 },
-        {   6, 1<<11 },
-        {   6, 1<<10 },
-        {   6, 1<<9 },
-        {   6, 1<<8 },
-        {   6, 1<<7 },
-        {   6, 1<<6 },
-        {   6, 1<<5 },
-        {   6, 1<<4 },
-        {   6, 1<<3 },
-        {   6, 1<<2 },
-        {   6, 1<<1 },
-        {   6, 1<<0 }
-    },
-    { 
-        { 8+3, 1<<7 },    // bar 7, top most LED
-        { 8+3, 1<<6 },
-        { 8+3, 1<<5 },
-        { 8+3, 1<<4 },
-        {   7, 1<<15 },
-        {   7, 1<<14 },
-        {   7, 1<<13 },
-        {   7, 1<<12 },
-        {   7, 1<<11 },
-        {   7, 1<<10 },
-        {   7, 1<<9 },
-        {   7, 1<<8 },
-        {   7, 1<<7 },
-        {   7, 1<<6 },
-        {   7, 1<<5 },
-        {   7, 1<<4 },
-        {   7, 1<<3 },
-        {   7, 1<<2 },
-        {   7, 1<<1 },
-        {   7, 1<<0 }
-    },
-    { 
-        { 8+4, 1<<7 },    // bar 8, top most LED
-        { 8+4, 1<<6 },
-        { 8+4, 1<<5 },
-        { 8+4, 1<<4 },
-        { 8+0, 1<<15 },
-        { 8+0, 1<<14 },
-        { 8+0, 1<<13 },
-        { 8+0, 1<<12 },
-        { 8+0, 1<<11 },
-        { 8+0, 1<<10 },
-        { 8+0, 1<<9 },
-        { 8+0, 1<<8 },
-        { 8+0, 1<<7 },
-        { 8+0, 1<<6 },
-        { 8+0, 1<<5 },
-        { 8+0, 1<<4 },
-        { 8+0, 1<<3 },
-        { 8+0, 1<<2 },
-        { 8+0, 1<<1 },
-        { 8+0, 1<<0 }
-    },
-    { 
-        { 8+5, 1<<7 },    // bar 9, top most LED
-        { 8+5, 1<<6 },
-        { 8+5, 1<<5 },
-        { 8+5, 1<<4 },
-        { 8+1, 1<<15 },
-        { 8+1, 1<<14 },
-        { 8+1, 1<<13 },
-        { 8+1, 1<<12 },
-        { 8+1, 1<<11 },
-        { 8+1, 1<<10 },
-        { 8+1, 1<<9 },
-        { 8+1, 1<<8 },
-        { 8+1, 1<<7 },
-        { 8+1, 1<<6 },
-        { 8+1, 1<<5 },
-        { 8+1, 1<<4 },
-        { 8+1, 1<<3 },
-        { 8+1, 1<<2 },
-        { 8+1, 1<<1 },
-        { 8+1, 1<<0 }
-    }   
+const sdTopology sidDefTopology = {
+    SD_DEF_WIDTH, SD_DEF_HEIGHT,
+    2, { 0x74, 0x72 }, { 0, 0 },
+    sizeof(defSegs) / sizeof(defSegs[0]), defSegs
 };
 
+static TwoWire *sdBusses[2] = { &Wire, &Wire1 };
+
+// Glyph cache: Font converted to vertical column masks (bit 0 =
+// bottom row of glyph), and char-to-glyph lookup tables
+#define SD_NO_GLYPH 0xff
+static uint16_t glyphCols[36+1+1+7][10];
+static uint16_t glyphCols8[36+1+1+4][8];
+static uint8_t  glyphLUT[128];
+static uint8_t  glyphLUT8[128];
+static bool     haveGlyphCache = false;
+
 #define SID_SIG_DURATION     2000
 #define SID_SIG_DURATION_CMD 5000
 
@@ -307,16 +120,34 @@ static const uint16_t sigMaps[SID_SS_MAX] = { // [left=right, right=left]
     0b1111111111
 };
 
-// Store i2c address and display ID
+// Original SID topology with given i2c addresses
 sidDisplay::sidDisplay(uint8_t address1, uint8_t address2)
 {
+    _topo = &sidDefTopology;
+    _numCtrl = 2;
     _address[0] = address1;
     _address[1] = address2;
+    _bus[0] = _bus[1] = &Wire;
+    _bufSize = _numCtrl * SD_CTRL_WORDS;
+}
+
+sidDisplay::sidDisplay(const sdTopology *topo)
+{
+    _topo = topo;
+    _numCtrl = min((int)topo->numCtrl, SD_MAX_CTRL);
+    for(int j = 0; j < _numCtrl; j++) {
+        _address[j] = topo->address[j];
+        _bus[j] = sdBusses[topo->bus[j] & 1];
+    }
+    _bufSize = _numCtrl * SD_CTRL_WORDS;
 }
 
 // Start the display
 void sidDisplay::begin()
 {
+    buildMap();
+    buildGlyphCache();
+
     directCmd(0x20 | 1);    // turn on oscillator
 
     clearBuf();             // clear buffer
@@ -339,23 +170,25 @@ void sidDisplay::off()
 
 void sidDisplay::lampTest()
 { 
-    for(int j = 0; j < 2; j++) {
-        Wire.beginTransmission(_address[j]);  
-        Wire.write(0x00);  // start address
-        for(int i = 0; i < SD_BUF_SIZE / 2; i++) {
-            Wire.write(0xff);
-            Wire.write(0xff);
+    for(int j = 0; j < _numCtrl; j++) {
+        _bus[j]->beginTransmission(_address[j]);  
+        _bus[j]->write(0x00);  // start address
+        for(int i = 0; i < SD_CTRL_WORDS; i++) {
+            _bus[j]->write(0xff);
+            _bus[j]->write(0xff);
         }
-        Wire.endTransmission();
+        _bus[j]->endTransmission();
     }
+    _lastSentValid = false;
 }
 
 
 // Clear the buffer
 void sidDisplay::clearBuf()
 {
-    for(int i = 0; i < SD_BUF_SIZE; i++) {
+    for(int i = 0; i < _bufSize; i++) {
         _displayBuffer[i] = 0;
+        _partBuffer[0][i] = _partBuffer[1][i] = 0;
     }
 }
 
@@ -400,17 +233,19 @@ void sidDisplay::drawBarWithHeight(int bar, int height)
     // Clear bar
     // Draw bar with given height
 
-    if(height < 0)       height = 0;
-    else if(height > 20) height = 20;
+    if(bar < 0 || bar >= _width) return;
+
+    if(height < 0)            height = 0;
+    else if(height > _height) height = _height;
 
-    if(height < 20) {
-        for(int i = 0; i < 20 - height; i++) {
-            _displayBuffer[translator[bar][i][0]] &= ~(translator[bar][i][1]);
+    if(height < _height) {
+        for(int i = 0; i < _height - height; i++) {
+            _displayBuffer[_map[bar][i][0]] &= ~(_map[bar][i][1]);
         }
     }
     if(height > 0) {
-        for(int i = 20 - height; i < 20; i++) {
-            _displayBuffer[translator[bar][i][0]] |= translator[bar][i][1];
+        for(int i = _height - height; i < _height; i++) {
+            _displayBuffer[_map[bar][i][0]] |= _map[bar][i][1];
         }
     }
 }
@@ -419,33 +254,39 @@ void sidDisplay::drawBarWithHeight(int bar, int height)
 void sidDisplay::drawBar(int bar, int bottom, int top)
 {
     // Clear bar
-    // Draw bar from top to bottom (0-19, 0=bottom)
+    // Draw bar from top to bottom (0-(height-1), 0=bottom)
 
-    if(top > 19) top = 19;
+    int maxY = _height - 1;
+
+    if(bar < 0 || bar >= _width) return;
+
+    if(top > maxY) top = maxY;
     else if(top < 0) top = 0;
-    if(bottom > 19) bottom = 19;
+    if(bottom > maxY) bottom = maxY;
     else if(bottom < 0) bottom = 0;
     if(bottom > top) bottom = top;
 
-    if(top < 19) {
-        for(int i = 0; i <= 19-top; i++) {
-            _displayBuffer[translator[bar][i][0]] &= ~(translator[bar][i][1]);
+    if(top < maxY) {
+        for(int i = 0; i <= maxY-top; i++) {
+            _displayBuffer[_map[bar][i][0]] &= ~(_map[bar][i][1]);
         }
     }
     if(bottom > 0) {
-        for(int i = 19; i <= 19-bottom; i--) {
-            _displayBuffer[translator[bar][i][0]] &= ~(translator[bar][i][1]);
+        for(int i = maxY; i <= maxY-bottom; i--) {
+            _displayBuffer[_map[bar][i][0]] &= ~(_map[bar][i][1]);
         }
     }
-    for(int i = 19-top; i <= 19-bottom; i++) {
-        _displayBuffer[translator[bar][i][0]] |= translator[bar][i][1];
+    for(int i = maxY-top; i <= maxY-bottom; i++) {
+        _displayBuffer[_map[bar][i][0]] |= _map[bar][i][1];
     }
 }
 
 void sidDisplay::clearBar(int bar)
 {
-    for(int i = 0; i <= 19; i++) {
-        _displayBuffer[translator[bar][i][0]] &= ~(translator[bar][i][1]);
+    if(bar < 0 || bar >= _width) return;
+    
+    for(int i = 0; i < _height; i++) {
+        _displayBuffer[_map[bar][i][0]] &= ~(_map[bar][i][1]);
     }
 }
 
@@ -454,35 +295,42 @@ void sidDisplay::drawDot(int bar, int dot_y)
 {
     // Do not clear bar
     // Draw dot at dot_y (0 = bottom)
-    if(dot_y > 19) dot_y = 19;
+    if(bar < 0 || bar >= _width) return;
+    
+    if(dot_y > _height - 1) dot_y = _height - 1;
     else if(dot_y < 0) dot_y = 0;
 
-    _displayBuffer[translator[bar][19-dot_y][0]] |= translator[bar][19-dot_y][1];
+    _displayBuffer[_map[bar][_height-1-dot_y][0]] |= _map[bar][_height-1-dot_y][1];
 }
 
 //#define SA_W_LINE
 
+// Mirrored bars: height and maxHeight are relative to the full
+// bar height; each half is _height / 2 LEDs high.
 void sidDisplay::drawMirrorBarWithHeight(int bar, int height, int maxHeight)
 {
     // Clear bar & draw mirror bar
     int bheight;
+    int half = _height / 2;
+
+    if(bar < 0 || bar >= _width) return;
 
     #ifdef SA_W_LINE
 
-    // Draw bar mirrored around line 9 with given height
+    // Draw bar mirrored around line half-1 with given height
 
-    for(int i = 0; i < 20; i++) {
-        if(i == 10) {
-            _displayBuffer[translator[bar][i][0]] |= translator[bar][i][1];
+    for(int i = 0; i < _height; i++) {
+        if(i == half) {
+            _displayBuffer[_map[bar][i][0]] |= _map[bar][i][1];
         } else {
-            _displayBuffer[translator[bar][i][0]] &= ~(translator[bar][i][1]);
+            _displayBuffer[_map[bar][i][0]] &= ~(_map[bar][i][1]);
         }
     }
 
-    if(height <= 1)      return;
-    else if(height > 20) height = 20;
+    if(height <= 1)           return;
+    else if(height > _height) height = _height;
 
-    maxHeight -= 10;
+    maxHeight -= half;
 
     bheight = height;
 
@@ -491,43 +339,44 @@ void sidDisplay::drawMirrorBarWithHeight(int bar, int height, int maxHeight)
     if(height > maxHeight) height = maxHeight;
     
     for(int i = 1; i <= height; i++) {
-        _displayBuffer[translator[bar][10-i][0]] |= translator[bar][10-i][1];
+        _displayBuffer[_map[bar][half-i][0]] |= _map[bar][half-i][1];
     }
 
     // Bottom: 20=>9, 3=>1, >3=>0
     bheight--;  
-    bheight /= 2;      
+    bheight /= 2;
+    if(half + bheight > _height - 1) bheight = _height - 1 - half;
     
     for(int i = 1; i <= bheight; i++) {
-        _displayBuffer[translator[bar][10+i][0]] |= translator[bar][10+i][1];
+        _displayBuffer[_map[bar][half+i][0]] |= _map[bar][half+i][1];
     }
 
     #else  // -------------------------------
 
-    // Draw bar mirrored in two 10-blocks-high parts
+    // Draw bar mirrored in two half-height parts
 
-    for(int i = 0; i < 20; i++) {
-        _displayBuffer[translator[bar][i][0]] &= ~(translator[bar][i][1]);
+    for(int i = 0; i < _height; i++) {
+        _displayBuffer[_map[bar][i][0]] &= ~(_map[bar][i][1]);
     }
 
-    if(height <= 1)      return;
-    else if(height > 20) height = 20;
+    if(height <= 1)           return;
+    else if(height > _height) height = _height;
 
     height /= 2; 
     
     bheight = height;
 
-    maxHeight -= 10;
+    maxHeight -= half;
 
     // Top & Bottom: 20=>10, 2=>1, >2=>0
     
     if(height > maxHeight) height = maxHeight;
     for(int i = 1; i <= height; i++) {
-        _displayBuffer[translator[bar][10-i][0]] |= translator[bar][10-i][1];
+        _displayBuffer[_map[bar][half-i][0]] |= _map[bar][half-i][1];
     }
 
     for(int i = 1; i <= bheight; i++) {
-        _displayBuffer[translator[bar][9+i][0]] |= translator[bar][9+i][1];
+        _displayBuffer[_map[bar][half-1+i][0]] |= _map[bar][half-1+i][1];
     }
 
     #endif
@@ -536,16 +385,19 @@ void sidDisplay::drawMirrorBarWithHeight(int bar, int height, int maxHeight)
 void sidDisplay::drawMirrorDot(int bar, int dot_y, int maxHeight)
 {
     int bdy;
+    int half = _height / 2;
     
     // Do not clear bar
 
-    maxHeight -= 10;
+    if(bar < 0 || bar >= _width) return;
+
+    maxHeight -= half;
 
     #ifdef SA_W_LINE
     
-    // Draw dot at relative dot_y (0 = bottom) around line 9
+    // Draw dot at relative dot_y (0 = bottom) around line half-1
     
-    if(dot_y > 19) dot_y = 19;
+    if(dot_y > _height - 1) dot_y = _height - 1;
     else if(dot_y < 0) dot_y = 0;
 
     bdy = dot_y;
@@ -554,20 +406,21 @@ void sidDisplay::drawMirrorDot(int bar, int dot_y, int maxHeight)
     dot_y /= 2;
 
     bdy /= 2;
+    if(half + bdy > _height - 1) bdy = _height - 1 - half;
 
     if(dot_y) {
         if(dot_y > maxHeight) dot_y = maxHeight;
-        _displayBuffer[translator[bar][10-dot_y][0]] |= translator[bar][10-dot_y][1];
+        _displayBuffer[_map[bar][half-dot_y][0]] |= _map[bar][half-dot_y][1];
     }
     if(bdy) {
-        _displayBuffer[translator[bar][10+bdy][0]] |= translator[bar][10+bdy][1];
+        _displayBuffer[_map[bar][half+bdy][0]] |= _map[bar][half+bdy][1];
     }
 
     #else
 
-    // Draw dot at relative dot_y (0 = bottom) into mirrored 2x10 area
+    // Draw dot at relative dot_y (0 = bottom) into mirrored 2 x half area
     
-    if(dot_y > 19) dot_y = 19;
+    if(dot_y > _height - 1) dot_y = _height - 1;
     else if(dot_y < 0) dot_y = 0;
 
     dot_y++;
@@ -576,24 +429,43 @@ void sidDisplay::drawMirrorDot(int bar, int dot_y, int maxHeight)
 
     if(dot_y) {
         if(dot_y > maxHeight) dot_y = maxHeight;
-        _displayBuffer[translator[bar][10-dot_y][0]] |= translator[bar][10-dot_y][1];
+        _displayBuffer[_map[bar][half-dot_y][0]] |= _map[bar][half-dot_y][1];
     }
     if(bdy) {
-        _displayBuffer[translator[bar][9+bdy][0]] |= translator[bar][9+bdy][1];
+        _displayBuffer[_map[bar][half-1+bdy][0]] |= _map[bar][half-1+bdy][1];
     }
 
     #endif
 }
 
-void sidDisplay::drawFieldAndShow(uint8_t *fieldData)
+// Draw dot with partial intensity (level 1-3, of SD_SUBFRAMES)
+// into buffer, do NOT call show. Only has an effect in dither
+// mode; partial dots are valid for one frame (ie until show()).
+void sidDisplay::drawPartialDot(int bar, int dot_y, uint8_t level)
 {
-    // Draw entire field. Data is 0 or 1, organized in lines
-    for(int i = 0, k = 0; i < 20; i++, k += 10) {
-        for(int j = 0; j < 10; j++) {
-            if(fieldData[k+j]) {
-                _displayBuffer[translator[j][i][0]] |= translator[j][i][1];
+    if(!_ditherOk || !level || bar < 0 || bar >= _width)
+        return;
+
+    if(dot_y > _height - 1) dot_y = _height - 1;
+    else if(dot_y < 0) dot_y = 0;
+    if(level > SD_SUBFRAMES - 1) level = SD_SUBFRAMES - 1;
+
+    const uint16_t *t = _map[bar][_height-1-dot_y];
+    if(level & 1) _partBuffer[0][t[0]] |= t[1];
+    if(level & 2) _partBuffer[1][t[0]] |= t[1];
+}
+
+// Draw entire field. Data is 0 or 1, organized in h lines of w
+// dots, placed at top left; parts of the display outside of the
+// field are cleared.
+void sidDisplay::drawFieldAndShow(uint8_t *fieldData, int w, int h)
+{
+    for(int i = 0; i < _height; i++) {
+        for(int j = 0; j < _width; j++) {
+            if(i < h && j < w && fieldData[(i * w) + j]) {
+                _displayBuffer[_map[j][i][0]] |= _map[j][i][1];
             } else {
-                _displayBuffer[translator[j][i][0]] &= ~(translator[j][i][1]);
+                _displayBuffer[_map[j][i][0]] &= ~(_map[j][i][1]);
             }
         }
     }
@@ -602,121 +474,32 @@ void sidDisplay::drawFieldAndShow(uint8_t *fieldData)
 
 void sidDisplay::drawLetterAndShow(char alpha, int x, int y)
 {
-    uint8_t field[20*10] = { 0 };
-    int w = 10, h = 10, fx = 0, fy = 0, a = 0x200;
+    uint8_t g;
 
-    if(x < -9 || x > 9 || y < -9 || y > 19) {
-        clearDisplayDirect();
-        return;
-    }
-    
-    if(alpha >= '0' && alpha <= '9') {
-        alpha -= '0';
-    } else if(alpha >= 'A' && alpha <= 'Z') {
-        alpha -= ('A' - 10);
-    } else if(alpha >= 'a' && alpha <= 'z') {
-        alpha -= ('a' - 10);
-    } else if(alpha == '.') {
-        alpha = 36;
-    } else if(alpha == '&') {
-        alpha = 37;
-    } else if(alpha == '*') {
-        alpha = 38;
-    } else if(alpha == '#') {
-        alpha = 39;
-    } else if(alpha == '^') {
-        alpha = 40;
-    } else if(alpha == '$') {
-        alpha = 41;
-    } else if(alpha == '<') {
-        alpha = 42;
-    } else if(alpha == '>') {
-        alpha = 43;
-    } else if(alpha == '~') {
-        alpha = 44;
-    } else {
+    if(x < -9 || x >= _width || y < -9 || y >= _height ||
+       (uint8_t)alpha > 127 || (g = glyphLUT[(uint8_t)alpha]) == SD_NO_GLYPH) {
         clearDisplayDirect();
         return;
     }
 
-    if(x < 0) {
-        fx = -x;
-        a >>= fx;
-        w = 10 - fx;
-        x = 0;
-    } else if(x > 0) {
-        w = 10 - x;
-    }
-    if(y < 0) {
-        fy = -y;
-        h = 10 - fy;
-        y = 0;
-    } else if(y > (20-10)) {       
-        h = 20 - y;           
-    }
-
-    for(int yy = fy; yy < h; yy++, y++) {
-        uint16_t font = alphaChars[(unsigned int)alpha][yy];
-        int xxx = x;
-        for(int xx = fx, s = a; xx < w; xx++, s >>= 1, xxx++) {
-            if(font & s) {
-                field[(y*10) + xxx] = 1;
-            }
-        }
-    }
-    drawFieldAndShow(field);
+    clearBuf();
+    drawGlyph(glyphCols[g], 10, 10, x, y, false);
+    show();
 }
 
 void sidDisplay::drawLetterMask(char alpha, int x, int y)
 {
-    int w = 8, h = 8, fx = 0, fy = 0, a = 0x80;
+    uint8_t g;
 
-    if(x < -7 || x > 9 || y < -7 || y > 19) {
+    if(x < -7 || x >= _width || y < -7 || y >= _height) {
         return;
     }
-    
-    if(alpha >= '0' && alpha <= '9') {
-        alpha -= '0';
-    } else if(alpha >= 'A' && alpha <= 'Z') {
-        alpha -= ('A' - 10);
-    } else if(alpha >= 'a' && alpha <= 'z') {
-        alpha -= ('a' - 10);
-    } else if(alpha == '.') {
-        alpha = 36;
-    } else if(alpha == '#') {
-        alpha = 37;
-    } else if(alpha >= '$' && alpha <= '\'') {
-        alpha -= '$';
-        alpha += 38;
-    } else { 
+
+    if((uint8_t)alpha > 127 || (g = glyphLUT8[(uint8_t)alpha]) == SD_NO_GLYPH) {
         return;
     }
 
-    if(x < 0) {
-        fx = -x;
-        a >>= fx;
-        w = 8 - fx;
-        x = 0;
-    } else if(x > 2) {
-        w = 8 - x;
-    }
-    if(y < 0) {
-        fy = -y;
-        h = 8 - fy;
-        y = 0;
-    } else if(y > (20-8)) {       
-        h = 20 - y;           
-    }
-
-    for(int yy = fy; yy < h; yy++, y++) {
-        uint8_t font = alphaChars8[(unsigned int)alpha][yy];
-        int xxx = x;
-        for(int xx = fx, s = a; xx < w; xx++, s >>= 1, xxx++) {
-            if(font & s) {
-                _displayBuffer[translator[xxx][y][0]] &= ~(translator[xxx][y][1]);
-            }
-        }
-    }
+    drawGlyph(glyphCols8[g], 8, 8, x, y, true);
 }
 
 void sidDisplay::drawClockAndShow(uint8_t *dateBuf, int dx, int dy)
@@ -786,46 +569,345 @@ void sidDisplay::drawClockAndShow(uint8_t *dateBuf, int dx, int dy)
     drawFieldAndShow(field);
 }
 
+// Draw (or mask out) a glyph from the glyph cache. Each column is
+// shifted into display row order (bit _height-1 = top row) and then
+// written into the buffer segment by segment.
+void sidDisplay::drawGlyph(const uint16_t *cols, int w, int h, int x, int y, bool mask)
+{
+    int sh = _height - h - y;
+    uint64_t hmask = (1ULL << _height) - 1;
+
+    for(int c = 0; c < w; c++) {
+        int bar = x + c;
+        uint64_t rb = cols[c];
+        
+        if(bar < 0 || bar >= _width || !rb) continue;
+
+        rb = (sh >= 0) ? (rb << sh) : (rb >> -sh);
+        rb &= hmask;
+        if(!rb) continue;
+
+        for(int r = 0; r < _numRuns[bar]; r++) {
+            const sdSegment *run = &_colRuns[bar][r];
+            uint16_t v = ((rb >> (_height - run->row - run->cnt)) & ((1 << run->cnt) - 1)) << run->shift;
+            if(mask) {
+                _displayBuffer[run->idx] &= ~v;
+            } else {
+                _displayBuffer[run->idx] |= v;
+            }
+        }
+    }
+}
+
+// Generate LED map from the topology's segment list, and collect
+// each bar's segments for glyph drawing
+void sidDisplay::buildMap()
+{
+    const sdTopology *t = _topo;
+
+    _width = min((int)t->width, SD_MAX_WIDTH);
+    _height = min((int)t->height, SD_MAX_HEIGHT);
+    _bufSize = _numCtrl * SD_CTRL_WORDS;
+
+    // Unmapped LEDs point to a bit that is never set
+    memset(_map, 0, sizeof(_map));
+    memset(_numRuns, 0, sizeof(_numRuns));
+
+    for(int s = 0; s < t->numSegs; s++) {
+        const sdSegment *seg = &t->segs[s];
+        if(seg->bar >= _width || seg->row + seg->cnt > _height || !seg->cnt ||
+           seg->idx >= _bufSize || seg->shift + seg->cnt > 16 ||
+           _numRuns[seg->bar] >= SD_MAX_RUNS) {
+            #ifdef SID_DBG
+            Serial.printf("sidDisplay: Bad or excess topology segment %d\n", s);
+            #endif
+            continue;
+        }
+        _colRuns[seg->bar][_numRuns[seg->bar]++] = *seg;
+        for(int i = 0; i < seg->cnt; i++) {
+            _map[seg->bar][seg->row + i][0] = seg->idx;
+            _map[seg->bar][seg->row + i][1] = 1 << (seg->shift + seg->cnt - 1 - i);
+        }
+    }
+}
+
+void sidDisplay::buildGlyphCache()
+{
+    static const char sym[]  = ".&*#^$<>~";
+    static const char sym8[] = ".#$%&'";
+
+    if(haveGlyphCache)
+        return;
+
+    memset(glyphLUT, SD_NO_GLYPH, sizeof(glyphLUT));
+    memset(glyphLUT8, SD_NO_GLYPH, sizeof(glyphLUT8));
+    for(int i = 0; i < 10; i++) {
+        glyphLUT['0' + i] = glyphLUT8['0' + i] = i;
+    }
+    for(int i = 0; i < 26; i++) {
+        glyphLUT['A' + i] = glyphLUT8['A' + i] = 10 + i;
+        glyphLUT['a' + i] = glyphLUT8['a' + i] = 10 + i;
+    }
+    for(int i = 0; i < sizeof(sym) - 1; i++) {
+        glyphLUT[(uint8_t)sym[i]] = 36 + i;
+    }
+    for(int i = 0; i < sizeof(sym8) - 1; i++) {
+        glyphLUT8[(uint8_t)sym8[i]] = 36 + i;
+    }
+
+    // Transpose font rows into columns
+    for(int g = 0; g < 36+1+1+7; g++) {
+        for(int c = 0; c < 10; c++) {
+            uint16_t m = 0;
+            for(int r = 0; r < 10; r++) {
+                m <<= 1;
+                if(alphaChars[g][r] & (0x200 >> c)) m |= 1;
+            }
+            glyphCols[g][c] = m;
+        }
+    }
+    for(int g = 0; g < 36+1+1+4; g++) {
+        for(int c = 0; c < 8; c++) {
+            uint16_t m = 0;
+            for(int r = 0; r < 8; r++) {
+                m <<= 1;
+                if(alphaChars8[g][r] & (0x80 >> c)) m |= 1;
+            }
+            glyphCols8[g][c] = m;
+        }
+    }
+
+    haveGlyphCache = true;
+}
+
 void sidDisplay::superImposeSpecSig()
 {
     uint16_t sigMap = sigMaps[_specialSig - 1];
     
-    for(int i = 0; i < 10; i++) {
+    for(int i = 0; i < SD_DEF_WIDTH && i < _width; i++) {
         if(sigMap & (1 << i)) {
-            _displayBuffer[translator[i][0][0]] |= translator[i][0][1];
+            _displayBuffer[_map[i][0][0]] |= _map[i][0][1];
         } else {
-            _displayBuffer[translator[i][0][0]] &= ~translator[i][0][1];
+            _displayBuffer[_map[i][0][0]] &= ~_map[i][0][1];
         }
         // Clear second row to make clearer
-        //_displayBuffer[translator[i][1][0]] &= ~translator[i][1][1];
+        //_displayBuffer[_map[i][1][0]] &= ~_map[i][1][1];
         // ... or better yet, set it
-        _displayBuffer[translator[i][1][0]] |= translator[i][1][1];
+        _displayBuffer[_map[i][1][0]] |= _map[i][1][1];
     }
 }
 
 // Show the buffer
 void sidDisplay::show()
 {
-    uint16_t *tp = &_displayBuffer[0];
-
+    PROF_SCOPE(PROF_SHOW);
+    
     if(_specialSig) {
-        if(millis() - _specialSigNow < _specialDuration) {
+        if(sidMillis() - _specialSigNow < _specialDuration) {
             superImposeSpecSig();
         } else {
             _specialSig = 0;
             _specialTrigger = false;
         }
     }
+
+    memcpy(_frame, _displayBuffer, sizeof(_frame));
+
+    _haveFramePart = false;
+    if(_ditherOk) {
+        for(int i = 0; i < _bufSize; i++) {
+            _framePart[0][i] = _partBuffer[0][i] & ~_frame[i];
+            _framePart[1][i] = _partBuffer[1][i] & ~_frame[i];
+            if(_framePart[0][i] | _framePart[1][i]) _haveFramePart = true;
+        }
+    }
+    memset(_partBuffer, 0, sizeof(_partBuffer));
+
+    if(_haveFramePart) {
+        _subFrame = 0;
+        sendSubFrame();
+    } else {
+        writeFrame(_frame);
+    }
+}
+
+// Write frame to the controllers; only the range of
+// words that differ from what was last written. The
+// ranges of all controllers are determined first, then
+// written back to back, bus by bus.
+void sidDisplay::writeFrame(const uint16_t *frame)
+{
+    int  first[SD_MAX_CTRL], last[SD_MAX_CTRL];
+    bool err = false;
+    
+    for(int j = 0, k = 0; j < _numCtrl; j++, k += SD_CTRL_WORDS) {
+        first[j] = k;
+        last[j] = k + SD_CTRL_WORDS - 1;
+        if(_lastSentValid) {
+            while(first[j] <= last[j] && frame[first[j]] == _lastSent[first[j]]) first[j]++;
+            if(first[j] > last[j]) continue;
+            while(frame[last[j]] == _lastSent[last[j]]) last[j]--;
+        }
+    }
+
+    for(int b = 0; b < 2; b++) {
+        for(int j = 0, k = 0; j < _numCtrl; j++, k += SD_CTRL_WORDS) {
+            if(_bus[j] != sdBusses[b] || first[j] > last[j])
+                continue;
+            _bus[j]->beginTransmission(_address[j]);
+            _bus[j]->write((first[j] - k) * 2);
+            for(int i = first[j]; i <= last[j]; i++) {
+                uint16_t t = frame[i];
+                _bus[j]->write(t & 0xff);
+                _bus[j]->write(t >> 8);
+                _lastSent[i] = t;
+            }
+            if(_bus[j]->endTransmission()) {
+                err = true;
+            }
+        }
+    }
+    
+    // If a transmission failed, we don't know the
+    // display RAM contents; write all next time
+    _lastSentValid = !err;
+    if(err) _i2cErr = true;
+}
+
+// Dither mode: Compose and write current sub-frame. An LED of
+// partial level n is lit in sub-frames 0 to n-1.
+void sidDisplay::sendSubFrame()
+{
+    uint16_t sf[SD_BUF_SIZE];
+
+    for(int i = 0; i < _bufSize; i++) {
+        uint16_t p0 = _framePart[0][i], p1 = _framePart[1][i];
+        switch(_subFrame) {
+        case 0:  sf[i] = p0 | p1; break;
+        case 1:  sf[i] = p1;      break;
+        case 2:  sf[i] = p0 & p1; break;
+        default: sf[i] = 0;
+        }
+        sf[i] |= _frame[i];
+    }
+
+    _subFrameUs = micros();
+    writeFrame(sf);
+    _sfSent++;
+}
+
+// Enable/disable dither mode. Requires the fast I2C
+// clock; HT16K33 is only specified for 400kHz, so if
+// it does not keep up, we fall back to binary rendering.
+void sidDisplay::setDither(bool enable)
+{
+    if(enable == _ditherReq)
+        return;
+
+    _ditherReq = enable;
+    _i2cErr = false;
+    _sfSent = _sfLate = _refreshRate = 0;
+    _rateNow = sidMillis();
+
+    if(enable) {
+        setClock(SD_I2C_CLOCK_FAST);
+        _ditherOk = true;
+    } else {
+        if(_ditherOk) {
+            _ditherOk = false;
+            setClock(SD_I2C_CLOCK);
+        }
+        if(_haveFramePart) {
+            _haveFramePart = false;
+            writeFrame(_frame);
+        }
+    }
+}
+
+// Set clock of all busses the display is connected to
+void sidDisplay::setClock(uint32_t clock)
+{
+    for(int b = 0; b < 2; b++) {
+        for(int j = 0; j < _numCtrl; j++) {
+            if(_bus[j] == sdBusses[b]) {
+                sdBusses[b]->setClock(clock);
+                break;
+            }
+        }
+    }
+}
+
+bool sidDisplay::getDither()
+{
+    return _ditherReq;
+}
+
+bool sidDisplay::isDithering()
+{
+    return _ditherOk;
+}
+
+// Sustained sub-frames per second (0 if not dithering)
+uint16_t sidDisplay::getRefreshRate()
+{
+    return _ditherOk ? _refreshRate : 0;
+}
+
+void sidDisplay::ditherFallback()
+{
+    #ifdef SID_DBG
+    Serial.printf("sidDisplay: Dither mode fall-back (%d sf/s, %d late, err %d)\n", _sfSent, _sfLate, _i2cErr);
+    #endif
+    _ditherOk = false;
+    _i2cErr = false;
+    setClock(SD_I2C_CLOCK);
+    _haveFramePart = false;
+    writeFrame(_frame);
+    _ditherRetryNow = sidMillis();
+}
+
+// Needs to be called as often as possible
+void sidDisplay::ditherLoop()
+{
+    unsigned long now;
     
-    for(int j = 0; j < 2; j++) {
-        Wire.beginTransmission(_address[j]);
-        Wire.write(0x00);
-        for(int i = 0; i < SD_BUF_SIZE / 2; i++) {
-            uint16_t t = *tp++;
-            Wire.write(t & 0xff);
-            Wire.write(t >> 8);
+    if(!_ditherReq)
+        return;
+
+    now = sidMillis();
+
+    if(!_ditherOk) {
+        if(now - _ditherRetryNow > SD_DITHER_RETRY) {
+            setClock(SD_I2C_CLOCK_FAST);
+            _ditherOk = true;
+            _sfSent = _sfLate = 0;
+            _rateNow = now;
         }
-        Wire.endTransmission();
+        return;
+    }
+
+    if(_i2cErr) {
+        ditherFallback();
+        return;
+    }
+
+    if(_haveFramePart) {
+        unsigned long el = micros() - _subFrameUs;
+        if(el >= SD_SUBFRAME_US) {
+            if(el >= 2 * SD_SUBFRAME_US) _sfLate++;
+            _subFrame = (_subFrame + 1) % SD_SUBFRAMES;
+            sendSubFrame();
+        }
+    }
+
+    if(now - _rateNow >= 1000) {
+        _refreshRate = _sfSent * 1000 / (now - _rateNow);
+        // Fall back if more than a quarter of the sub-frames was late
+        if(_sfSent >= 20 && _sfLate * 4 > _sfSent) {
+            ditherFallback();
+        }
+        _sfSent = _sfLate = 0;
+        _rateNow = now;
     }
 }
 
@@ -835,7 +917,7 @@ void sidDisplay::specialSig(uint8_t sig)
         return;
 
     if((_specialSig = sig)) {
-        _specialSigNow = millis();
+        _specialSigNow = sidMillis();
         _specialTrigger = true;
         _specialDuration = (sig < SIS_SS_CMDSTRT) ? SID_SIG_DURATION : SID_SIG_DURATION_CMD;
     } else
@@ -846,7 +928,7 @@ bool sidDisplay::specialTrigger()
 {
     if(!_specialTrigger) return false;
     
-    if(_specialSig && (millis() - _specialSigNow > _specialDuration)) {
+    if(_specialSig && (sidMillis() - _specialSigNow > _specialDuration)) {
         _specialSig = 0;
         _specialTrigger = false;
         return true;
@@ -858,22 +940,43 @@ bool sidDisplay::specialTrigger()
 
 void sidDisplay::clearDisplayDirect()
 {
-    for(int j = 0; j < 2; j++) {
-        Wire.beginTransmission(_address[j]);
-        Wire.write(0x00);
-        for(int i = 0; i < SD_BUF_SIZE / 2; i++) {
-            Wire.write(0x00);
-            Wire.write(0x00);
+    for(int j = 0; j < _numCtrl; j++) {
+        _bus[j]->beginTransmission(_address[j]);
+        _bus[j]->write(0x00);
+        for(int i = 0; i < SD_CTRL_WORDS; i++) {
+            _bus[j]->write(0x00);
+            _bus[j]->write(0x00);
         }
-        Wire.endTransmission();
+        _bus[j]->endTransmission();
     }
+    memset(_lastSent, 0, sizeof(_lastSent));
+    memset(_frame, 0, sizeof(_frame));
+    _haveFramePart = false;
+    _lastSentValid = true;
 }
 
 void sidDisplay::directCmd(uint8_t val)
 {
-    for(int j = 0; j < 2; j++) {
-        Wire.beginTransmission(_address[j]);
-        Wire.write(val);
-        Wire.endTransmission();
+    for(int j = 0; j < _numCtrl; j++) {
+        _bus[j]->beginTransmission(_address[j]);
+        _bus[j]->write(val);
+        _bus[j]->endTransmission();
     }
 }
+
+int sidDisplay::getWidth()
+{
+    return _width;
+}
+
+int sidDisplay::getHeight()
+{
+    return _height;
+}
+
+// Display object (buffers) and glyph cache
+void display_getMemUse(memUse *m)
+{
+    m->staticBytes = sizeof(sidDisplay) + sizeof(glyphCols) + sizeof(glyphCols8) + 
+                     sizeof(glyphLUT) + sizeof(glyphLUT8);
+}
@@ -55,6 +55,8 @@
 #ifndef _SIDDISPLAY_H
 #define _SIDDISPLAY_H
 
+#include <Wire.h>
+
 // Special sequences
 #define SID_SS_STOP        0
 #define SID_SS_REMSTART    1
@@ -65,13 +67,56 @@
 #define SIS_SS_CMDSTRT     6
 #define SID_SS_MAX         (SIS_SS_CMDSTRT+10)
 
-#define SD_BUF_SIZE   16  // Buffer size in words (16bit)
+#define SD_MAX_CTRL   4   // Max number of HT16K33 controllers
+#define SD_CTRL_WORDS 8   // Display RAM size per controller in words (16bit)
+#define SD_BUF_SIZE   (SD_MAX_CTRL * SD_CTRL_WORDS)  // Buffer size in words
+#define SD_MAX_WIDTH  20  // Max number of bars
+#define SD_MAX_HEIGHT 32  // Max number of LEDs per bar
+#define SD_MAX_RUNS   4   // Max number of segments per bar
+
+// Original SID geometry
+#define SD_DEF_WIDTH  10
+#define SD_DEF_HEIGHT 20
+
+// Dither mode (intermediate intensities through sub-frames)
+#define SD_SUBFRAMES        4         // Sub-frames per frame; partial levels are 1-3
+#define SD_SUBFRAME_US      2000      // Sub-frame interval in us
+#define SD_DITHER_RETRY     10000     // ms until we retry after fall-back to binary
+#define SD_I2C_CLOCK        400000
+#define SD_I2C_CLOCK_FAST   1000000
+
+// Topology segment: A run of vertically adjacent LEDs of a bar
+// that live in consecutive (descending) bits of the same buffer
+// word. Buffer word n is word n % 8 of controller n / 8.
+typedef struct {
+    uint8_t bar;      // bar (column, 0=left)
+    uint8_t row;      // first (top most) row (0=top)
+    uint8_t cnt;      // number of rows
+    uint8_t idx;      // index in buffer
+    uint8_t shift;    // bit position of last (bottom most) row
+} sdSegment;
+
+// Display topology: Controllers, geometry and LED wiring. Segments
+// must be listed top to bottom for each bar. Controllers on bus 1
+// (Wire1) require Wire1 to be set up by the caller.
+typedef struct {
+    uint8_t width;                  // number of bars
+    uint8_t height;                 // LEDs per bar
+    uint8_t numCtrl;                // number of controllers
+    uint8_t address[SD_MAX_CTRL];   // i2c address per controller
+    uint8_t bus[SD_MAX_CTRL];       // 0 = Wire, 1 = Wire1
+    uint8_t numSegs;
+    const sdSegment *segs;
+} sdTopology;
+
+extern const sdTopology sidDefTopology;
 
 class sidDisplay {
 
     public:
 
         sidDisplay(uint8_t address1, uint8_t address2);
+        sidDisplay(const sdTopology *topo);
         void begin();
         void on();
         void off();
@@ -96,7 +141,9 @@ class sidDisplay {
         void drawMirrorBarWithHeight(int bar, int height, int maxHeight);
         void drawMirrorDot(int bar, int dot_y, int maxHeight);
 
-        void drawFieldAndShow(uint8_t *fieldData);
+        void drawPartialDot(int bar, int dot_y, uint8_t level);
+
+        void drawFieldAndShow(uint8_t *fieldData, int w = SD_DEF_WIDTH, int h = SD_DEF_HEIGHT);
 
         void drawLetterAndShow(char alpha, int x = 0, int y = 8);
         void drawLetterMask(char alpha, int x, int y);
@@ -105,11 +152,35 @@ class sidDisplay {
         void specialSig(uint8_t sig);
         bool specialTrigger();
 
+        void     setDither(bool enable);
+        bool     getDither();
+        bool     isDithering();
+        uint16_t getRefreshRate();
+        void     ditherLoop();
+
+        int getWidth();
+        int getHeight();
+
     private:
         void superImposeSpecSig();
         void directCmd(uint8_t val);
+
+        void writeFrame(const uint16_t *frame);
+        void setClock(uint32_t clock);
+        void sendSubFrame();
+        void ditherFallback();
+        
+        void buildMap();
+        void buildGlyphCache();
+        void drawGlyph(const uint16_t *cols, int w, int h, int x, int y, bool mask);
         
-        uint8_t _address[2] = { 0, 0 };
+        const sdTopology *_topo;
+        uint8_t  _numCtrl = 0;
+        uint8_t  _address[SD_MAX_CTRL];
+        TwoWire *_bus[SD_MAX_CTRL];
+        int      _width = SD_DEF_WIDTH;
+        int      _height = SD_DEF_HEIGHT;
+        int      _bufSize = 0;
 
         uint8_t _brightness = 15;     // current display brightness
         uint8_t _origBrightness = 15; // value from settings
@@ -121,6 +192,33 @@ class sidDisplay {
         
         uint16_t _displayBuffer[SD_BUF_SIZE];
 
+        // Display RAM as last written, for differential writes
+        uint16_t _lastSent[SD_BUF_SIZE];
+        bool     _lastSentValid = false;
+
+        // Dither mode: Partial-intensity planes (level = plane0 + 2*plane1),
+        // and latched frame for sub-frame refresh
+        uint16_t _partBuffer[2][SD_BUF_SIZE];
+        uint16_t _frame[SD_BUF_SIZE];
+        uint16_t _framePart[2][SD_BUF_SIZE];
+        bool     _haveFramePart = false;
+        bool     _ditherReq = false;
+        bool     _ditherOk = false;
+        bool     _i2cErr = false;
+        uint8_t  _subFrame = 0;
+        unsigned long _subFrameUs = 0;
+        unsigned long _rateNow = 0;
+        unsigned long _ditherRetryNow = 0;
+        uint16_t _sfSent = 0;
+        uint16_t _sfLate = 0;
+        uint16_t _refreshRate = 0;
+
+        // LED map generated from topology: { index in buffer, bitmask }
+        uint16_t _map[SD_MAX_WIDTH][SD_MAX_HEIGHT][2];
+
+        uint8_t   _numRuns[SD_MAX_WIDTH];
+        sdSegment _colRuns[SD_MAX_WIDTH][SD_MAX_RUNS];
+
 };
 
 #endif
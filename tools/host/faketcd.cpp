@@ -0,0 +1,1092 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Host tools: Fake TCD and BTTFN benchmark
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+/*
+ * A stand-in for a Time Circuits Display, speaking BTTFN over 
+ * localhost UDP and multicast, and a host build of the SID's
+ * receive path and client state (sid_bttfn.cpp, sid_event.cpp) 
+ * as its client.
+ *
+ * TCD thread:      Answers DISCOVER (multicast) and polls (unicast);
+ *                  once streaming, sends NOT_SPD and NOT_DATA streams
+ *                  with injected loss and reordering, a TCD restart 
+ *                  half-way, and PREPARE/TT/REENTRY/ABORT sequences.
+ * Receiver thread: Like bttfnRxTask(): Validates, sorts through 
+ *                  bttfn_rxSort(), passes the rest on in a ring.
+ * Main thread:     Like bttfn_loop(): Requests, response timeouts,
+ *                  TCD cache and NOT_DATA through the bttfn_cli*()
+ *                  client functions; handles the ring (sequence 
+ *                  checks through bttfn_seqCheck()) and the events.
+ *
+ * Before streaming, the client boots twice with a cached TCD 
+ * address: One that does not answer (must fall back to DISCOVER
+ * after BTTFN_CACHE_TRIES timeouts), then the one found (must be
+ * used right away and validated by one DISCOVER).
+ *
+ * Reported: TCD cache scenarios, sequence-check decisions against 
+ * an oracle that knows what was sent, notification-to-event 
+ * latency, request round trip time, and in-memory packet 
+ * processing throughput.
+ *
+ * The TCD puts a marker, its epoch (restart count) and the send
+ * time into unused bytes of the packets it sends; the SID code
+ * ignores these.
+ */
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#include <sys/select.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "sid_bttfn.h"
+#include "sid_event.h"
+#include "sid_sched.h"
+
+#include "hostnet.h"
+
+#define SIM_OFS         32          // marker, epoch, send stamp
+#define SIM_MARKER      0xa5
+#define SIM_MAX_TRIG    65536
+#define POLL_INT        100         // ms; SID poll interval
+#define HOST_HASH       0x5151cafe  // SID's hash of TCD hostname
+#define DEAD_TCD        "192.0.2.1" // cached address that does not answer
+
+static struct {
+    int      secs = 5;
+    int      spdRate = 50;          // NOT_SPD per second
+    int      dataRate = 10;         // NOT_DATA per second
+    int      trigInt = 200;         // ms between TT sequence steps
+    int      loss = 5;              // % of stream packets dropped
+    int      reorder = 5;           // % of stream packets delayed by one
+    int      probe = 100;           // ms; request interval while on NOT_DATA
+    bool     restart = true;        // restart TCD half-way
+    uint16_t port = 1338;
+    uint32_t seed = 1985;
+    long     memPkts = 2000000;
+} opt;
+
+static std::atomic<bool> tcdRunning(true);
+static std::atomic<bool> tcdStreaming(false);
+static std::atomic<bool> sidRunning(true);
+static std::atomic<uint32_t> tcdAddr(0);    // as learned by SID
+
+// Trigger notifications, in order sent; matched in order received
+static uint32_t trigStamp[SIM_MAX_TRIG];
+static uint8_t  trigType[SIM_MAX_TRIG];
+static std::atomic<int> trigSent(0);
+
+/*
+ * Helpers
+ */
+
+static uint32_t rnd(uint32_t *x)
+{
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    return *x;
+}
+
+static void put16(bttfnBuf *b, int o, uint16_t v)
+{
+    b->b[o] = v; b->b[o+1] = v >> 8;
+}
+
+static void put32(bttfnBuf *b, int o, uint32_t v)
+{
+    put16(b, o, v); put16(b, o + 2, v >> 16);
+}
+
+static uint32_t get32(const bttfnBuf *b, int o)
+{
+    return b->b[o] | (b->b[o+1] << 8) | (b->b[o+2] << 16) | ((uint32_t)b->b[o+3] << 24);
+}
+
+static void simMark(bttfnBuf *b, uint8_t epoch)
+{
+    b->b[SIM_OFS] = SIM_MARKER;
+    b->b[SIM_OFS + 1] = epoch;
+    put32(b, SIM_OFS + 2, micros());
+}
+
+/*
+ * TCD
+ */
+
+typedef struct {
+    uint32_t seq;
+    uint32_t sent;          // including lost
+    uint32_t lost;
+    uint32_t reordered;
+    bool     haveHeld;
+    bttfnBuf held;
+} tcdStream;
+
+static struct {
+    int       sock = -1;        // unicast; also sends multicast
+    int       mcSock = -1;      // DISCOVER
+    uint8_t   epoch = 0;
+    uint32_t  session = 0;
+    bool      dropNext1 = false;
+    bool      haveClient = false;
+    tcdStream spd, data;
+    uint32_t  requests = 0;
+    uint32_t  rnd = 0;
+} tcd;
+
+static void tcdInitPkt(bttfnBuf *b, uint8_t ver, uint8_t flags)
+{
+    BttfnPacket pkt(b);
+
+    pkt.init();
+    pkt.setVersion(ver);
+    pkt.setFlags(flags);
+}
+
+static void tcdSendMc(const bttfnBuf *b)
+{
+    sendTo(tcd.sock, b, inet_addr(MC_GROUP), opt.port + 2);
+}
+
+// Stream packet: Lose, hold back or send (with held-back one after it)
+static void tcdStreamSend(tcdStream *st, bttfnBuf *b)
+{
+    uint32_t r = rnd(&tcd.rnd) % 100;
+
+    st->sent++;
+
+    if(tcd.dropNext1 && st == &tcd.spd) {
+        tcd.dropNext1 = false;
+        st->lost++;
+        return;
+    }
+    if(r < (uint32_t)opt.loss) {
+        st->lost++;
+        return;
+    }
+    if(!st->haveHeld && r < (uint32_t)(opt.loss + opt.reorder)) {
+        st->held = *b;
+        st->haveHeld = true;
+        st->reordered++;
+        return;
+    }
+
+    tcdSendMc(b);
+    if(st->haveHeld) {
+        tcdSendMc(&st->held);
+        st->haveHeld = false;
+    }
+}
+
+static void tcdFlush(tcdStream *st)
+{
+    if(st->haveHeld) {
+        tcdSendMc(&st->held);
+        st->haveHeld = false;
+    }
+}
+
+static void tcdSendSpd()
+{
+    bttfnBuf b;
+
+    tcdInitPkt(&b, BTTFN_VERSION | 0x40, BTTFN_NOT_SPD);
+    put16(&b, 6, (tcd.spd.seq / 4) % 89);
+    put16(&b, 8, BTTFN_SSRC_GPS);
+    put32(&b, 12, tcd.spd.seq++);
+    simMark(&b, tcd.epoch);
+    BttfnPacket(&b).seal();
+
+    tcdStreamSend(&tcd.spd, &b);
+}
+
+static void tcdSendData()
+{
+    bttfnBuf b;
+
+    tcdInitPkt(&b, BTTFN_VERSION | 0x40, BTTFN_NOT_DATA | BTTFN_RSP_SPEED | BTTFN_RSP_STATUS);
+    put32(&b, 6, tcd.data.seq++);
+    put16(&b, 18, 42);
+    put32(&b, 27, tcd.session);
+    simMark(&b, tcd.epoch);
+    BttfnPacket(&b).seal();
+
+    tcdStreamSend(&tcd.data, &b);
+}
+
+// PREPARE, TT, REENTRY, PREPARE, TT, ABORT, ...
+static void tcdSendTrigger()
+{
+    static const uint8_t seq[6] = {
+        BTTFN_NOT_PREPARE, BTTFN_NOT_TT, BTTFN_NOT_REENTRY,
+        BTTFN_NOT_PREPARE, BTTFN_NOT_TT, BTTFN_NOT_ABORT_TT
+    };
+    int n = trigSent.load();
+    bttfnBuf b;
+
+    if(n >= SIM_MAX_TRIG)
+        return;
+
+    tcdInitPkt(&b, BTTFN_VERSION | 0x40, seq[n % 6]);
+    if(seq[n % 6] == BTTFN_NOT_TT) {
+        put16(&b, 6, ETTO_LEAD);
+        put16(&b, 8, n & 0xffff);      // P1: trigger index, to verify order
+    }
+    simMark(&b, tcd.epoch);
+    BttfnPacket(&b).seal();
+
+    trigType[n] = seq[n % 6];
+    trigStamp[n] = get32(&b, SIM_OFS + 2);
+    trigSent.store(n + 1);
+
+    tcdSendMc(&b);
+}
+
+static void tcdRestart()
+{
+    tcdFlush(&tcd.spd);
+    tcdFlush(&tcd.data);
+    tcd.epoch++;
+    tcd.spd.seq = tcd.data.seq = 1;
+    tcd.session = rnd(&tcd.rnd);
+    // Lose NOT_SPD #1, so the SID needs to resync
+    tcd.dropNext1 = true;
+}
+
+// mc: DISCOVER through multicast
+static void tcdRespond(const bttfnBuf *req, struct sockaddr_in *from, bool mc)
+{
+    BttfnPacket rq((bttfnBuf *)req);
+    uint8_t flags = rq.flags();
+    bttfnBuf b;
+
+    // Requests carry the MC/ND support bits in the version 
+    // byte, so they can't be told from responses by that.
+    // TT trigger requests (flags 0x80 only) are not polls.
+    if(flags == 0x80)
+        return;
+
+    tcd.requests++;
+    // Polled directly: SID knows our address and takes our 
+    // notifications now
+    if(!mc) tcd.haveClient = true;
+
+    tcdInitPkt(&b, BTTFN_VERSION | 0x80, flags);
+    put32(&b, 6, rq.reqId());
+    if(flags & BTTFN_RSP_DATETIME) {
+        const uint8_t dt[8] = { 0x07, 0xbd, 10, 26, 1, 21, 0, 0 };
+        memcpy(&b.b[10], dt, 8);
+    }
+    if(flags & BTTFN_RSP_SPEED) {
+        put16(&b, 18, 88);
+    }
+    if(flags & BTTFN_RSP_STATUS) {
+        b.b[26] = 0;
+    }
+    if(flags & BTTFN_RSP_CAPS) {
+        b.b[31] = BTTFN_CAP_MCSPD | BTTFN_CAP_REMKP | BTTFN_CAP_NOTDATA;
+    }
+    BttfnPacket(&b).seal();
+
+    sendTo(tcd.sock, &b, from->sin_addr.s_addr, ntohs(from->sin_port));
+}
+
+static void tcdRead(int s, bool mc)
+{
+    struct sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    bttfnBuf b;
+
+    if(recvfrom(s, b.b, BTTF_PACKET_SIZE, MSG_DONTWAIT, (struct sockaddr *)&from, &fromLen) != BTTF_PACKET_SIZE)
+        return;
+    if(!BttfnPacket(&b).valid())
+        return;
+
+    tcdRespond(&b, &from, mc);
+}
+
+static void tcdThread()
+{
+    unsigned long start = 0, now;
+    unsigned long nextSpd = 0, nextData = 0, nextTrig = 0;
+    bool restarted = !opt.restart;
+    fd_set rfds;
+    struct timeval tv;
+
+    while(tcdRunning) {
+
+        FD_ZERO(&rfds);
+        FD_SET(tcd.sock, &rfds);
+        FD_SET(tcd.mcSock, &rfds);
+        tv.tv_sec = 0;
+        tv.tv_usec = 1000;
+        if(select(std::max(tcd.sock, tcd.mcSock) + 1, &rfds, NULL, NULL, &tv) > 0) {
+            if(FD_ISSET(tcd.sock, &rfds))   tcdRead(tcd.sock, false);
+            if(FD_ISSET(tcd.mcSock, &rfds)) tcdRead(tcd.mcSock, true);
+        }
+
+        now = millis();
+
+        // Only answer requests until the SID is through with booting
+        if(!tcdStreaming)
+            continue;
+        if(!start) {
+            start = nextSpd = nextData = nextTrig = now;
+        }
+
+        if(!restarted && now - start >= (unsigned long)opt.secs * 500) {
+            tcdRestart();
+            restarted = true;
+        }
+
+        if(opt.spdRate) {
+            while((long)(now - nextSpd) >= 0) {
+                tcdSendSpd();
+                nextSpd += 1000 / opt.spdRate;
+            }
+        }
+        if(opt.dataRate) {
+            while((long)(now - nextData) >= 0) {
+                tcdSendData();
+                nextData += 1000 / opt.dataRate;
+            }
+        }
+        // Triggers only once a SID has found us
+        if(tcd.haveClient && opt.trigInt && (long)(now - nextTrig) >= 0) {
+            tcdSendTrigger();
+            nextTrig = now + opt.trigInt;
+        }
+    }
+
+    tcdFlush(&tcd.spd);
+    tcdFlush(&tcd.data);
+}
+
+/*
+ * SID: Receiver
+ */
+
+typedef struct {
+    bttfnBuf buf;
+    uint32_t stamp;             // micros() at arrival
+    uint32_t addr;              // sender
+} rxSlot;
+
+static rxSlot       rxRing[BTTFN_RX_RING];
+static std::atomic<uint32_t> rxHead(0);
+static std::atomic<uint32_t> rxTail(0);
+static bttfnRxStats rxSt;
+static uint32_t     rxEarly = 0;        // multicast before TCD was known
+static int          sidSock = -1;
+static int          sidMcSock = -1;
+
+static bool rxRead(int s, bool mc)
+{
+    struct sockaddr_in from;
+    socklen_t fromLen = sizeof(from);
+    uint32_t head = rxHead.load(std::memory_order_relaxed);
+    uint32_t tcdA;
+    rxSlot *slot;
+    int len;
+
+    if(head - rxTail.load(std::memory_order_acquire) >= BTTFN_RX_RING) {
+        bttfnBuf dummy;
+        if(recv(s, dummy.b, BTTF_PACKET_SIZE, MSG_DONTWAIT) < 0)
+            return false;
+        rxSt.received++;
+        rxSt.dropped++;
+        return true;
+    }
+
+    slot = &rxRing[head & (BTTFN_RX_RING - 1)];
+
+    len = recvfrom(s, slot->buf.b, BTTF_PACKET_SIZE, MSG_DONTWAIT, (struct sockaddr *)&from, &fromLen);
+    if(len < 0)
+        return false;
+
+    slot->stamp = micros();
+    rxSt.received++;
+
+    BttfnPacket pkt(&slot->buf);
+
+    if(len != BTTF_PACKET_SIZE || !pkt.valid()) {
+        rxSt.invalid++;
+        return true;
+    }
+
+    slot->addr = from.sin_addr.s_addr;
+    tcdA = tcdAddr.load(std::memory_order_acquire);
+
+    switch(bttfn_rxSort(pkt, mc, slot->addr, tcdA, false)) {
+    case BTTFN_RX_DROP:
+        if(!tcdA) rxEarly++;
+        return true;
+    case BTTFN_RX_EVENT:
+        rxSt.posted++;
+        return true;
+    }
+
+    rxHead.store(head + 1, std::memory_order_release);
+    sched_wake();
+
+    return true;
+}
+
+static void rxThread()
+{
+    fd_set rfds;
+    struct timeval tv;
+    int t;
+
+    while(sidRunning) {
+        FD_ZERO(&rfds);
+        FD_SET(sidSock, &rfds);
+        FD_SET(sidMcSock, &rfds);
+        tv.tv_sec = 0;
+        tv.tv_usec = 10000;
+        if(select(std::max(sidSock, sidMcSock) + 1, &rfds, NULL, NULL, &tv) <= 0)
+            continue;
+        if(FD_ISSET(sidMcSock, &rfds)) {
+            t = 100;
+            while(rxRead(sidMcSock, true) && t--) {}
+        }
+        if(FD_ISSET(sidSock, &rfds)) {
+            t = 100;
+            while(rxRead(sidSock, false) && t--) {}
+        }
+    }
+}
+
+/*
+ * SID: Main loop
+ */
+
+// What the sequence check should have decided, from what was sent
+typedef struct {
+    uint8_t  epoch;
+    uint32_t maxSeq;
+    bool     resync;
+    uint32_t handled;
+    uint32_t accepted;
+    uint32_t rejected;
+    uint32_t expRejected;
+    uint32_t mismatches;
+    uint32_t resyncLoss;        // rejected after TCD restart
+} seqOracle;
+
+static struct {
+    bttfnClient  cl;
+    uint8_t      reqStatus;
+    bttfnSeq     spdSeq, dataSeq;
+    bttfnRxStats spdSt, dataSt;
+    seqOracle    spdOr, dataOr;
+    uint32_t     session;
+    unsigned long probeNow;
+    uint32_t     polls;
+    uint32_t     discovers;
+    uint32_t     timeouts;
+    uint32_t     newTCD;
+    uint32_t     dataIgnored;       // NOT_DATA before caps known
+    uint32_t     unmarked;
+    std::vector<uint32_t> rtt;
+    std::vector<uint32_t> lat;
+    int          trigRecv;
+    uint32_t     trigMismatch;
+} sid;
+
+// TCD cache scenarios
+typedef struct {
+    bool     ok;
+    unsigned long firstMs;          // until first response
+    unsigned long doneMs;           // until cache state NONE with a TCD
+    uint32_t polls;
+    uint32_t discovers;
+    uint32_t timeouts;
+    uint32_t newTCD;
+} cacheRun;
+
+static void oracleCheck(seqOracle *o, const bttfnBuf *b, uint32_t seq, bool acc)
+{
+    uint8_t epoch = b->b[SIM_OFS + 1];
+    bool exp;
+
+    o->handled++;
+    if(acc) o->accepted++;
+    else    o->rejected++;
+
+    if(epoch != o->epoch) {
+        o->epoch = epoch;
+        o->maxSeq = 0;
+        o->resync = true;
+    }
+
+    if(o->resync) {
+        if(!acc) {
+            o->resyncLoss++;
+            return;
+        }
+        o->resync = false;
+        o->maxSeq = seq;
+        return;
+    }
+
+    // #1 is always taken, the sender might have restarted
+    exp = seq > o->maxSeq || seq == 1;
+    if(!exp) o->expRejected++;
+    if(exp != acc) o->mismatches++;
+    if(seq > o->maxSeq) o->maxSeq = seq;
+}
+
+// Tell receiver which address multicast must come from
+static void sidSetTCD()
+{
+    tcdAddr.store(sid.cl.tcdAddr, std::memory_order_release);
+}
+
+// As BTTFNSendRequest()
+static void sidSendRequest()
+{
+    bttfnBuf b;
+    BttfnPacket pkt(&b);
+    bool discover;
+
+    sid.cl.packetDue = false;
+    sid.cl.updateNow = millis() | 1;
+
+    discover = bttfn_cliDiscover(&sid.cl);
+
+    pkt.init();
+    pkt.setHostname("simsid");
+    pkt.setDevType(BTTFN_TYPE_SID);
+    pkt.setVersion(BTTFN_VERSION | BTTFN_SUP_MC | BTTFN_SUP_ND);
+    pkt.setReqId(bttfn_cliRequest(&sid.cl, millis()));
+    sid.polls++;
+
+    if(discover) {
+        pkt.setFlags(sid.reqStatus | BTTFN_RSP_DISCOVER);
+        pkt.setHostHash(sid.cl.hostHash);
+        sid.discovers++;
+    } else {
+        pkt.setFlags(sid.reqStatus);
+    }
+
+    sid.cl.reqStamp = micros();
+    if(discover) {
+        sendTo(sidSock, &b, inet_addr(MC_GROUP), opt.port + 1);
+    } else {
+        sendTo(sidSock, &b, sid.cl.tcdAddr, opt.port);
+    }
+}
+
+// As bttfn_handleResponse(); of the data, only caps are of interest
+static void sidResponse(rxSlot *slot)
+{
+    BttfnPacket pkt(&slot->buf);
+    uint32_t rtt = slot->stamp - sid.cl.reqStamp;
+
+    switch(bttfn_cliResponse(&sid.cl, pkt, slot->addr, slot->stamp)) {
+    case BTTFN_CLI_IGNORED:
+        return;
+    case BTTFN_CLI_NEWTCD:
+        sidSetTCD();
+        sid.newTCD++;
+        break;
+    }
+
+    sid.rtt.push_back(rtt);
+
+    if(pkt.flags() & BTTFN_RSP_CAPS) {
+        sid.reqStatus &= ~BTTFN_RSP_CAPS;
+        if(pkt.caps() & BTTFN_CAP_MCSPD) sid.reqStatus &= ~BTTFN_RSP_SPEED;
+        sid.cl.supportsNOTData = !!(pkt.caps() & BTTFN_CAP_NOTDATA);
+    }
+}
+
+static void sidHandle(rxSlot *slot)
+{
+    BttfnPacket pkt(&slot->buf);
+    uint32_t seq;
+    bool acc;
+
+    if(!pkt.isNotification()) {
+        sidResponse(slot);
+        return;
+    }
+
+    if(slot->buf.b[SIM_OFS] != SIM_MARKER) {
+        sid.unmarked++;
+        return;
+    }
+
+    // As handle_tcd_notification()
+    if(pkt.isDataNot()) {
+        if(!bttfn_cliNotData(&sid.cl, millis())) {
+            sid.dataIgnored++;
+            return;
+        }
+        if(sid.session != pkt.dataSession()) {
+            bttfn_seqReset(&sid.dataSeq);
+            sid.session = pkt.dataSession();
+        }
+        seq = pkt.dataSeq();
+        acc = bttfn_seqCheck(&sid.dataSeq, seq, &sid.dataSt);
+        oracleCheck(&sid.dataOr, &slot->buf, seq, acc);
+    } else if(pkt.notId() == BTTFN_NOT_SPD) {
+        seq = pkt.spdSeq();
+        acc = bttfn_seqCheck(&sid.spdSeq, seq, &sid.spdSt);
+        oracleCheck(&sid.spdOr, &slot->buf, seq, acc);
+    }
+}
+
+static uint8_t trigEvent(uint8_t notId)
+{
+    switch(notId) {
+    case BTTFN_NOT_PREPARE:  return EVT_PREPARE;
+    case BTTFN_NOT_TT:       return EVT_TT;
+    case BTTFN_NOT_REENTRY:  return EVT_REENTRY;
+    case BTTFN_NOT_ABORT_TT: return EVT_ABORT;
+    }
+    return EVT_NONE;
+}
+
+static void sidLoop()
+{
+    uint32_t tail = rxTail.load(std::memory_order_relaxed);
+    sidEvent ev;
+
+    while(rxHead.load(std::memory_order_acquire) != tail) {
+        sidHandle(&rxRing[tail & (BTTFN_RX_RING - 1)]);
+        rxTail.store(++tail, std::memory_order_release);
+    }
+
+    while(evt_getNext(&ev)) {
+        uint32_t now = micros();
+        int k = sid.trigRecv++;
+        if(k >= trigSent.load() || ev.type != trigEvent(trigType[k])) {
+            sid.trigMismatch++;
+            continue;
+        }
+        if(ev.type == EVT_TT && ev.u.tt.p1 != (k & 0xffff)) {
+            sid.trigMismatch++;
+        }
+        sid.lat.push_back(now - trigStamp[k]);
+    }
+}
+
+// As bttfn_loop(); until ms have passed or done() returns true
+static void sidMain(unsigned long ms, bool (*done)() = NULL)
+{
+    unsigned long start = millis(), now;
+    bool due;
+
+    while((now = millis()) - start < ms) {
+        sidLoop();
+
+        if(done && done())
+            return;
+
+        now |= 1;
+
+        due = sid.cl.packetDue;
+        if(bttfn_cliTimeout(&sid.cl, now)) {
+            // Cached address dropped
+            sidSetTCD();
+        }
+        if(due && !sid.cl.packetDue) sid.timeouts++;
+
+        if(sid.cl.notData) {
+            // Probing for round trip, at opt.probe instead 
+            // of BTTFN_RTT_PROBE_INT
+            if(now - sid.probeNow > (unsigned long)opt.probe) {
+                sid.probeNow = now;
+                sidSendRequest();
+            }
+            if(bttfn_cliDataTimeout(&sid.cl, now)) {
+                bttfn_seqReset(&sid.dataSeq);
+            }
+        } else if(bttfn_cliPollDue(&sid.cl, now)) {
+            sidSendRequest();
+        }
+
+        host_wait(10);
+    }
+}
+
+/*
+ * TCD cache: Boot with a cached address, run until the cache 
+ * state is settled.
+ */
+
+static bool cacheSettled()
+{
+    return sid.cl.tcdAddr && sid.cl.cacheState == BTTFN_CACHE_NONE;
+}
+
+static bool cacheBoot(cacheRun *r, const bttfnCacheEntry *e, unsigned long limit)
+{
+    unsigned long start;
+    uint32_t polls = sid.polls, disc = sid.discovers, to = sid.timeouts, nt = sid.newTCD;
+    size_t rtts = sid.rtt.size();
+
+    bttfn_cliInit(&sid.cl, 0, HOST_HASH);
+    sid.cl.pollInt = POLL_INT;
+    sid.reqStatus = 0x53;
+    if(!bttfn_cliUseCache(&sid.cl, e))
+        return false;
+    sidSetTCD();
+
+    start = millis();
+    r->firstMs = 0;
+    while(!cacheSettled() && millis() - start < limit) {
+        sidMain(10, cacheSettled);
+        if(!r->firstMs && sid.rtt.size() > rtts) {
+            r->firstMs = millis() - start;
+        }
+    }
+    r->doneMs = millis() - start;
+    r->polls = sid.polls - polls;
+    r->discovers = sid.discovers - disc;
+    r->timeouts = sid.timeouts - to;
+    r->newTCD = sid.newTCD - nt;
+
+    return cacheSettled();
+}
+
+static bool cacheTest(cacheRun *gone, cacheRun *valid)
+{
+    const unsigned long limit = (BTTFN_CACHE_TRIES + 2) * BTTFN_RESPONSE_TO;
+    bttfnCacheEntry e;
+
+    memset(&e, 0, sizeof(e));
+    e.hostHash = HOST_HASH;
+    e.ip = inet_addr(DEAD_TCD);
+
+    // Cached TCD gone: BTTFN_CACHE_TRIES timeouts, then DISCOVER
+    gone->ok = cacheBoot(gone, &e, limit) && gone->timeouts == BTTFN_CACHE_TRIES &&
+               gone->discovers == 1 && gone->newTCD == 1 &&
+               bttfn_cliCacheGet(&sid.cl, &e) && e.ip == sid.cl.tcdAddr;
+    if(!gone->ok)
+        return false;
+
+    // Reboot with what was found: Used right away, one DISCOVER
+    // to validate, same TCD
+    valid->ok = cacheBoot(valid, &e, limit) && !valid->timeouts && 
+                valid->polls == 2 && valid->discovers == 1 && !valid->newTCD &&
+                sid.cl.tcdAddr == e.ip;
+
+    return valid->ok;
+}
+
+/*
+ * In-memory processing throughput: valid(), bttfn_rxSort(), 
+ * sequence check, event retrieval; no sockets.
+ */
+
+static void memBench()
+{
+    const int n = 1024;
+    std::vector<bttfnBuf> pkts(n);
+    bttfnRxStats st;
+    bttfnSeq sq;
+    uint32_t x = opt.seed, tcdA = htonl(INADDR_LOOPBACK);
+    uint32_t acc = 0;
+    unsigned long t0, t1;
+    sidEvent ev;
+
+    // 90% NOT_SPD, the rest NOT_DATA, triggers and commands
+    for(int i = 0; i < n; i++) {
+        bttfnBuf *b = &pkts[i];
+        uint32_t r = rnd(&x) % 100;
+        if(r < 90) {
+            tcdInitPkt(b, BTTFN_VERSION | 0x40, BTTFN_NOT_SPD);
+            put16(b, 6, 42);
+            put16(b, 8, BTTFN_SSRC_GPS);
+            put32(b, 12, i + 1);
+        } else if(r < 95) {
+            tcdInitPkt(b, BTTFN_VERSION | 0x40, BTTFN_NOT_DATA | BTTFN_RSP_SPEED);
+            put32(b, 6, i + 1);
+        } else if(r < 98) {
+            tcdInitPkt(b, BTTFN_VERSION | 0x40, BTTFN_NOT_TT);
+            put16(b, 6, ETTO_LEAD);
+        } else {
+            tcdInitPkt(b, BTTFN_VERSION | 0x40, BTTFN_NOT_SID_CMD);
+            put32(b, 6, 6003);
+        }
+        BttfnPacket(b).seal();
+    }
+
+    memset(&st, 0, sizeof(st));
+    bttfn_seqReset(&sq);
+
+    t0 = micros();
+    for(long i = 0; i < opt.memPkts; i++) {
+        BttfnPacket pkt(&pkts[i & (n - 1)]);
+        if(!(i & (n - 1))) {
+            bttfn_seqReset(&sq);
+        }
+        if(!pkt.valid())
+            continue;
+        switch(bttfn_rxSort(pkt, true, tcdA, tcdA, false)) {
+        case BTTFN_RX_EVENT:
+            evt_get(EVQ_BTTFN, &ev);
+            acc++;
+            break;
+        case BTTFN_RX_MAIN:
+            if(!pkt.isDataNot() && pkt.notId() == BTTFN_NOT_SPD) {
+                acc += bttfn_seqCheck(&sq, pkt.spdSeq(), &st);
+            }
+            break;
+        }
+    }
+    t1 = micros();
+
+    printf("In-memory processing (valid, sort, sequence check, events)\n");
+    printf("  %ld packets in %lu ms: %.1f ns/packet, %.2f Mpackets/s (%u acted on)\n",
+           opt.memPkts, (t1 - t0) / 1000,
+           (double)(t1 - t0) * 1000.0 / opt.memPkts,
+           (double)opt.memPkts / (t1 - t0), acc);
+}
+
+/*
+ * Report
+ */
+
+static void printDist(const char *what, std::vector<uint32_t>& v)
+{
+    uint64_t sum = 0;
+
+    if(v.empty()) {
+        printf("%s: no samples\n", what);
+        return;
+    }
+
+    std::sort(v.begin(), v.end());
+    for(uint32_t x : v) sum += x;
+    printf("%s (us)\n  n %zu, avg %llu, p50 %u, p99 %u, max %u\n", what, v.size(),
+           (unsigned long long)(sum / v.size()), v[v.size() / 2], 
+           v[v.size() * 99 / 100], v.back());
+}
+
+static void cacheReport(const char *what, const cacheRun *r)
+{
+    printf("  %-18s %s: first response %lu ms, settled %lu ms; requests %u, DISCOVER %u, timeouts %u\n",
+           what, r->ok ? "ok  " : "FAIL", r->firstMs, r->doneMs, r->polls, r->discovers, r->timeouts);
+}
+
+static bool report(const cacheRun *gone, const cacheRun *valid)
+{
+    const seqOracle *o[2] = { &sid.spdOr, &sid.dataOr };
+    const tcdStream *ts[2] = { &tcd.spd, &tcd.data };
+    const bttfnRxStats *ms[2] = { &sid.spdSt, &sid.dataSt };
+    evtStats es;
+    bool ok = true;
+
+    evt_getStats(EVQ_BTTFN, &es);
+
+    printf("\nTCD cache (%u tries, response timeout %d ms)\n", BTTFN_CACHE_TRIES, BTTFN_RESPONSE_TO);
+    cacheReport("cached TCD gone", gone);
+    cacheReport("cached TCD valid", valid);
+
+    printf("\nReceive path (UDP localhost, multicast %s)\n", MC_GROUP);
+    printf("  received %u, invalid %u, ring full %u, posted as events %u, before discovery %u\n",
+           rxSt.received, rxSt.invalid, rxSt.dropped, rxSt.posted, rxEarly);
+    printf("  event queue: posted %u, dropped %u\n", es.posted, es.dropped);
+
+    printf("\nSequence checks         NOT_SPD   NOT_DATA\n");
+    printf("  sent               %10u %10u\n", ts[0]->sent, ts[1]->sent);
+    printf("  lost (injected)    %10u %10u\n", ts[0]->lost, ts[1]->lost);
+    printf("  late (injected)    %10u %10u\n", ts[0]->reordered, ts[1]->reordered);
+    printf("  checked            %10u %10u\n", o[0]->handled, o[1]->handled);
+    printf("  accepted           %10u %10u\n", o[0]->accepted, o[1]->accepted);
+    printf("  rejected           %10u %10u\n", ms[0]->seqRejected, ms[1]->seqRejected);
+    printf("  expected rejected  %10u %10u\n", o[0]->expRejected, o[1]->expRejected);
+    printf("  gaps counted       %10u %10u\n", ms[0]->seqGaps, ms[1]->seqGaps);
+    printf("  lost to resync     %10u %10u\n", o[0]->resyncLoss, o[1]->resyncLoss);
+    printf("  mismatches         %10u %10u\n", o[0]->mismatches, o[1]->mismatches);
+
+    printf("\nTriggers: sent %d, received %d, mismatches %u\n", 
+           trigSent.load(), sid.trigRecv, sid.trigMismatch);
+    printDist("Notification to event latency", sid.lat);
+    printDist("Request round trip", sid.rtt);
+    printf("  requests %u, answered by TCD %u, NOT_DATA %s\n", sid.polls, tcd.requests,
+           sid.cl.notData ? "on" : "off");
+    printf("  estimate: min %u, smoothed %u, jitter %u, transit delay %u\n",
+           sid.cl.clk.rttMin, sid.cl.clk.srtt, sid.cl.clk.rttVar, sid.cl.clk.delay);
+
+    if(o[0]->mismatches || o[1]->mismatches) {
+        printf("FAIL: Sequence check decisions differ from expected\n");
+        ok = false;
+    }
+    if(o[0]->resyncLoss > BTTFN_SEQ_RESYNC || o[1]->resyncLoss) {
+        printf("FAIL: Too many packets lost after TCD restart\n");
+        ok = false;
+    }
+    if(sid.trigMismatch || sid.trigRecv != trigSent.load() || !trigSent.load()) {
+        printf("FAIL: Trigger notifications missing or out of order\n");
+        ok = false;
+    }
+    if(!gone->ok || !valid->ok) {
+        printf("FAIL: TCD cache\n");
+        ok = false;
+    }
+    if(sid.rtt.empty() || !sid.cl.tcdAddr) {
+        printf("FAIL: TCD not found\n");
+        ok = false;
+    }
+    if(opt.dataRate && !sid.cl.notData) {
+        printf("FAIL: NOT_DATA not taken\n");
+        ok = false;
+    }
+
+    return ok;
+}
+
+static void usage()
+{
+    printf("usage: faketcd [-t secs] [-s spd/s] [-d data/s] [-i trig_ms] [-l loss%%]\n"
+           "               [-r reorder%%] [-P probe_ms] [-n] [-p port] [-S seed] [-m mempkts]\n"
+           "  -n  no TCD restart\n");
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    cacheRun gone, valid;
+    bool ok;
+
+    while((c = getopt(argc, argv, "t:s:d:i:l:r:P:np:S:m:h")) != -1) {
+        switch(c) {
+        case 't': opt.secs = atoi(optarg); break;
+        case 's': opt.spdRate = atoi(optarg); break;
+        case 'd': opt.dataRate = atoi(optarg); break;
+        case 'i': opt.trigInt = atoi(optarg); break;
+        case 'l': opt.loss = atoi(optarg); break;
+        case 'r': opt.reorder = atoi(optarg); break;
+        case 'P': opt.probe = atoi(optarg); break;
+        case 'n': opt.restart = false; break;
+        case 'p': opt.port = atoi(optarg); break;
+        case 'S': opt.seed = strtoul(optarg, NULL, 0); break;
+        case 'm': opt.memPkts = atol(optarg); break;
+        default:  usage(); return 2;
+        }
+    }
+    if(opt.secs < 1 || opt.spdRate < 0 || opt.spdRate > 1000 || opt.dataRate < 0 || 
+       opt.dataRate > 1000 || opt.loss < 0 || opt.reorder < 0 || opt.loss + opt.reorder > 100 ||
+       opt.probe < 1 || !opt.seed) {
+        usage();
+        return 2;
+    }
+
+    tcd.rnd = opt.seed;
+    tcd.spd.seq = tcd.data.seq = 1;
+    tcd.session = rnd(&tcd.rnd);
+    bttfn_seqReset(&sid.spdSeq);
+    bttfn_seqReset(&sid.dataSeq);
+
+    tcd.sock = openSock(opt.port, NULL);
+    tcd.mcSock = openSock(opt.port + 1, MC_GROUP);
+    sidSock = openSock(0, NULL);
+    sidMcSock = openSock(opt.port + 2, MC_GROUP);
+    if(tcd.sock < 0 || tcd.mcSock < 0 || sidSock < 0 || sidMcSock < 0) {
+        perror("faketcd: socket setup");
+        return 2;
+    }
+
+    printf("faketcd: %d s, NOT_SPD %d/s, NOT_DATA %d/s, trigger every %d ms, loss %d%%, late %d%%%s\n",
+           opt.secs, opt.spdRate, opt.dataRate, opt.trigInt, opt.loss, opt.reorder,
+           opt.restart ? ", TCD restart" : "");
+
+    memset(&gone, 0, sizeof(gone));
+    memset(&valid, 0, sizeof(valid));
+
+    std::thread tt(tcdThread);
+    std::thread rt(rxThread);
+
+    cacheTest(&gone, &valid);
+
+    // Fall back to plain DISCOVER if cache test failed
+    if(!sid.cl.tcdAddr) {
+        bttfn_cliInit(&sid.cl, 0, HOST_HASH);
+        sid.cl.pollInt = POLL_INT;
+        sidSetTCD();
+    }
+
+    tcdStreaming = true;
+    sidMain((unsigned long)opt.secs * 1000);
+
+    // Let packets in flight arrive
+    tcdRunning = false;
+    tt.join();
+    sidMain(100);
+    sidRunning = false;
+    rt.join();
+    sidLoop();
+
+    ok = report(&gone, &valid);
+
+    printf("\n");
+    memBench();
+
+    printf("\nResult: %s\n", ok ? "PASS" : "FAIL");
+
+    return ok ? 0 : 1;
+}
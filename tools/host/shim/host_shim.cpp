@@ -0,0 +1,126 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Host build: Arduino shim
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include <time.h>
+#include <unistd.h>
+
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "Arduino.h"
+#include "src/SD/SD.h"
+
+HostSerial Serial;
+
+// No SD card on the host
+SDClass SD;
+bool    haveSD = false;
+
+static uint64_t monoUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Time since start, like on the ESP32; unsigned long is
+// 64 bits here, so this must not wrap during a run.
+static uint64_t nowUs()
+{
+    static uint64_t startUs = monoUs();
+    return monoUs() - startUs + 1000;
+}
+
+unsigned long millis()
+{
+    return (unsigned long)(nowUs() / 1000);
+}
+
+unsigned long micros()
+{
+    return (unsigned long)(uint32_t)nowUs();
+}
+
+void delay(unsigned long ms)
+{
+    usleep(ms * 1000);
+}
+
+uint32_t esp_random()
+{
+    return (uint32_t)random() ^ ((uint32_t)random() << 16);
+}
+
+// Scheduler: Host main loops sleep in host_wait(), which
+// sched_wake() cuts short, like sched_idle() on the ESP32
+static std::mutex              wakeMtx;
+static std::condition_variable wakeCv;
+static bool                    wakeFlag = false;
+
+void sched_wake()
+{
+    {
+        std::lock_guard<std::mutex> lk(wakeMtx);
+        wakeFlag = true;
+    }
+    wakeCv.notify_one();
+}
+
+void host_wait(unsigned long ms)
+{
+    std::unique_lock<std::mutex> lk(wakeMtx);
+    wakeCv.wait_for(lk, std::chrono::milliseconds(ms), [] { return wakeFlag; });
+    wakeFlag = false;
+}
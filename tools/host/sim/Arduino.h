@@ -0,0 +1,140 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Host harness: Arduino/ESP32 shim
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+/*
+ * The test shim (../shim/Arduino.h) plus what the rest of the 
+ * firmware needs from the Arduino core and ESP-IDF to build on
+ * a host: GPIO, FreeRTOS task notifications and semaphores, 
+ * critical sections. Time is the simulated clock, see sim.h.
+ */
+
+#ifndef _SIM_ARDUINO_H
+#define _SIM_ARDUINO_H
+
+#include "../shim/Arduino.h"
+
+#include <math.h>
+#include <ctype.h>
+
+#define HIGH    1
+#define LOW     0
+#define INPUT   0x01
+#define OUTPUT  0x03
+#define INPUT_PULLUP   0x05
+#define INPUT_PULLDOWN 0x09
+#define CHANGE  3
+#define RISING  1
+#define FALLING 2
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define BIT(n)  (1UL << (n))
+
+#define sq(x)   ((x) * (x))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*fn)(void), int mode);
+void detachInterrupt(uint8_t pin);
+
+void esp_restart();
+
+bool     setCpuFrequencyMhz(uint32_t mhz);
+uint32_t getCpuFrequencyMhz();
+
+typedef struct hw_timer_s hw_timer_t;
+
+typedef int esp_err_t;
+#define ESP_OK    0
+#define ESP_FAIL  -1
+
+// FreeRTOS: One task (the loop task), nothing blocks
+typedef void *TaskHandle_t;
+typedef void *SemaphoreHandle_t;
+typedef int   BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              1
+#define portMAX_DELAY       0xffffffffUL
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+
+typedef struct { int dummy; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0 }
+#define portENTER_CRITICAL(m)       ((void)(m))
+#define portEXIT_CRITICAL(m)        ((void)(m))
+#define portENTER_CRITICAL_ISR(m)   ((void)(m))
+#define portEXIT_CRITICAL_ISR(m)    ((void)(m))
+#define portYIELD_FROM_ISR()
+
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t   xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack, 
+                                     void *arg, UBaseType_t prio, TaskHandle_t *handle, BaseType_t core);
+uint32_t     ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+void         xTaskNotifyGive(TaskHandle_t t);
+void         vTaskNotifyGiveFromISR(TaskHandle_t t, BaseType_t *woken);
+void         vTaskDelay(TickType_t ticks);
+UBaseType_t  uxTaskGetStackHighWaterMark(TaskHandle_t t);
+BaseType_t   xPortGetCoreID();
+
+SemaphoreHandle_t xSemaphoreCreateBinary();
+SemaphoreHandle_t xSemaphoreCreateMutex();
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t s);
+
+#endif
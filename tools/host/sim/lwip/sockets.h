@@ -0,0 +1,5 @@
+// Host harness: BSD sockets
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
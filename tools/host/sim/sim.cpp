@@ -0,0 +1,414 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Host harness: Simulated hardware
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <WiFi.h>
+#include "esp_sim.h"
+#include "src/SD/SD.h"
+
+#include "sid_global.h"
+#include "sid_time.h"
+
+#include "sim.h"
+
+HostSerial Serial;
+HostWiFi   WiFi;
+TwoWire    Wire(0);
+TwoWire    Wire1(1);
+
+// No SD card
+SDClass SD;
+bool    haveSD = false;
+
+/*
+ * Time: Everything runs on the simulated clock
+ */
+
+unsigned long millis()
+{
+    return sidSimMillis;
+}
+
+// 32 bits, wraps like on the ESP32
+unsigned long micros()
+{
+    return (uint32_t)(sidSimMillis * 1000);
+}
+
+int64_t esp_timer_get_time()
+{
+    return (int64_t)sidSimMillis * 1000;
+}
+
+void delay(unsigned long ms)
+{
+    sidSimMillis += ms;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    sidSimMillis += ticks;
+}
+
+// Hardware RNG: Reproducible, from sim_seed()
+static uint32_t hwRndState = 0x1985cafe;
+
+void sim_seed(uint32_t seed)
+{
+    hwRndState = seed ? seed : 0x1985cafe;
+}
+
+uint32_t esp_random()
+{
+    uint32_t x = hwRndState;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return (hwRndState = x);
+}
+
+/*
+ * GPIO
+ */
+
+#define SIM_NUM_PINS 40
+
+static uint8_t pinLevel[SIM_NUM_PINS];
+
+void sim_setPin(int pin, int level)
+{
+    if(pin >= 0 && pin < SIM_NUM_PINS) pinLevel[pin] = !!level;
+}
+
+int sim_getPin(int pin)
+{
+    return (pin >= 0 && pin < SIM_NUM_PINS) ? pinLevel[pin] : 0;
+}
+
+void pinMode(uint8_t pin, uint8_t mode)          { }
+void digitalWrite(uint8_t pin, uint8_t val)      { sim_setPin(pin, val); }
+int  digitalRead(uint8_t pin)                    { return sim_getPin(pin); }
+void attachInterrupt(uint8_t pin, void (*fn)(void), int mode) { }
+void detachInterrupt(uint8_t pin)                { }
+
+static uint32_t cpuMhz = 240;
+
+bool setCpuFrequencyMhz(uint32_t mhz)
+{
+    cpuMhz = mhz;
+    return true;
+}
+
+uint32_t getCpuFrequencyMhz()
+{
+    return cpuMhz;
+}
+
+void esp_restart()
+{
+    fprintf(stderr, "sim: esp_restart() at %lu ms\n", sidSimMillis);
+    exit(2);
+}
+
+/*
+ * FreeRTOS: Only the loop task runs; other tasks are not started.
+ * Nothing blocks.
+ */
+
+#define LOOP_TASK ((TaskHandle_t)1)
+#define NET_TASK  ((TaskHandle_t)2)
+
+TaskHandle_t xTaskGetCurrentTaskHandle()                { return LOOP_TASK; }
+BaseType_t   xPortGetCoreID()                           { return 1; }
+uint32_t     ulTaskNotifyTake(BaseType_t c, TickType_t t) { return 0; }
+void         xTaskNotifyGive(TaskHandle_t t)            { }
+void         vTaskNotifyGiveFromISR(TaskHandle_t t, BaseType_t *w) { }
+UBaseType_t  uxTaskGetStackHighWaterMark(TaskHandle_t t) { return 1024; }
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void *), const char *name, uint32_t stack, 
+                                   void *arg, UBaseType_t prio, TaskHandle_t *handle, BaseType_t core)
+{
+    if(handle) *handle = NET_TASK;
+    return pdPASS;
+}
+
+typedef struct {
+    int count;
+} simSem;
+
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return (SemaphoreHandle_t)calloc(1, sizeof(simSem));
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    simSem *s = (simSem *)calloc(1, sizeof(simSem));
+    s->count = 1;
+    return (SemaphoreHandle_t)s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks)
+{
+    simSem *m = (simSem *)s;
+
+    if(!m || !m->count) return pdFALSE;
+    m->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    simSem *m = (simSem *)s;
+
+    if(!m || m->count) return pdFALSE;
+    m->count++;
+    return pdTRUE;
+}
+
+/*
+ * esp_timer (stall detector only; not started by the harness), 
+ * heap, power management
+ */
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+    *handle = (esp_timer_handle_t)args;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) { return ESP_OK; }
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout)   { return ESP_OK; }
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)                           { return ESP_OK; }
+
+size_t    heap_caps_get_free_size(uint32_t caps)             { return 160 * 1024; }
+size_t    heap_caps_get_minimum_free_size(uint32_t caps)     { return 150 * 1024; }
+size_t    heap_caps_get_largest_free_block(uint32_t caps)    { return 100 * 1024; }
+esp_err_t heap_caps_register_failed_alloc_callback(esp_alloc_failed_hook_t cb) { return ESP_OK; }
+
+esp_err_t esp_pm_configure(const void *config)                        { return ESP_OK; }
+esp_err_t esp_sleep_enable_gpio_wakeup()                              { return ESP_OK; }
+esp_err_t gpio_wakeup_enable(gpio_num_t pin, gpio_int_type_t type)    { return ESP_OK; }
+esp_err_t gpio_wakeup_disable(gpio_num_t pin)                         { return ESP_OK; }
+
+/*
+ * I2C: HT16K33 display controllers
+ */
+
+simDisplay simDisp;
+void (*sim_dispChanged)() = NULL;
+
+static simCtrl *findCtrl(uint8_t address)
+{
+    for(int i = 0; i < simDisp.numCtrl; i++) {
+        if(simDisp.ctrl[i].address == address) 
+            return &simDisp.ctrl[i];
+    }
+    if(simDisp.numCtrl == SIM_MAX_CTRL)
+        return NULL;
+
+    simCtrl *c = &simDisp.ctrl[simDisp.numCtrl++];
+    memset(c, 0, sizeof(*c));
+    c->address = address;
+
+    return c;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    _address = address;
+    _len = 0;
+}
+
+size_t TwoWire::write(uint8_t val)
+{
+    if(_len == sizeof(_buf))
+        return 0;
+
+    _buf[_len++] = val;
+
+    return 1;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    simCtrl *c;
+    simCtrl old;
+    uint8_t cmd;
+
+    if(!_len || !(c = findCtrl(_address)))
+        return 2;     // NACK on address
+
+    old = *c;
+    cmd = _buf[0];
+
+    switch(cmd & 0xf0) {
+    case 0x00:        // Display RAM, from address
+        for(int i = 1, a = cmd & 0x0f; i < _len; i++, a = (a + 1) & 0x0f) {
+            c->ram[a] = _buf[i];
+        }
+        break;
+    case 0x20:        // System setup
+        c->oscOn = cmd & 0x01;
+        break;
+    case 0x80:        // Display setup
+        c->dispOn = cmd & 0x01;
+        c->blink = (cmd >> 1) & 0x03;
+        break;
+    case 0xe0:        // Dimming
+        c->dim = cmd & 0x0f;
+        break;
+    }
+
+    simDisp.writes++;
+    simDisp.bytes += _len + 1;
+    if(memcmp(&old, c, sizeof(old))) {
+        simDisp.changes++;
+        if(sim_dispChanged) sim_dispChanged();
+    }
+
+    _len = 0;
+
+    return 0;
+}
+
+/*
+ * I2S microphone: A synthetic signal; a few tones whose levels 
+ * drift slowly, and some noise. Samples are left aligned 18 bit 
+ * like the SPH0645's.
+ */
+
+static int      audioLevel = 100;
+static uint32_t sampleNo = 0;
+static uint32_t noiseState = 0x2545f491;
+
+void sim_setAudio(int level)
+{
+    audioLevel = level;
+}
+
+esp_err_t i2s_driver_install(i2s_port_t port, const i2s_config_t *config, int queueSize, void *queue)
+{
+    return ESP_OK;
+}
+
+esp_err_t i2s_driver_uninstall(i2s_port_t port)                        { return ESP_OK; }
+esp_err_t i2s_set_pin(i2s_port_t port, const i2s_pin_config_t *pins)   { return ESP_OK; }
+esp_err_t i2s_start(i2s_port_t port)                                   { return ESP_OK; }
+esp_err_t i2s_stop(i2s_port_t port)                                    { return ESP_OK; }
+
+esp_err_t i2s_read(i2s_port_t port, void *dest, size_t size, size_t *bytesRead, TickType_t ticks)
+{
+    static const float tones[] = { 80.0f, 250.0f, 700.0f, 1800.0f, 4500.0f, 9000.0f };
+    const int numTones = sizeof(tones) / sizeof(tones[0]);
+    int32_t *s = (int32_t *)dest;
+    size_t n = size / sizeof(int32_t);
+    float t, v, lvl;
+
+    for(size_t i = 0; i < n; i++, sampleNo++) {
+        t = (float)sampleNo / 32000.0f;
+        v = 0.0f;
+        for(int k = 0; k < numTones; k++) {
+            lvl = 0.5f + 0.5f * sinf(2.0f * (float)M_PI * t * (0.13f + 0.07f * k) + k);
+            v += lvl * sinf(2.0f * (float)M_PI * tones[k] * t);
+        }
+        noiseState ^= noiseState << 13;
+        noiseState ^= noiseState >> 17;
+        noiseState ^= noiseState << 5;
+        v += ((int)(noiseState & 0xff) - 128) / 512.0f;
+        s[i] = (int32_t)(v * audioLevel * 40.0f) * 16384;
+    }
+
+    *bytesRead = n * sizeof(int32_t);
+
+    return ESP_OK;
+}
+
+/*
+ * IR: Queue of received codes
+ */
+
+#define SIM_IR_QUEUE 64
+
+static uint32_t irQueue[SIM_IR_QUEUE];
+static int      irHead = 0, irTail = 0;
+
+void sim_irSend(uint32_t hash)
+{
+    int n = (irHead + 1) % SIM_IR_QUEUE;
+
+    if(n == irTail) return;
+
+    irQueue[irHead] = hash;
+    irHead = n;
+}
+
+bool sim_irPending()
+{
+    return irHead != irTail;
+}
+
+bool sim_irReceive(uint32_t *hash)
+{
+    if(irHead == irTail) 
+        return false;
+
+    *hash = irQueue[irTail];
+    irTail = (irTail + 1) % SIM_IR_QUEUE;
+
+    return true;
+}
@@ -0,0 +1,115 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Host harness: Simulated hardware
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+/*
+ * The harness runs the firmware's loop task on the simulated 
+ * clock (SID_SIMCLOCK, sid_time.h). millis(), micros() and 
+ * esp_timer follow it as well, so everything the loop task 
+ * times - sequences, games, SA, display, debounce, power save - 
+ * runs at simulated speed; sched_idle() advances the clock 
+ * instead of sleeping.
+ *
+ * Hardware: 
+ * - Display: HT16K33 controllers on Wire/Wire1, whose display 
+ *   RAM and state are kept here (simDisp)
+ * - IR remote: Codes queued through sim_irSend() are received 
+ *   by IRRemote::loop() one per call
+ * - I2S microphone: A synthetic signal (see sim.cpp)
+ * - GPIO: Levels only; no interrupts. Buttons are never pressed.
+ * - WiFi never connects, settings are the defaults and are 
+ *   never saved, there is no SD card
+ */
+
+#ifndef _SIM_H
+#define _SIM_H
+
+#include <stdint.h>
+
+#define SIM_MAX_CTRL  4
+#define SIM_CTRL_RAM  16     // HT16K33 display RAM, bytes
+
+typedef struct {
+    uint8_t  address;
+    uint8_t  ram[SIM_CTRL_RAM];
+    bool     oscOn;
+    bool     dispOn;
+    uint8_t  blink;
+    uint8_t  dim;             // 0-15
+} simCtrl;
+
+typedef struct {
+    int      numCtrl;
+    simCtrl  ctrl[SIM_MAX_CTRL];
+    uint32_t writes;          // I2C transactions
+    uint32_t bytes;
+    uint32_t changes;         // transactions that changed what is shown
+} simDisplay;
+
+extern simDisplay simDisp;
+
+// Called after every I2C transaction that changed what is shown
+extern void (*sim_dispChanged)();
+
+void sim_irSend(uint32_t hash);
+bool sim_irPending();
+bool sim_irReceive(uint32_t *hash);
+
+void sim_setPin(int pin, int level);
+int  sim_getPin(int pin);
+
+void sim_setAudio(int level);
+
+void sim_seed(uint32_t seed);
+
+#endif
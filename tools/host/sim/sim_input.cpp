@@ -0,0 +1,111 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Host harness: IR remote and buttons
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+/*
+ * Replaces input.cpp: IRRemote receives the codes queued through
+ * sim_irSend() instead of decoding pulses; SIDButton is never 
+ * pressed.
+ */
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#include "input.h"
+#include "sid_mem.h"
+
+#include "sim.h"
+
+IRRemote::IRRemote(uint8_t timerno, uint8_t ir_pin)
+{
+    _timer_no = timerno;
+}
+
+void IRRemote::begin()
+{
+    _hvalue = 0;
+}
+
+// One code per call
+bool IRRemote::loop()
+{
+    return sim_irReceive(&_hvalue);
+}
+
+uint32_t IRRemote::readHash()
+{
+    return _hvalue;
+}
+
+void IRRemote::resume()               { }
+void IRRemote::sleep(bool edgeWake)   { }
+void IRRemote::wake()                 { }
+bool IRRemote::edgeSeen()             { return sim_irPending(); }
+
+void ir_getMemUse(memUse *m)
+{
+    m->staticBytes = sizeof(IRRemote);
+}
+
+SIDButton::SIDButton(const int pin, const bool activeLow, const bool pullupActive, const bool pulldownActive)
+{
+    _pin = pin;
+}
+
+void SIDButton::setTiming(const int dticks, const int pticks, const int lticks) { }
+void SIDButton::attachPress(void (*newFunction)(void))          { _pressFunc = newFunction; }
+void SIDButton::attachLongPressStart(void (*newFunction)(void)) { _longPressStartFunc = newFunction; }
+void SIDButton::attachLongPressStop(void (*newFunction)(void))  { _longPressStopFunc = newFunction; }
+void SIDButton::scan()                { }
+void SIDButton::reset()               { }
@@ -0,0 +1,157 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Host harness: Network task and settings
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+/*
+ * Replaces sid_wifi.cpp and sid_settings.cpp: No network task,
+ * WiFi is never connected; settings are the defaults from 
+ * sid_settings.h and nothing is loaded or saved.
+ */
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#include "sid_settings.h"
+#include "sid_wifi.h"
+#include "sid_mem.h"
+
+struct Settings   settings;
+struct IPSettings ipsettings;
+
+bool FlashROMode = false;
+
+bool wifiSetupDone = true;
+bool wifiIsOff = true;
+bool wifiAPIsOff = true;
+bool wifiInAPMode = false;
+bool carMode = false;
+
+// Network
+
+void wifi_setup()                     { }
+void wifi_loop()                      { }
+void wifi_startTask()                 { }
+bool wifi_isSetupDone()               { return true; }
+bool wifi_staConfigured()             { return false; }
+void wifi_request(uint8_t req)        { }
+void wifiOn(unsigned long newDelay, bool alsoInAPMode, bool deferConfigPortal) { }
+void wifiStartCP()                    { }
+bool updateAvailable()                { return false; }
+void updateConfigPortalStrictValue()  { }
+void updateConfigPortalSAValues()     { }
+void updateConfigPortalIRFBValues()   { }
+bool checkIPConfig()                  { return false; }
+
+bool wifi_getIP(uint8_t& a, uint8_t& b, uint8_t& c, uint8_t& d)
+{
+    a = b = c = d = 0;
+    return false;
+}
+
+bool isIp(char *str)
+{
+    unsigned int a, b, c, d;
+    char e;
+
+    return sscanf(str, "%u.%u.%u.%u%c", &a, &b, &c, &d, &e) == 4 &&
+           a < 256 && b < 256 && c < 256 && d < 256;
+}
+
+void wifi_getMemUse(memUse *m)        { }
+
+// Settings
+
+void settings_setup()                 { }
+void unmount_fs()                     { }
+void write_settings()                 { }
+bool checkConfigExists()              { return false; }
+
+bool evalBool(char *s)
+{
+    return *s != '0';
+}
+
+void saveIRKeys()                     { }
+void deleteIRKeys()                   { }
+void loadBrightness()                 { }
+void storeBrightness()                { }
+void saveBrightness()                 { }
+void loadIRLock()                     { }
+void storeIRLock()                    { }
+void saveIRLock()                     { }
+void loadStrict()                     { }
+void saveStrict()                     { }
+void loadSASettings()                 { }
+void saveSASettings()                 { }
+void loadPosIRFB()                    { }
+void savePosIRFB()                    { }
+void loadIRCFB()                      { }
+void saveIRCFB()                      { }
+void saveUpdAvail()                   { }
+void loadUpdVers(int &v, int& r)      { v = r = 0; }
+void saveUpdVers(int v, int r)        { }
+void saveAllSecCP()                   { }
+void saveCarMode()                    { }
+void loadIdlePat()                    { }
+void storeIdlePat()                   { }
+void saveIdlePat()                    { }
+uint8_t loadBootMode()                { return BOOTM_NORMAL; }
+void storeBootMode(uint8_t bootMode)  { }
+void saveBootMode()                   { }
+bool loadIpSettings()                 { return false; }
+void writeIpSettings()                { }
+void deleteIpSettings()               { }
+bool loadTCDCache(uint8_t *buf, int len) { return false; }
+void saveTCDCache(uint8_t *buf, int len) { }
+void moveSettings()                   { }
@@ -0,0 +1,2 @@
+// Host harness: see esp_sim.h
+#include "../esp_sim.h"
@@ -0,0 +1,489 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Host harness: main_loop() on a simulated clock
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+/*
+ * Runs the firmware's setup() and loop() on the simulated clock 
+ * (SID_SIMCLOCK) with simulated hardware (sim/), driven by a 
+ * scripted IR remote: idle, time travel, idle patterns, spectrum 
+ * analyzer, games, brightness; the script repeats every 10 
+ * simulated minutes, its first 5 minutes cover all of them. 
+ * Hours run in seconds.
+ *
+ * Reports the real cost of every loop() pass (main_loop() and 
+ * bttfn_loop(); sched_idle() only advances the clock), per phase 
+ * of the script, and display traffic.
+ *
+ * Writes a display frame log (-l): One line per change of what 
+ * the display shows, with the simulated time and the state of 
+ * every HT16K33 (on/dimming, display RAM); with -g, compares it 
+ * to a golden log instead.
+ */
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#include <time.h>
+#include <getopt.h>
+
+#include <string>
+
+#include "sid_main.h"
+#include "sid_settings.h"
+#include "sid_wifi.h"
+#include "sid_sched.h"
+#include "sid_task.h"
+#include "sid_time.h"
+
+#include "sim/sim.h"
+
+#define CYCLE_MS      (10*60*1000)
+#define KEY_GAP       250         // ms between keys of a command
+#define BOOT_MS       1000        // clock at boot
+
+// Default IR remote, as in sid_main.cpp
+static const uint32_t irCodes[NUM_IR_KEYS] = {
+    0x97483bfb, 0xe318261b, 0x00511dbb, 0xee886d7f, 0x52a3d41f,
+    0xd7e84b1b, 0x20fe4dbb, 0xf076c13b, 0xa3c8eddb, 0xe5cfbd7f,
+    0xc101e57b, 0xf0c41643, 0x3d9ae3f7, 0x1bc0157b, 0x8c22657b,
+    0x0449e79f, 0x488f3cbb
+};
+
+// Script; one cycle. Keys: 0-9, * #, U D L R (arrows), E (OK)
+typedef struct {
+    uint32_t    at;               // ms into cycle
+    const char *keys;
+    int         phase;
+} step;
+
+enum { PH_IDLE, PH_TT, PH_SA, PH_SIDDLY, PH_SNAKE, PH_NUM };
+
+static const char *phaseNames[PH_NUM] = {
+    "idle", "time travel", "spectrum analyzer", "siddly", "snake"
+};
+
+static const step script[] = {
+    {      0, "",        PH_IDLE   },     // idle pattern 0, strict
+    {  30000, "0",       PH_TT     },
+    {  60000, "*11E",    PH_IDLE   },     // idle pattern 1
+    {  80000, "0",       PH_TT     },
+    { 110000, "*14E",    PH_IDLE   },     // backlot
+    { 130000, "DDD",     PH_IDLE   },     // brightness
+    { 135000, "UUU",     PH_IDLE   },
+    { 140000, "*21E",    PH_SA     },
+    { 170000, "*20E",    PH_IDLE   },
+    { 180000, "*22E",    PH_SIDDLY },
+    { 185000, "LLRUU",   PH_SIDDLY },
+    { 190000, "RRULD0",  PH_SIDDLY },
+    { 195000, "0000",    PH_SIDDLY },
+    { 210000, "9",       PH_IDLE   },
+    { 215000, "*23E",    PH_SNAKE  },
+    { 220000, "LDRU",    PH_SNAKE  },
+    { 228000, "RDLU",    PH_SNAKE  },
+    { 240000, "9",       PH_IDLE   },
+    { 245000, "*15E",    PH_IDLE   },     // identity crisis
+    { 270000, "0",       PH_TT     },
+    // Golden frame log (make test) ends here
+    { 300000, "*60E",    PH_IDLE   },     // strict off
+    { 305000, "*12E",    PH_IDLE   },     // idle pattern 2
+    { 360000, "0",       PH_TT     },
+    { 390000, "*13E",    PH_IDLE   },     // idle pattern 3
+    { 420000, "*21E",    PH_SA     },
+    { 510000, "*20E",    PH_IDLE   },
+    { 515000, "*60E",    PH_IDLE   },     // strict on
+    { 520000, "*10E",    PH_IDLE   },     // idle pattern 0
+    { 560000, "0",       PH_TT     },
+    { 590000, "",        PH_IDLE   }
+};
+#define SCRIPT_STEPS (int)(sizeof(script) / sizeof(script[0]))
+
+static struct {
+    double      secs = 3600.0;
+    uint32_t    seed = 1985;
+    const char *logFile = NULL;
+    const char *goldenFile = NULL;
+} opt;
+
+/*
+ * Frame log
+ */
+
+static FILE          *frameLog = NULL;
+static std::string    golden;
+static size_t         goldenPos = 0;
+static bool           goldenDiff = false;
+static std::string    pending, lastLine;
+static unsigned long  pendingT = 0;
+static bool           havePending = false;
+static uint32_t       frames = 0;
+
+static void dispState(std::string& s)
+{
+    char b[8];
+
+    s.clear();
+    for(int i = 0; i < simDisp.numCtrl; i++) {
+        simCtrl *c = &simDisp.ctrl[i];
+        if(i) s += ' ';
+        if(c->oscOn && c->dispOn) {
+            snprintf(b, sizeof(b), "%x%s:", c->dim, c->blink ? "b" : "");
+            s += b;
+        } else {
+            s += "-:";
+        }
+        for(int j = 0; j < SIM_CTRL_RAM; j++) {
+            snprintf(b, sizeof(b), "%02x", c->ram[j]);
+            s += b;
+        }
+    }
+}
+
+static void logLine(unsigned long t, const std::string& state)
+{
+    char b[16];
+    std::string line;
+
+    if(state == lastLine)
+        return;
+    lastLine = state;
+
+    snprintf(b, sizeof(b), "%lu ", t);
+    line = b + state + "\n";
+    frames++;
+
+    if(frameLog) {
+        fputs(line.c_str(), frameLog);
+    }
+
+    if(opt.goldenFile && !goldenDiff) {
+        if(golden.compare(goldenPos, line.size(), line)) {
+            size_t e = golden.find('\n', goldenPos);
+            goldenDiff = true;
+            printf("Frame %u differs from golden log:\n  got      %s  expected %s\n", 
+                   frames, line.c_str(),
+                   goldenPos < golden.size() ? golden.substr(goldenPos, e - goldenPos + 1).c_str() : "(end)\n");
+        }
+        goldenPos += line.size();
+    }
+}
+
+// Frames written within the same ms are one frame
+static void onDispChanged()
+{
+    unsigned long now = sidMillis();
+
+    if(havePending && now != pendingT) {
+        logLine(pendingT, pending);
+    }
+    dispState(pending);
+    pendingT = now;
+    havePending = true;
+}
+
+static void flushLog()
+{
+    if(havePending) {
+        logLine(pendingT, pending);
+        havePending = false;
+    }
+}
+
+/*
+ * Per-loop cost: Histogram in 100ns buckets up to 100us, beyond 
+ * that in 10us buckets up to 10ms
+ */
+
+#define HIST_FINE   1000
+#define HIST_COARSE 1000
+
+typedef struct {
+    uint64_t passes;
+    uint64_t totalNs;
+    uint64_t maxNs;
+    unsigned long maxAt;
+    uint64_t simMs;
+    uint32_t i2cWrites;
+    uint32_t i2cBytes;
+    uint32_t fine[HIST_FINE];
+    uint32_t coarse[HIST_COARSE + 1];
+} phaseStat;
+
+static phaseStat stats[PH_NUM];
+
+static uint64_t nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void account(phaseStat *p, uint64_t ns)
+{
+    p->passes++;
+    p->totalNs += ns;
+    if(ns > p->maxNs) {
+        p->maxNs = ns;
+        p->maxAt = sidMillis();
+    }
+    if(ns < HIST_FINE * 100) {
+        p->fine[ns / 100]++;
+    } else {
+        p->coarse[min((uint64_t)HIST_COARSE, ns / 10000)]++;
+    }
+}
+
+static uint64_t percentile(const phaseStat *p, double q)
+{
+    uint64_t want = (uint64_t)(p->passes * q), n = 0;
+
+    for(int i = 0; i < HIST_FINE; i++) {
+        if((n += p->fine[i]) > want) return (uint64_t)(i + 1) * 100;
+    }
+    for(int i = 0; i <= HIST_COARSE; i++) {
+        if((n += p->coarse[i]) > want) return (i < HIST_COARSE) ? (uint64_t)(i + 1) * 10000 : p->maxNs;
+    }
+    return p->maxNs;
+}
+
+/*
+ * Script
+ */
+
+static int keyIndex(char k)
+{
+    switch(k) {
+    case '*': return 10;
+    case '#': return 11;
+    case 'U': return 12;
+    case 'D': return 13;
+    case 'L': return 14;
+    case 'R': return 15;
+    case 'E': return 16;
+    }
+    return (k >= '0' && k <= '9') ? k - '0' : -1;
+}
+
+static void report(uint64_t realNs)
+{
+    phaseStat all;
+    double simS = 0;
+
+    memset(&all, 0, sizeof(all));
+
+    printf("\n%-18s %9s %8s %8s %8s %8s %9s %9s %10s\n", 
+           "Phase", "sim s", "loops/s", "avg us", "p50 us", "p99 us", "max us", "(at s)", "I2C B/s");
+    for(int i = 0; i <= PH_NUM; i++) {
+        phaseStat *p = (i < PH_NUM) ? &stats[i] : &all;
+        if(i < PH_NUM) {
+            all.passes += p->passes;
+            all.totalNs += p->totalNs;
+            all.simMs += p->simMs;
+            all.i2cWrites += p->i2cWrites;
+            all.i2cBytes += p->i2cBytes;
+            for(int j = 0; j < HIST_FINE; j++) all.fine[j] += p->fine[j];
+            for(int j = 0; j <= HIST_COARSE; j++) all.coarse[j] += p->coarse[j];
+            if(p->maxNs > all.maxNs) {
+                all.maxNs = p->maxNs;
+                all.maxAt = p->maxAt;
+            }
+        }
+        if(!p->passes || !p->simMs)
+            continue;
+        printf("%-18s %9.0f %8.1f %8.2f %8.1f %8.1f %9.1f %9.1f %10.0f\n", 
+               (i < PH_NUM) ? phaseNames[i] : "all", 
+               p->simMs / 1000.0,
+               p->passes * 1000.0 / p->simMs,
+               p->totalNs / 1000.0 / p->passes,
+               percentile(p, 0.5) / 1000.0,
+               percentile(p, 0.99) / 1000.0,
+               p->maxNs / 1000.0,
+               p->maxAt / 1000.0,
+               p->i2cBytes * 1000.0 / p->simMs);
+    }
+
+    simS = all.simMs / 1000.0;
+    printf("\n%.2f simulated hours in %.2f s real time (%.0fx); %llu loop passes, "
+           "%u display frames logged\n",
+           simS / 3600.0, realNs / 1e9, simS / (realNs / 1e9), 
+           (unsigned long long)all.passes, frames);
+}
+
+static void usage()
+{
+    printf("usage: simloop [-H hours | -t secs] [-s seed] [-l framelog] [-g golden]\n"
+           "  -H  simulated hours to run (default 1)\n"
+           "  -t  simulated seconds to run\n"
+           "  -l  write display frame log\n"
+           "  -g  compare display frame log to golden log\n");
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long endMs, cycleStart, nextKey;
+    uint64_t realStart, t0, ns;
+    int c, stepIdx = 0, phase = PH_IDLE;
+    const char *keys = "";
+    uint32_t w0, b0;
+
+    while((c = getopt(argc, argv, "H:t:s:l:g:h")) != -1) {
+        switch(c) {
+        case 'H': opt.secs = atof(optarg) * 3600.0; break;
+        case 't': opt.secs = atof(optarg); break;
+        case 's': opt.seed = strtoul(optarg, NULL, 0); break;
+        case 'l': opt.logFile = optarg; break;
+        case 'g': opt.goldenFile = optarg; break;
+        default:  usage(); return 2;
+        }
+    }
+    if(opt.secs < 1 || !opt.seed) {
+        usage();
+        return 2;
+    }
+
+    if(opt.logFile && !(frameLog = fopen(opt.logFile, "w"))) {
+        perror(opt.logFile);
+        return 2;
+    }
+    if(opt.goldenFile) {
+        FILE *f = fopen(opt.goldenFile, "r");
+        char buf[4096];
+        size_t n;
+        if(!f) {
+            perror(opt.goldenFile);
+            return 2;
+        }
+        while((n = fread(buf, 1, sizeof(buf), f)) > 0) golden.append(buf, n);
+        fclose(f);
+    }
+
+    sim_seed(opt.seed);
+    sim_dispChanged = onDispChanged;
+
+    // Like setup()
+    sidSimMillis = BOOT_MS;
+    powerupMillis = sidMillis();
+    task_init();
+    main_boot();
+    settings_setup();
+    wifi_setup();
+    wifi_startTask();
+    main_setup();
+    task_setupDone();
+
+    endMs = sidMillis() + (unsigned long)(opt.secs * 1000.0);
+    cycleStart = sidMillis();
+    nextKey = 0;
+
+    printf("simloop: %.0f simulated seconds, seed %u\n", opt.secs, opt.seed);
+
+    realStart = nowNs();
+
+    while(sidMillis() < endMs) {
+        unsigned long now = sidMillis();
+        unsigned long before = now;
+        phaseStat *p;
+
+        // Script
+        if(stepIdx < SCRIPT_STEPS && now - cycleStart >= script[stepIdx].at) {
+            keys = script[stepIdx].keys;
+            phase = script[stepIdx].phase;
+            stepIdx++;
+            nextKey = now;
+        }
+        if(*keys && now >= nextKey) {
+            int k = keyIndex(*keys++);
+            if(k >= 0) sim_irSend(irCodes[k]);
+            nextKey = now + KEY_GAP;
+        }
+        if(stepIdx == SCRIPT_STEPS && now - cycleStart >= CYCLE_MS) {
+            cycleStart += CYCLE_MS;
+            stepIdx = 0;
+        }
+
+        p = &stats[phase];
+        w0 = simDisp.writes;
+        b0 = simDisp.bytes;
+
+        // Like loop()
+        t0 = nowNs();
+        task_parkPoint();
+        main_loop();
+        bttfn_loop();
+        ns = nowNs() - t0;
+
+        sched_idle();
+
+        account(p, ns);
+        p->i2cWrites += simDisp.writes - w0;
+        p->i2cBytes += simDisp.bytes - b0;
+        p->simMs += sidMillis() - before;
+    }
+
+    flushLog();
+
+    report(nowNs() - realStart);
+
+    if(frameLog) fclose(frameLog);
+
+    if(opt.goldenFile) {
+        if(!goldenDiff && goldenPos != golden.size()) {
+            printf("Frame log ends before golden log (%u frames)\n", frames);
+            goldenDiff = true;
+        }
+        printf("\nGolden log %s: %s\n", opt.goldenFile, goldenDiff ? "FAIL" : "PASS");
+        return goldenDiff ? 1 : 0;
+    }
+
+    return 0;
+}
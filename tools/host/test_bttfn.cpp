@@ -0,0 +1,751 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Host tests: BTTFN packet view
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+/*
+ * Wire images of every notification type a TCD sends (and of the
+ * ones the SID sends itself), checked against BttfnPacket.
+ * Checksums in the images were computed independently of 
+ * BttfnPacket::checksum().
+ */
+
+#include <Arduino.h>
+
+#include "sid_bttfn.h"
+
+#include "hosttest.h"
+
+static const uint8_t pktPrepare[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05
+};
+
+// P0 5000, P1 6600
+static const uint8_t pktTT[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x02, 0x88, 0x13, 0xc8, 0x19, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc0
+};
+
+static const uint8_t pktReentry[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07
+};
+
+static const uint8_t pktAbort[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02
+};
+
+static const uint8_t pktAlarm[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01
+};
+
+static const uint8_t pktRefill[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04
+};
+
+// Command 2
+static const uint8_t pktFluxCmd[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x07, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05
+};
+
+// Command 6003
+static const uint8_t pktSidCmd[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x08, 0x73, 0x17, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xcc
+};
+
+// Command 1
+static const uint8_t pktPcgCmd[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x09, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c
+};
+
+static const uint8_t pktWakeup[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
+};
+
+// Command 7
+static const uint8_t pktAuxCmd[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x0b, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c
+};
+
+// Command 9
+static const uint8_t pktVsrCmd[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x0c, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x11
+};
+
+// 42mph from GPS, seq 1000
+static const uint8_t pktSpd[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x0f, 0x2a, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0xe8, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x9d
+};
+
+// TCDI1 EXT|NM, TCDI2 TIMEINFO|BUSY, 2025-10-26 01:21
+static const uint8_t pktInfo[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x10, 0x14, 0x00, 0x01, 0x80, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x07, 0xe9, 0x0a, 0x1a, 0x01, 0x15, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xb3
+};
+
+// NOT_DATA: Date/time, speed 88, status NM|FPO|BUSY, seq 77, 
+// session 0xc0ffee01
+static const uint8_t pktData[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x93, 0x4d, 0x00, 0x00, 0x00, 0x07, 0xe9,
+    0x0a, 0x1a, 0x01, 0x15, 0x00, 0x00, 0x58, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x13, 0x01, 0xee, 0xff, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2f
+};
+
+// Response to request 0x01020304: Date/time, speed -2 (none), 
+// status BUSY|SPDRE, caps MCSPD|REMKP|NOTDATA|SSID
+static const uint8_t pktResp[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x81, 0x53, 0x04, 0x03, 0x02, 0x01, 0x07, 0xe9,
+    0x0a, 0x1a, 0x01, 0x15, 0x00, 0x00, 0xfe, 0xff, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x90, 0x00, 0x00, 0x00, 0x00, 0x59, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x99
+};
+
+// NOT_SID_SA: seq 5, 10 bands, range 31
+static const uint8_t pktSA[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x40, 0x05, 0x00, 0x00, 0x00, 0x02, 0x0a,
+    0x1f, 0xe3, 0xb0, 0xf9, 0x41, 0x78, 0x36, 0x95, 0xe4, 0xe6, 0x17, 0x23,
+    0xe6, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3b
+};
+static const uint8_t saVals[20] = {
+    3, 7, 12, 19, 31, 0, 1, 15, 22, 9,      // heights
+    5, 9, 14, 19, 31, 2, 3, 17, 25, 11      // peaks
+};
+
+// NOT_SID_SA as sent by a SID with the default 20 LEDs per bar:
+// seq 6, 10 bands, range 20
+static const uint8_t pktSA20[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x40, 0x06, 0x00, 0x00, 0x00, 0x02, 0x0a,
+    0x14, 0x81, 0xa4, 0x46, 0xa9, 0x38, 0x0b, 0x82, 0x81, 0xd8, 0x9c, 0xc1,
+    0xa8, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xee
+};
+static const int saHeights20[10] = {
+    1, 4, 9, 13, 20, 20, 2, 7, 11, 16
+};
+static const uint8_t saPeaks20[10] = {
+    0, 3, 8, 12, 19, 19, 1, 6, 10, 15
+};
+
+// NOT_SID_MIRROR: frame 123456, bl 14, sbl 37, var 20, 
+// flags 0x84, seed 0xdeadbeef, seq time 98765, way up
+static const uint8_t pktMirror[BTTF_PACKET_SIZE] = {
+    0x42, 0x54, 0x54, 0x46, 0x41, 0x41, 0x40, 0xe2, 0x01, 0x00, 0x02, 0x0a,
+    0x0e, 0x25, 0x14, 0x84, 0x00, 0xef, 0xbe, 0xad, 0xde, 0xcd, 0x81, 0x01,
+    0x00, 0x01, 0x80, 0xa4, 0x36, 0xa5, 0x38, 0x0b, 0x02, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf7
+};
+static const uint8_t mirHeights[BTTFN_MIR_BARS] = {
+    0, 4, 9, 13, 19, 18, 2, 7, 11, 16
+};
+
+static void load(bttfnBuf *buf, const uint8_t *img)
+{
+    memcpy(buf->b, img, BTTF_PACKET_SIZE);
+}
+
+// Valid notification with given id, not NOT_DATA
+static void checkNot(const uint8_t *img, uint8_t id)
+{
+    bttfnBuf buf;
+    BttfnPacket pkt(&buf);
+
+    load(&buf, img);
+    CHECK(pkt.valid());
+    CHECK(pkt.isNotification());
+    CHECK(!pkt.isResponse());
+    CHECK(!pkt.isDataNot());
+    CHECK_EQ(pkt.notId(), id);
+}
+
+static void test_simpleNots()
+{
+    checkNot(pktPrepare, BTTFN_NOT_PREPARE);
+    checkNot(pktReentry, BTTFN_NOT_REENTRY);
+    checkNot(pktAbort, BTTFN_NOT_ABORT_TT);
+    checkNot(pktAlarm, BTTFN_NOT_ALARM);
+    checkNot(pktRefill, BTTFN_NOT_REFILL);
+    checkNot(pktWakeup, BTTFN_NOT_WAKEUP);
+}
+
+static void test_tt()
+{
+    bttfnBuf buf;
+    BttfnPacket pkt(&buf);
+
+    checkNot(pktTT, BTTFN_NOT_TT);
+    load(&buf, pktTT);
+    CHECK_EQ(pkt.ttP0(), 5000);
+    CHECK_EQ(pkt.ttP1(), 6600);
+}
+
+static void test_commands()
+{
+    bttfnBuf buf;
+    BttfnPacket pkt(&buf);
+
+    checkNot(pktSidCmd, BTTFN_NOT_SID_CMD);
+    load(&buf, pktSidCmd);
+    CHECK_EQ(pkt.command(), 6003);
+
+    // Commands for other devices
+    checkNot(pktFluxCmd, BTTFN_NOT_FLUX_CMD);
+    load(&buf, pktFluxCmd);
+    CHECK_EQ(pkt.command(), 2);
+    checkNot(pktPcgCmd, BTTFN_NOT_PCG_CMD);
+    load(&buf, pktPcgCmd);
+    CHECK_EQ(pkt.command(), 1);
+    checkNot(pktAuxCmd, BTTFN_NOT_AUX_CMD);
+    load(&buf, pktAuxCmd);
+    CHECK_EQ(pkt.command(), 7);
+    checkNot(pktVsrCmd, BTTFN_NOT_VSR_CMD);
+    load(&buf, pktVsrCmd);
+    CHECK_EQ(pkt.command(), 9);
+}
+
+static void test_spd()
+{
+    bttfnBuf buf;
+    BttfnPacket pkt(&buf);
+
+    checkNot(pktSpd, BTTFN_NOT_SPD);
+    load(&buf, pktSpd);
+    CHECK_EQ(pkt.spdSpeed(), 42);
+    CHECK_EQ(pkt.spdSource(), BTTFN_SSRC_GPS);
+    CHECK_EQ(pkt.spdSeq(), 1000);
+}
+
+static void test_info()
+{
+    const uint8_t dt[8] = { 0x07, 0xe9, 0x0a, 0x1a, 0x01, 0x15, 0x00, 0x00 };
+    bttfnBuf buf;
+    BttfnPacket pkt(&buf);
+
+    checkNot(pktInfo, BTTFN_NOT_INFO);
+    load(&buf, pktInfo);
+    CHECK_EQ(pkt.info1(), BTTFN_TCDI1_EXT | BTTFN_TCDI1_NM);
+    CHECK_EQ(pkt.info2(), BTTFN_TCDI2_TIMEINFO | BTTFN_TCDI2_BUSY);
+    CHECK(!memcmp(pkt.infoDateTime(), dt, 8));
+}
+
+static void test_data()
+{
+    const uint8_t dt[8] = { 0x07, 0xe9, 0x0a, 0x1a, 0x01, 0x15, 0x00, 0x00 };
+    bttfnBuf buf;
+    BttfnPacket pkt(&buf);
+
+    load(&buf, pktData);
+    CHECK(pkt.valid());
+    CHECK(pkt.isNotification());
+    CHECK(pkt.isDataNot());
+    CHECK_EQ(pkt.flags() & ~BTTFN_NOT_DATA, BTTFN_RSP_DATETIME | BTTFN_RSP_SPEED | BTTFN_RSP_STATUS);
+    CHECK_EQ(pkt.dataSeq(), 77);
+    CHECK_EQ(pkt.dataSession(), 0xc0ffee01);
+    CHECK_EQ(pkt.speed(), 88);
+    CHECK_EQ(pkt.status(), BTTFN_STAT_NM | BTTFN_STAT_FPO | BTTFN_STAT_BUSY);
+    CHECK(!memcmp(pkt.dateTime(), dt, 8));
+}
+
+static void test_response()
+{
+    bttfnBuf buf;
+    BttfnPacket pkt(&buf);
+
+    load(&buf, pktResp);
+    CHECK(pkt.valid());
+    CHECK(pkt.isResponse());
+    CHECK(!pkt.isNotification());
+    CHECK_EQ(pkt.reqId(), 0x01020304);
+    CHECK_EQ(pkt.flags(), 0x53);
+    CHECK_EQ(pkt.speed(), -2);
+    CHECK_EQ(pkt.status(), BTTFN_STAT_BUSY | BTTFN_STAT_SPDRE);
+    CHECK_EQ(pkt.caps(), BTTFN_CAP_MCSPD | BTTFN_CAP_REMKP | BTTFN_CAP_NOTDATA | BTTFN_CAP_SSID);
+}
+
+static void test_sa()
+{
+    bttfnBuf buf, out;
+    BttfnPacket pkt(&buf), opkt(&out);
+
+    checkNot(pktSA, BTTFN_NOT_SID_SA);
+    load(&buf, pktSA);
+    CHECK_EQ(pkt.reqId(), 5);
+    CHECK_EQ(pkt.saNumBands(), 10);
+    CHECK_EQ(pkt.saRange(), BTTFN_SA_MAXVAL);
+    for(int i = 0; i < 20; i++) {
+        CHECK_EQ(pkt.saValue(i), saVals[i]);
+    }
+
+    // Built by hand from the header fields, byte-identical
+    opkt.init();
+    opkt.setVersion(BTTFN_VERSION | 0x40);
+    opkt.setFlags(BTTFN_NOT_SID_SA);
+    opkt.setSAHeader(10, BTTFN_SA_MAXVAL);
+    opkt.setSeq(5);
+    opkt.setSAValues(saVals, 20);
+    CHECK(opkt.valid());
+    CHECK(!memcmp(out.b, pktSA, BTTF_PACKET_SIZE));
+
+    // Default SID: Range is the bar height, not the 5-bit maximum
+    checkNot(pktSA20, BTTFN_NOT_SID_SA);
+    load(&buf, pktSA20);
+    CHECK_EQ(pkt.saNumBands(), 10);
+    CHECK_EQ(pkt.saRange(), 20);
+    for(int i = 0; i < 10; i++) {
+        CHECK_EQ(pkt.saValue(i), saHeights20[i]);
+        CHECK_EQ(pkt.saValue(10 + i), saPeaks20[i]);
+    }
+
+    // Built by bttfn_saFrame()'s bttfn_saBuild(), byte-identical
+    memset(&out, 0, sizeof(out));
+    bttfn_saBuild(&out, 6, saHeights20, saPeaks20, 10, 20);
+    CHECK(opkt.valid());
+    CHECK(!memcmp(out.b, pktSA20, BTTF_PACKET_SIZE));
+}
+
+static void test_mirror()
+{
+    bttfnBuf buf, out;
+    BttfnPacket pkt(&buf), opkt(&out);
+
+    checkNot(pktMirror, BTTFN_NOT_SID_MIRROR);
+    load(&buf, pktMirror);
+    CHECK_EQ(pkt.mirFrame(), 123456);
+    CHECK_EQ(pkt.mirNumBars(), BTTFN_MIR_BARS);
+    CHECK_EQ(pkt.mirBaseLine(), 14);
+    CHECK_EQ(pkt.mirStrictBL(), 37);
+    CHECK_EQ(pkt.mirVariation(), 20);
+    CHECK_EQ(pkt.mirFlags(), 0x84);
+    CHECK_EQ(pkt.mirSeed(), 0xdeadbeef);
+    CHECK_EQ(pkt.mirSeqTime(), 98765);
+    CHECK(pkt.mirWayUp());
+    for(int i = 0; i < BTTFN_MIR_BARS; i++) {
+        CHECK_EQ(pkt.mirHeight(i), mirHeights[i]);
+    }
+
+    // Built like bttfn_mirSend() does, byte-identical
+    opkt.init();
+    opkt.setVersion(BTTFN_VERSION | 0x40);
+    opkt.setFlags(BTTFN_NOT_SID_MIRROR);
+    opkt.setSeq(123456);
+    opkt.setMirState(14, 37, 20, 0x84, true);
+    opkt.setMirSeed(0xdeadbeef);
+    opkt.setMirSeqTime(98765);
+    opkt.setMirHeights(mirHeights, BTTFN_MIR_BARS);
+    CHECK(opkt.valid());
+    CHECK(!memcmp(out.b, pktMirror, BTTF_PACKET_SIZE));
+}
+
+// Any corrupted byte or wrong header must be rejected
+static void test_invalid()
+{
+    const uint8_t *imgs[] = {
+        pktPrepare, pktTT, pktSpd, pktInfo, pktData, pktResp, pktSA, pktMirror
+    };
+    bttfnBuf buf;
+    BttfnPacket pkt(&buf);
+
+    for(unsigned int n = 0; n < sizeof(imgs) / sizeof(imgs[0]); n++) {
+        for(int i = 0; i < BTTF_PACKET_SIZE; i++) {
+            load(&buf, imgs[n]);
+            buf.b[i] ^= 0x10;
+            CHECK(!pkt.valid());
+        }
+    }
+}
+
+// Setters keep the checksum valid incrementally
+static void test_setters()
+{
+    bttfnBuf buf;
+    BttfnPacket pkt(&buf);
+    uint32_t x = 1985;
+
+    pkt.init();
+    CHECK(pkt.valid());
+    for(int i = 0; i < 10000; i++) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        switch(x % 6) {
+        case 0: pkt.setVersion(x >> 8); break;
+        case 1: pkt.setFlags(x >> 8); break;
+        case 2: pkt.setReqId(x); break;
+        case 3: pkt.setHostname((x & 0x100) ? "sid" : "verylonghostname"); break;
+        case 4: pkt.setCommand(x >> 8, x >> 16, x >> 24); break;
+        case 5: pkt.setRemID(x); break;
+        }
+        if(!pkt.valid()) break;
+    }
+    CHECK(pkt.valid());
+    pkt.setHostname("verylonghostname");
+    CHECK_EQ(buf.b[10+12], '.');
+}
+
+/*
+ * Client state (bttfn_cli*())
+ */
+
+#define TCD_A   0x0100007f
+#define TCD_B   0x0200007f
+
+// Response to the client's current request
+static void cliRsp(bttfnBuf *buf, const bttfnClient *c, uint8_t flags, int16_t spd, uint8_t st, uint8_t caps)
+{
+    BttfnPacket pkt(buf);
+
+    pkt.init();
+    pkt.setVersion(BTTFN_VERSION | 0x80);
+    pkt.setFlags(flags);
+    pkt.setReqId(c->reqId);
+    buf->b[18] = spd; buf->b[19] = spd >> 8;
+    buf->b[26] = st;
+    buf->b[31] = caps;
+    pkt.seal();
+}
+
+static void test_clientDiscover()
+{
+    bttfnClient c;
+    bttfnCacheEntry e;
+    bttfnBuf buf;
+    BttfnPacket pkt(&buf);
+    unsigned long now = 1000;
+
+    // By IP: No DISCOVER, nothing to cache
+    bttfn_cliInit(&c, TCD_A, 0);
+    CHECK(!bttfn_cliDiscover(&c));
+    CHECK(!bttfn_cliCacheGet(&c, &e));
+
+    // By hostname: DISCOVER
+    bttfn_cliInit(&c, 0, 0x1234);
+    CHECK(bttfn_cliDiscover(&c));
+    CHECK(bttfn_cliPollDue(&c, now));
+    CHECK_EQ(bttfn_cliRequest(&c, now), now);
+    CHECK(!bttfn_cliPollDue(&c, now + 5000));
+    c.reqStamp = 500;
+
+    // Wrong ID, or not a response: ignored
+    cliRsp(&buf, &c, BTTFN_RSP_DISCOVER, 0, 0, 0);
+    pkt.setReqId(now + 1);
+    CHECK_EQ(bttfn_cliResponse(&c, pkt, TCD_A, 900), BTTFN_CLI_IGNORED);
+    cliRsp(&buf, &c, BTTFN_RSP_DISCOVER, 0, 0, 0);
+    pkt.setVersion(BTTFN_VERSION | 0x40);
+    CHECK_EQ(bttfn_cliResponse(&c, pkt, TCD_A, 900), BTTFN_CLI_IGNORED);
+    CHECK(c.packetDue);
+
+    cliRsp(&buf, &c, BTTFN_RSP_DISCOVER, 0, 0, 0);
+    CHECK_EQ(bttfn_cliResponse(&c, pkt, TCD_A, 900), BTTFN_CLI_NEWTCD);
+    CHECK_EQ(c.tcdAddr, TCD_A);
+    CHECK(!c.packetDue);
+    CHECK(c.cacheDirty);
+    CHECK(!bttfn_cliDiscover(&c));
+    CHECK(bttfn_cliCacheGet(&c, &e));
+    CHECK(!c.cacheDirty);
+    CHECK_EQ(e.hostHash, 0x1234);
+    CHECK_EQ(e.ip, TCD_A);
+    // Round trip of DISCOVER not used; estimate restarts with new TCD
+    CHECK_EQ(c.clk.samples, 0);
+
+    // Cache: Entry for other host or without address not used
+    bttfn_cliInit(&c, 0, 0x1234);
+    e.hostHash = 0x4321;
+    CHECK(!bttfn_cliUseCache(&c, &e));
+    e.hostHash = 0x1234;
+    e.ip = 0;
+    CHECK(!bttfn_cliUseCache(&c, &e));
+    CHECK(bttfn_cliDiscover(&c));
+
+    // Cached TCD answers: Validate by DISCOVER, keep it
+    e.ip = TCD_A;
+    CHECK(bttfn_cliUseCache(&c, &e));
+    CHECK_EQ(c.cacheState, BTTFN_CACHE_TRY);
+    CHECK(!bttfn_cliDiscover(&c));
+    CHECK(!bttfn_cliCacheGet(&c, &e));
+    bttfn_cliRequest(&c, ++now);
+    cliRsp(&buf, &c, 0x53, 0, 0, 0);
+    CHECK_EQ(bttfn_cliResponse(&c, pkt, TCD_A, 0), BTTFN_CLI_OK);
+    CHECK_EQ(c.cacheState, BTTFN_CACHE_VALIDATE);
+    CHECK(bttfn_cliDiscover(&c));
+    bttfn_cliRequest(&c, ++now);
+    cliRsp(&buf, &c, BTTFN_RSP_DISCOVER | 0x13, 0, 0, 0);
+    CHECK_EQ(bttfn_cliResponse(&c, pkt, TCD_A, 0), BTTFN_CLI_OK);
+    CHECK_EQ(c.cacheState, BTTFN_CACHE_NONE);
+    CHECK_EQ(c.tcdAddr, TCD_A);
+    CHECK(!bttfn_cliDiscover(&c));
+
+    // Cached address answers, but DISCOVER finds TCD elsewhere
+    bttfn_cliInit(&c, 0, 0x1234);
+    CHECK(bttfn_cliUseCache(&c, &e));
+    bttfn_cliRequest(&c, ++now);
+    cliRsp(&buf, &c, 0x13, 0, 0, 0);
+    bttfn_cliResponse(&c, pkt, TCD_A, 0);
+    bttfn_cliRequest(&c, ++now);
+    cliRsp(&buf, &c, BTTFN_RSP_DISCOVER | 0x13, 0, 0, 0);
+    CHECK_EQ(bttfn_cliResponse(&c, pkt, TCD_B, 0), BTTFN_CLI_NEWTCD);
+    CHECK_EQ(c.tcdAddr, TCD_B);
+    CHECK_EQ(c.cacheState, BTTFN_CACHE_NONE);
+}
+
+static void test_clientTimeout()
+{
+    bttfnClient c;
+    bttfnCacheEntry e;
+    unsigned long now = 1000;
+
+    // Cached TCD does not answer: Dropped after BTTFN_CACHE_TRIES
+    bttfn_cliInit(&c, 0, 0x1234);
+    memset(&e, 0, sizeof(e));
+    e.hostHash = 0x1234;
+    e.ip = TCD_A;
+    CHECK(bttfn_cliUseCache(&c, &e));
+    for(int i = 1; i <= BTTFN_CACHE_TRIES; i++) {
+        c.updateNow = now;
+        bttfn_cliRequest(&c, now);
+        CHECK(!bttfn_cliTimeout(&c, now + BTTFN_RESPONSE_TO));
+        CHECK(c.packetDue);
+        now += BTTFN_RESPONSE_TO + 1;
+        if(i < BTTFN_CACHE_TRIES) {
+            CHECK(!bttfn_cliTimeout(&c, now));
+            CHECK_EQ(c.failCount, i);
+            CHECK_EQ(c.tcdAddr, TCD_A);
+            // New request right away
+            CHECK(bttfn_cliPollDue(&c, now));
+        } else {
+            CHECK(bttfn_cliTimeout(&c, now));
+        }
+        CHECK(!c.packetDue);
+    }
+    CHECK_EQ(c.tcdAddr, 0);
+    CHECK_EQ(c.cacheState, BTTFN_CACHE_NONE);
+    CHECK_EQ(c.failCount, 0);
+    CHECK(bttfn_cliDiscover(&c));
+
+    // TCD by IP: Never dropped; after 10 timeouts, poll interval
+    bttfn_cliInit(&c, TCD_A, 0);
+    for(int i = 0; i < 12; i++) {
+        c.updateNow = now;
+        bttfn_cliRequest(&c, now);
+        now += BTTFN_RESPONSE_TO + 1;
+        CHECK(!bttfn_cliTimeout(&c, now));
+    }
+    CHECK_EQ(c.failCount, 10);
+    CHECK_EQ(c.tcdAddr, TCD_A);
+    CHECK(!bttfn_cliPollDue(&c, now));
+    CHECK(bttfn_cliPollDue(&c, now + BTTFN_POLL_INT));
+
+    // No timeouts while on NOT_DATA
+    bttfn_cliInit(&c, TCD_A, 0x1234);
+    CHECK(!bttfn_cliNotData(&c, now));
+    c.supportsNOTData = true;
+    CHECK(bttfn_cliNotData(&c, now));
+    bttfn_cliRequest(&c, now);
+    CHECK(!bttfn_cliTimeout(&c, now + 10000));
+    CHECK(c.packetDue);
+    CHECK(!bttfn_cliPollDue(&c, now + 100000));
+
+    // NOT_DATA timeout: Polling, keep TCD, but validate it
+    CHECK(!bttfn_cliDataTimeout(&c, now + BTTFN_DATA_TO));
+    CHECK(bttfn_cliDataTimeout(&c, now + BTTFN_DATA_TO + 1));
+    CHECK(!c.notData);
+    CHECK_EQ(c.cacheState, BTTFN_CACHE_TRY);
+    CHECK_EQ(c.tcdAddr, TCD_A);
+    CHECK(!bttfn_cliDataTimeout(&c, now + 2 * BTTFN_DATA_TO));
+}
+
+static void test_clientPoll()
+{
+    bttfnClient c;
+    bttfnBuf buf;
+    BttfnPacket pkt(&buf);
+    unsigned long now = 1000;
+
+    bttfn_cliInit(&c, TCD_A, 0);
+    CHECK_EQ(bttfn_cliPollInt(&c), BTTFN_POLL_INT);
+
+    // Unchanged data: Doubled with each response, up to max
+    for(int i = 0; i <= BTTFN_POLL_SHIFT_MAX + 2; i++) {
+        bttfn_cliRequest(&c, now++);
+        cliRsp(&buf, &c, BTTFN_RSP_SPEED | BTTFN_RSP_STATUS, 42, BTTFN_STAT_NM, 0);
+        bttfn_cliResponse(&c, pkt, TCD_A, 0);
+        CHECK_EQ(c.pollShift, min(i, BTTFN_POLL_SHIFT_MAX));
+    }
+    CHECK_EQ(bttfn_cliPollInt(&c), BTTFN_POLL_INT << BTTFN_POLL_SHIFT_MAX);
+
+    // Change snaps back; date/time does not count
+    bttfn_cliRequest(&c, now++);
+    cliRsp(&buf, &c, BTTFN_RSP_SPEED | BTTFN_RSP_STATUS, 43, BTTFN_STAT_NM, 0);
+    bttfn_cliResponse(&c, pkt, TCD_A, 0);
+    CHECK_EQ(c.pollShift, 0);
+    bttfn_cliRequest(&c, now++);
+    cliRsp(&buf, &c, BTTFN_RSP_SPEED | BTTFN_RSP_STATUS | BTTFN_RSP_DATETIME, 43, BTTFN_STAT_NM, 0);
+    buf.b[10] = 0x55;
+    pkt.seal();
+    bttfn_cliResponse(&c, pkt, TCD_A, 0);
+    CHECK_EQ(c.pollShift, 1);
+
+    // Timeout snaps back, too
+    bttfn_cliRequest(&c, now);
+    bttfn_cliTimeout(&c, now + BTTFN_RESPONSE_TO + 1);
+    CHECK_EQ(c.pollShift, 0);
+
+    // TCD pushes changes: Stretched right away
+    c.supportsNOTData = true;
+    bttfn_cliRequest(&c, now++);
+    cliRsp(&buf, &c, BTTFN_RSP_SPEED, 10, 0, 0);
+    bttfn_cliResponse(&c, pkt, TCD_A, 0);
+    CHECK_EQ(c.pollShift, BTTFN_POLL_SHIFT_MAX);
+
+    // Fast polling is not stretched
+    c.pollInt = BTTFN_POLL_INT / 2;
+    CHECK_EQ(bttfn_cliPollInt(&c), BTTFN_POLL_INT / 2);
+    c.updateNow = now;
+    CHECK(!bttfn_cliPollDue(&c, now + BTTFN_POLL_INT / 2));
+    CHECK(bttfn_cliPollDue(&c, now + BTTFN_POLL_INT / 2 + 1));
+}
+
+static void test_clientRtt()
+{
+    static const uint32_t rtt[12] = { 900, 400, 700, 300, 1200, 500, 600, 800, 1000, 1100, 950, 1300 };
+    bttfnClient c;
+    bttfnBuf buf;
+    BttfnPacket pkt(&buf);
+    uint32_t mn;
+
+    bttfn_cliInit(&c, TCD_A, 0);
+
+    for(int i = 0; i < 12; i++) {
+        bttfn_cliRequest(&c, 1000 + i);
+        c.reqStamp = 0x80000000 + i * 1000000;
+        cliRsp(&buf, &c, BTTFN_RSP_STATUS, 0, 0, 0);
+        CHECK_EQ(bttfn_cliResponse(&c, pkt, TCD_A, c.reqStamp + rtt[i]), BTTFN_CLI_OK);
+        // Minimum of last BTTFN_RTT_SAMPLES
+        mn = rtt[i];
+        for(int j = max(0, i - BTTFN_RTT_SAMPLES + 1); j <= i; j++) mn = min(mn, rtt[j]);
+        CHECK_EQ(c.clk.rtt, rtt[i]);
+        CHECK_EQ(c.clk.rttMin, mn);
+        CHECK_EQ(c.clk.delay, mn / 2);
+    }
+    CHECK_EQ(c.clk.samples, 12);
+    CHECK(c.clk.srtt > 700 && c.clk.srtt < 1100);
+    CHECK(c.clk.rttVar > 0);
+
+    // Stamp wraps
+    bttfn_cliRttReset(&c);
+    bttfn_cliRequest(&c, 2000);
+    c.reqStamp = 0xffffff00;
+    cliRsp(&buf, &c, BTTFN_RSP_STATUS, 0, 0, 0);
+    bttfn_cliResponse(&c, pkt, TCD_A, 0x100);
+    CHECK_EQ(c.clk.samples, 1);
+    CHECK_EQ(c.clk.rtt, 0x200);
+    CHECK_EQ(c.clk.srtt, 0x200);
+    CHECK_EQ(c.clk.rttVar, 0x100);
+}
+
+int main()
+{
+    RUN(test_simpleNots);
+    RUN(test_tt);
+    RUN(test_commands);
+    RUN(test_spd);
+    RUN(test_info);
+    RUN(test_data);
+    RUN(test_response);
+    RUN(test_sa);
+    RUN(test_mirror);
+    RUN(test_invalid);
+    RUN(test_setters);
+    RUN(test_clientDiscover);
+    RUN(test_clientTimeout);
+    RUN(test_clientPoll);
+    RUN(test_clientRtt);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,429 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Host tests: Idle pattern mirroring
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+/*
+ * Two units in one process, a leader and a follower, each with 
+ * its own idle state and PRNG state. The leader builds mirror 
+ * frames with idle_mirBuild() and renders with idle_bars() like
+ * bttfn_mirSend() and showIdleFrame(); the follower takes every 
+ * frame that gets through with bttfn_mirAccept(), idle_mirApply()
+ * and idle_bars() like bttfn_mirReceive() and bttfn_mirShow(). 
+ * Both log their bars; the logs must be identical for every 
+ * received frame, and the follower's own PRNG state must be 
+ * untouched.
+ */
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#include "sid_bttfn.h"
+#include "sid_idle.h"
+#include "sid_seq.h"
+#include "sid_time.h"
+
+#include "hosttest.h"
+
+#define TEST_FRAMES   2000
+#define LOSS_PCT      10
+
+#define LEADER_ADDR   0x0a000001
+#define OTHER_ADDR    0x0a000002
+
+// Strict frames, like the TT sequence
+static const uint8_t strictData[] = {
+    SEQ_HDR(6, 0),
+    SEQ_FRM(0, 0,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1),
+    SEQ_FRM(0, 0,  3,  4,  2,  5,  3,  4,  5,  2,  4,  3),
+    SEQ_FRM(0, 0,  7,  8,  5,  9,  6,  8,  9,  4,  8,  7),
+    SEQ_FRM(0, 0, 11, 12,  8, 13, 10, 12, 13,  6, 12, 11),
+    SEQ_FRM(0, 0, 15, 16, 11, 17, 14, 16, 17,  8, 16, 14),
+    SEQ_FRM(0, 0, 20, 20, 13, 20, 20, 19, 20, 10, 20, 17)
+};
+
+// Backlot sequence
+static const uint8_t blData[] = {
+    SEQ_HDR(4, 200),
+    SEQ_FRM(0,   0,            2,  4,  6,  8, 10, 12, 14, 16, 18, 20),
+    SEQ_FRM(300, SEQF_INTERP, 20, 18, 16, 14, 12, 10,  8,  6,  4,  2),
+    SEQ_FRM(0,   0,            5,  5,  5,  5,  5,  5,  5,  5,  5,  5),
+    SEQ_FRM(150, 0,            0, 10,  0, 10,  0, 10,  0, 10,  0, 10)
+};
+
+static sidSeq strictSeq, blSeq;
+
+typedef struct {
+    idleState   st;
+    uint32_t    rnd;
+    bttfnMirRx  rx;
+    bttfnRxStats stats;
+} unit;
+
+static void unitInit(unit *u, uint32_t seed)
+{
+    memset(u, 0, sizeof(*u));
+    u->st.baseLine = 10;
+    u->st.wayUp = true;
+    memset(u->st.heights, 19, sizeof(u->st.heights));
+    u->st.strictSeq = &strictSeq;
+    u->st.blSeq = &blSeq;
+    u->rnd = seed;
+}
+
+// The leader's own idle frame: Baseline walk and frame type, 
+// from its PRNG, like showIdle()
+static void ownFrame(unit *u, idleFrame *fr, uint32_t t)
+{
+    uint32_t r;
+
+    sidRndState = u->rnd;
+
+    r = sidRandom();
+    u->st.baseLine += (int)(r % 5) - 2;
+    if(u->st.baseLine < 0) u->st.baseLine = 0;
+    else if(u->st.baseLine > 19) u->st.baseLine = 19;
+    u->st.strictBaseLine += u->st.wayUp ? 1 : -1;
+    if(u->st.strictBaseLine >= seq_numFrames(&strictSeq) - 1) u->st.wayUp = false;
+    else if(u->st.strictBaseLine <= 0) u->st.wayUp = true;
+
+    fr->variation = 20;
+    fr->seed = 0;
+    fr->seqTime = t;
+
+    switch((r >> 8) % 10) {
+    case 0:
+        fr->flags = SBLF_LM;
+        break;
+    case 1:
+        fr->flags = SBLF_ISTT | SBLF_ANIM;
+        fr->variation = 80;
+        break;
+    case 2:
+        fr->flags = SBLF_STRICT;
+        break;
+    case 3:
+        fr->flags = SBLF_REPEAT;
+        break;
+    case 4:
+    case 5:
+        fr->flags = SBLF_NOBL;
+        break;
+    default:
+        fr->flags = 0;
+    }
+
+    u->rnd = sidRndState;
+}
+
+// Leader: State goes out before rendering consumes randomness
+static void leaderFrame(unit *u, bttfnBuf *buf, uint32_t frame, uint8_t *bars)
+{
+    idleFrame fr;
+
+    ownFrame(u, &fr, frame * 37);
+
+    sidRndState = u->rnd;
+    idle_mirBuild(buf, frame, &u->st, &fr, sidRndState);
+    idle_bars(&u->st, &fr, bars);
+    u->rnd = sidRndState;
+}
+
+// Follower: Render from the leader's state, keep own PRNG state
+static bool followerFrame(unit *u, bttfnBuf *buf, uint32_t addr, unsigned long now, uint8_t *bars)
+{
+    BttfnPacket pkt(buf);
+    idleFrame fr;
+
+    if(!bttfn_mirAccept(&u->rx, pkt, addr, now, &u->stats))
+        return false;
+
+    idle_mirApply(&u->st, pkt, &fr);
+
+    sidRndState = u->rnd;
+    idle_bars(&u->st, &fr, bars);
+    u->rnd = sidRndState;
+
+    return true;
+}
+
+static void test_frameLog()
+{
+    static uint8_t leadLog[TEST_FRAMES][IDLE_BARS];
+    static uint8_t follLog[TEST_FRAMES][IDLE_BARS];
+    static bool    got[TEST_FRAMES];
+    unit lead, foll;
+    bttfnBuf txBuf, rxBuf;
+    uint32_t x = 1985, ownBefore;
+    unsigned long now = 1000;
+    int received = 0, diffs = 0, ownDiffs = 0;
+    int lastGot = -1, gaps = 0;
+
+    unitInit(&lead, 0x1a2b3c4d);
+    unitInit(&foll, 0x99887766);
+
+    memset(&txBuf, 0, sizeof(txBuf));
+
+    for(int f = 0; f < TEST_FRAMES; f++, now += 50) {
+        leaderFrame(&lead, &txBuf, f + 1, leadLog[f]);
+
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        got[f] = (x % 100 >= LOSS_PCT);
+        if(!got[f]) continue;
+
+        // Over the wire
+        memcpy(&rxBuf, &txBuf, sizeof(rxBuf));
+        BttfnPacket pkt(&rxBuf);
+        CHECK(pkt.valid());
+        CHECK_EQ(pkt.notId(), BTTFN_NOT_SID_MIRROR);
+        CHECK_EQ(pkt.mirFrame(), (uint32_t)(f + 1));
+
+        ownBefore = foll.rnd;
+        CHECK(followerFrame(&foll, &rxBuf, LEADER_ADDR, now, follLog[f]));
+        if(foll.rnd != ownBefore) ownDiffs++;
+        if(lastGot >= 0) gaps += f - lastGot - 1;
+        lastGot = f;
+        received++;
+    }
+
+    for(int f = 0; f < TEST_FRAMES; f++) {
+        if(got[f] && memcmp(leadLog[f], follLog[f], IDLE_BARS)) diffs++;
+    }
+
+    printf("  frames %d, received %d, differing %d\n", TEST_FRAMES, received, diffs);
+
+    CHECK(received > TEST_FRAMES * (100 - LOSS_PCT - 5) / 100);
+    CHECK(received < TEST_FRAMES);
+    CHECK_EQ(diffs, 0);
+    CHECK_EQ(ownDiffs, 0);
+    CHECK_EQ(foll.stats.mirFrames, (uint32_t)received);
+    CHECK_EQ(foll.stats.mirGaps, (uint32_t)gaps);
+
+    // Follower ends up with the leader's state
+    CHECK_EQ(foll.st.baseLine, lead.st.baseLine);
+    CHECK_EQ(foll.st.strictBaseLine, lead.st.strictBaseLine);
+    CHECK_EQ(foll.st.wayUp, lead.st.wayUp);
+}
+
+// Leader lock, frame order, timeout
+static void test_accept()
+{
+    unit lead, foll;
+    bttfnBuf buf, old;
+    uint8_t bars[IDLE_BARS];
+    unsigned long now = 5000;
+
+    unitInit(&lead, 0x12345678);
+    unitInit(&foll, 0x87654321);
+    memset(&buf, 0, sizeof(buf));
+
+    CHECK(!bttfn_mirActive(&foll.rx, now));
+
+    leaderFrame(&lead, &buf, 10, bars);
+    old = buf;
+    CHECK(followerFrame(&foll, &buf, LEADER_ADDR, now, bars));
+    CHECK(bttfn_mirActive(&foll.rx, now + 100));
+
+    // Another leader is ignored while the first one sends
+    leaderFrame(&lead, &buf, 11, bars);
+    CHECK(!followerFrame(&foll, &buf, OTHER_ADDR, now + 50, bars));
+    CHECK_EQ(foll.rx.leader, (uint32_t)LEADER_ADDR);
+
+    // Repeated and old frames are rejected
+    CHECK(!followerFrame(&foll, &old, LEADER_ADDR, now + 60, bars));
+    CHECK_EQ(foll.stats.seqRejected, (uint32_t)1);
+
+    // Gap
+    leaderFrame(&lead, &buf, 14, bars);
+    CHECK(followerFrame(&foll, &buf, LEADER_ADDR, now + 100, bars));
+    CHECK_EQ(foll.stats.mirGaps, (uint32_t)3);
+    CHECK_EQ(foll.stats.mirFrames, (uint32_t)2);
+
+    // Wrong number of bars
+    {
+        BttfnPacket pkt(&buf);
+        uint8_t h[IDLE_BARS] = { 0 };
+        pkt.setMirHeights(h, BTTFN_MIR_BARS - 1);
+        CHECK(!followerFrame(&foll, &buf, LEADER_ADDR, now + 150, bars));
+    }
+
+    // Leader quiet: Fall back, then any leader, any frame number
+    CHECK(bttfn_mirActive(&foll.rx, now + 100 + BTTFN_MIR_TIMEOUT - 1));
+    CHECK(!bttfn_mirActive(&foll.rx, now + 100 + BTTFN_MIR_TIMEOUT));
+    CHECK(!bttfn_mirActive(&foll.rx, now + 100 + BTTFN_MIR_TIMEOUT + 1));
+    CHECK(followerFrame(&foll, &old, OTHER_ADDR, now + 200 + BTTFN_MIR_TIMEOUT, bars));
+    CHECK_EQ(foll.rx.leader, (uint32_t)OTHER_ADDR);
+    CHECK_EQ(foll.rx.frame, (uint32_t)10);
+}
+
+// Out-of-range state from the wire is clamped to what we can render
+static void test_clamp()
+{
+    unit foll;
+    bttfnBuf buf;
+    BttfnPacket pkt(&buf);
+    idleFrame fr;
+    uint8_t h[IDLE_BARS], bars[IDLE_BARS];
+    uint32_t own;
+
+    unitInit(&foll, 0x55aa55aa);
+    memset(&buf, 0, sizeof(buf));
+    memset(h, 31, sizeof(h));
+
+    pkt.init();
+    pkt.setVersion(BTTFN_VERSION | 0x40);
+    pkt.setFlags(BTTFN_NOT_SID_MIRROR);
+    pkt.setSeq(1);
+    pkt.setMirState(40, 250, 0, SBLF_REPEAT, false);
+    pkt.setMirSeed(0);
+    pkt.setMirSeqTime(0);
+    pkt.setMirHeights(h, BTTFN_MIR_BARS);
+
+    idle_mirApply(&foll.st, pkt, &fr);
+    CHECK_EQ(foll.st.baseLine, 19);
+    CHECK_EQ(foll.st.strictBaseLine, seq_numFrames(&strictSeq) - 1);
+    CHECK_EQ(foll.st.wayUp, false);
+    CHECK(fr.variation >= 1);
+    for(int i = 0; i < IDLE_BARS; i++) {
+        CHECK_EQ(foll.st.heights[i], 19);
+    }
+
+    // Repeat of clamped heights: 20 LEDs
+    own = sidRndState = foll.rnd;
+    idle_bars(&foll.st, &fr, bars);
+    for(int i = 0; i < IDLE_BARS; i++) {
+        CHECK_EQ(bars[i], 20);
+    }
+
+    // Variation 0, no seed: Renders from our own PRNG
+    fr.flags = 0;
+    idle_bars(&foll.st, &fr, bars);
+    CHECK(sidRndState != own);
+    for(int i = 0; i < IDLE_BARS; i++) {
+        CHECK(bars[i] >= 1 && bars[i] <= 20);
+    }
+
+    // Strict frame beyond the end of the sequence
+    fr.flags = SBLF_STRICT;
+    idle_bars(&foll.st, &fr, bars);
+    CHECK(bars[0] == 20 && bars[7] == 10);
+}
+
+// Backlot frames: Follower samples the leader's sequence time
+static void test_backlot()
+{
+    unit lead, foll;
+    bttfnBuf buf;
+    idleFrame fr = { 20, SBLF_NOBL, 0, 0 };
+    uint8_t lb[IDLE_BARS], fb[IDLE_BARS], sb[IDLE_BARS];
+    uint16_t next;
+
+    unitInit(&lead, 0x0badf00d);
+    unitInit(&foll, 0x0ddba11);
+    memset(&buf, 0, sizeof(buf));
+
+    for(uint32_t t = 0; t < 2000; t += 17) {
+        fr.seqTime = t;
+        idle_mirBuild(&buf, t + 1, &lead.st, &fr, sidRndState);
+        next = idle_bars(&lead.st, &fr, lb);
+        CHECK(followerFrame(&foll, &buf, LEADER_ADDR, 1000 + t, fb));
+        CHECK_EQ(next, seq_sample(&blSeq, t, sb));
+        CHECK(!memcmp(lb, sb, IDLE_BARS));
+        CHECK(!memcmp(lb, fb, IDLE_BARS));
+    }
+}
+
+// Bars within range, TT frames capped
+static void test_bars()
+{
+    uint8_t h[IDLE_BARS];
+
+    sidRndState = 2463534242UL;
+    for(int bl = 0; bl < 25; bl++) {
+        memset(h, 0, sizeof(h));
+        idle_calcBars(bl, 20, 0, h);
+        for(int i = 0; i < IDLE_BARS; i++) {
+            CHECK(h[i] <= 19);
+            if(bl == 0) CHECK_EQ(h[i], 0);
+        }
+        idle_calcBars(bl, 20, SBLF_LM, h);
+        for(int i = 0; i < IDLE_BARS; i++) {
+            CHECK(h[i] <= 19);
+        }
+        idle_calcBars(bl, 80, SBLF_ISTT | SBLF_ANIM, h);
+        for(int i = 0; i < IDLE_BARS; i++) {
+            CHECK(h[i] <= idleMaxTTHeight[i]);
+        }
+        idle_calcBars(bl, 80, SBLF_ISTT, h);
+        for(int i = 0; i < IDLE_BARS; i++) {
+            CHECK_EQ(h[i], idleMaxTTHeight[i]);
+        }
+    }
+}
+
+int main()
+{
+    if(!seq_openMem(&strictSeq, strictData, sizeof(strictData)) ||
+       !seq_openMem(&blSeq, blData, sizeof(blData))) {
+        printf("Failed to open sequences\n");
+        return 1;
+    }
+
+    RUN(test_bars);
+    RUN(test_frameLog);
+    RUN(test_accept);
+    RUN(test_clamp);
+    RUN(test_backlot);
+
+    return TEST_RESULT();
+}
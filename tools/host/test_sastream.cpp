@@ -0,0 +1,287 @@
+/*
+ * -------------------------------------------------------------------
+ * CircuitSetup.us Status Indicator Display
+ * (C) 2023-2026 Thomas Winischhofer (A10001986)
+ * https://github.com/realA10001986/SID
+ * https://sid.out-a-ti.me
+ *
+ * Host tests: SA band data stream
+ *
+ * -------------------------------------------------------------------
+ * License: Modified MIT NON-AI
+ * 
+ * Permission is hereby granted, free of charge, to any person 
+ * obtaining a copy of this software and associated documentation 
+ * files (the "Software"), to deal in the Software without restriction, 
+ * including without limitation the rights to use, copy, modify, 
+ * merge, publish, distribute, sublicense, and/or sell copies of the 
+ * Software, and to permit persons to whom the Software is furnished to 
+ * do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be 
+ * included in all copies or substantial portions of the Software.
+ * 
+ * Links inside the Software pointing to the original source must not 
+ * be changed or removed.
+ *
+ * In addition, the following restrictions apply:
+ * 
+ * 1. The Software and any modifications made to it may not be used 
+ * for the purpose of training or improving machine learning algorithms, 
+ * including but not limited to artificial intelligence, natural 
+ * language processing, or data mining. This condition applies to any 
+ * derivatives, modifications, or updates based on the Software code. 
+ * Any usage of the Software in an AI-training dataset is considered a 
+ * breach of this License.
+ *
+ * 2. The Software may not be included in any dataset used for 
+ * training or improving machine learning algorithms, including but 
+ * not limited to artificial intelligence, natural language processing, 
+ * or data mining.
+ *
+ * 3. Any person or organization found to be in violation of these 
+ * restrictions will be subject to legal action and may be held liable 
+ * for any damages resulting from such use.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, 
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF 
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. 
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY 
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, 
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE 
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */ 
+
+/*
+ * Sends SA band data built by bttfn_saBuild() at the SA frame rate
+ * to the multicast group on localhost, with injected loss, and 
+ * receives it like another prop would: Measures delivered frame 
+ * rate and loss, and checks every frame's values.
+ */
+
+#include "sid_global.h"
+
+#include <Arduino.h>
+
+#include <sys/select.h>
+
+#include <atomic>
+#include <thread>
+
+#include "sid_bttfn.h"
+
+#include "hostnet.h"
+#include "hosttest.h"
+
+#define SA_FRAME_US   32000     // 1024 samples at 32kHz
+#define NUM_BANDS     10
+#define BAR_HEIGHT    20        // LEDs per bar of the original SID
+#define TEST_PORT     31340     // not BTTFN's, to stay out of the way
+#define TEST_FRAMES   94        // 3 seconds
+#define LOSS_PCT      10
+
+static std::atomic<bool> sending(true);
+static uint32_t lost = 0;
+static uint64_t buildNs = 0;
+
+// Heights 1..BAR_HEIGHT as sa_loop() produces them, plus some 
+// beyond, to check clamping; peaks 0..BAR_HEIGHT-1
+static void pattern(uint32_t seq, int *h, uint8_t *p)
+{
+    for(int i = 0; i < NUM_BANDS; i++) {
+        h[i] = (int)((seq * 3 + i * 7) % (BAR_HEIGHT + 4)) - 2;
+        p[i] = (seq + i * 5) % BAR_HEIGHT;
+    }
+}
+
+static uint8_t clampTo(int v, int range)
+{
+    return (v < 0) ? 0 : ((v > range) ? range : v);
+}
+
+static void sender()
+{
+    int s = openSock(0, NULL);
+    int h[NUM_BANDS];
+    uint8_t p[NUM_BANDS];
+    bttfnBuf buf;
+    uint32_t x = 1985;
+    unsigned long start = micros(), t0;
+
+    memset(&buf, 0, sizeof(buf));
+
+    for(uint32_t seq = 1; seq <= TEST_FRAMES; seq++) {
+        pattern(seq, h, p);
+
+        t0 = micros();
+        bttfn_saBuild(&buf, seq, h, p, NUM_BANDS, BAR_HEIGHT);
+        buildNs += (micros() - t0) * 1000;
+
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        if(x % 100 < LOSS_PCT) {
+            lost++;
+        } else {
+            sendTo(s, &buf, inet_addr(MC_GROUP), TEST_PORT);
+        }
+
+        while((long)(start + seq * SA_FRAME_US - micros()) > 0) {
+            delay(1);
+        }
+    }
+
+    close(s);
+    sending = false;
+}
+
+static void test_stream()
+{
+    int s = openSock(TEST_PORT, MC_GROUP);
+    unsigned long first = 0, last = 0, idleSince = 0;
+    uint32_t cnt = 0, firstSeq = 0, lastSeq = 0, badVals = 0, outOfOrder = 0;
+    int h[NUM_BANDS];
+    uint8_t p[NUM_BANDS];
+    bttfnBuf buf;
+    BttfnPacket pkt(&buf);
+
+    CHECK(s >= 0);
+    if(s < 0) return;
+
+    std::thread st(sender);
+
+    for(;;) {
+        fd_set rfds;
+        struct timeval tv = { 0, 50000 };
+
+        FD_ZERO(&rfds);
+        FD_SET(s, &rfds);
+        if(select(s + 1, &rfds, NULL, NULL, &tv) <= 0) {
+            if(!sending) {
+                if(!idleSince) idleSince = millis();
+                else if(millis() - idleSince > 200) break;
+            }
+            continue;
+        }
+        if(recv(s, buf.b, BTTF_PACKET_SIZE, 0) != BTTF_PACKET_SIZE || !pkt.valid())
+            continue;
+        if(!pkt.isNotification() || pkt.notId() != BTTFN_NOT_SID_SA)
+            continue;
+
+        unsigned long now = micros();
+        uint32_t seq = pkt.reqId();
+
+        if(!cnt) {
+            first = now;
+            firstSeq = seq;
+        } else if(seq <= lastSeq) {
+            outOfOrder++;
+        }
+        last = now;
+        lastSeq = seq;
+        cnt++;
+
+        CHECK_EQ(pkt.saNumBands(), NUM_BANDS);
+        CHECK_EQ(pkt.saRange(), BAR_HEIGHT);
+        pattern(seq, h, p);
+        for(int i = 0; i < NUM_BANDS; i++) {
+            if(pkt.saValue(i) != clampTo(h[i], BAR_HEIGHT) || pkt.saValue(NUM_BANDS + i) != p[i]) {
+                badVals++;
+            }
+        }
+    }
+
+    st.join();
+    close(s);
+
+    CHECK(cnt > 1);
+    if(cnt <= 1) return;
+
+    double secs = (double)(last - first) / 1e6;
+    double sentFps = (lastSeq - firstSeq) / secs;
+    double gotFps = (cnt - 1) / secs;
+    uint32_t missing = TEST_FRAMES - cnt;
+
+    printf("  frames %u, received %u, lost %u (injected %u), out of order %u\n",
+           TEST_FRAMES, cnt, missing, lost, outOfOrder);
+    printf("  frame rate: sent %.2f/s, delivered %.2f/s (SA %.2f/s)\n", 
+           sentFps, gotFps, 1e6 / SA_FRAME_US);
+    printf("  bttfn_saBuild(): %.0f ns/frame\n", (double)buildNs / TEST_FRAMES);
+
+    CHECK_EQ(badVals, 0);
+    CHECK_EQ(outOfOrder, 0);
+    CHECK_EQ(missing, lost);
+    // Frames go out at the SA frame rate, within 5%
+    CHECK(sentFps > 0.95e6 / SA_FRAME_US && sentFps < 1.05e6 / SA_FRAME_US);
+    CHECK(gotFps > 0.95e6 / SA_FRAME_US * (TEST_FRAMES - lost) / TEST_FRAMES);
+}
+
+// Header follows number of bands and bar height; range is the
+// bar height, taller bars are scaled to 5 bits
+static void test_build()
+{
+    int h[BTTFN_SA_MAXVALS];
+    uint8_t p[BTTFN_SA_MAXVALS];
+    bttfnBuf buf;
+    BttfnPacket pkt(&buf);
+
+    memset(&buf, 0, sizeof(buf));
+    for(int i = 0; i < BTTFN_SA_MAXVALS; i++) {
+        h[i] = i * 3 - 10;
+        p[i] = i * 2;
+    }
+
+    bttfn_saBuild(&buf, 7, h, p, NUM_BANDS, BAR_HEIGHT);
+    CHECK(pkt.valid());
+    CHECK_EQ(pkt.saNumBands(), NUM_BANDS);
+    CHECK_EQ(pkt.saRange(), BAR_HEIGHT);
+    for(int i = 0; i < NUM_BANDS; i++) {
+        CHECK_EQ(pkt.saValue(i), clampTo(h[i], BAR_HEIGHT));
+        CHECK_EQ(pkt.saValue(NUM_BANDS + i), clampTo(p[i], BAR_HEIGHT));
+    }
+    
+    bttfn_saBuild(&buf, 8, h, p, 5, BAR_HEIGHT);
+    CHECK(pkt.valid());
+    CHECK_EQ(pkt.reqId(), 8);
+    CHECK_EQ(pkt.saNumBands(), 5);
+    CHECK_EQ(pkt.saRange(), BAR_HEIGHT);
+    for(int i = 0; i < 5; i++) {
+        CHECK_EQ(pkt.saValue(i), clampTo(h[i], BAR_HEIGHT));
+        CHECK_EQ(pkt.saValue(5 + i), clampTo(p[i], BAR_HEIGHT));
+    }
+
+    // Smaller display: Range follows
+    bttfn_saBuild(&buf, 9, h, p, 5, 16);
+    CHECK(pkt.valid());
+    CHECK_EQ(pkt.saRange(), 16);
+    for(int i = 0; i < 5; i++) {
+        CHECK_EQ(pkt.saValue(i), clampTo(h[i], 16));
+    }
+
+    // Bars taller than 5 bits: Scaled into 0..31
+    for(int i = 0; i < NUM_BANDS; i++) {
+        h[i] = i * 40 / (NUM_BANDS - 1);
+        p[i] = (i * 39) / (NUM_BANDS - 1);
+    }
+    bttfn_saBuild(&buf, 10, h, p, NUM_BANDS, 40);
+    CHECK(pkt.valid());
+    CHECK_EQ(pkt.saRange(), BTTFN_SA_MAXVAL);
+    CHECK_EQ(pkt.saValue(0), 0);
+    CHECK_EQ(pkt.saValue(NUM_BANDS - 1), BTTFN_SA_MAXVAL);
+    CHECK_EQ(pkt.saValue(2 * NUM_BANDS - 1), 39 * BTTFN_SA_MAXVAL / 40);
+    for(int i = 0; i < NUM_BANDS; i++) {
+        CHECK_EQ(pkt.saValue(i), h[i] * BTTFN_SA_MAXVAL / 40);
+        CHECK_EQ(pkt.saValue(NUM_BANDS + i), p[i] * BTTFN_SA_MAXVAL / 40);
+    }
+
+    // More bands than fit: Cut down
+    bttfn_saBuild(&buf, 11, h, p, BTTFN_SA_MAXVALS, BAR_HEIGHT);
+    CHECK(pkt.valid());
+    CHECK_EQ(pkt.saNumBands(), BTTFN_SA_MAXVALS / 2);
+}
+
+int main()
+{
+    RUN(test_build);
+    RUN(test_stream);
+
+    return TEST_RESULT();
+}